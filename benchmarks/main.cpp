@@ -0,0 +1,1063 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <cstdio>
+#include <array>
+#include <tuple>
+#include <filesystem>
+#include <GLSP/loaders.h>
+#include <GLSP/cache.h>
+#include <GLSP/processing.h>
+#include <GLSP/pointcloud.h>
+#include "report.h"
+
+USING_NAMESPACE_GLSP
+
+static bench::Report REPORT;
+
+static std::string get_file_name(const std::string &path)
+{
+    return std::filesystem::path(path).filename().string();
+}
+
+/*
+Writes a tessellated grid OBJ with positions, uvs and normals of roughly the requested size.
+*/
+static std::string write_synthetic_OBJ(size_t targetMB)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / ("glsp_synthetic_" + std::to_string(targetMB) + "mb.obj")).string();
+    if (std::filesystem::exists(path))
+        return path;
+
+    // Roughly 150 bytes per grid cell (one vertex line of each kind plus two triangles)
+    const size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(targetMB * 1e6 / 150.0)));
+    std::ofstream file(path);
+    file << "# GLSP synthetic benchmark mesh\no Grid\n";
+    char line[128];
+    for (size_t j = 0; j < side; j++)
+        for (size_t i = 0; i < side; i++)
+        {
+            const float x = i / float(side - 1), z = j / float(side - 1);
+            snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 100.0f - 50.0f, std::sin(x * 20.0f) * std::cos(z * 20.0f), z * 100.0f - 50.0f);
+            file << line;
+        }
+    for (size_t j = 0; j < side; j++)
+        for (size_t i = 0; i < side; i++)
+        {
+            snprintf(line, sizeof(line), "vt %.6f %.6f\n", i / float(side - 1), j / float(side - 1));
+            file << line;
+        }
+    for (size_t j = 0; j < side; j++)
+        for (size_t i = 0; i < side; i++)
+        {
+            const glm::vec3 n = glm::normalize(glm::vec3(std::sin(i * 0.1f), 1.0f, std::cos(j * 0.1f)));
+            snprintf(line, sizeof(line), "vn %.4f %.4f %.4f\n", n.x, n.y, n.z);
+            file << line;
+        }
+    for (size_t j = 0; j + 1 < side; j++)
+        for (size_t i = 0; i + 1 < side; i++)
+        {
+            const size_t a = j * side + i + 1, b = a + 1, c = a + side, d = c + 1;
+            file << "f " << a << '/' << a << '/' << a << ' ' << b << '/' << b << '/' << b << ' ' << d << '/' << d << '/' << d << '\n';
+            file << "f " << a << '/' << a << '/' << a << ' ' << d << '/' << d << '/' << d << ' ' << c << '/' << c << '/' << c << '\n';
+        }
+    return path;
+}
+
+/*
+Writes a tessellated grid as a binary little endian PLY with normals, uvs and colors of roughly the requested size.
+*/
+static std::string write_synthetic_PLY(size_t targetMB)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / ("glsp_synthetic_" + std::to_string(targetMB) + "mb.ply")).string();
+    if (std::filesystem::exists(path))
+        return path;
+
+    // 36 bytes per vertex and 2 * 13 bytes per grid cell
+    const size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(targetMB * 1e6 / 62.0)));
+    std::ofstream file(path, std::ios::binary);
+    file << "ply\nformat binary_little_endian 1.0\ncomment GLSP synthetic benchmark mesh\n"
+         << "element vertex " << side * side << "\n"
+         << "property float x\nproperty float y\nproperty float z\n"
+         << "property float nx\nproperty float ny\nproperty float nz\n"
+         << "property float u\nproperty float v\n"
+         << "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n"
+         << "element face " << 2 * (side - 1) * (side - 1) << "\n"
+         << "property list uchar int vertex_indices\nend_header\n";
+    for (size_t j = 0; j < side; j++)
+        for (size_t i = 0; i < side; i++)
+        {
+            const float x = i / float(side - 1), z = j / float(side - 1);
+            const glm::vec3 n = glm::normalize(glm::vec3(std::sin(i * 0.1f), 1.0f, std::cos(j * 0.1f)));
+            const float attributes[8] = {x * 100.0f - 50.0f, std::sin(x * 20.0f) * std::cos(z * 20.0f), z * 100.0f - 50.0f, n.x, n.y, n.z, x, z};
+            const unsigned char color[4] = {static_cast<unsigned char>(x * 255), 128, static_cast<unsigned char>(z * 255), 255};
+            file.write(reinterpret_cast<const char *>(attributes), sizeof(attributes));
+            file.write(reinterpret_cast<const char *>(color), sizeof(color));
+        }
+    for (size_t j = 0; j + 1 < side; j++)
+        for (size_t i = 0; i + 1 < side; i++)
+        {
+            const int a = int(j * side + i), b = a + 1, c = a + int(side), d = c + 1;
+            const unsigned char count = 3;
+            const int faces[2][3] = {{a, b, d}, {a, d, c}};
+            for (const auto &face : faces)
+            {
+                file.write(reinterpret_cast<const char *>(&count), 1);
+                file.write(reinterpret_cast<const char *>(face), sizeof(face));
+            }
+        }
+    return path;
+}
+
+/*
+Builds a wavy uv mapped grid with roughly the requested amount of triangles directly in memory.
+*/
+static MeshData make_synthetic_grid(size_t triangles)
+{
+    const size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(triangles / 2.0)) + 1);
+    MeshData data;
+    data.vertices.reserve(side * side);
+    for (size_t j = 0; j < side; j++)
+        for (size_t i = 0; i < side; i++)
+        {
+            const float x = i / float(side - 1), z = j / float(side - 1);
+            const glm::vec3 normal = glm::normalize(glm::vec3(std::sin(x * 20.0f), 1.0f, std::cos(z * 20.0f)));
+            data.vertices.push_back({{x * 100.0f - 50.0f, std::sin(x * 20.0f) * std::cos(z * 20.0f), z * 100.0f - 50.0f}, normal, glm::vec3(0.0f), {x, z}, glm::vec3(1.0f)});
+        }
+    data.indices.reserve((side - 1) * (side - 1) * 6);
+    for (size_t j = 0; j + 1 < side; j++)
+        for (size_t i = 0; i + 1 < side; i++)
+        {
+            const unsigned int a = static_cast<unsigned int>(j * side + i), b = a + 1, c = a + static_cast<unsigned int>(side), d = c + 1;
+            data.indices.insert(data.indices.end(), {a, b, d, a, d, c});
+        }
+    return data;
+}
+
+/*
+Writes the synthetic grid as a binary glTF with interleaved canonical vertices and 32 bit indices.
+*/
+static std::string write_synthetic_GLB(size_t triangles)
+{
+    const std::string path = (std::filesystem::temp_directory_path() / ("glsp_synthetic_" + std::to_string(triangles) + ".glb")).string();
+    if (std::filesystem::exists(path))
+        return path;
+
+    const MeshData grid = make_synthetic_grid(triangles);
+    const size_t vertexBytes = grid.vertices.size() * sizeof(Vertex), indexBytes = grid.indices.size() * sizeof(unsigned int);
+    const std::string attribute = R"({"bufferView":0,"componentType":5126,"count":)" + std::to_string(grid.vertices.size());
+    std::string json = R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],"nodes":[{"mesh":0}],)"
+                       R"("meshes":[{"primitives":[{"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2,"COLOR_0":3},"indices":4}]}],)"
+                       R"("accessors":[)" +
+                       attribute + R"(,"byteOffset":)" + std::to_string(offsetof(Vertex, position)) + R"(,"type":"VEC3"},)" +
+                       attribute + R"(,"byteOffset":)" + std::to_string(offsetof(Vertex, normal)) + R"(,"type":"VEC3"},)" +
+                       attribute + R"(,"byteOffset":)" + std::to_string(offsetof(Vertex, uv)) + R"(,"type":"VEC2"},)" +
+                       attribute + R"(,"byteOffset":)" + std::to_string(offsetof(Vertex, color)) + R"(,"type":"VEC3"},)" +
+                       R"({"bufferView":1,"componentType":5125,"type":"SCALAR","count":)" + std::to_string(grid.indices.size()) + "}]," +
+                       R"("bufferViews":[{"buffer":0,"byteLength":)" + std::to_string(vertexBytes) + R"(,"byteStride":)" + std::to_string(sizeof(Vertex)) + "}," +
+                       R"({"buffer":0,"byteOffset":)" + std::to_string(vertexBytes) + R"(,"byteLength":)" + std::to_string(indexBytes) + "}]," +
+                       R"("buffers":[{"byteLength":)" + std::to_string(vertexBytes + indexBytes) + "}]}";
+    json.resize((json.size() + 3) & ~size_t(3), ' ');
+
+    const uint32_t binBytes = static_cast<uint32_t>(vertexBytes + indexBytes);
+    const uint32_t header[5] = {0x46546C67, 2, static_cast<uint32_t>(28 + json.size() + binBytes), static_cast<uint32_t>(json.size()), 0x4E4F534A};
+    const uint32_t binHeader[2] = {binBytes, 0x004E4942};
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(json.data(), json.size());
+    file.write(reinterpret_cast<const char *>(binHeader), sizeof(binHeader));
+    file.write(reinterpret_cast<const char *>(grid.vertices.data()), vertexBytes);
+    file.write(reinterpret_cast<const char *>(grid.indices.data()), indexBytes);
+    return path;
+}
+
+/*
+Compares both imports corner by corner, so that differences in vertex deduplication do not count as mismatches.
+*/
+static bool same_geometry(const MeshData &a, const MeshData &b)
+{
+    if (a.indices.size() != b.indices.size())
+        return false;
+    const float EPSILON = 1e-5f;
+    for (size_t i = 0; i < a.indices.size(); i++)
+    {
+        const Vertex &va = a.vertices[a.indices[i]];
+        const Vertex &vb = b.vertices[b.indices[i]];
+        if (glm::any(glm::greaterThan(glm::abs(va.position - vb.position), glm::vec3(EPSILON))) ||
+            glm::any(glm::greaterThan(glm::abs(va.normal - vb.normal), glm::vec3(EPSILON))) ||
+            glm::any(glm::greaterThan(glm::abs(va.uv - vb.uv), glm::vec2(EPSILON))) ||
+            glm::any(glm::greaterThan(glm::abs(va.color - vb.color), glm::vec3(EPSILON))))
+            return false;
+    }
+    return true;
+}
+
+/*
+Whole file reads touching every byte: an ifstream copy into a zero filled vector against the mapped file.
+*/
+static void bench_file_reading(const std::string &path, int runs)
+{
+    bench::reset_peak_RSS();
+    std::vector<double> copied, mapped;
+    uint64_t checksum[2] = {0, 0};
+    size_t size = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        {
+            std::ifstream file(path, std::ios::binary);
+            file.seekg(0, std::ios::end);
+            std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+            file.seekg(0, std::ios::beg);
+            file.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+            checksum[0] = utils::hash_bytes(bytes.data(), bytes.size());
+        }
+        timer.stop();
+        copied.push_back(timer.get());
+
+        timer.start();
+        {
+            const utils::MappedFile file(path, utils::FILE_ACCESS_SEQUENTIAL);
+            checksum[1] = utils::hash_bytes(file.get_data(), file.get_size());
+            size = file.get_size();
+        }
+        timer.stop();
+        mapped.push_back(timer.get());
+    }
+    REPORT.add("file reading", get_file_name(path) + " ifstream copy", copied, size * 1e-6, "MB");
+    REPORT.add("file reading", get_file_name(path) + " mapped", mapped, size * 1e-6, "MB");
+    printf("%-48s %8.1f MB | ifstream copy %8.2f ms | mapped %8.2f ms | x%.2f%s\n", get_file_name(path).c_str(),
+           size * 1e-6, bench::best(copied), bench::best(mapped), bench::best(copied) / bench::best(mapped), checksum[0] == checksum[1] ? "" : " MISMATCH");
+}
+
+static void bench_OBJ(const std::string &path, int runs)
+{
+    bench::reset_peak_RSS();
+    const double sizeMB = std::filesystem::file_size(path) * 1e-6;
+
+    std::vector<double> tinyobj, parallel;
+    MeshData reference, native;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+
+        reference = {};
+        timer.start();
+        loaders::parse_OBJ_tinyobj(path.c_str(), reference);
+        timer.stop();
+        tinyobj.push_back(timer.get());
+
+        native = {};
+        timer.start();
+        loaders::parse_OBJ(path.c_str(), native);
+        timer.stop();
+        parallel.push_back(timer.get());
+    }
+    REPORT.add("OBJ import", get_file_name(path) + " tinyobj", tinyobj, sizeMB, "MB");
+    REPORT.add("OBJ import", get_file_name(path) + " parallel", parallel, sizeMB, "MB");
+    const double tinyobjBest = bench::best(tinyobj), nativeBest = bench::best(parallel);
+
+    printf("%-48s %9.2f MB | tinyobj %9.2f ms %8.2f MB/s | parallel %9.2f ms %8.2f MB/s | x%.2f | %zu verts %zu tris | %s\n",
+           get_file_name(path).c_str(), sizeMB,
+           tinyobjBest, sizeMB / (tinyobjBest * 1e-3), nativeBest, sizeMB / (nativeBest * 1e-3), tinyobjBest / nativeBest,
+           native.vertices.size(), native.indices.size() / 3, same_geometry(reference, native) ? "match" : "MISMATCH");
+}
+
+static void bench_PLY(const std::string &path, int runs)
+{
+    bench::reset_peak_RSS();
+    const double sizeMB = std::filesystem::file_size(path) * 1e-6;
+
+    std::vector<double> tinyply, mappedRuns, streamedRuns;
+    MeshData reference, mapped, streamed;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+
+        reference = {};
+        timer.start();
+        loaders::parse_PLY_tinyply(path.c_str(), reference);
+        timer.stop();
+        tinyply.push_back(timer.get());
+
+        mapped = {};
+        timer.start();
+        loaders::parse_PLY(path.c_str(), mapped, true);
+        timer.stop();
+        mappedRuns.push_back(timer.get());
+
+        streamed = {};
+        timer.start();
+        loaders::parse_PLY(path.c_str(), streamed, false);
+        timer.stop();
+        streamedRuns.push_back(timer.get());
+    }
+    REPORT.add("PLY import", get_file_name(path) + " tinyply", tinyply, sizeMB, "MB");
+    REPORT.add("PLY import", get_file_name(path) + " mapped", mappedRuns, sizeMB, "MB");
+    REPORT.add("PLY import", get_file_name(path) + " streamed", streamedRuns, sizeMB, "MB");
+    const double tinyplyBest = bench::best(tinyply), mappedBest = bench::best(mappedRuns), streamedBest = bench::best(streamedRuns);
+
+    const bool match = same_geometry(reference, mapped) && same_geometry(reference, streamed);
+    printf("%-48s %9.2f MB | tinyply %9.2f ms %8.2f MB/s | mapped %9.2f ms %8.2f MB/s | streamed %9.2f ms %8.2f MB/s | %zu verts %zu tris | %s\n",
+           get_file_name(path).c_str(), sizeMB,
+           tinyplyBest, sizeMB / (tinyplyBest * 1e-3), mappedBest, sizeMB / (mappedBest * 1e-3), streamedBest, sizeMB / (streamedBest * 1e-3),
+           mapped.vertices.size(), mapped.indices.size() / 3, match ? "match" : "MISMATCH");
+}
+
+/*
+glTF import plus a pass over the vertex and index buffers it references, standing in for the upload, against hashing
+the whole file. Imports bounded by I/O take about the same time.
+*/
+static void bench_GLTF(const std::string &path, int runs)
+{
+    bench::reset_peak_RSS();
+    const double sizeMB = std::filesystem::file_size(path) * 1e-6;
+    std::vector<double> readRuns, parseRuns, importRuns;
+    size_t vertices = 0, triangles = 0;
+    bool loaded = true;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        {
+            const utils::MappedFile file(path, utils::FILE_ACCESS_SEQUENTIAL);
+            utils::hash_bytes(file.get_data(), file.get_size());
+        }
+        timer.stop();
+        readRuns.push_back(timer.get());
+
+        std::vector<Mesh *> meshes;
+        timer.start();
+        loaded = loaders::load_GLTF(nullptr, path.c_str(), meshes) && loaded;
+        timer.stop();
+        parseRuns.push_back(timer.get());
+        timer.start();
+        for (Mesh *mesh : meshes)
+        {
+            const Geometry *geometry = mesh->get_geometry();
+            if (!geometry)
+                continue;
+            for (const VertexBuffer &VBO : geometry->get_VAO().get_vertex_buffers())
+                utils::hash_bytes(VBO.get_data(), VBO.get_total_size());
+            utils::hash_bytes(geometry->get_IBO().get_data(), geometry->get_IBO().get_total_size());
+            vertices = geometry->get_vertex_count();
+            triangles = geometry->get_IBO().get_index_count() / 3;
+        }
+        timer.stop();
+        importRuns.push_back(parseRuns.back() + timer.get());
+        for (Mesh *mesh : meshes)
+            delete mesh;
+    }
+    REPORT.add("glTF import", get_file_name(path) + " read", readRuns, sizeMB, "MB");
+    REPORT.add("glTF import", get_file_name(path) + " parse and touch", importRuns, sizeMB, "MB");
+    const double read = bench::best(readRuns), imported = bench::best(parseRuns), import = bench::best(importRuns);
+    printf("%-48s %9.2f MB | read %9.2f ms | parse %7.3f ms | parse and touch %9.2f ms | x%.2f of read | %zu verts %zu tris%s\n",
+           get_file_name(path).c_str(), sizeMB, read, imported, import, import / read,
+           vertices, triangles, loaded ? "" : " FAILED");
+}
+
+/*
+Tangent generation over doubling thread counts, to check how it scales with cores.
+*/
+static void bench_tangents(size_t triangles, int runs)
+{
+    bench::reset_peak_RSS();
+    const MeshData source = make_synthetic_grid(triangles);
+    double singleThread = 0.0;
+    for (unsigned int threads = 1; threads <= utils::get_thread_count(); threads *= 2)
+    {
+        std::vector<double> samples;
+        for (int run = 0; run < runs; run++)
+        {
+            MeshData data = source;
+            utils::ManualTimer timer;
+            timer.start();
+            processing::compute_tangents(data, threads);
+            timer.stop();
+            samples.push_back(timer.get());
+        }
+        REPORT.add("tangents", std::to_string(source.indices.size() / 3) + " tris " + std::to_string(threads) + " threads", samples,
+                   source.indices.size() / 3 * 1e-6, "Mtris");
+        const double best = bench::best(samples);
+        if (threads == 1)
+            singleThread = best;
+        printf("%9zu tris | %2u threads %9.2f ms %8.2f Mtris/s | x%.2f\n", source.indices.size() / 3, threads, best,
+               source.indices.size() / 3 / (best * 1e3), singleThread / best);
+    }
+}
+
+/*
+Welding of the triangle soup of a synthetic grid, where every vertex is shared by six corners.
+*/
+static void bench_weld(size_t triangles, int runs)
+{
+    bench::reset_peak_RSS();
+    const MeshData grid = make_synthetic_grid(triangles);
+    MeshData soup;
+    soup.vertices.reserve(grid.indices.size());
+    for (const unsigned int index : grid.indices)
+        soup.vertices.push_back(grid.vertices[index]);
+
+    std::vector<double> samples;
+    size_t removed = 0, vertices = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        MeshData data = soup;
+        utils::ManualTimer timer;
+        timer.start();
+        removed = processing::weld_vertices(data);
+        timer.stop();
+        samples.push_back(timer.get());
+        vertices = data.vertices.size();
+    }
+    REPORT.add("vertex dedup", std::to_string(soup.vertices.size()) + " vertices", samples, soup.vertices.size() * 1e-6, "Mverts");
+    const double best = bench::best(samples);
+    printf("%9zu verts -> %9zu | %9.2f ms %8.2f Mverts/s | %s\n", soup.vertices.size(), vertices, best, soup.vertices.size() / (best * 1e3),
+           vertices == grid.vertices.size() && removed == soup.vertices.size() - vertices ? "match" : "MISMATCH");
+}
+
+/*
+Vertex cache efficiency of the imported index order against the optimized one.
+*/
+static void bench_mesh_optimization(const std::string &path)
+{
+    MeshData data;
+    loaders::parse_OBJ(path.c_str(), data);
+
+    utils::ManualTimer timer;
+    timer.start();
+    const processing::MeshOptimizationReport report = processing::optimize_mesh(data);
+    timer.stop();
+
+    printf("%-48s %9zu tris | ACMR %5.3f -> %5.3f | ATVR %5.3f -> %5.3f | %9.2f ms\n", get_file_name(path).c_str(),
+           data.indices.size() / 3, report.before.ACMR, report.after.ACMR, report.before.ATVR, report.after.ATVR, timer.get());
+}
+
+static void bench_quantization(const std::string &path)
+{
+    MeshData data;
+    loaders::parse_OBJ(path.c_str(), data);
+    processing::compute_tangents(data);
+
+    processing::QuantizedMeshData quantized;
+    utils::ManualTimer timer;
+    timer.start();
+    const processing::QuantizationReport report = processing::quantize_mesh(data, quantized);
+    timer.stop();
+
+    printf("%-48s %6.2f -> %6.2f MB | pos %.2e | normal %.4f deg | tangent %.4f deg | %9.2f ms\n", get_file_name(path).c_str(),
+           report.originalBytes * 1e-6, report.quantizedBytes * 1e-6, report.maxPositionError, glm::degrees(report.maxNormalError),
+           glm::degrees(report.maxTangentError), timer.get());
+}
+
+/*
+Meshlet build throughput over a cache optimized grid, scaling the thread count like bench_tangents.
+*/
+static void bench_meshlets(size_t triangles, int runs)
+{
+    bench::reset_peak_RSS();
+    MeshData data = make_synthetic_grid(triangles);
+    processing::optimize_vertex_cache(data);
+    double singleThread = 0.0;
+    for (unsigned int threads = 1; threads <= utils::get_thread_count(); threads *= 2)
+    {
+        processing::MeshletData meshlets;
+        processing::MeshletSettings settings;
+        settings.threadCount = threads;
+        std::vector<double> samples;
+        for (int run = 0; run < runs; run++)
+        {
+            utils::ManualTimer timer;
+            timer.start();
+            processing::build_meshlets(data, meshlets, settings);
+            timer.stop();
+            samples.push_back(timer.get());
+        }
+        REPORT.add("meshlets", std::to_string(data.indices.size() / 3) + " tris " + std::to_string(threads) + " threads", samples,
+                   data.indices.size() / 3 * 1e-6, "Mtris");
+        const double best = bench::best(samples);
+        if (threads == 1)
+            singleThread = best;
+        printf("%9zu tris | %7zu meshlets %5.1f tris avg | %2u threads %9.2f ms %8.2f Mtris/s | x%.2f\n", data.indices.size() / 3, meshlets.size(),
+               data.indices.size() / 3.0 / meshlets.size(), threads, best, data.indices.size() / 3 / (best * 1e3), singleThread / best);
+    }
+}
+
+/*
+Triangles of every level of detail as sorted vertex positions, rotated to start at the smallest vertex, so that levels
+can be compared regardless of vertex and triangle order.
+*/
+static std::vector<std::vector<std::array<float, 9>>> get_LOD_triangles(const MeshData &data)
+{
+    std::vector<std::vector<std::array<float, 9>>> levels;
+    for (const LODLevel &level : data.LODs)
+    {
+        std::vector<std::array<float, 9>> triangles;
+        for (const Submesh &submesh : level.submeshes)
+            for (size_t i = submesh.indexOffset; i + 2 < size_t(submesh.indexOffset) + submesh.indexCount; i += 3)
+            {
+                std::array<glm::vec3, 3> corners;
+                for (int c = 0; c < 3; c++)
+                    corners[c] = data.vertices[data.indices[i + c] + submesh.baseVertex].position;
+                auto less = [](const glm::vec3 &a, const glm::vec3 &b)
+                { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+                const int first = int(std::min_element(corners.begin(), corners.end(), less) - corners.begin());
+                std::array<float, 9> triangle;
+                for (int c = 0; c < 3; c++)
+                    for (int axis = 0; axis < 3; axis++)
+                        triangle[c * 3 + axis] = corners[(first + c) % 3][axis];
+                triangles.push_back(triangle);
+            }
+        std::sort(triangles.begin(), triangles.end());
+        levels.push_back(std::move(triangles));
+    }
+    return levels;
+}
+
+static void print_LODs(const char *name, const MeshData &data, size_t triangles, double ms)
+{
+    printf("%-48s %9zu tris | %9.2f ms %6.2f Mtris/s |", name, triangles, ms, triangles / (ms * 1e3));
+    for (const LODLevel &level : data.LODs)
+    {
+        size_t levelTriangles = 0;
+        for (const Submesh &submesh : level.submeshes)
+            levelTriangles += submesh.indexCount / 3;
+        printf(" %zu (%.2e)", levelTriangles, level.error);
+    }
+    printf("\n");
+}
+
+/*
+Simplification into 3 levels (1/2, 1/4, 1/8), printing triangles and object space error of each one.
+*/
+static void bench_LODs(const std::string &path)
+{
+    MeshData data;
+    loaders::parse_OBJ(path.c_str(), data);
+    const size_t triangles = data.indices.size() / 3;
+    utils::ManualTimer timer;
+    timer.start();
+    processing::generate_LODs(data);
+    timer.stop();
+    print_LODs(get_file_name(path).c_str(), data, triangles, timer.get());
+}
+
+static void bench_LODs(size_t triangles)
+{
+    MeshData data = make_synthetic_grid(triangles);
+    triangles = data.indices.size() / 3;
+    utils::ManualTimer timer;
+    timer.start();
+    processing::generate_LODs(data);
+    timer.stop();
+    print_LODs("synthetic grid", data, triangles, timer.get());
+
+    // Reordering for the vertex cache must keep every level drawing the same triangles
+    MeshData optimized = data;
+    processing::optimize_mesh(optimized);
+    printf("%-48s %9zu tris | levels after optimize_mesh %s\n", "synthetic grid", triangles,
+           get_LOD_triangles(optimized) == get_LOD_triangles(data) ? "match" : "MISMATCH");
+}
+
+/*
+Parses once, writes the binary cache and measures how long it takes to get a Geometry back from it.
+*/
+static void bench_mesh_cache(const std::string &path, int runs)
+{
+    const double sizeMB = std::filesystem::file_size(path) * 1e-6;
+    const uint64_t options = 0;
+
+    MeshData data;
+    loaders::parse_OBJ(path.c_str(), data);
+    cache::store_mesh(path.c_str(), options, data);
+
+    double best = 1e30;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        Geometry *geometry = cache::load_mesh(path.c_str(), options);
+        timer.stop();
+        best = std::min(best, timer.get());
+        delete geometry;
+    }
+    std::filesystem::remove(cache::get_mesh_cache_path(path.c_str(), options));
+
+    printf("%-48s %9.2f MB | mapped cache %9.4f ms\n", get_file_name(path).c_str(), sizeMB, best);
+}
+
+/*
+Mip chain generation of a synthetic RGBA image with both filters, scaling the thread count like bench_tangents.
+*/
+static void bench_mip_chain(int size, int runs)
+{
+    bench::reset_peak_RSS();
+    std::vector<unsigned char> pixels(size_t(size) * size * 4);
+    uint32_t state = 0x12345678u;
+    for (unsigned char &p : pixels)
+    {
+        state = state * 1664525u + 1013904223u;
+        p = static_cast<unsigned char>(state >> 24);
+    }
+
+    const char *filters[] = {"box", "kaiser"};
+    for (int filter = processing::MIP_FILTER_BOX; filter <= processing::MIP_FILTER_KAISER; filter++)
+    {
+        double singleThread = 0.0;
+        for (unsigned int threads = 1; threads <= utils::get_thread_count(); threads *= 2)
+        {
+            processing::MipSettings settings;
+            settings.filter = static_cast<processing::MipFilter>(filter);
+            settings.threadCount = threads;
+            processing::MipChain chain;
+            std::vector<double> samples;
+            for (int run = 0; run < runs; run++)
+            {
+                utils::ManualTimer timer;
+                timer.start();
+                processing::generate_mip_chain(pixels.data(), {size, size}, 4, chain, settings);
+                timer.stop();
+                samples.push_back(timer.get());
+            }
+            REPORT.add("mip chain", std::to_string(size) + " " + filters[filter] + " " + std::to_string(threads) + " threads", samples,
+                       double(size) * size * 1e-6, "Mpixels");
+            const double best = bench::best(samples);
+            if (threads == 1)
+                singleThread = best;
+            printf("%5dx%-5d %-6s | %2zu levels | %2u threads %9.2f ms %8.2f Mpixels/s | x%.2f\n", size, size, filters[filter], chain.get_level_count(),
+                   threads, best, double(size) * size / (best * 1e3), singleThread / best);
+        }
+    }
+}
+
+/*
+Decoding an image against mapping its cached mip chain and reading every level, as the upload would.
+*/
+static void bench_texture_cache(const std::string &path, int runs)
+{
+    bench::reset_peak_RSS();
+    const processing::MipSettings settings;
+    const uint64_t options = 0;
+
+    const double sizeMB = std::filesystem::file_size(path) * 1e-6;
+    std::vector<double> decodeRuns;
+    Image img;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        loaders::decode_image(path.c_str(), img);
+        timer.stop();
+        decodeRuns.push_back(timer.get());
+        if (run + 1 < runs)
+            stbi_image_free(img.data);
+    }
+    REPORT.add("image loading", get_file_name(path) + " decode", decodeRuns, sizeMB, "MB");
+    const double decode = bench::best(decodeRuns);
+
+    processing::MipChain chain;
+    utils::ManualTimer timer;
+    timer.start();
+    processing::generate_mip_chain(img.data, img.extent, img.channels, chain, settings);
+    timer.stop();
+    const double generate = timer.get();
+    stbi_image_free(img.data);
+    cache::store_texture(path.c_str(), options, chain);
+
+    std::vector<double> mappedRuns;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        TextureLevels levels;
+        cache::load_texture(path.c_str(), options, levels);
+        for (size_t level = 0; level < levels.get_level_count(); level++)
+            utils::hash_bytes(levels.data[level], chain.get_level_size(level)); // Touch every page
+        timer.stop();
+        mappedRuns.push_back(timer.get());
+    }
+    std::filesystem::remove(cache::get_texture_cache_path(path.c_str(), options));
+    REPORT.add("image loading", get_file_name(path) + " mapped cache", mappedRuns, sizeMB, "MB");
+    const double mapped = bench::best(mappedRuns);
+
+    printf("%-24s %5dx%-5d | decode %8.2f ms | mip chain %8.2f ms | mapped cache %2zu levels %8.2f ms\n", get_file_name(path).c_str(),
+           img.extent.width, img.extent.height, decode, generate, chain.get_level_count(), mapped);
+}
+
+/*
+PSNR over the channels a block format stores, against the source expanded like the GPU samples it.
+*/
+static double compute_block_PSNR(const Image &img, const std::vector<unsigned char> &decoded, unsigned int channels)
+{
+    const size_t texels = size_t(img.extent.width) * img.extent.height;
+    double error = 0.0;
+    for (size_t i = 0; i < texels; i++)
+        for (unsigned int c = 0; c < channels; c++)
+        {
+            const double source = c < unsigned(img.channels) ? img.data[i * img.channels + c] : (c == 3 ? 255.0 : 0.0);
+            const double difference = source - decoded[i * 4 + c];
+            error += difference * difference;
+        }
+    error /= double(texels) * channels;
+    return error > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / error) : 99.0;
+}
+
+/*
+Block compression of a real image in every format and quality preset, with encoding throughput and PSNR.
+*/
+static void bench_block_compression(const std::string &path)
+{
+    Image img;
+    if (!loaders::decode_image(path.c_str(), img))
+        return;
+
+    const char *formats[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+    const unsigned int channels[] = {3, 4, 1, 2, 4};
+    const char *qualities[] = {"fast", "normal", "high"};
+    std::vector<unsigned char> blocks, decoded(size_t(img.extent.width) * img.extent.height * 4);
+    for (int format = processing::BLOCK_FORMAT_BC1; format <= processing::BLOCK_FORMAT_BC7; format++)
+        for (int quality = processing::BLOCK_QUALITY_FAST; quality <= processing::BLOCK_QUALITY_HIGH; quality++)
+        {
+            processing::BlockCompressionSettings settings;
+            settings.format = static_cast<processing::BlockFormat>(format);
+            settings.quality = static_cast<processing::BlockQuality>(quality);
+            utils::ManualTimer timer;
+            timer.start();
+            processing::compress_blocks(img.data, img.extent, img.channels, blocks, settings);
+            timer.stop();
+            processing::decompress_blocks(blocks.data(), img.extent, settings.format, decoded.data());
+
+            printf("%-24s %5dx%-5d %s %-6s | %9.2f ms %8.2f Mpixels/s | %6.2f MB | PSNR %6.2f dB\n", get_file_name(path).c_str(),
+                   img.extent.width, img.extent.height, formats[format], qualities[quality], timer.get(), double(img.extent.width) * img.extent.height / (timer.get() * 1e3),
+                   blocks.size() * 1e-6, compute_block_PSNR(img, decoded, channels[format]));
+        }
+    stbi_image_free(img.data);
+}
+
+/*
+Panorama to cubemap projection of a synthetic HDR sky, scaling the thread count like bench_tangents.
+*/
+static void bench_panorama(Extent2D extent, int resolution, int runs)
+{
+    std::vector<float> pixels(size_t(extent.width) * extent.height * 3);
+    for (int y = 0; y < extent.height; y++)
+        for (int x = 0; x < extent.width; x++)
+        {
+            float *texel = pixels.data() + (size_t(y) * extent.width + x) * 3;
+            const float elevation = 1.0f - float(y) / extent.height;
+            texel[0] = 0.2f + elevation * 4.0f;
+            texel[1] = 0.3f + elevation * 5.0f * (0.5f + 0.5f * std::sin(x * 0.01f));
+            texel[2] = 0.5f + elevation * 8.0f;
+        }
+
+    double singleThread = 0.0;
+    for (unsigned int threads = 1; threads <= utils::get_thread_count(); threads *= 2)
+    {
+        processing::CubemapSettings settings;
+        settings.resolution = resolution;
+        settings.threadCount = threads;
+        processing::CubemapData cubemap;
+        double best = 1e30;
+        for (int run = 0; run < runs; run++)
+        {
+            utils::ManualTimer timer;
+            timer.start();
+            processing::panorama_to_cubemap(pixels.data(), extent, 3, cubemap, settings);
+            timer.stop();
+            best = std::min(best, timer.get());
+        }
+        if (threads == 1)
+            singleThread = best;
+        printf("%5dx%-5d -> 6x%-5d | %2zu levels | %2u threads %9.2f ms %8.2f Mtexels/s | x%.2f\n", extent.width, extent.height, resolution,
+               cubemap.faces[0].get_level_count(), threads, best, 6.0 * resolution * resolution / (best * 1e3), singleThread / best);
+    }
+}
+
+/*
+Spherical harmonics irradiance of a projected sky, at the face sizes the projection can be given.
+*/
+static void bench_irradiance_SH(int resolution, int runs)
+{
+    std::vector<float> pixels(size_t(resolution) * 4 * resolution * 2 * 3);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = 0.5f + float(i % 977) / 977.0f;
+    processing::CubemapSettings settings;
+    settings.resolution = resolution;
+    settings.tonemap = false;
+    processing::CubemapData cubemap;
+    processing::panorama_to_cubemap(pixels.data(), {resolution * 4, resolution * 2}, 3, cubemap, settings);
+
+    SphericalHarmonics sh;
+    processing::CubemapData baked;
+    double project = 1e30, bake = 1e30;
+    for (int run = 0; run < runs; run++)
+    {
+        utils::ManualTimer timer;
+        timer.start();
+        processing::project_irradiance_SH(cubemap, sh, resolution);
+        timer.stop();
+        project = std::min(project, timer.get());
+        timer.start();
+        processing::bake_irradiance_SH(sh, 32, baked);
+        timer.stop();
+        bake = std::min(bake, timer.get());
+    }
+    printf("6x%-5d | project %8.3f ms %8.2f Mtexels/s | bake 6x32 %6.3f ms\n", resolution, project, 6.0 * resolution * resolution / (project * 1e3), bake);
+}
+
+/*
+GGX prefiltering of a projected sky with a bright spot, and the BRDF lookup table, against mapping their baked caches.
+*/
+static void bench_specular(int resolution, unsigned int sampleCount)
+{
+    std::vector<float> pixels(size_t(resolution) * 8 * resolution * 4 * 3, 1.0f);
+    for (int y = 10; y < 20; y++)
+        for (int x = 100; x < 110; x++)
+            for (int c = 0; c < 3; c++)
+                pixels[(size_t(y) * resolution * 8 + x) * 3 + c] = 500.0f;
+    processing::CubemapSettings cubemapSettings;
+    cubemapSettings.resolution = resolution * 2;
+    cubemapSettings.tonemap = false;
+    processing::CubemapData environment;
+    processing::panorama_to_cubemap(pixels.data(), {resolution * 8, resolution * 4}, 3, environment, cubemapSettings);
+
+    processing::SpecularSettings settings;
+    settings.resolution = resolution;
+    settings.sampleCount = sampleCount;
+    processing::CubemapData prefiltered;
+    processing::MipChain lut;
+    utils::ManualTimer timer;
+    timer.start();
+    processing::prefilter_specular(environment, prefiltered, settings);
+    timer.stop();
+    const double prefilter = timer.get();
+    timer.start();
+    processing::integrate_BRDF(256, sampleCount, lut);
+    timer.stop();
+    const double integrate = timer.get();
+
+    const uint64_t contentHash = utils::hash_bytes(&resolution, sizeof(resolution), 0xBE7C);
+    cache::store_baked(contentHash, sampleCount, prefiltered.faces, 6);
+    TextureLevels levels;
+    timer.start();
+    const bool hit = cache::load_baked(contentHash, sampleCount, 6, levels);
+    timer.stop();
+    std::remove(cache::get_baked_cache_path(contentHash, sampleCount).c_str());
+
+    printf("6x%-4d %zu levels %4u samples | prefilter %9.2f ms | BRDF LUT 256 %8.2f ms | baked cache %s %6.3f ms\n", resolution,
+           prefiltered.faces[0].get_level_count(), sampleCount, prefilter, integrate, hit ? "hit" : "miss", timer.get());
+}
+
+static void bench_file_watcher(size_t fileCount, int runs)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "glsp_bench_watch";
+    std::filesystem::create_directories(directory);
+    utils::FileWatcher watcher;
+    std::vector<std::string> files;
+    for (size_t i = 0; i < fileCount; i++)
+    {
+        files.push_back((directory / ("asset" + std::to_string(i) + ".txt")).string());
+        std::ofstream(files.back()) << i;
+        watcher.add(files.back());
+    }
+    std::vector<std::string> changed;
+    watcher.poll(changed);
+
+    const int POLLS = 1000;
+    utils::ManualTimer timer;
+    timer.start();
+    for (int i = 0; i < POLLS; i++)
+        watcher.poll(changed);
+    timer.stop();
+    const double idle = timer.get() * 1e3 / POLLS;
+
+    // Saved like editors do, written aside and renamed over the original
+    double latency = 1e30;
+    bool detected = true;
+    for (int run = 0; run < runs; run++)
+    {
+        const std::string &target = files[run % fileCount];
+        changed.clear();
+        timer.start();
+        std::ofstream(target + ".swap") << "edit " << run;
+        std::filesystem::rename(target + ".swap", target);
+        while (watcher.poll(changed) == 0 && timer.get() < 2000.0)
+            timer.stop();
+        timer.stop();
+        detected = detected && changed.size() == 1 && changed[0] == utils::FileWatcher::get_absolute_path(target);
+        latency = std::min(latency, timer.get());
+    }
+    std::filesystem::remove_all(directory);
+    printf("%6zu files | idle poll %8.2f us | save to detection %8.3f ms | %s\n", fileCount, idle, latency, detected ? "detected" : "MISSED");
+}
+
+/*
+Out of core octree build of the vertices of a synthetic PLY taken as a point cloud, with a small distribution budget
+so chunks are flushed many times, and node selection for a view over the cloud.
+*/
+static void bench_point_octree(const std::string &path, size_t memoryBudgetMB)
+{
+    bench::reset_peak_RSS();
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "glsp_bench_octree";
+    PointOctreeSettings settings;
+    settings.memoryBudget = memoryBudgetMB << 20;
+    settings.chunkPoints = 1 << 20;
+
+    utils::ManualTimer timer;
+    timer.start();
+    const bool built = PointCloud::build_octree(path.c_str(), directory.string().c_str(), settings);
+    timer.stop();
+    const double build = timer.get();
+
+    PointCloud cloud(directory.string().c_str());
+    REPORT.add("point octree", get_file_name(path) + " build", {build}, cloud.get_point_count() * 1e-6, "Mpoints");
+    uint64_t stored = 0;
+    unsigned int depth = 0;
+    for (const PointCloudNode &node : cloud.get_nodes())
+    {
+        stored += node.pointCount;
+        depth = std::max<unsigned int>(depth, node.level);
+    }
+
+    Camera camera(1920, 1080, {0.0f, 20.0f, -60.0f});
+    camera.set_rotation({-90.0f, -20.0f, 0.0f});
+    timer.start();
+    const std::vector<uint32_t> &visible = cloud.select_nodes(camera.get_view(), camera.get_projection(), 1080.0f);
+    timer.stop();
+    size_t selected = 0;
+    for (const uint32_t node : visible)
+        selected += cloud.get_nodes()[node].pointCount;
+
+    std::filesystem::remove_all(directory);
+    printf("%-32s %4zu MB budget | build %9.2f ms %8.2f Mpoints/s | %6zu nodes depth %2u | select %6.3f ms %6zu nodes %9zu points | %s\n",
+           get_file_name(path).c_str(), memoryBudgetMB, build, cloud.get_point_count() / (build * 1e3),
+           cloud.get_nodes().size(), depth, timer.get(), visible.size(), selected,
+           built && stored == cloud.get_point_count() ? "match" : "MISMATCH");
+}
+
+int main(int argc, char **argv)
+{
+    // Usage: glsp_bench [runs] [synthetic sizes in MB...] [--triangles count]... [--json path]
+    int runs = 3;
+    std::vector<size_t> syntheticMB, syntheticTriangles;
+    std::string jsonPath;
+    bool runsGiven = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (arg == "--triangles" && i + 1 < argc)
+            syntheticTriangles.push_back(static_cast<size_t>(atoll(argv[++i])));
+        else if (!runsGiven)
+        {
+            runs = std::max(1, atoi(argv[i]));
+            runsGiven = true;
+        }
+        else
+            syntheticMB.push_back(static_cast<size_t>(atoi(argv[i])));
+    }
+    if (syntheticMB.empty())
+        syntheticMB = {16, 128};
+    if (syntheticTriangles.empty())
+        syntheticTriangles = {1000000, 4000000};
+    bench::reset_peak_RSS();
+
+    printf("File reading (hash of every byte), best of %d runs\n", runs);
+    for (size_t mb : syntheticMB)
+        bench_file_reading(write_synthetic_OBJ(mb), runs);
+
+    printf("\nOBJ import, best of %d runs, %u threads\n", runs, utils::get_thread_count());
+    bench_OBJ(RESOURCES_PATH "meshes/boat.obj", runs);
+    for (size_t mb : syntheticMB)
+        bench_OBJ(write_synthetic_OBJ(mb), runs);
+
+    printf("\nPLY import, best of %d runs\n", runs);
+    for (size_t mb : syntheticMB)
+        bench_PLY(write_synthetic_PLY(mb), runs);
+
+    printf("\nglTF import (binary, interleaved), best of %d runs\n", runs);
+    for (size_t triangles : syntheticTriangles)
+        bench_GLTF(write_synthetic_GLB(triangles), runs);
+
+    printf("\nTangent generation, best of %d runs\n", runs);
+    for (size_t triangles : syntheticTriangles)
+        bench_tangents(triangles, runs);
+
+    printf("\nVertex deduplication (welding a triangle soup), best of %d runs\n", runs);
+    for (size_t triangles : syntheticTriangles)
+        bench_weld(triangles, runs);
+
+    printf("\nMesh optimization (FIFO 16 vertex cache)\n");
+    bench_mesh_optimization(RESOURCES_PATH "meshes/boat.obj");
+    for (size_t mb : syntheticMB)
+        bench_mesh_optimization(write_synthetic_OBJ(mb));
+
+    printf("\nVertex quantization (max errors)\n");
+    bench_quantization(RESOURCES_PATH "meshes/boat.obj");
+    for (size_t mb : syntheticMB)
+        bench_quantization(write_synthetic_OBJ(mb));
+
+    printf("\nMeshlet build (64 vertices / 124 triangles), best of %d runs\n", runs);
+    for (size_t triangles : syntheticTriangles)
+        bench_meshlets(triangles, runs);
+
+    printf("\nLOD generation, levels as triangles (error)\n");
+    bench_LODs(RESOURCES_PATH "meshes/boat.obj");
+    bench_LODs(syntheticTriangles.front());
+
+    printf("\nBinary mesh cache, best of %d runs\n", runs);
+    bench_mesh_cache(RESOURCES_PATH "meshes/boat.obj", runs);
+    for (size_t mb : syntheticMB)
+        bench_mesh_cache(write_synthetic_OBJ(mb), runs);
+
+    printf("\nMip chain generation, best of %d runs\n", runs);
+    bench_mip_chain(2048, runs);
+
+    printf("\nTexture cache, best of %d runs\n", runs);
+    bench_texture_cache(RESOURCES_PATH "textures/wing.png", runs);
+    bench_texture_cache(RESOURCES_PATH "textures/heightTerrain.png", runs);
+
+    printf("\nBlock compression, %u threads\n", utils::get_thread_count());
+    bench_block_compression(RESOURCES_PATH "textures/wing.png");
+
+    printf("\nPanorama to cubemap (bilinear, tonemapped, with mips), best of %d runs\n", runs);
+    bench_panorama({2048, 1024}, 512, runs);
+    bench_panorama({4096, 2048}, 1024, runs);
+
+    printf("\nSpherical harmonics irradiance, best of %d runs\n", runs);
+    bench_irradiance_SH(64, runs);
+    bench_irradiance_SH(128, runs);
+    bench_irradiance_SH(512, runs);
+
+    printf("\nSpecular prefiltering and BRDF integration\n");
+    bench_specular(64, 128);
+    bench_specular(128, 256);
+
+    printf("\nFile watcher (hot reload), best of %d runs\n", runs);
+    bench_file_watcher(16, runs);
+    bench_file_watcher(1024, runs);
+
+    printf("\nPoint cloud octree (out of core build, view selection)\n");
+    for (size_t mb : syntheticMB)
+        bench_point_octree(write_synthetic_PLY(mb), 16);
+
+    if (!jsonPath.empty())
+    {
+        if (!REPORT.write_JSON(jsonPath, runs, utils::get_thread_count()))
+        {
+            fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+            return 1;
+        }
+        printf("\n%zu measurements written to %s\n", REPORT.get_measurements().size(), jsonPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#ifndef __BENCH_REPORT__
+#define __BENCH_REPORT__
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace bench
+{
+    /*
+    Peak resident set size of the process in bytes.
+    */
+    inline size_t get_peak_RSS()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#elif defined(__linux__)
+        // VmHWM, unlike getrusage, can be reset
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+            if (line.compare(0, 6, "VmHWM:") == 0)
+                return size_t(std::stoull(line.substr(6))) * 1024;
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return size_t(usage.ru_maxrss) * 1024;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return size_t(usage.ru_maxrss); // Bytes on macOS
+#endif
+    }
+
+    /*
+    Restarts the peak at the current resident size, so that it can be attributed to the next measurement. Only
+    Linux allows it, elsewhere peaks are those of the whole process so far.
+    */
+    inline void reset_peak_RSS()
+    {
+#ifdef __linux__
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+    }
+
+    /*
+    Value at the given fraction of the sorted samples, interpolating between the closest ones.
+    */
+    inline double percentile(std::vector<double> samples, double fraction)
+    {
+        if (samples.empty())
+            return 0.0;
+        std::sort(samples.begin(), samples.end());
+        const double position = fraction * double(samples.size() - 1);
+        const size_t below = size_t(position);
+        const size_t above = std::min(below + 1, samples.size() - 1);
+        return samples[below] + (samples[above] - samples[below]) * (position - double(below));
+    }
+
+    inline double best(const std::vector<double> &samples)
+    {
+        return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+    }
+
+    struct Measurement
+    {
+        std::string suite;
+        std::string name;
+        std::vector<double> milliseconds; // Every run
+        double work;                      // Done in a run, in units
+        std::string unit;
+        size_t peakRSS; // Since the previous measurement or the start of its benchmark
+    };
+
+    /*
+    Collects the runs of every benchmark and writes them as JSON, with throughput at the median, p50 and p99
+    latencies and peak RSS, so that results can be compared across releases.
+    */
+    class Report
+    {
+        std::vector<Measurement> m_measurements;
+
+        static std::string escape(const std::string &text)
+        {
+            std::string escaped;
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    escaped += '\\';
+                if (static_cast<unsigned char>(c) >= 0x20)
+                    escaped += c;
+            }
+            return escaped;
+        }
+
+    public:
+        /*
+        Records the runs of a measurement. Work is what a single run processes, in the given unit (MB, Mtris...).
+        */
+        void add(const std::string &suite, const std::string &name, const std::vector<double> &milliseconds, double work, const std::string &unit)
+        {
+            m_measurements.push_back({suite, name, milliseconds, work, unit, get_peak_RSS()});
+            reset_peak_RSS();
+        }
+
+        inline const std::vector<Measurement> &get_measurements() const { return m_measurements; }
+
+        bool write_JSON(const std::string &path, int runs, unsigned int threads) const
+        {
+            FILE *file = fopen(path.c_str(), "w");
+            if (!file)
+                return false;
+            fprintf(file, "{\n  \"runs\": %d,\n  \"threads\": %u,\n  \"benchmarks\": [", runs, threads);
+            for (size_t i = 0; i < m_measurements.size(); i++)
+            {
+                const Measurement &m = m_measurements[i];
+                const double p50 = percentile(m.milliseconds, 0.5);
+                double mean = 0.0;
+                for (const double ms : m.milliseconds)
+                    mean += ms / double(m.milliseconds.size());
+                fprintf(file, "%s\n    {\"suite\": \"%s\", \"name\": \"%s\", \"runs\": %zu, \"min_ms\": %.6f, \"p50_ms\": %.6f, \"p99_ms\": %.6f, "
+                              "\"mean_ms\": %.6f, \"work\": %.6f, \"throughput\": %.6f, \"unit\": \"%s/s\", \"peak_rss_bytes\": %zu}",
+                        i ? "," : "", escape(m.suite).c_str(), escape(m.name).c_str(), m.milliseconds.size(), best(m.milliseconds), p50,
+                        percentile(m.milliseconds, 0.99), mean, m.work, p50 > 0.0 ? m.work / (p50 * 1e-3) : 0.0, escape(m.unit).c_str(), m.peakRSS);
+            }
+            fprintf(file, "\n  ]\n}\n");
+            return fclose(file) == 0;
+        }
+    };
+}
+
+#endif
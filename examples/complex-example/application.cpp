@@ -13,11 +13,8 @@ void Application::init()
 #pragma endregion;
 #pragma region SHADER PIPELINES
     // Uniform buffers creation
-    m_cameraUBO = new UniformBuffer(sizeof(CameraUniforms), UBOLayout::CAMERA_LAYOUT);
-    m_cameraUBO->generate();
-
-    m_globalUBO = new UniformBuffer(sizeof(GlobalUniforms), UBOLayout::GLOBAL_LAYOUT);
-    m_globalUBO->generate();
+    m_frameUniforms = new RingBuffer(1024);
+    m_frameUniforms->generate();
 
     Material *birdMaterial;
     Material *terrainMaterial;
@@ -120,24 +117,23 @@ void Application::init()
     m_seagulls.mesh = new Mesh();
 
     // Not interleaved attributes because compute shader doesnt handle them well as storage buffers
-    const size_t BYTES = seagullPos.size() * sizeof(float);
-    
-    VertexBuffer posVBO(seagullPos.data(), BYTES);
+    // Vectors are adopted by the buffers, not copied
+    VertexBuffer posVBO(std::move(seagullPos));
     posVBO.push_attribute_layout<float>(4); // 4 as vec4
-    VertexBuffer upVBO(seagullUp.data(), BYTES);
+    VertexBuffer upVBO(std::move(seagullUp));
     upVBO.push_attribute_layout<float>(4);
-    VertexBuffer forwardVBO(seagullForward.data(), BYTES);
+    VertexBuffer forwardVBO(std::move(seagullForward));
     forwardVBO.push_attribute_layout<float>(4);
-    VertexBuffer varianzeVBO(seagullVarianze.data(), BYTES);
+    VertexBuffer varianzeVBO(std::move(seagullVarianze));
     varianzeVBO.push_attribute_layout<float>(4);
 
     VertexArray flockVAO;
-    flockVAO.push_vertex_buffer(posVBO);
-    flockVAO.push_vertex_buffer(upVBO);
-    flockVAO.push_vertex_buffer(forwardVBO);
-    flockVAO.push_vertex_buffer(varianzeVBO);
+    flockVAO.push_vertex_buffer(std::move(posVBO));
+    flockVAO.push_vertex_buffer(std::move(upVBO));
+    flockVAO.push_vertex_buffer(std::move(forwardVBO));
+    flockVAO.push_vertex_buffer(std::move(varianzeVBO));
 
-    m_seagulls.mesh->set_geometry(new Geometry(flockVAO, NUM_SEAGULLS, GL_POINTS));
+    m_seagulls.mesh->set_geometry(new Geometry(std::move(flockVAO), NUM_SEAGULLS, GL_POINTS));
 
     m_seagulls.mesh->set_material(birdMaterial);
     m_seagulls.mesh->set_position({-2.0f, 18.0f, 0.0f});
@@ -145,12 +141,10 @@ void Application::init()
 
     // Setting textures for the birds
     Texture *seagullBody = new Texture();
-    loaders::load_image(seagullBody, RESOURCES_PATH "textures/seagull.png");
-    seagullBody->generate();
+    loaders::load_image_async(seagullBody, RESOURCES_PATH "textures/seagull.png");
     birdMaterial->set_texture("u_bodyT", seagullBody);
     Texture *seagullWing = new Texture();
-    loaders::load_image(seagullWing, RESOURCES_PATH "textures/wing.png");
-    seagullWing->generate();
+    loaders::load_image_async(seagullWing, RESOURCES_PATH "textures/wing.png");
     birdMaterial->set_texture("u_wingT", seagullWing, 1);
 
     // ---------------- Terrain --------------
@@ -159,15 +153,13 @@ void Application::init()
     m_terrain->set_material(terrainMaterial);
     m_terrain->set_scale(100.0f);
     Texture *heightTerrainTexture = new Texture();
-    loaders::load_image(heightTerrainTexture, RESOURCES_PATH "textures/heightTerrain.png");
-    heightTerrainTexture->generate();
+    loaders::load_image_async(heightTerrainTexture, RESOURCES_PATH "textures/heightTerrain.png");
     terrainMaterial->set_texture("u_heightMap", heightTerrainTexture);
-    TextureConfig jpgConfig{};
-    jpgConfig.format = GL_RGB;
-    jpgConfig.internalFormat = GL_RGB16;
-    Texture *terrainTexture = new Texture(jpgConfig);
-    loaders::load_image(terrainTexture, RESOURCES_PATH "textures/terrain.jpg");
-    terrainTexture->generate();
+    // Albedo only needs rgb. BC1 keeps it at 4 bits per texel with its mips precomputed in the texture cache
+    processing::BlockCompressionSettings albedoCompression{};
+    albedoCompression.format = processing::BLOCK_FORMAT_BC1;
+    Texture *terrainTexture = new Texture();
+    loaders::load_texture_async(terrainTexture, RESOURCES_PATH "textures/terrain.jpg", {}, &albedoCompression);
     terrainMaterial->set_texture("u_albedoT", terrainTexture, 1);
 
     // ----------- WATER --------------
@@ -183,11 +175,10 @@ void Application::init()
 
     // --------- BOAT ---------
     m_boat = new Mesh();
-    loaders::load_OBJ(m_boat, RESOURCES_PATH "meshes/boat.obj");
+    loaders::load_OBJ_async(m_boat, RESOURCES_PATH "meshes/boat.obj");
     m_boat->set_material(boatMaterial);
     Texture *boatTexture = new Texture();
-    loaders::load_image(boatTexture, RESOURCES_PATH "textures/boatColor.png");
-    boatTexture->generate();
+    loaders::load_image_async(boatTexture, RESOURCES_PATH "textures/boatColor.png");
     boatMaterial->set_texture("u_albedoT", boatTexture);
     m_boat->set_scale(0.3);
     m_boat->set_position({0.2, 0.95, -16.0});
@@ -207,7 +198,7 @@ void Application::update()
     m_compute->bind();
     if (m_seagulls.mesh->get_geometry()->is_buffer_loaded())
     {
-        VertexArray seagullsVAO = m_seagulls.mesh->get_geometry()->get_VAO();
+        const VertexArray &seagullsVAO = m_seagulls.mesh->get_geometry()->get_VAO();
         seagullsVAO.get_vertex_buffers().front().bind_base(GL_SHADER_STORAGE_BUFFER, 0); // Bind position vbo
         seagullsVAO.get_vertex_buffers()[2].bind_base(GL_SHADER_STORAGE_BUFFER, 1);  // Bind forward vbo
         seagullsVAO.get_vertex_buffers().back().bind_base(GL_SHADER_STORAGE_BUFFER, 2);  // Bind velosity diff vbo
@@ -247,6 +238,8 @@ void Application::draw()
     // Blit msaa to default backbuffer
     Framebuffer::blit(m_multisampledFBO, nullptr,
                       GL_COLOR_BUFFER_BIT, GL_NEAREST, m_window.extent, m_window.extent);
+
+    m_frameUniforms->end_frame();
 }
 #pragma endregion
 #pragma region UNIFORM UPDATE
@@ -254,10 +247,11 @@ void Application::update_uniforms()
 {
 
     // Setup UBOs
+    m_frameUniforms->begin_frame();
     CameraUniforms camu;
     camu.vp = m_camera->get_projection() * m_camera->get_view();
     camu.v = m_camera->get_view();
-    m_cameraUBO->upload_data(sizeof(CameraUniforms), &camu);
+    m_frameUniforms->bind_range(GL_UNIFORM_BUFFER, UBOLayout::CAMERA_LAYOUT, m_frameUniforms->upload(&camu, sizeof(CameraUniforms)));
 
     GlobalUniforms globu;
     globu.ambient = {m_scene.ambientColor,
@@ -265,7 +259,7 @@ void Application::update_uniforms()
     glm::vec3 vLightPos = camu.v * glm::vec4(m_scene.lightPos, 1.0);
     globu.lightPos = {vLightPos, m_scene.lightIntensity};
     globu.lightColor = {m_scene.lightColor, m_scene.fogIntensity};
-    m_globalUBO->upload_data(sizeof(GlobalUniforms), &globu);
+    m_frameUniforms->bind_range(GL_UNIFORM_BUFFER, UBOLayout::GLOBAL_LAYOUT, m_frameUniforms->upload(&globu, sizeof(GlobalUniforms)));
 
     // Update material uniforms
     MaterialUniforms terrainU;
@@ -92,8 +92,7 @@ private:
         CAMERA_LAYOUT = 0,
         GLOBAL_LAYOUT = 1,
     };
-    UniformBuffer *m_cameraUBO;
-    UniformBuffer *m_globalUBO;
+    RingBuffer *m_frameUniforms; // Camera and global UBOs, rewritten every frame
 
     GraphicPipeline m_wavePipeline{};  //No need to embed it in a material, low level functionality
     ComputeShader* m_compute;
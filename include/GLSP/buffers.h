@@ -12,6 +12,7 @@
 #define __BUFFERS__
 
 #include <vector>
+#include <memory>
 #include <GLSP/core.h>
 
 GLSP_NAMESPACE_BEGIN
@@ -24,17 +25,31 @@ class VertexArray;
 class UniformBuffer;
 
 /*
-Base abstract class for buffer objects
+Base abstract class for buffer objects. Buffers own their GL object, so they can be moved but not copied. Moving
+into an existing buffer swaps their objects, and the moved from one releases the old object.
 */
 class Buffer
 {
 protected:
-    unsigned int m_id;
+    unsigned int m_id{0};
 
     bool m_generated{false};
 
 public:
     Buffer() {}
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    Buffer(Buffer &&other) noexcept : m_id(other.m_id), m_generated(other.m_generated)
+    {
+        other.m_id = 0;
+        other.m_generated = false;
+    }
+    Buffer &operator=(Buffer &&other) noexcept
+    {
+        std::swap(m_id, other.m_id);
+        std::swap(m_generated, other.m_generated);
+        return *this;
+    }
 
     virtual void generate() = 0;
     virtual void bind() const = 0;
@@ -53,6 +68,8 @@ struct AttributeLayout
     unsigned int type;
     size_t count;
     unsigned char normalized;
+    int location{-1}; // Shader location. If negative it takes the next one in the vertex array
+    int offset{-1};   // Byte offset of the first element in the buffer. If negative it follows the previous layout
 
     static size_t get_size(unsigned int type)
     {
@@ -64,6 +81,14 @@ struct AttributeLayout
             return 4;
         case GL_UNSIGNED_BYTE:
             return 1;
+        case GL_BYTE:
+            return 1;
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_SHORT:
+            return 2;
+        case GL_HALF_FLOAT:
+            return 2;
         }
         ASSERT(false);
         return 0;
@@ -78,11 +103,36 @@ class VertexBuffer : public Buffer
     std::vector<AttributeLayout> m_layouts;
     size_t m_strideBytes;
     size_t m_totalBytes;
-    void *m_data;
+    const void *m_data;
+    std::shared_ptr<const void> m_storage; // Keeps the data alive, shared with hot reloaded buffers
 
 public:
-    VertexBuffer(void *data, const size_t sizeInBytes);
+    /*
+    Copies the data.
+    */
+    VertexBuffer(const void *data, const size_t sizeInBytes);
+    /*
+    References externally owned data without copying it (e.g. a memory mapped file), kept alive by the storage object.
+    Without storage the data is only borrowed, and must outlive the upload.
+    */
+    VertexBuffer(const void *data, const size_t sizeInBytes, std::shared_ptr<const void> storage);
+    /*
+    Adopts the data of a vector without copying it.
+    */
+    template <typename T>
+    VertexBuffer(std::vector<T> &&data) : VertexBuffer(nullptr, 0, nullptr)
+    {
+        auto storage = std::make_shared<const std::vector<T>>(std::move(data));
+        m_data = storage->data();
+        m_totalBytes = storage->size() * sizeof(T);
+        m_storage = std::move(storage);
+    }
+    VertexBuffer(VertexBuffer &&) = default;
+    VertexBuffer &operator=(VertexBuffer &&) = default;
 
+    /*
+    Deletes the buffer object.
+    */
     ~VertexBuffer();
 
     void generate();
@@ -92,6 +142,17 @@ public:
      */
     void upload_data();
 
+    /*
+    Overwrites a byte range of the already allocated buffer object.
+    */
+    void upload_data(const size_t sizeInBytes, const void *data, const size_t offset) const;
+
+    /*
+    Takes the data of another buffer with the same layouts and stride and uploads it into this buffer object. Its storage is kept
+    and overwritten if the sizes match, otherwise it is reallocated under the same name. Returns false if they differ.
+    */
+    bool update_data(const VertexBuffer &source);
+
     void bind() const;
 
     void unbind() const;
@@ -110,35 +171,20 @@ public:
         ASSERT("Must have a type")
     }
     /*
-        Push and subscribes a new FLOAT attribute layout to the VBO.
-        */
-    template <>
-    void push_attribute_layout<float>(size_t itemCount)
-    {
-        m_layouts.push_back({GL_FLOAT, itemCount, GL_FALSE});
-        m_strideBytes += itemCount * AttributeLayout::get_size(GL_FLOAT);
-    }
-    /*
-          Push and subscribes a new UINT attribute layout to the VBO.
-          */
-    template <>
-    void push_attribute_layout<unsigned int>(size_t itemCount)
-    {
-        m_layouts.push_back({GL_UNSIGNED_INT, itemCount, GL_FALSE});
-        m_strideBytes += itemCount * AttributeLayout::get_size(GL_UNSIGNED_INT);
-    }
-    /*
-          Push and subscribes a new UCHAR attribute layout to the VBO.
-          */
-    template <>
-    void push_attribute_layout<unsigned char>(size_t itemCount)
+    Push and subscribes an already described attribute layout to the VBO.
+    */
+    void push_attribute_layout(const AttributeLayout &layout)
     {
-        m_layouts.push_back({GL_UNSIGNED_BYTE, itemCount, GL_TRUE});
-        m_strideBytes += itemCount * AttributeLayout::get_size(GL_UNSIGNED_BYTE);
+        m_layouts.push_back(layout);
+        m_strideBytes += layout.count * AttributeLayout::get_size(layout.type);
     }
 
     inline const std::vector<AttributeLayout> get_layouts() const { return m_layouts; }
     /*
+    Overrides the stride given by the pushed layouts, for data with padding or gaps between vertices. Call after pushing them.
+    */
+    inline void set_stride_size(size_t strideBytes) { m_strideBytes = strideBytes; }
+    /*
     Returns read only size in bytes of the vertex  stride
     */
     inline const size_t get_stride_size() const { return m_strideBytes; }
@@ -151,10 +197,67 @@ public:
 
     inline bool empty() const { return m_totalBytes == 0; }
     /*
+    CPU side vertex data, as it will be uploaded. Null once released.
+    */
+    inline const void *get_data() const { return m_data; }
+    /*
+    Drops the CPU side copy of the data, for buffers already uploaded that will not be read or updated from the CPU.
+    The GPU data can still be read with read_data().
+    */
+    void release_data();
+    /*
     CAUTION !! Slow operation. Retrieves data from the GPU for reading purposes.
     */
     void read_data(void *readData, size_t offset = 0, size_t sizeInBytes = 0) const;
 };
+/*
+Push and subscribes a new FLOAT attribute layout to the VBO.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<float>(size_t itemCount)
+{
+    push_attribute_layout({GL_FLOAT, itemCount, GL_FALSE});
+}
+/*
+Push and subscribes a new UINT attribute layout to the VBO.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<unsigned int>(size_t itemCount)
+{
+    push_attribute_layout({GL_UNSIGNED_INT, itemCount, GL_FALSE});
+}
+/*
+Push and subscribes a new UCHAR attribute layout to the VBO. Read as normalized [0,1] floats.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<unsigned char>(size_t itemCount)
+{
+    push_attribute_layout({GL_UNSIGNED_BYTE, itemCount, GL_TRUE});
+}
+/*
+Push and subscribes a new CHAR attribute layout to the VBO. Read as normalized [-1,1] floats.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<signed char>(size_t itemCount)
+{
+    push_attribute_layout({GL_BYTE, itemCount, GL_TRUE});
+}
+/*
+Push and subscribes a new USHORT attribute layout to the VBO. Read as normalized [0,1] floats.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<unsigned short>(size_t itemCount)
+{
+    push_attribute_layout({GL_UNSIGNED_SHORT, itemCount, GL_TRUE});
+}
+/*
+Push and subscribes a new SHORT attribute layout to the VBO. Read as normalized [-1,1] floats.
+*/
+template <>
+inline void VertexBuffer::push_attribute_layout<short>(size_t itemCount)
+{
+    push_attribute_layout({GL_SHORT, itemCount, GL_TRUE});
+}
 #pragma endregion
 #pragma region IBO
 /*
@@ -163,10 +266,26 @@ OpenGL IBO abstraction
 class IndexBuffer : public Buffer
 {
     std::vector<unsigned int> m_indices;
+    const unsigned int *m_externalIndices{nullptr};
+    std::shared_ptr<const void> m_storage; // Keeps external indices alive
     size_t m_totalBytes;
 
 public:
-    IndexBuffer(std::vector<unsigned int> indices) : Buffer(), m_indices(indices), m_totalBytes(indices.size() * sizeof(unsigned int)) {}
+    /*
+    Takes the indices, pass them as an rvalue to avoid a copy.
+    */
+    IndexBuffer(std::vector<unsigned int> indices) : Buffer(), m_indices(std::move(indices)), m_totalBytes(m_indices.size() * sizeof(unsigned int)) {}
+    /*
+    References externally owned indices without copying them. The storage object keeps them alive.
+    */
+    IndexBuffer(const unsigned int *indices, size_t indexCount, std::shared_ptr<const void> storage)
+        : Buffer(), m_externalIndices(indices), m_storage(storage), m_totalBytes(indexCount * sizeof(unsigned int)) {}
+    IndexBuffer(IndexBuffer &&) = default;
+    IndexBuffer &operator=(IndexBuffer &&) = default;
+
+    /*
+    Deletes the buffer object.
+    */
     ~IndexBuffer();
 
     void generate();
@@ -176,6 +295,11 @@ public:
      */
     void upload_data();
 
+    /*
+    Takes the indices of another buffer and uploads them into this buffer object, in place if the sizes match.
+    */
+    void update_data(const IndexBuffer &source);
+
     void bind() const;
     void unbind() const;
 
@@ -186,7 +310,19 @@ public:
 
     inline bool empty() const { return m_totalBytes == 0; }
 
-    inline std::vector<unsigned int> get_indices() const { return m_indices; }
+    inline size_t get_index_count() const { return m_totalBytes / sizeof(unsigned int); }
+
+    /*
+    CPU side indices. Null once released.
+    */
+    inline const unsigned int *get_data() const { return m_externalIndices ? m_externalIndices : m_indices.data(); }
+
+    /*
+    Drops the CPU side copy of the indices, once uploaded.
+    */
+    void release_data();
+
+    inline std::vector<unsigned int> get_indices() const { return std::vector<unsigned int>(get_data(), get_data() + get_index_count()); }
 };
 
 #pragma endregion
@@ -197,10 +333,20 @@ OpenGL VAO abstraction
 class VertexArray : public Buffer
 {
     unsigned int m_layoutCount;
+    unsigned int m_lastLocation{0}; // Of the last attribute, divisors apply to it
     std::vector<VertexBuffer> m_VBOs;
 
+    void generate_direct();
+    void validate_layouts();
+
 public:
     VertexArray() : Buffer(), m_layoutCount(0) {}
+    VertexArray(VertexArray &&) = default;
+    VertexArray &operator=(VertexArray &&) = default;
+
+    /*
+    Deletes the VAO. Its VBOs delete their own buffer objects.
+    */
     ~VertexArray();
 
     /*
@@ -212,15 +358,34 @@ public:
     void unbind() const;
 
     /*
-    Adds a VBO.
+    Adds a VBO, taking ownership of it.
+    */
+    void push_vertex_buffer(VertexBuffer &&vbo);
+
+    /*
+    Makes an index buffer the element array of the VAO.
+    */
+    void set_index_buffer(const IndexBuffer &ibo) const;
+
+    /*
+    Replaces the data of every VBO by the one of the matching VBO in source, keeping buffer objects and attribute
+    bindings. Returns false, changing nothing, if both arrays do not have the same buffers and layouts.
     */
-    void push_vertex_buffer(const VertexBuffer vbo);
+    bool update_vertex_buffers(const VertexArray &source);
 
+    /*
+    Sets the instancing divisor of the last attribute of the VAO, at whatever location it is.
+    */
     void set_layout_divisor(const unsigned int divisor);
 
     inline unsigned int get_layout_count() const { return m_layoutCount; }
 
-    inline const std::vector<VertexBuffer> get_vertex_buffers() const { return m_VBOs; }
+    inline const std::vector<VertexBuffer> &get_vertex_buffers() const { return m_VBOs; }
+
+    /*
+    Drops the CPU side copy of the data of every VBO, once uploaded.
+    */
+    void release_data();
 
     inline bool empty() const { return m_VBOs.empty(); }
 };
@@ -264,6 +429,88 @@ public:
      */
     void upload_data(const size_t sizeInBytes, const void *data, const size_t offset = 0) const;
 };
+#pragma endregion
+#pragma region RING
+/*
+Persistently and coherently mapped buffer for data rewritten every frame: uniforms, storage or vertices. It is split
+in a region per frame in flight, each guarded by a fence, so that writing is a plain memcpy into memory the GPU is
+done reading, without driver calls nor implicit synchronization. Needs OpenGL 4.4 (glBufferStorage).
+
+Per frame: begin_frame(), any amount of allocate() or upload(), the draw calls using them, end_frame().
+*/
+class RingBuffer : public Buffer
+{
+    size_t m_frameBytes;
+    unsigned int m_frameCount;
+    unsigned int m_frame{0};
+    size_t m_head{0};
+    size_t m_alignment{1};
+    uint8_t *m_mapped{nullptr};
+    std::vector<GLsync> m_fences;
+
+public:
+    /*
+    Suballocation inside the region of the current frame. Pointer is null if the region ran out of space.
+    */
+    struct Allocation
+    {
+        void *pointer;
+        size_t offset; // From the start of the buffer, as used by glBindBufferRange or draw calls
+        size_t size;
+    };
+
+    RingBuffer(const size_t frameBytes, const unsigned int framesInFlight = 3);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    void generate();
+
+    /*
+    Binds to GL_ARRAY_BUFFER, for vertex data
+    */
+    void bind() const;
+    void unbind() const;
+
+    /*
+    Waits until the GPU is done with the region of the oldest frame in flight and starts suballocating from it.
+    */
+    void begin_frame();
+
+    /*
+    Fences the region of the current frame. Call after every command reading from it has been issued.
+    */
+    void end_frame();
+
+    /*
+    Reserves bytes in the region of the current frame, aligned within the whole buffer. With no alignment given they
+    are aligned for uniform and storage buffer ranges. Returns an empty allocation if the frame is full.
+    */
+    Allocation allocate(const size_t sizeInBytes, size_t alignment = 0);
+
+    inline Allocation upload(const void *data, const size_t sizeInBytes, const size_t alignment = 0)
+    {
+        Allocation allocation = allocate(sizeInBytes, alignment);
+        if (allocation.pointer)
+            memcpy(allocation.pointer, data, sizeInBytes);
+        return allocation;
+    }
+
+    /*
+    Binds an allocation to an indexed target, such as GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER. Failed (empty)
+    allocations are ignored, leaving the previous binding in place.
+    */
+    void bind_range(unsigned int target, unsigned int binding, const Allocation &allocation) const;
+
+    inline size_t get_frame_size() const { return m_frameBytes; }
+    inline unsigned int get_frames_in_flight() const { return m_frameCount; }
+    /*
+    Bytes used in the current frame
+    */
+    inline size_t get_used_size() const { return m_head; }
+};
+#pragma endregion
 
 GLSP_NAMESPACE_END
 
@@ -0,0 +1,197 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#ifndef __CACHE__
+#define __CACHE__
+
+#include <string>
+#include <GLSP/mesh.h>
+#include <GLSP/texture.h>
+#include <GLSP/processing.h>
+#include <GLSP/utils.h>
+
+GLSP_NAMESPACE_BEGIN
+
+/*
+Offers binary caching of already imported assets, so that text formats are only parsed once. Entries are content
+addressed: named after the hash of their source content, the import options (which include the loader) and the format
+version, so identical sources share them wherever they live. They are written atomically to a cache directory capped
+in size, evicting the least recently used entries, and can be shared by processes running at the same time.
+*/
+namespace cache
+{
+    const uint32_t MESH_CACHE_MAGIC = 0x4D505347; // "GSPM"
+    const uint32_t MESH_CACHE_VERSION = 3;
+    const char *const MESH_CACHE_EXTENSION = ".glspmesh";
+    const size_t MESH_CACHE_MAX_ATTRIBUTES = 8;
+    const size_t MESH_CACHE_ALIGNMENT = 64;
+
+    /*
+    Fixed size header of the binary mesh container. Vertex and index blocks follow at aligned offsets,
+    so they can be handed straight from the mapped file to the GPU.
+    */
+    struct MeshCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+
+        // Source validation
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t sourceHash;
+        uint64_t optionsHash;
+
+        // Vertex layout
+        uint32_t vertexStride;
+        uint32_t attributeCount;
+        struct
+        {
+            uint32_t type;
+            uint32_t count;
+            uint32_t normalized;
+        } attributes[MESH_CACHE_MAX_ATTRIBUTES];
+        uint32_t primitive;
+        uint32_t pad;
+
+        // Data blocks
+        uint64_t vertexCount;
+        uint64_t vertexOffset;
+        uint64_t indexCount;
+        uint64_t indexOffset;
+        uint64_t submeshCount;
+        uint64_t submeshOffset;
+        uint64_t LODCount;
+        uint64_t LODOffset; // LODCount MeshCacheLOD entries followed by the submeshes of every level
+
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct MeshCacheLOD
+    {
+        uint32_t submeshCount;
+        float error;
+    };
+
+    const uint32_t TEXTURE_CACHE_MAGIC = 0x54505347; // "GSPT"
+    const uint32_t TEXTURE_CACHE_VERSION = 3;
+    const char *const TEXTURE_CACHE_EXTENSION = ".glsptex";
+    const char *const CUBEMAP_CACHE_EXTENSION = ".glspcube";
+    const char *const BAKED_CACHE_EXTENSION = ".glspbake";
+    const char *const SOURCE_RECORD_EXTENSION = ".glspsrc"; // Remembered content hash of a source
+    const uint64_t DEFAULT_SIZE_LIMIT = uint64_t(4) << 30;
+    const size_t TEXTURE_CACHE_MAX_LEVELS = 16;
+    const size_t TEXTURE_CACHE_MAX_FACES = 6;
+
+    /*
+    Fixed size header of the binary texture container, KTX2 alike: a level index followed by every level at an aligned
+    offset, tightly packed and ready to be uploaded from the mapped file.
+    */
+    struct TextureCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+
+        // Source validation
+        uint64_t sourceSize;
+        int64_t sourceTime;
+        uint64_t sourceHash;
+        uint64_t optionsHash;
+
+        // Pixel layout
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t dataType; // GL_UNSIGNED_BYTE or GL_FLOAT
+        uint32_t sRGB;
+        uint32_t compressedFormat; // 0 if levels are not block compressed
+        uint32_t faceCount;        // 1, or 6 for cubemaps
+        uint32_t levelCount;
+        struct
+        {
+            uint64_t offset;
+            uint64_t size;
+        } levels[TEXTURE_CACHE_MAX_FACES][TEXTURE_CACHE_MAX_LEVELS];
+    };
+
+    /*
+    Enables or disables the binary cache for every mesh loader. Enabled by default.
+    */
+    void set_enabled(bool op);
+    bool is_enabled();
+
+    /*
+    Directory where cache files are written. Defaults to GLSP_CACHE_DIR if set, otherwise to the user cache directory
+    (XDG_CACHE_HOME/GLSP, ~/.cache/GLSP or LOCALAPPDATA/GLSP/cache). An empty string restores the default.
+    */
+    void set_directory(const std::string &directory);
+    std::string get_directory();
+
+    /*
+    Total size of the entries in the cache directory. Checked after every store, which evicts the least recently
+    used entries over it. Loading an entry marks it as used.
+    */
+    void set_size_limit(uint64_t bytes);
+    uint64_t get_size_limit();
+
+    /*
+    Evicts entries over the size limit right away.
+    */
+    void trim();
+
+    /*
+    Entry an import of the current content of a source maps to. Empty if the source can not be read.
+    */
+    std::string get_mesh_cache_path(const char *sourceFile, uint64_t optionsHash);
+    std::string get_texture_cache_path(const char *sourceFile, uint64_t optionsHash);
+    std::string get_cubemap_cache_path(const char *sourceFile, uint64_t optionsHash);
+
+    /*
+    Writes the canonical vertex data of an import into the binary container. Written atomically through a temporary file.
+    */
+    bool store_mesh(const char *sourceFile, uint64_t optionsHash, const MeshData &data);
+
+    /*
+    Maps a cache entry and creates a geometry whose buffers point straight into the mapped memory. Returns nullptr if
+    there is no entry for the current source content and options. Sources are only hashed again when their size or
+    modification time change.
+    */
+    Geometry *load_mesh(const char *sourceFile, uint64_t optionsHash);
+
+    /*
+    Writes a precomputed mip chain into the binary texture container. Written atomically through a temporary file.
+    */
+    bool store_texture(const char *sourceFile, uint64_t optionsHash, const processing::MipChain &chain);
+
+    /*
+    Maps a texture cache entry and fills the levels with pointers straight into the mapped memory. Returns false if
+    there is no entry, same rules as meshes.
+    */
+    bool load_texture(const char *sourceFile, uint64_t optionsHash, TextureLevels &levels);
+
+    /*
+    Same container with the six faces of a cubemap baked from a panorama (see processing::panorama_to_cubemap), under
+    its own extension.
+    */
+    bool store_cubemap(const char *sourceFile, uint64_t optionsHash, const processing::CubemapData &cubemap);
+    bool load_cubemap(const char *sourceFile, uint64_t optionsHash, TextureLevels &levels);
+
+    /*
+    Same container for textures baked at runtime rather than imported from a file (e.g. prefiltered environments),
+    addressed by a hash of the content they were baked from instead of a source.
+    */
+    std::string get_baked_cache_path(uint64_t contentHash, uint64_t optionsHash);
+    bool store_baked(uint64_t contentHash, uint64_t optionsHash, const processing::MipChain *faces, uint32_t faceCount);
+    bool load_baked(uint64_t contentHash, uint64_t optionsHash, uint32_t faceCount, TextureLevels &levels);
+}
+
+GLSP_NAMESPACE_END
+
+#endif
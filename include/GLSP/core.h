@@ -170,6 +170,14 @@ typedef enum TextureType{
 	TEXTURE_CUBEMAP = GL_TEXTURE_CUBE_MAP
 }TextureType;
 
+/*
+Direct State Access (GL 4.5). When enabled, buffers, vertex arrays, textures and framebuffers are created and
+updated through their names, without touching the global binding points. Set by the renderer from its context
+settings, before any resource is generated.
+*/
+void set_direct_state_access(bool enabled);
+bool uses_direct_state_access();
+
 
 /// Forward declarations
 class Renderer;
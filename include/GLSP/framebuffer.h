@@ -51,6 +51,10 @@ class Framebuffer
 
     bool m_generated{false};
 
+    // Direct State Access versions of the attachment and renderbuffer storage setup
+    void attach_direct(const Attachment &attachment) const;
+    void allocate_direct(const Renderbuffer &renderbuffer) const;
+
 public:
     Framebuffer(Extent2D extent, std::vector<Attachment> attachments, unsigned int samples = 1) : m_extent(extent), m_attachments(attachments), m_samples(samples) {}
     ~Framebuffer() { cleanup(); }
@@ -17,6 +17,7 @@ Eeasy include file
 
 #include <GLSP/core.h>
 #include <GLSP/buffers.h>
+#include <GLSP/cache.h>
 #include <GLSP/camera.h>
 #include <GLSP/controller.h>
 #include <GLSP/framebuffer.h>
@@ -25,6 +26,8 @@ Eeasy include file
 #include <GLSP/material.h>
 #include <GLSP/mesh.h>
 #include <GLSP/object3D.h>
+#include <GLSP/pointcloud.h>
+#include <GLSP/processing.h>
 #include <GLSP/renderer.h>
 #include <GLSP/shader.h>
 #include <GLSP/texture.h>
@@ -18,17 +18,218 @@
 #include <stb_image.h>
 #include <GLSP/mesh.h>
 #include <GLSP/utils.h>
+#include <GLSP/processing.h>
 
 GLSP_NAMESPACE_BEGIN
 
 namespace loaders
 {
-    void load_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials = false, bool calculateTangents = false);
+    /*
+    Every shape in the file goes into a single vertex/index buffer pair, each one drawn as a submesh range. If importMaterials
+    is true, usemtl groups also split ranges and get a material id (see Mesh::set_submesh_material). If LODCount is not 0,
+    that many levels of detail are generated, each one with half the triangles of the previous (see processing::generate_LODs).
+    */
+    void load_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials = false, bool calculateTangents = false, unsigned int LODCount = 0);
 
-    void load_PLY(Mesh *const mesh, const char *fileName, bool preload = true, bool verbose = false, bool calculateTangents = false);
+    /*
+    Parses an OBJ file by splitting it into line-aligned chunks that are tokenized in parallel. Vertices are deduplicated by
+    their position/uv/normal index triplet. Shapes, and usemtl groups if materialGroups is true, are recorded as submeshes.
+    Does not need an OpenGL context. Set threadCount to 0 to use all hardware threads.
+    */
+    bool parse_OBJ(const char *fileName, MeshData &data, unsigned int threadCount = 0, bool materialGroups = true);
+
+    /*
+    Single threaded tinyobj based parser. Kept as reference for validation and benchmarking.
+    */
+    bool parse_OBJ_tinyobj(const char *fileName, MeshData &data);
+
+    void load_PLY(Mesh *const mesh, const char *fileName, bool preload = true, bool verbose = false, bool calculateTangents = false, unsigned int LODCount = 0);
+
+    /*
+    Size of the window used when streaming PLY files instead of mapping them.
+    */
+    const size_t PLY_STREAM_CHUNK_BYTES = 1 << 22;
+
+    /*
+    Summary of a PLY header. Useful for sizing caller owned destinations before decoding.
+    */
+    struct PLYInfo
+    {
+        size_t vertexCount{0};
+        size_t faceCount{0};
+        bool binary{false};
+        bool hasNormals{false};
+        bool hasColors{false};
+        bool hasUVs{false};
+    };
+
+    bool read_PLY_info(const char *fileName, PLYInfo &info);
+
+    /*
+    Streams binary or ascii PLY vertices straight into an interleaved canonical vertex destination (e.g. a mapped buffer) of
+    at least vertexCapacity vertices. Faces are fan triangulated into indices if not null. If preload is true the file is
+    memory mapped, otherwise it is read through a fixed size window and never fully held in memory.
+    */
+    bool decode_PLY(const char *fileName, Vertex *vertices, size_t vertexCapacity, std::vector<unsigned int> *indices, bool preload = true, bool verbose = false);
+
+    /*
+    Streams the vertices of a PLY file through a fixed size batch, so that files of any size can be processed with
+    bounded memory. The sink gets consecutive batches of at most batchSize vertices and can stop the stream by
+    returning false. Faces are not read.
+    */
+    bool stream_PLY(const char *fileName, const std::function<bool(const Vertex *, size_t)> &sink, size_t batchSize = 1 << 16);
+
+    /*
+    Parses a PLY file into canonical vertices, decoding in place so that peak memory stays at the output size. Does not need an OpenGL context.
+    */
+    bool parse_PLY(const char *fileName, MeshData &data, bool preload = true, bool verbose = false);
+
+    /*
+    tinyply based parser. Kept as reference for validation and benchmarking.
+    */
+    bool parse_PLY_tinyply(const char *fileName, MeshData &data, bool preload = true, bool verbose = false);
+
+    /*
+    Imports the default scene of a glTF 2.0 file, either .gltf with external or embedded buffers or binary .glb. Every
+    node becomes a Mesh with the node transform, attached under root (if not null) following the node hierarchy and
+    appended to meshes, which the caller owns. Extra primitives of a node mesh become children of its Mesh. Vertex data
+    is not repacked into Vertex: files are memory mapped, and the buffer view range used by each primitive becomes a
+    vertex buffer referencing the mapping, with a layout per accessor at the canonical vertex locations (position 0,
+    normal 1, tangent 2, uv 3, color 4). Only sparse accessors are copied, and 8 and 16 bit indices widened. Materials,
+    skins and animations are not imported. On failure nothing is attached to root or appended to meshes. Does not need
+    an OpenGL context.
+    */
+    bool load_GLTF(Object3D *const root, const char *fileName, std::vector<Mesh *> &meshes);
 
     void load_image(Texture *const texture, const char *fileName, bool isPanorama = false);
 
+    /*
+    Decodes an image file into CPU memory. Does not need an OpenGL context.
+    */
+    bool decode_image(const char *fileName, Image &image);
+
+    /*
+    Loads a 2D texture together with its whole mip chain, built on CPU (see processing::generate_mip_chain) the first
+    time and mapped from the texture cache afterwards. The texture gets immutable storage and every level is uploaded
+    as is, without glGenerateMipmap, so later launches skip decoding and filtering. If compression is given, levels
+    are also block compressed before being cached (see processing::compress_mip_chain) and the texture takes their
+    compressed format instead of the configured internal format.
+    */
+    bool load_texture(Texture *const texture, const char *fileName, processing::MipSettings settings = {}, const processing::BlockCompressionSettings *compression = nullptr);
+
+    /*
+    Loads an equirectangular HDR panorama into a cubemap texture. Faces and their mips are projected on CPU (see
+    processing::panorama_to_cubemap) the first time and mapped from the cubemap cache afterwards, so unlike
+    load_image(texture, fileName, true) no render passes or glGenerateMipmap run when the texture is generated. The
+    texture must be configured as a TEXTURE_CUBEMAP, its extent is set to the face size.
+    */
+    bool load_panorama(Texture *const texture, const char *fileName, processing::CubemapSettings settings = {});
+
+    /*
+    Asynchronous variants. Parsing and decoding run on a pool of worker threads, while the final GPU upload is queued
+    for the GL thread, which must call process_uploads() every frame (the renderer loop already does it). The returned
+    future becomes ready once the asset is uploaded, or holds false if the import failed. The target object must
+    outlive the load.
+    */
+    std::shared_future<bool> load_OBJ_async(Mesh *const mesh, const char *fileName, bool importMaterials = false, bool calculateTangents = false, unsigned int LODCount = 0);
+
+    std::shared_future<bool> load_PLY_async(Mesh *const mesh, const char *fileName, bool preload = true, bool verbose = false, bool calculateTangents = false, unsigned int LODCount = 0);
+
+    /*
+    If generate is true the texture object is also created and filled on the GL thread.
+    */
+    std::shared_future<bool> load_image_async(Texture *const texture, const char *fileName, bool isPanorama = false, bool generate = true);
+
+    std::shared_future<bool> load_texture_async(Texture *const texture, const char *fileName, processing::MipSettings settings = {}, const processing::BlockCompressionSettings *compression = nullptr, bool generate = true);
+
+    std::shared_future<bool> load_panorama_async(Texture *const texture, const char *fileName, processing::CubemapSettings settings = {}, bool generate = true);
+
+    struct ImageLoadRequest
+    {
+        Texture *texture;
+        std::string fileName;
+        bool isPanorama{false};
+    };
+
+    /*
+    Decode statistics of a batch of images. Files are listed in the order their decoding finished.
+    */
+    struct ImageBatchReport
+    {
+        struct File
+        {
+            std::string fileName;
+            double decodeMs{0.0};
+            size_t fileBytes{0};
+            Extent2D extent{};
+            bool decoded{false};
+        };
+        std::vector<File> files;
+        double elapsedMs{0.0}; // From the call until the last file was decoded
+        size_t fileBytes{0};
+        size_t pixels{0};
+
+        inline double get_throughput() const { return elapsedMs > 0.0 ? fileBytes * 1e-3 / elapsedMs : 0.0; } // MB/s
+        inline double get_pixel_rate() const { return elapsedMs > 0.0 ? pixels * 1e-3 / elapsedMs : 0.0; }   // Mpixels/s
+    };
+
+    /*
+    Decodes a batch of images in parallel on the asynchronous loading pool. Each image is handed to the GL thread as soon
+    as it is decoded, so uploads happen in completion order instead of request order. The future becomes ready once
+    every upload is done.
+    */
+    std::shared_future<ImageBatchReport> load_images(const std::vector<ImageLoadRequest> &requests, bool generate = true);
+
+    /*
+    Runs the GPU uploads of finished asynchronous loads. Call from the GL thread. Stops after budgetMs milliseconds if
+    greater than 0, leaving the rest for the next call. Returns the number of uploads processed.
+    */
+    size_t process_uploads(double budgetMs = 0.0);
+
+    /*
+    Blocks until an asynchronous load is done, processing uploads meanwhile. Call from the GL thread.
+    */
+    template <typename T>
+    T wait(const std::shared_future<T> &load)
+    {
+        while (load.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+            process_uploads();
+        return load.get();
+    }
+
+    /*
+    Hot reload. Watched files are re-imported on the asynchronous loading pool when they change on disk (see
+    utils::FileWatcher) and swapped in by process_uploads() at the start of a frame, so editing an asset costs the import
+    of that asset only. GL objects are kept: mesh buffers and immutable texture storage are overwritten in place when
+    sizes match, and shaders that fail to compile keep their previous program. Call from the GL thread, and unwatch an
+    object before deleting it.
+    */
+    bool watch_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials = false, bool calculateTangents = false, unsigned int LODCount = 0);
+
+    bool watch_PLY(Mesh *const mesh, const char *fileName, bool preload = true, bool calculateTangents = false, unsigned int LODCount = 0);
+
+    bool watch_texture(Texture *const texture, const char *fileName, processing::MipSettings settings = {}, const processing::BlockCompressionSettings *compression = nullptr);
+
+    bool watch_panorama(Texture *const texture, const char *fileName, processing::CubemapSettings settings = {});
+
+    /*
+    Sources in the single file .glsl format (see Shader::parse_shader).
+    */
+    bool watch_shader(Shader *const shader, const char *fileName);
+
+    void unwatch(const void *object);
+
+    /*
+    Starts re-importing the watched files changed since the last call. Cheap enough to run every frame (the renderer
+    loop already does it). Returns the number of reloads started.
+    */
+    size_t poll_hot_reload();
+
+    /*
+    Resizes the asynchronous loading worker pool. Set threadCount to 0 to use all hardware threads.
+    */
+    void set_async_thread_count(unsigned int threadCount);
+
 }
 
 GLSP_NAMESPACE_END
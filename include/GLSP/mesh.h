@@ -42,6 +42,38 @@ struct Vertex
     }
 };
 
+/*
+Range of a shared index buffer drawn as a unit, usually an imported shape or material group.
+*/
+struct Submesh
+{
+    unsigned int indexOffset{0};
+    unsigned int indexCount{0};
+    int baseVertex{0};
+    int materialId{-1}; // -1 if it has no material
+};
+
+/*
+Simplified version of a mesh drawn from the same vertex and index buffers.
+*/
+struct LODLevel
+{
+    std::vector<Submesh> submeshes;
+    float error{0.0f}; // Object space deviation from the full resolution mesh
+};
+
+/*
+CPU side result of a mesh import. It can be filled without an OpenGL context and later be turned into a Geometry.
+*/
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<Submesh> submeshes;  // Empty if the whole index buffer is drawn at once
+    std::vector<std::string> materials; // Names referenced by submesh material ids
+    std::vector<LODLevel> LODs;         // Coarser levels, their indices are appended to the index buffer
+};
+
 /*
 Class that defines the mesh geometry. Can be simply instanced by filling with a canonical vertex type array. 
 It can also be instance using directly a custom VetexArray, letting the user have total freedom when defining the mesh vertex info and attribute layouts.
@@ -56,6 +88,10 @@ protected:
     unsigned int m_primitiveType;
     unsigned int m_vertexPerPatch; // In case of tesselation
 
+    std::vector<Submesh> m_submeshes;
+    std::vector<LODLevel> m_LODs;
+    size_t m_LOD{0};
+
     bool m_indexed;
     bool m_buffer_loaded{false};
 
@@ -65,25 +101,63 @@ public:
     */
     Geometry(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int primitive = GL_TRIANGLES);
     /*
+    Takes ownership of an import. Its vertex and index data are adopted by the buffers instead of copied.
+    */
+    Geometry(MeshData &&data, unsigned int primitive = GL_TRIANGLES);
+    /*
     Low level constructor for directly handling vertex array structure and definition
     */
-    Geometry(VertexArray VAO, size_t vertexCount, unsigned int primitive = GL_TRIANGLES) : m_VAO(VAO), m_IBO({}), m_vertexCount(vertexCount), m_primitiveType{primitive}, m_vertexPerPatch(4) {}
+    Geometry(VertexArray &&VAO, size_t vertexCount, unsigned int primitive = GL_TRIANGLES) : m_VAO(std::move(VAO)), m_IBO({}), m_vertexCount(vertexCount), m_primitiveType{primitive}, m_vertexPerPatch(4) {}
     /*
    Low level constructor for directly handling vertex array structure and definition plus index buffer
    */
-    Geometry(VertexArray VAO, size_t vertexCount, IndexBuffer IBO, unsigned int primitive = GL_TRIANGLES) : m_VAO(VAO), m_IBO(IBO), m_vertexCount(vertexCount), m_primitiveType{primitive}, m_vertexPerPatch(4) {}
+    Geometry(VertexArray &&VAO, size_t vertexCount, IndexBuffer &&IBO, unsigned int primitive = GL_TRIANGLES) : m_VAO(std::move(VAO)), m_IBO(std::move(IBO)), m_vertexCount(vertexCount), m_primitiveType{primitive}, m_vertexPerPatch(4) {}
+    Geometry(Geometry &&) = default;
+    Geometry &operator=(Geometry &&) = default;
+
+    virtual ~Geometry() = default;
 
     /*
-    Gets a read-only copy of the vertex array object. By accessing the vertex buffers inside it one can access the geometry vertex data
+    Gets the read-only vertex array object. By accessing the vertex buffers inside it one can access the geometry vertex data
     */
-    inline const VertexArray get_VAO() const { return m_VAO; }
+    inline const VertexArray &get_VAO() const { return m_VAO; }
     /*
-    Gets a read-only copy of the index buffer object. One can accesss the indices in the mesh with this object. If geometry is not indexed, this object will be empty.
+    Gets the read-only index buffer object. One can accesss the indices in the mesh with this object. If geometry is not indexed, this object will be empty.
     */
-    inline const IndexBuffer get_IBO() const { return m_IBO; }
+    inline const IndexBuffer &get_IBO() const { return m_IBO; }
 
     inline size_t get_vertex_count() const { return m_vertexCount; }
 
+    /*
+    Draw ranges inside the index buffer. If empty, the whole buffer is drawn in a single call.
+    */
+    inline const std::vector<Submesh> &get_submeshes() const { return m_submeshes; }
+    inline void set_submeshes(const std::vector<Submesh> &submeshes) { m_submeshes = submeshes; }
+
+    /*
+    Levels of detail coarser than the full resolution one, ordered by increasing error. Level 0 is the full resolution
+    mesh and level i > 0 is get_LODs()[i - 1].
+    */
+    inline const std::vector<LODLevel> &get_LODs() const { return m_LODs; }
+    inline void set_LODs(const std::vector<LODLevel> &LODs)
+    {
+        m_LODs = LODs;
+        m_LOD = 0;
+    }
+
+    inline void set_LOD(size_t level) { m_LOD = std::min(level, m_LODs.size()); }
+    inline size_t get_LOD() const { return m_LOD; }
+
+    /*
+    Activates the coarsest level whose error is within maxError (object space) and returns it.
+    */
+    size_t select_LOD(float maxError);
+
+    /*
+    Draw ranges of the active level of detail.
+    */
+    inline const std::vector<Submesh> &get_draw_submeshes() const { return m_LOD == 0 ? m_submeshes : m_LODs[m_LOD - 1].submeshes; }
+
     inline void set_patch_vertex_number(unsigned int num) { m_vertexPerPatch = num; }
     inline unsigned int get_patch_vertex_number() const { return m_vertexPerPatch; }
 
@@ -94,8 +168,21 @@ public:
 
     virtual void generate_buffers();
 
+    /*
+    Takes the data, draw ranges and levels of detail of an equivalent geometry (same primitive, vertex buffers and
+    layouts, both indexed or not) into the already generated buffers of this one, so GL objects and attribute bindings
+    are kept. Storage is overwritten in place where sizes match. Returns false, changing nothing, if they are not equivalent.
+    */
+    bool update_buffers(const Geometry &source);
+
     inline bool is_buffer_loaded() const { return m_buffer_loaded; }
 
+    /*
+    Drops the CPU side copies of the vertices and indices once the buffers are generated, so that the geometry only
+    lives in GPU memory. Processing functions that read the geometry data can not be used on it afterwards.
+    */
+    void release_data();
+
     /**
      * Change GL_POINTS rasterization size for drawing
      */
@@ -120,11 +207,12 @@ class Mesh : public Object3D
 protected:
     Geometry *m_geometry;
     Material *m_material;
+    std::vector<Material *> m_submeshMaterials;
 
     static int INSTANCED_MESHES;
 
 public:
-    Mesh() : Object3D("Mesh", {0.0f, 0.0f, 0.0f}, Object3DType::MESH), m_material(nullptr) { Mesh::INSTANCED_MESHES++; }
+    Mesh() : Object3D("Mesh", {0.0f, 0.0f, 0.0f}, Object3DType::MESH), m_geometry(nullptr), m_material(nullptr) { Mesh::INSTANCED_MESHES++; }
     Mesh(Geometry *const geometry, Material *const material) : Object3D("Mesh", {0.0f, 0.0f, 0.0f}, Object3DType::MESH), m_material(material), m_geometry(geometry) { Mesh::INSTANCED_MESHES++; }
     ~Mesh()
     {
@@ -140,8 +228,21 @@ public:
 
     inline Material *const get_material() const { return m_material; }
 
+    /*
+    Material used by the submeshes with the given material id instead of the main one. Not owned by the mesh.
+    */
+    void set_submesh_material(unsigned int materialId, Material *const material);
+
+    inline Material *const get_submesh_material(unsigned int materialId) const { return materialId < m_submeshMaterials.size() ? m_submeshMaterials[materialId] : nullptr; }
+
     virtual void draw(bool useMaterial = true);
 
+    /*
+    Selects the geometry level of detail whose error projects to at most pixelError pixels on a viewport of the given
+    height, seen from a camera at cameraPosition with a vertical field of view in degrees. Returns the selected level.
+    */
+    size_t select_LOD(const glm::vec3 &cameraPosition, float fieldOfView, float viewportHeight, float pixelError = 1.0f);
+
     inline static int get_number_of_instances() { return INSTANCED_MESHES; }
 
     /*
@@ -11,6 +11,7 @@
 #ifndef __OBJECT_3D__
 #define __OBJECT_3D__
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
@@ -91,7 +92,7 @@ public:
         m_transform.position = glm::vec3(0.0f);
     }
 
-    ~Object3D()
+    virtual ~Object3D()
     {
         // delete[] children;
         delete m_parent;
@@ -196,6 +197,15 @@ public:
         m_children.push_back(child);
     }
 
+    virtual void remove_child(Object3D *child)
+    {
+        auto it = std::find(m_children.begin(), m_children.end(), child);
+        if (it == m_children.end())
+            return;
+        child->m_parent = nullptr;
+        m_children.erase(it);
+    }
+
     virtual std::vector<Object3D *> get_children() const { return m_children; }
 
     virtual Object3D *get_parent() const { return m_parent; }
@@ -0,0 +1,159 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#ifndef __POINTCLOUD__
+#define __POINTCLOUD__
+
+#include <GLSP/mesh.h>
+#include <GLSP/camera.h>
+
+GLSP_NAMESPACE_BEGIN
+
+/*
+Point as stored in the octree files: position relative to the octree origin and RGBA8 color.
+*/
+struct PointRecord
+{
+    glm::vec3 position;
+    uint32_t color;
+};
+
+/*
+Node of the point octree. Nodes are stored breadth first and the children of a node are contiguous, in
+octant order (bit 0 x, bit 1 y, bit 2 z). Points are additive: a node holds a subsample of its region and its
+children only hold the points it did not take.
+*/
+struct PointCloudNode
+{
+    uint64_t offset;     // First point in the points file
+    uint32_t pointCount;
+    uint32_t firstChild; // Index of the first child, meaningless without children
+    uint8_t childMask;
+    uint8_t level;
+    uint16_t padding;
+    uint32_t x, y, z; // Integer coordinates of the node cell at its level
+};
+
+struct PointOctreeSettings
+{
+    size_t maxNodePoints{20000};      // Leaves are split beyond this
+    unsigned int gridResolution{128}; // Sampling grid cells per axis in every node, sets the spacing of the points they keep
+    size_t chunkPoints{1 << 21};      // Regions of the cloud processed independently, bounds the memory of every worker
+    size_t memoryBudget{256 << 20};   // Bytes of points buffered while distributing them to the chunks
+    unsigned int threadCount{0};      // Zero takes the hardware concurrency
+};
+
+struct PointCloudSettings
+{
+    size_t memoryBudget{512 << 20}; // Bytes of GPU memory taken by the resident nodes
+    size_t pointBudget{10000000};   // Maximum points drawn in a frame
+    float pointSpacing{2.0f};       // Target screen space spacing between points, in pixels. Nodes are refined until reaching it
+    unsigned int maxPendingLoads{8};
+    double uploadBudget{2.0}; // Milliseconds per update spent uploading loaded nodes
+};
+
+/*
+Point cloud of any size streamed out of core. The cloud is converted once into a level of detail octree with
+build_octree(), which works in a fixed amount of memory. At runtime only the nodes needed for the current view are
+read from disk, on a background thread, and kept in a pool of GPU memory of a fixed size, evicting the least
+recently used when it is full.
+
+Positions are stored relative to the octree origin, which becomes the position of the object, so that large
+coordinates keep their precision. Positions go to location 0 and colors to location 4.
+*/
+class PointCloud : public Mesh
+{
+    struct LoadedNode
+    {
+        uint32_t node;
+        std::vector<PointRecord> points;
+    };
+
+    PointCloudSettings m_settings;
+    std::vector<PointCloudNode> m_nodes;
+    glm::vec3 m_origin{0.0f};
+    float m_size{0.0f};
+    float m_spacing{0.0f};
+    uint64_t m_pointCount{0};
+    std::unique_ptr<utils::MappedFile> m_points;
+
+    // Residency of nodes in the GPU pool, which is split in slots fitting the largest node
+    size_t m_slotPoints{0};
+    std::vector<int> m_nodeSlots;
+    std::vector<uint32_t> m_slotNodes;
+    std::vector<uint64_t> m_slotFrames;
+    std::vector<int> m_freeSlots;
+    std::vector<uint8_t> m_pending;
+    unsigned int m_pendingLoads{0};
+    uint64_t m_frame{0};
+
+    std::vector<uint32_t> m_visibleNodes;
+    std::vector<int> m_drawFirsts;
+    std::vector<int> m_drawCounts;
+    size_t m_drawnPoints{0};
+
+    std::mutex m_loadedMutex;
+    std::deque<LoadedNode> m_loaded;
+    // Last, so that it joins its workers before anything they use is destroyed
+    std::unique_ptr<utils::ThreadPool> m_loader;
+
+    void create_pool();
+    void request_node(uint32_t node);
+    int acquire_slot();
+
+public:
+    /*
+    Opens an octree built with build_octree(). Only the hierarchy is read, so it can be called from any thread.
+    */
+    PointCloud(const char *directory, PointCloudSettings settings = {});
+
+    /*
+    Converts a PLY point cloud of any size into an octree in the given directory, with a memory footprint of roughly
+    the memory budget plus one chunk per thread. Returns false if the file can not be read or the octree written.
+    */
+    static bool build_octree(const char *fileName, const char *directory, PointOctreeSettings settings = {});
+
+    inline bool is_loaded() const { return !m_nodes.empty(); }
+    inline const std::vector<PointCloudNode> &get_nodes() const { return m_nodes; }
+    inline uint64_t get_point_count() const { return m_pointCount; }
+    /*
+    Side of the cubic bounds of the octree
+    */
+    inline float get_size() const { return m_size; }
+    /*
+    Spacing between the points of the root node. It halves every level
+    */
+    inline float get_spacing() const { return m_spacing; }
+
+    /*
+    Computes the nodes needed for a view, in order of priority: inside the frustum and refined until the projected
+    spacing of their points is under the target, or the point budget is reached. Does not touch the GPU.
+    */
+    const std::vector<uint32_t> &select_nodes(const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight);
+
+    /*
+    Selects the nodes for the camera, requests the missing ones and uploads those already read, within the upload
+    budget. Must be called in the GL thread before drawing.
+    */
+    void update(Camera *const camera, float viewportHeight);
+
+    inline const std::vector<uint32_t> &get_visible_nodes() const { return m_visibleNodes; }
+    inline size_t get_resident_node_count() const { return m_slotNodes.size() - m_freeSlots.size(); }
+    inline size_t get_drawn_point_count() const { return m_drawnPoints; }
+
+    /*
+    Draws the selected nodes which are resident, in a single call.
+    */
+    void draw(bool useMaterial = true) override;
+};
+
+GLSP_NAMESPACE_END
+
+#endif
@@ -0,0 +1,416 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#ifndef __PROCESSING__
+#define __PROCESSING__
+
+#include <GLSP/mesh.h>
+#include <GLSP/utils.h>
+
+GLSP_NAMESPACE_BEGIN
+
+/*
+Offers CPU side algorithms that work over imported mesh and image data. None of them need an OpenGL context.
+*/
+namespace processing
+{
+    /*
+    Generates per vertex tangents for an indexed triangle list, following MikkTSpace conventions: per corner face tangents are
+    projected onto the vertex normal plane, normalized and weighted by the corner angle, then orthonormalized against the
+    normal. Triangles are split among threads that accumulate separately. Set threadCount to 0 to use all hardware threads.
+    */
+    void compute_tangents(MeshData &data, unsigned int threadCount = 0);
+
+    /*
+    Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache. ACMR is the average amount of
+    vertex shader invocations per triangle (0.5 is the ideal for regular grids) and ATVR per referenced vertex (1.0 is ideal).
+    */
+    struct VertexCacheStatistics
+    {
+        size_t vertexTransforms{0};
+        float ACMR{0.0f};
+        float ATVR{0.0f};
+    };
+
+    VertexCacheStatistics analyze_vertex_cache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+    /*
+    Reorders triangles inside each submesh for vertex cache locality using Forsyth's linear-speed algorithm.
+    */
+    void optimize_vertex_cache(MeshData &data);
+
+    /*
+    Splits each submesh into clusters at vertex cache discontinuities and sorts them so that outward facing ones are
+    drawn first, reducing overdraw. Clusters are kept while their ACMR is within threshold times the original one, so
+    run it after optimize_vertex_cache.
+    */
+    void optimize_overdraw(MeshData &data, float threshold = 1.05f);
+
+    /*
+    Merges bitwise identical vertices and remaps the indices, which are created for unindexed triangle soups.
+    Submesh base vertices are folded into the indices. Returns the amount of vertices removed.
+    */
+    size_t weld_vertices(MeshData &data);
+
+    /*
+    Reorders vertices in the order the index buffer first references them, improving vertex fetch locality.
+    Submesh base vertices are folded into the indices.
+    */
+    void optimize_vertex_fetch(MeshData &data);
+
+    struct MeshOptimizationReport
+    {
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    /*
+    Runs vertex cache, overdraw (optional) and vertex fetch optimizations in sequence.
+    */
+    MeshOptimizationReport optimize_mesh(MeshData &data, bool overdraw = true, float overdrawThreshold = 1.05f);
+
+    /*
+    Same as optimize_mesh over a geometry that uses the canonical vertex layout and has not been uploaded yet. Its buffers
+    are replaced with the optimized ones. Returns false (geometry untouched) if it can not be optimized.
+    */
+    bool optimize_geometry(Geometry &geometry, MeshOptimizationReport *report = nullptr, bool overdraw = true, float overdrawThreshold = 1.05f);
+
+    /*
+    Compact 24 byte alternative to the canonical 56 byte vertex. Positions are 16 bit normalized against the mesh bounds
+    (or half floats), normals and tangents octahedral encoded into two 16 bit snorms, uvs 16 bit normalized against the uv
+    bounds and colors 8 bit normalized. The fourth position and color components are padding.
+    */
+    struct QuantizedVertex
+    {
+        unsigned short position[4];
+        short normal[2];
+        short tangent[2];
+        unsigned short uv[2];
+        unsigned char color[4];
+    };
+
+    struct QuantizationSettings
+    {
+        bool halfFloatPositions{false}; // Needs no decode transform, but precision drops far from the origin
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Maps normalized attributes back to their original range as offset + value * scale.
+    */
+    struct QuantizationTransform
+    {
+        glm::vec3 positionOffset{0.0f};
+        glm::vec3 positionScale{1.0f};
+        glm::vec2 uvOffset{0.0f};
+        glm::vec2 uvScale{1.0f};
+
+        /*
+        Prepend it to the model matrix so unmodified vertex shaders receive object space positions.
+        */
+        glm::mat4 get_position_matrix() const;
+    };
+
+    struct QuantizedMeshData
+    {
+        std::vector<QuantizedVertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<Submesh> submeshes;
+        std::vector<std::string> materials;
+        QuantizationTransform transform;
+        bool halfFloatPositions{false};
+    };
+
+    /*
+    Deviation of the quantized attributes from the originals. Angles in radians.
+    */
+    struct QuantizationReport
+    {
+        float maxPositionError{0.0f};
+        float maxNormalError{0.0f};
+        float maxTangentError{0.0f};
+        float maxUVError{0.0f};
+        size_t originalBytes{0};
+        size_t quantizedBytes{0};
+    };
+
+    /*
+    Quantizes the vertices of a mesh. Indices, submeshes and materials are copied as they are.
+    */
+    QuantizationReport quantize_mesh(const MeshData &data, QuantizedMeshData &quantized, QuantizationSettings settings = {});
+
+    /*
+    Takes ownership of quantized data and builds a geometry with the matching normalized attribute layouts, in the same
+    attribute locations as the canonical vertex. Shaders decode normals, tangents and uvs with QuantizedVertexDecodeSource.
+    */
+    Geometry *create_quantized_geometry(QuantizedMeshData &&data, unsigned int primitive = GL_TRIANGLES);
+
+    /*
+    GLSL helpers to paste into vertex shaders reading quantized geometry. Set u_uvOffset and u_uvScale from the
+    quantization transform.
+    */
+    const std::string QuantizedVertexDecodeSource = R"(
+    uniform vec2 u_uvOffset;
+    uniform vec2 u_uvScale;
+
+    vec3 oct_decode(vec2 e)
+    {
+        vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+        float t = max(-v.z, 0.0);
+        v.x += v.x >= 0.0 ? -t : t;
+        v.y += v.y >= 0.0 ? -t : t;
+        return normalize(v);
+    }
+
+    vec2 uv_decode(vec2 uv)
+    {
+        return u_uvOffset + uv * u_uvScale;
+    }
+)";
+
+    struct MeshletSettings
+    {
+        unsigned int maxVertices{64};   // Up to 256, local indices are 8 bit
+        unsigned int maxTriangles{124};
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Clusters of a triangle mesh with bounded vertex and triangle counts, in structure of arrays form. Every per meshlet
+    array is std430 compatible, so each one can be wrapped in a VertexBuffer and bound with bind_base(GL_SHADER_STORAGE_BUFFER).
+    */
+    struct MeshletData
+    {
+        // Per meshlet: vertex offset, vertex count, triangle offset and triangle count
+        std::vector<glm::uvec4> ranges;
+        // Per meshlet: center and radius
+        std::vector<glm::vec4> spheres;
+        // Per meshlet: axis aligned bounds, w unused
+        std::vector<glm::vec4> boundsMin;
+        std::vector<glm::vec4> boundsMax;
+        // Per meshlet: backface cone apex (w unused) and axis with the cutoff in w. Zero axis and cutoff 1 if it can not cull
+        std::vector<glm::vec4> coneApexes;
+        std::vector<glm::vec4> coneAxes;
+
+        // Indices into the geometry vertex buffer, submesh base vertices already applied
+        std::vector<unsigned int> vertices;
+        // Three local vertex indices packed per triangle in the low 24 bits
+        std::vector<unsigned int> triangles;
+        // First meshlet of each submesh plus the total count. Meshlets never span submeshes
+        std::vector<unsigned int> submeshOffsets;
+
+        inline size_t size() const { return ranges.size(); }
+
+        /*
+        True if every triangle of the meshlet faces away from a camera at that position.
+        */
+        inline bool is_backfacing(size_t meshlet, const glm::vec3 &cameraPosition) const
+        {
+            const glm::vec3 direction = glm::vec3(coneApexes[meshlet]) - cameraPosition;
+            const float length = glm::length(direction);
+            return length > 0.0f && glm::dot(direction, glm::vec3(coneAxes[meshlet])) >= coneAxes[meshlet].w * length;
+        }
+    };
+
+    /*
+    Splits the index buffer of each submesh into meshlets and computes their bounding sphere, AABB and normal cone.
+    Triangles are clustered greedily in index order, so run optimize_vertex_cache first for tighter clusters. Long
+    submeshes are split among threads and the bounds are computed in parallel per meshlet.
+    */
+    void build_meshlets(const MeshData &data, MeshletData &meshlets, MeshletSettings settings = {});
+
+    /*
+    Same as above over a geometry whose first vertex buffer still has its CPU data and starts with a float3 position.
+    Returns false if the geometry can not be read.
+    */
+    bool build_meshlets(const Geometry &geometry, MeshletData &meshlets, MeshletSettings settings = {});
+
+    struct LODSettings
+    {
+        std::vector<float> ratios{0.5f, 0.25f, 0.125f}; // Target triangle ratio of each level against the full resolution mesh
+        float maxError{0.05f};                          // Relative to the mesh extent. Levels stop short of their ratio beyond it
+        float attributeWeight{1e-3f};                   // Weight of normal and uv changes when ranking collapses
+        bool lockBorders{true};                         // Keeps open edges in place, including the ones between submeshes
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Builds a level of detail chain with quadric error edge collapses. Vertices only collapse onto existing ones, so every
+    level reuses the vertex buffer and its indices are appended to the index buffer, recorded in data.LODs together with
+    their object space error. Collapses are ranked by quadric error plus the change of normals and uvs, never cross uv
+    seams sideways and never flip triangles. Every level is simplified from the full resolution submeshes, all of them
+    in parallel. A mesh without submeshes gets one covering its full resolution indices, and a level that could not be
+    reduced further than the previous one is skipped, so data.LODs can hold fewer levels than settings.ratios.
+    */
+    void generate_LODs(MeshData &data, LODSettings settings = {});
+
+    enum MipFilter
+    {
+        MIP_FILTER_BOX,    // Area average of the covered texels
+        MIP_FILTER_KAISER, // Kaiser windowed sinc. Sharper, keeps detail that box filtering blurs away
+    };
+
+    struct MipSettings
+    {
+        MipFilter filter{MIP_FILTER_KAISER};
+        bool sRGB{true}; // Color channels of 8 bit images are sRGB encoded and filtered in linear space. Alpha is always linear
+        bool wrap{true}; // Filter across the borders as a repeating texture would. Clamped otherwise
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Every level of an image, largest first, stored back to back with tightly packed rows. Pixels are 8 bit unorm or
+    32 bit float (HDR) with the same amount of channels as the source.
+    */
+    struct MipChain
+    {
+        Extent2D extent{0, 0};
+        unsigned int channels{0};
+        bool HDR{false};
+        bool sRGB{false};
+        unsigned int compressedFormat{0}; // GL compressed internal format if levels hold blocks (see compress_mip_chain)
+
+        std::vector<unsigned char> data;
+        std::vector<size_t> levelOffsets; // One entry per level plus the total size
+
+        inline size_t get_level_count() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+        inline Extent2D get_level_extent(size_t level) const { return {std::max(extent.width >> level, 1), std::max(extent.height >> level, 1)}; }
+        inline const unsigned char *get_level_data(size_t level) const { return data.data() + levelOffsets[level]; }
+        inline size_t get_level_size(size_t level) const { return levelOffsets[level + 1] - levelOffsets[level]; }
+    };
+
+    /*
+    Builds the full mip chain of an image down to 1x1. Each level is filtered from the previous one kept in linear float
+    precision, separably (rows, then columns), with rows split among threads and four floats per SSE2 operation. Level 0
+    is the source, copied as is.
+    */
+    void generate_mip_chain(const unsigned char *pixels, Extent2D extent, unsigned int channels, MipChain &chain, MipSettings settings = {});
+    void generate_mip_chain(const float *pixels, Extent2D extent, unsigned int channels, MipChain &chain, MipSettings settings = {});
+
+    /*
+    Texture levels pointing into in-memory chains (one per face), which storage keeps alive.
+    */
+    TextureLevels get_texture_levels(const MipChain *faces, unsigned int faceCount, std::shared_ptr<const void> storage);
+
+    enum BlockFormat
+    {
+        BLOCK_FORMAT_BC1, // RGB, 8 bytes per block
+        BLOCK_FORMAT_BC3, // RGBA, 16 bytes per block
+        BLOCK_FORMAT_BC4, // R, 8 bytes per block
+        BLOCK_FORMAT_BC5, // RG, 16 bytes per block. Normal maps
+        BLOCK_FORMAT_BC7, // RGBA, 16 bytes per block. Best quality
+    };
+
+    enum BlockQuality
+    {
+        BLOCK_QUALITY_FAST,   // Principal axis endpoints only
+        BLOCK_QUALITY_NORMAL, // Plus least squares endpoint refinement and BC7 p-bit search
+        BLOCK_QUALITY_HIGH,   // Plus a local search around the endpoints
+    };
+
+    struct BlockCompressionSettings
+    {
+        BlockFormat format{BLOCK_FORMAT_BC7};
+        BlockQuality quality{BLOCK_QUALITY_NORMAL};
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Compressed internal format to upload blocks with. Always the UNORM variant, so compressed textures sample the same
+    values as their uncompressed counterparts.
+    */
+    unsigned int get_block_format_GL(BlockFormat format);
+    size_t get_block_size(BlockFormat format);
+
+    /*
+    Encodes an 8 bit image into 4x4 blocks, row by row of blocks. Channels follow GL sampling rules: BC4 takes red, BC5
+    red and green, BC1 rgb, and missing channels read as 0 (alpha as 255). Border blocks repeat the edge texels. Block
+    rows are split among threads and the 16 texels of a block are matched against the palette four at a time with SSE2.
+    BC7 blocks are always written in mode 6 (one subset, rgba endpoints with p-bits and 4 bit indices).
+    */
+    void compress_blocks(const unsigned char *pixels, Extent2D extent, unsigned int channels, std::vector<unsigned char> &blocks, BlockCompressionSettings settings = {});
+
+    /*
+    Compresses every level of an 8 bit mip chain. Returns false for HDR chains.
+    */
+    bool compress_mip_chain(const MipChain &chain, MipChain &compressed, BlockCompressionSettings settings = {});
+
+    /*
+    Decodes blocks back into RGBA8 texels, for validation without a GPU. BC7 only decodes mode 6 blocks.
+    */
+    void decompress_blocks(const unsigned char *blocks, Extent2D extent, BlockFormat format, unsigned char *pixels);
+
+    struct CubemapSettings
+    {
+        int resolution{0}; // Face size. 0 picks a quarter of the panorama width, which keeps its texel density
+        bool tonemap{true}; // Reinhard and gamma 2.2, the same output the GPU converter (Texture::panorama_to_cubemap) gives
+        bool mipmaps{true};
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Faces in GL order (+X, -X, +Y, -Y, +Z, -Z), each one with its own chain of float texels. Face rows go upwards,
+    the way the GPU converter renders them.
+    */
+    struct CubemapData
+    {
+        MipChain faces[6];
+
+        inline int get_resolution() const { return faces[0].extent.width; }
+    };
+
+    /*
+    Projects an equirectangular HDR panorama onto the six faces of a cubemap. Every face row is an independent task, so
+    all faces are filled in parallel. Directions, their spherical coordinates and the bilinear footprints are computed
+    for four texels at once with SSE2, using a polynomial atan2 accurate to about 1e-5 radians.
+    */
+    void panorama_to_cubemap(const float *pixels, Extent2D extent, unsigned int channels, CubemapData &cubemap, CubemapSettings settings = {});
+
+    /*
+    Projects an HDR cubemap onto nine spherical harmonics, convolved with the clamped cosine lobe (see SphericalHarmonics).
+    Texel directions follow GL cubemap sampling rules, so they match the lookups of the convolution shader, and every
+    texel is weighted by its exact solid angle. Nine coefficients can not hold more detail than a small face, so the
+    largest level not bigger than maxResolution is projected. Face rows are split among threads, which reduce four
+    texels at once with SSE2 into their own sums. Returns false for non HDR cubemaps.
+    */
+    bool project_irradiance_SH(const CubemapData &cubemap, SphericalHarmonics &sh, int maxResolution = 128, unsigned int threadCount = 0);
+
+    /*
+    Evaluates the coefficients on every texel of a cubemap with a single level, following GL cubemap sampling rules.
+    */
+    void bake_irradiance_SH(const SphericalHarmonics &sh, int resolution, CubemapData &cubemap);
+
+    struct SpecularSettings
+    {
+        int resolution{128}; // Face size of the sharpest level. Clamped to the environment size
+        int levelCount{6};   // Roughness of level i is i / (levelCount - 1), so shaders sample lod roughness * (levelCount - 1)
+        unsigned int sampleCount{256};
+        unsigned int threadCount{0};
+    };
+
+    /*
+    Prefilters an HDR environment for split sum specular lighting: every level holds the GGX lobe of its roughness
+    integrated with importance sampling, assuming n = v = r. Each sample is fetched trilinearly from a mip whose texels
+    cover the solid angle the sample stands for, which removes the aliasing of bright spots with few samples. The
+    sample pattern only depends on the roughness, so it is built once per level and rotated around every texel. Face
+    rows are split among threads. Level 0 is the environment itself, resampled to the resolution.
+    */
+    void prefilter_specular(const CubemapData &environment, CubemapData &prefiltered, SpecularSettings settings = {});
+
+    /*
+    Split sum BRDF integration lookup table: scale (red) and bias (green) applied to F0, for n dot v in x and roughness
+    in y, with the same GGX and Schlick-GGX terms as cook-torrance.glsl (k = roughness^2 / 2 for image based lighting).
+    */
+    void integrate_BRDF(int resolution, unsigned int sampleCount, MipChain &lut, unsigned int threadCount = 0);
+}
+
+GLSP_NAMESPACE_END
+
+#endif
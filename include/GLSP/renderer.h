@@ -55,6 +55,8 @@ struct ContextSettings
     int OpenGLMajor{4};
     int OpenGLMinor{6};
     int OpenGLProfile{GLFW_OPENGL_CORE_PROFILE};
+    // Creates and updates GPU resources through Direct State Access. Needs a GL 4.5 context
+    bool directStateAccess{false};
 };
 
 struct RendererSettings
@@ -65,6 +67,7 @@ struct RendererSettings
     bool depthTest{true};
     bool depthWrites{true};
     bool blending{true};
+    double uploadBudget{4.0}; // Milliseconds per frame spent uploading asynchronously loaded assets. 0 means unlimited
 };
 
 /*
@@ -67,6 +67,12 @@ public:
 
     inline ShaderType get_type() { return m_type; }
 
+    /*
+    Compiles and links new sources. On success the program replaces the current one, so uniforms and uniform block
+    bindings have to be set again. On failure errors are logged and the current program is kept.
+    */
+    bool reload(const ShaderStageSource &source);
+
 #pragma region LEGACY UNIFORM PIPELINE
 
     void set_bool(const char *name, bool value) const;
@@ -66,24 +66,97 @@ struct Image
     bool panorama{false};
 };
 
+/*
+Precomputed mip levels uploaded as they are, skipping glGenerateMipmap. Level pointers usually point inside a mapped
+texture cache file, which storage keeps alive. Cubemaps have six faces in GL order, their levels stored face after face.
+*/
+struct TextureLevels
+{
+    std::vector<const void *> data;
+    std::vector<Extent2D> extents; // Per level, shared by every face
+    std::vector<size_t> sizes;
+    unsigned int faceCount{1};
+
+    unsigned int format{GL_RGBA};
+    unsigned int dataType{GL_UNSIGNED_BYTE};
+    unsigned int compressedFormat{0}; // If not 0, levels hold blocks of this compressed internal format
+
+    std::shared_ptr<const void> storage;
+
+    inline size_t get_level_count() const { return extents.size(); }
+    inline const void *get_data(unsigned int face, size_t level) const { return data[face * extents.size() + level]; }
+};
+
+/*
+Nine RGB coefficients of an L2 spherical harmonics irradiance approximation, with the clamped cosine convolution already
+applied. Evaluating them gives the same values an irradiance map from the convolution shader holds. Shaders can
+evaluate them with utils::SHIrradianceSource.
+*/
+struct SphericalHarmonics
+{
+    glm::vec3 coefficients[9]{};
+
+    inline glm::vec3 evaluate(const glm::vec3 &n) const
+    {
+        const glm::vec3 irradiance = coefficients[0] * 0.282095f +
+                                     (coefficients[1] * n.y + coefficients[2] * n.z + coefficients[3] * n.x) * 0.488603f +
+                                     (coefficients[4] * (n.x * n.y) + coefficients[5] * (n.y * n.z) + coefficients[7] * (n.x * n.z)) * 1.092548f +
+                                     coefficients[6] * (0.315392f * (3.0f * n.z * n.z - 1.0f)) +
+                                     coefficients[8] * (0.546274f * (n.x * n.x - n.y * n.y));
+        return glm::max(irradiance, glm::vec3(0.0f));
+    }
+};
+
+enum IrradianceMethod
+{
+    IRRADIANCE_CONVOLUTION,          // Hemisphere integration per texel in a fragment shader
+    IRRADIANCE_SPHERICAL_HARMONICS, // Projection onto spherical harmonics on CPU, then evaluated per texel
+};
+
 /*
 Wrapper of the OpenGL texture object.
 */
 class Texture
 {
 protected:
-    unsigned int m_id;
+    unsigned int m_id{0};
 
     Extent2D m_extent{};
 
     TextureConfig m_config{};
 
     Image m_image{};
+    TextureLevels m_levels{};
 
     bool m_generated{false};
+    bool m_immutable{false};
+    int m_storageFormat{0};       // Internal format of the immutable storage
+    size_t m_storageLevelCount{0}; // Levels of the immutable storage
 
     void setup();
 
+    /*
+    Direct State Access version of setup(). Storage is always immutable and filled through the texture name.
+    */
+    void setup_direct(const void *data, bool uploadLevels);
+
+    /*
+    Converts panoramas and frees the image cache, once the storage is set up.
+    */
+    void finish_setup();
+
+    /*
+    Immutable storage filled with every face and level of m_levels.
+    */
+    void upload_levels();
+
+    /*
+    Copies every face and level of m_levels into the immutable storage, bound unless using Direct State Access.
+    */
+    void upload_level_data();
+
+    int get_storage_format(const TextureLevels &levels) const;
+
     /*
    Utily function in case a panorama image is loaded. It converts it to a usable cubemap format.
    */
@@ -106,6 +179,21 @@ public:
     inline Image get_image() const { return m_image; }
     inline void set_image(Image img) { m_image = img; }
 
+    inline const TextureLevels &get_levels() const { return m_levels; }
+    /*
+    2D and cubemap textures with levels matching their extent (and face count) are created with immutable storage and
+    every level is uploaded from them. Levels are released after generating if freeImageCacheOnGenerate is set.
+    */
+    inline void set_levels(TextureLevels levels) { m_levels = std::move(levels); }
+
+    /*
+    Replaces the content of a generated texture by new levels. If they fit its immutable storage (same extent, level
+    count, face count and format) they are written in place and the texture object is kept, otherwise the texture is
+    set up again for them. Returns true if the storage was reused. Textures not generated yet just take the levels
+    and their extent.
+    */
+    bool update_levels(TextureLevels levels);
+
     inline Extent2D get_extent() const { return m_extent; }
     void set_extent(Extent2D extent);
 
@@ -117,6 +205,11 @@ public:
 
     virtual void unbind() const;
 
+    /*
+    Sets the texture up again with the new extent. Immutable storage (always the case with Direct State Access) can not
+    be respecified, so the texture gets a new name and get_id() changes: anything holding the old one, like framebuffer
+    attachments or bindless handles, has to pick it up again.
+    */
     virtual void resize(Extent2D extent);
 
     inline bool is_generated() const { return m_generated; }
@@ -125,7 +218,29 @@ public:
 
     void generate_mipmaps();
 
-    Texture *compute_irradiance(int resolution = 32);
+    /*
+    Diffuse irradiance cubemap of this cubemap. The convolution method samples the whole hemisphere for every texel,
+    the spherical harmonics method bakes the result of compute_irradiance_SH instead and takes milliseconds.
+    */
+    Texture *compute_irradiance(int resolution = 32, IrradianceMethod method = IRRADIANCE_CONVOLUTION);
+
+    /*
+    Projects this cubemap onto spherical harmonics. Reads back a level of at most 128 texels per side, so mipmaps make
+    it faster. Returns false if the texture is not a generated cubemap.
+    */
+    bool compute_irradiance_SH(SphericalHarmonics &sh, unsigned int threadCount = 0);
+
+    /*
+    Split sum specular environment of this cubemap: levelCount mips of GGX prefiltered radiance, roughness growing linearly
+    up to 1 in the last one (see processing::prefilter_specular). Bakes are cached on disk keyed by the hash of the
+    read back texels and the parameters, so an environment is only prefiltered once.
+    */
+    Texture *compute_specular(int resolution = 128, int levelCount = 6, unsigned int sampleCount = 256);
+
+    /*
+    RG16F BRDF integration lookup table that goes along with compute_specular, cached on disk as well.
+    */
+    static Texture *compute_BRDF_LUT(int resolution = 256, unsigned int sampleCount = 512);
 };
 
 GLSP_NAMESPACE_END
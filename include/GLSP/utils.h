@@ -15,6 +15,18 @@
 #include <deque>
 #include <fstream>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <vector>
+#include <string_view>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
 #include <GLSP/core.h>
 
 GLSP_NAMESPACE_BEGIN
@@ -56,6 +68,166 @@ namespace utils
         const double &get() { return timestamp; }
     };
 
+    /*
+    Number of worker threads used by default in parallel tasks. Never less than one.
+    */
+    inline unsigned int get_thread_count()
+    {
+        const unsigned int count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+    /*
+    Splits the range [0, count) in contiguous blocks and runs the task over them concurrently, one block per thread.
+    Blocks the caller until every block has been processed. Task signature is (begin, end, blockIndex).
+    */
+    void parallel_for(size_t count, const std::function<void(size_t, size_t, size_t)> &task, unsigned int threadCount = 0);
+
+    /*
+    Fixed size pool of worker threads consuming a FIFO of tasks. Destroying it waits for the queued tasks to finish.
+    */
+    class ThreadPool
+    {
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stopping{false};
+
+        void work();
+
+    public:
+        ThreadPool(unsigned int threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void enqueue(std::function<void()> &&task);
+
+        /*
+        Enqueues a callable and returns a future to its result.
+        */
+        template <typename F>
+        auto submit(F &&task) -> std::future<decltype(task())>
+        {
+            auto packaged = std::make_shared<std::packaged_task<decltype(task())()>>(std::forward<F>(task));
+            std::future<decltype(task())> result = packaged->get_future();
+            enqueue([packaged]()
+                    { (*packaged)(); });
+            return result;
+        }
+
+        inline size_t get_thread_count() const { return m_workers.size(); }
+    };
+
+    /*
+    Fast ASCII float parser. Skips leading blanks and returns the pointer past the parsed number, or the
+    input pointer if no number could be read. Most inputs are handled exactly in a fast path, the rest fall back to strtod.
+    */
+    inline const char *parse_float(const char *p, const char *end, float &value)
+    {
+        static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        const char *const input = p;
+        while (p < end && (*p == ' ' || *p == '\t'))
+            p++;
+        const char *start = p;
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*p - '0');
+                if (mantissa)
+                    digits++;
+            }
+            else
+                exponent++;
+            anyDigit = true;
+            p++;
+        }
+        if (p < end && *p == '.')
+        {
+            p++;
+            while (p < end && *p >= '0' && *p <= '9')
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + uint64_t(*p - '0');
+                    if (mantissa)
+                        digits++;
+                    exponent--;
+                }
+                anyDigit = true;
+                p++;
+            }
+        }
+        if (!anyDigit)
+        {
+            // Might still be inf or nan. Leave it to the C runtime
+            char buffer[32];
+            size_t length = 0;
+            while (start + length < end && length < sizeof(buffer) - 1 && start[length] > ' ')
+            {
+                buffer[length] = start[length];
+                length++;
+            }
+            buffer[length] = '\0';
+            char *parsedEnd = nullptr;
+            const double fallback = std::strtod(buffer, &parsedEnd);
+            if (parsedEnd == buffer)
+                return input;
+            value = static_cast<float>(fallback);
+            return start + (parsedEnd - buffer);
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char *e = p + 1;
+            bool negativeExponent = false;
+            if (e < end && (*e == '-' || *e == '+'))
+                negativeExponent = *e++ == '-';
+            if (e < end && *e >= '0' && *e <= '9')
+            {
+                int explicitExponent = 0;
+                while (e < end && *e >= '0' && *e <= '9')
+                {
+                    if (explicitExponent < 10000)
+                        explicitExponent = explicitExponent * 10 + (*e - '0');
+                    e++;
+                }
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                p = e;
+            }
+        }
+
+        double result;
+        if (mantissa == 0)
+            result = 0.0;
+        else if (mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+            // Exact in double precision (Clinger fast path)
+            result = exponent < 0 ? double(mantissa) / POW10[-exponent] : double(mantissa) * POW10[exponent];
+        else
+        {
+            char buffer[64];
+            const size_t length = std::min<size_t>(p - start, sizeof(buffer) - 1);
+            memcpy(buffer, start, length);
+            buffer[length] = '\0';
+            value = static_cast<float>(std::strtod(buffer, nullptr));
+            return p;
+        }
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
     struct memory_buffer : public std::streambuf
     {
         char *p_start{nullptr};
@@ -88,24 +260,107 @@ namespace utils
         memory_stream(char const *first_elem, size_t size)
             : memory_buffer(first_elem, size), std::istream(static_cast<std::streambuf *>(this)) {}
     };
-    inline std::vector<uint8_t> read_file_binary(const std::string &pathToFile)
+    /*
+    How a mapped file is going to be read, passed to the OS as a paging hint.
+    */
+    enum FileAccess
     {
-        std::ifstream file(pathToFile, std::ios::binary);
-        std::vector<uint8_t> fileBufferBytes;
+        FILE_ACCESS_DEFAULT,
+        FILE_ACCESS_SEQUENTIAL, // Read front to back (parsers): aggressive read-ahead, pages requested upfront
+        FILE_ACCESS_RANDOM,     // Scattered reads (caches with indices): no read-ahead
+    };
 
-        if (file.is_open())
-        {
-            file.seekg(0, std::ios::end);
-            size_t sizeBytes = file.tellg();
-            file.seekg(0, std::ios::beg);
-            fileBufferBytes.resize(sizeBytes);
-            if (file.read((char *)fileBufferBytes.data(), sizeBytes))
-                return fileBufferBytes;
-        }
-        else
-            throw std::runtime_error("could not open binary ifstream to path " + pathToFile);
-        return fileBufferBytes;
+    /*
+    Read-only view of a whole file. It is memory mapped, so pages are loaded lazily by the OS, opening is cheap and nothing
+    is copied. Files that can not be mapped (pipes, some network or virtual file systems) are read into a buffer instead,
+    transparently for the reader.
+    */
+    class MappedFile
+    {
+        const uint8_t *m_data{nullptr};
+        size_t m_size{0};
+        std::unique_ptr<uint8_t[]> m_buffer; // Only used by the buffered fallback
+#ifdef _WIN32
+        void *m_fileHandle{nullptr};
+        void *m_mappingHandle{nullptr};
+#else
+        int m_fileDescriptor{-1};
+#endif
+
+        void read_buffered(const std::string &pathToFile);
+
+    public:
+        /*
+        Throws std::runtime_error if the file can not be opened or read.
+        */
+        MappedFile(const std::string &pathToFile, FileAccess access = FILE_ACCESS_DEFAULT);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        inline const uint8_t *get_data() const { return m_data; }
+        inline size_t get_size() const { return m_size; }
+        inline std::string_view get_text() const { return std::string_view(reinterpret_cast<const char *>(m_data), m_size); }
+        inline bool is_mapped() const { return !m_buffer && m_data; }
+    };
+
+    /*
+    Owning copy of a whole file. Prefer MappedFile, which reads it in place.
+    */
+    inline std::vector<uint8_t> read_file_binary(const std::string &pathToFile)
+    {
+        const MappedFile file(pathToFile, FILE_ACCESS_SEQUENTIAL);
+        return std::vector<uint8_t>(file.get_data(), file.get_data() + file.get_size());
     }
+
+    /*
+    Reports files modified on disk. On Linux it listens to inotify events of their directories, so files replaced by
+    editors that save through a rename are still tracked, and polling costs a single non blocking read. Elsewhere, or if
+    inotify is not available, modification times are compared at most every POLL_INTERVAL_MS milliseconds.
+    */
+    class FileWatcher
+    {
+        std::unordered_map<std::string, std::filesystem::file_time_type> m_files; // Absolute path, last seen modification time
+        std::chrono::steady_clock::time_point m_lastScan{};
+#ifdef __linux__
+        int m_inotify{-1};
+        std::unordered_map<int, std::string> m_directories; // Watch descriptor, absolute directory
+#endif
+
+        void scan(std::vector<std::string> &changed, size_t first);
+
+    public:
+        static constexpr int POLL_INTERVAL_MS = 250;
+
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        /*
+        Returns false if the directory of the file can not be watched.
+        */
+        bool add(const std::string &pathToFile);
+        void remove(const std::string &pathToFile);
+
+        /*
+        Non blocking. Appends the absolute path of every watched file written since the last call, once per file.
+        */
+        size_t poll(std::vector<std::string> &changed);
+
+        static std::string get_absolute_path(const std::string &pathToFile);
+    };
+
+    /*
+    Fast non-cryptographic 64 bit hash of a block of memory.
+    */
+    uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0);
+
+    /*
+    Unit tangent of a triangle from its positions and uvs, orthogonalized against the (unit) normal. Zero if the uvs are degenerate.
+    */
     glm::vec3 get_tangent_gram_smidt(glm::vec3 &p1, glm::vec3 &p2, glm::vec3 &p3, glm::vec2 &uv1, glm::vec2 &uv2, glm::vec2 &uv3, glm::vec3 normal);
 
     template <typename T, typename... Rest>
@@ -257,6 +512,21 @@ void main()
 
 )";
 
+// Evaluation of SphericalHarmonics coefficients, to paste in shaders that sample irradiance from them instead of a cubemap
+const std::string SHIrradianceSource = R"(
+    uniform vec3 u_SH[9];
+
+    vec3 irradianceSH(vec3 n)
+    {
+        vec3 irradiance = u_SH[0] * 0.282095
+                        + (u_SH[1] * n.y + u_SH[2] * n.z + u_SH[3] * n.x) * 0.488603
+                        + (u_SH[4] * (n.x * n.y) + u_SH[5] * (n.y * n.z) + u_SH[7] * (n.x * n.z)) * 1.092548
+                        + u_SH[6] * (0.315392 * (3.0 * n.z * n.z - 1.0))
+                        + u_SH[8] * (0.546274 * (n.x * n.x - n.y * n.y));
+        return max(irradiance, vec3(0.0));
+    }
+)";
+
 // Vertex data for a cube
 const float cubeVertices[] = {
     // positions        
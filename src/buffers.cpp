@@ -8,29 +8,111 @@
     Copyright (c) 2024 Antonio Espinosa Garcia
 
 */
+#include <algorithm>
 #include <GLSP/buffers.h>
 
 GLSP_NAMESPACE_BEGIN
-VertexBuffer::VertexBuffer(void *data, const size_t sizeInBytes) : Buffer(), m_strideBytes(0), m_data(nullptr), m_totalBytes(sizeInBytes)
+VertexBuffer::VertexBuffer(const void *data, const size_t sizeInBytes)
+    : VertexBuffer(std::vector<uint8_t>(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + sizeInBytes))
+{
+}
+
+VertexBuffer::VertexBuffer(const void *data, const size_t sizeInBytes, std::shared_ptr<const void> storage)
+    : Buffer(), m_strideBytes(0), m_data(data), m_totalBytes(sizeInBytes), m_storage(std::move(storage))
 {
-    m_data = malloc(sizeInBytes);
-    memcpy(m_data, data, sizeInBytes);
 }
 
 VertexBuffer::~VertexBuffer()
 {
+    if (m_generated)
+    {
+        GL_CHECK(glDeleteBuffers(1, &m_id));
+    }
+}
 
+void VertexBuffer::release_data()
+{
+    m_data = nullptr;
+    m_storage.reset();
 }
 
 void VertexBuffer::upload_data()
 {
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glNamedBufferData(m_id, m_totalBytes, m_data, GL_STATIC_DRAW));
+        return;
+    }
     bind();
     GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_totalBytes, m_data, GL_STATIC_DRAW));
     unbind();
 }
+
+void VertexBuffer::upload_data(const size_t sizeInBytes, const void *data, const size_t offset) const
+{
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glNamedBufferSubData(m_id, offset, sizeInBytes, data));
+        return;
+    }
+    bind();
+    GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, offset, sizeInBytes, data));
+    unbind();
+}
+
+namespace
+{
+    bool same_layouts(const std::vector<AttributeLayout> &a, const std::vector<AttributeLayout> &b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const AttributeLayout &x, const AttributeLayout &y)
+                                                  { return x.type == y.type && x.count == y.count && x.normalized == y.normalized && x.location == y.location && x.offset == y.offset; });
+    }
+}
+
+bool VertexBuffer::update_data(const VertexBuffer &source)
+{
+    if (m_strideBytes != source.m_strideBytes || !same_layouts(m_layouts, source.m_layouts))
+        return false;
+    const bool sameSize = m_totalBytes == source.m_totalBytes;
+    m_data = source.m_data;
+    m_storage = source.m_storage;
+    m_totalBytes = source.m_totalBytes;
+    // Storage stays mutable under the name, so that a reload of a different size keeps the VAO bindings
+    if (uses_direct_state_access())
+    {
+        if (sameSize)
+        {
+            GL_CHECK(glNamedBufferSubData(m_id, 0, m_totalBytes, m_data));
+        }
+        else
+        {
+            GL_CHECK(glNamedBufferData(m_id, m_totalBytes, m_data, GL_STATIC_DRAW));
+        }
+        return true;
+    }
+    bind();
+    if (sameSize)
+    {
+        GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, m_totalBytes, m_data));
+    }
+    else
+    {
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_totalBytes, m_data, GL_STATIC_DRAW));
+    }
+    unbind();
+    return true;
+}
+
 void VertexBuffer::generate()
 {
-    GL_CHECK(glGenBuffers(1, &m_id));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateBuffers(1, &m_id));
+    }
+    else
+    {
+        GL_CHECK(glGenBuffers(1, &m_id));
+    }
     m_generated = true;
 }
 
@@ -50,17 +132,30 @@ void VertexBuffer::bind_base(unsigned int type, unsigned int readLayout) const
 }
 void VertexBuffer::read_data(void *readData, size_t offset, size_t sizeInBytes) const
 {
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glGetNamedBufferSubData(m_id, offset, sizeInBytes == 0 ? m_totalBytes : sizeInBytes, readData));
+        return;
+    }
     bind();
     GL_CHECK(glGetBufferSubData(GL_ARRAY_BUFFER, offset, sizeInBytes == 0 ? m_totalBytes : sizeInBytes, readData));
     unbind();
 }
 VertexArray::~VertexArray()
 {
-    //  GL_CHECK(glDeleteVertexArrays(1, &m_id))
+    if (m_generated)
+    {
+        GL_CHECK(glDeleteVertexArrays(1, &m_id));
+    }
 }
 
 void VertexArray::generate()
 {
+    if (uses_direct_state_access())
+    {
+        generate_direct();
+        return;
+    }
     GL_CHECK(glGenVertexArrays(1, &m_id));
     bind();
     for (VertexBuffer &vbo : m_VBOs)
@@ -73,14 +168,49 @@ void VertexArray::generate()
         for (int i = 0; i < layouts.size(); i++)
         {
             const auto &layout = layouts[i];
-            GL_CHECK(glEnableVertexAttribArray(m_layoutCount));
-            GL_CHECK(glVertexAttribPointer(m_layoutCount, layout.count, layout.type,
+            const unsigned int location = layout.location >= 0 ? layout.location : m_layoutCount;
+            if (layout.offset >= 0)
+                offset = layout.offset;
+            GL_CHECK(glEnableVertexAttribArray(location));
+            GL_CHECK(glVertexAttribPointer(location, layout.count, layout.type,
                                            layout.normalized, vbo.get_stride_size(), (void *)offset));
             offset += layout.count * AttributeLayout::get_size(layout.type);
+            m_lastLocation = location;
             m_layoutCount++;
         }
     }
     unbind();
+    validate_layouts();
+}
+
+void VertexArray::generate_direct()
+{
+    GL_CHECK(glCreateVertexArrays(1, &m_id));
+    for (VertexBuffer &vbo : m_VBOs)
+    {
+        vbo.generate();
+        vbo.upload_data();
+        size_t offset = 0;
+        for (const AttributeLayout &layout : vbo.get_layouts())
+        {
+            const unsigned int location = layout.location >= 0 ? layout.location : m_layoutCount;
+            if (layout.offset >= 0)
+                offset = layout.offset;
+            // A binding per attribute, named as its location, so that divisors keep applying to single attributes
+            GL_CHECK(glVertexArrayVertexBuffer(m_id, location, vbo.get_id(), GLintptr(offset), vbo.get_stride_size()));
+            GL_CHECK(glVertexArrayAttribFormat(m_id, location, layout.count, layout.type, layout.normalized, 0));
+            GL_CHECK(glVertexArrayAttribBinding(m_id, location, location));
+            GL_CHECK(glEnableVertexArrayAttrib(m_id, location));
+            offset += layout.count * AttributeLayout::get_size(layout.type);
+            m_lastLocation = location;
+            m_layoutCount++;
+        }
+    }
+    validate_layouts();
+}
+
+void VertexArray::validate_layouts()
+{
     if (m_layoutCount == 0)
     {
         if (m_VBOs.empty())
@@ -106,33 +236,124 @@ void VertexArray::unbind() const
     GL_CHECK(glBindVertexArray(0));
 }
 
-void VertexArray::push_vertex_buffer(const VertexBuffer vbo)
+void VertexArray::set_index_buffer(const IndexBuffer &ibo) const
 {
-    m_VBOs.push_back(vbo);
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glVertexArrayElementBuffer(m_id, ibo.get_id()));
+        return;
+    }
+    bind();
+    ibo.bind();
+    unbind();
+}
+
+void VertexArray::push_vertex_buffer(VertexBuffer &&vbo)
+{
+    m_VBOs.push_back(std::move(vbo));
+}
+
+void VertexArray::release_data()
+{
+    for (VertexBuffer &vbo : m_VBOs)
+        vbo.release_data();
+}
+
+bool VertexArray::update_vertex_buffers(const VertexArray &source)
+{
+    if (!m_generated || m_VBOs.size() != source.m_VBOs.size())
+        return false;
+    for (size_t i = 0; i < m_VBOs.size(); i++)
+        if (m_VBOs[i].get_stride_size() != source.m_VBOs[i].get_stride_size() || !same_layouts(m_VBOs[i].get_layouts(), source.m_VBOs[i].get_layouts()))
+            return false;
+    for (size_t i = 0; i < m_VBOs.size(); i++)
+        m_VBOs[i].update_data(source.m_VBOs[i]);
+    return true;
 }
 
 void VertexArray::set_layout_divisor(const unsigned int divisor)
 {
-    GL_CHECK(glVertexAttribDivisor(m_layoutCount - 1, divisor));
+    if (uses_direct_state_access())
+    {
+        // Bindings are named as the location of their attribute
+        GL_CHECK(glVertexArrayBindingDivisor(m_id, m_lastLocation, divisor));
+        return;
+    }
+    GL_CHECK(glVertexAttribDivisor(m_lastLocation, divisor));
 }
 
 IndexBuffer::~IndexBuffer()
 {
+    if (m_generated)
+    {
+        GL_CHECK(glDeleteBuffers(1, &m_id));
+    }
+}
+
+void IndexBuffer::release_data()
+{
+    std::vector<unsigned int>().swap(m_indices);
+    m_externalIndices = nullptr;
+    m_storage.reset();
 }
 
 void IndexBuffer::generate()
 {
-    GL_CHECK(glGenBuffers(1, &m_id));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateBuffers(1, &m_id));
+    }
+    else
+    {
+        GL_CHECK(glGenBuffers(1, &m_id));
+    }
     m_generated = true;
 }
 
 void IndexBuffer::upload_data()
 {
     ASSERT(sizeof(GLuint) == sizeof(unsigned int));
+    // Attached to its VAO with VertexArray::set_index_buffer()
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glNamedBufferData(m_id, m_totalBytes, get_data(), GL_STATIC_DRAW));
+        return;
+    }
     bind();
-    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_totalBytes, m_indices.data(), GL_STATIC_DRAW));
+    GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_totalBytes, get_data(), GL_STATIC_DRAW));
     // unbind();
 }
+void IndexBuffer::update_data(const IndexBuffer &source)
+{
+    const bool sameSize = m_totalBytes == source.m_totalBytes;
+    m_indices = source.m_indices;
+    m_externalIndices = source.m_externalIndices;
+    m_storage = source.m_storage;
+    m_totalBytes = source.m_totalBytes;
+    if (uses_direct_state_access())
+    {
+        if (sameSize)
+        {
+            GL_CHECK(glNamedBufferSubData(m_id, 0, m_totalBytes, get_data()));
+        }
+        else
+        {
+            GL_CHECK(glNamedBufferData(m_id, m_totalBytes, get_data(), GL_STATIC_DRAW));
+        }
+        return;
+    }
+    // Bound to the VAO of the caller, which owns the element array binding
+    bind();
+    if (sameSize)
+    {
+        GL_CHECK(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_totalBytes, get_data()));
+    }
+    else
+    {
+        GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_totalBytes, get_data(), GL_STATIC_DRAW));
+    }
+}
+
 void IndexBuffer::bind() const
 {
     GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id));
@@ -145,10 +366,18 @@ void IndexBuffer::unbind() const
 
 void UniformBuffer::generate()
 {
-    GL_CHECK(glGenBuffers(1, &m_id));
-    GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, m_id));
-    GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, BYTES, NULL, GL_STATIC_DRAW));
-    GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateBuffers(1, &m_id));
+        GL_CHECK(glNamedBufferStorage(m_id, BYTES, NULL, GL_DYNAMIC_STORAGE_BIT));
+    }
+    else
+    {
+        GL_CHECK(glGenBuffers(1, &m_id));
+        GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, m_id));
+        GL_CHECK(glBufferData(GL_UNIFORM_BUFFER, BYTES, NULL, GL_STATIC_DRAW));
+        GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+    }
 
     size_t i = 0;
     for (Layout &layout : m_layouts)
@@ -161,6 +390,11 @@ void UniformBuffer::generate()
 
 void UniformBuffer::upload_data(const size_t sizeInBytes, const void *data, const size_t offset) const
 {
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glNamedBufferSubData(m_id, offset, sizeInBytes, data));
+        return;
+    }
     GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, m_id));
     glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeInBytes, data);
     GL_CHECK(glBindBuffer(GL_UNIFORM_BUFFER, 0));
@@ -179,4 +413,120 @@ void UniformBuffer::unbind() const
 UniformBuffer::~UniformBuffer(){
     GL_CHECK(glDeleteBuffers(1, &m_id))}
 
+RingBuffer::RingBuffer(const size_t frameBytes, const unsigned int framesInFlight)
+    : Buffer(), m_frameBytes(frameBytes), m_frameCount(std::max(framesInFlight, 1u)), m_fences(m_frameCount, nullptr)
+{
+}
+
+RingBuffer::~RingBuffer()
+{
+    if (!m_generated)
+        return;
+    for (GLsync fence : m_fences)
+        if (fence)
+            glDeleteSync(fence);
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glUnmapNamedBuffer(m_id));
+    }
+    else
+    {
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_id));
+        GL_CHECK(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    }
+    GL_CHECK(glDeleteBuffers(1, &m_id));
+}
+
+void RingBuffer::generate()
+{
+    // Regions start aligned for any kind of range binding
+    GLint uniformAlignment = 1, storageAlignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    m_alignment = size_t(std::max({uniformAlignment, storageAlignment, 16}));
+    m_frameBytes = (m_frameBytes + m_alignment - 1) / m_alignment * m_alignment;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr bytes = GLsizeiptr(m_frameBytes * m_frameCount);
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateBuffers(1, &m_id));
+        GL_CHECK(glNamedBufferStorage(m_id, bytes, nullptr, flags));
+        m_mapped = static_cast<uint8_t *>(glMapNamedBufferRange(m_id, 0, bytes, flags));
+    }
+    else
+    {
+        GL_CHECK(glGenBuffers(1, &m_id));
+        // Bound to a target without side effects on vertex or uniform state
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, m_id));
+        GL_CHECK(glBufferStorage(GL_COPY_WRITE_BUFFER, bytes, nullptr, flags));
+        m_mapped = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes, flags));
+        GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    }
+    if (!m_mapped)
+    {
+        ERR_LOG("Ring buffer could not be persistently mapped");
+        return;
+    }
+    m_frame = m_frameCount - 1;
+    m_generated = true;
+}
+
+void RingBuffer::bind() const
+{
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_id));
+}
+
+void RingBuffer::unbind() const
+{
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void RingBuffer::begin_frame()
+{
+    m_frame = (m_frame + 1) % m_frameCount;
+    m_head = 0;
+    GLsync &fence = m_fences[m_frame];
+    if (!fence)
+        return;
+    // Only blocks if the CPU is a whole ring of frames ahead of the GPU
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(fence, 0, 1000000);
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void RingBuffer::end_frame()
+{
+    GLsync &fence = m_fences[m_frame];
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+RingBuffer::Allocation RingBuffer::allocate(const size_t sizeInBytes, size_t alignment)
+{
+    alignment = alignment ? alignment : m_alignment;
+    // Alignment applies to the offset in the whole buffer, frame sizes need not be multiples of it
+    const size_t base = size_t(m_frame) * m_frameBytes;
+    const size_t offset = (base + m_head + alignment - 1) / alignment * alignment;
+    const size_t start = offset - base;
+    if (!m_mapped || start + sizeInBytes > m_frameBytes)
+    {
+        ERR_LOG("Ring buffer frame of " << m_frameBytes << " bytes can not fit " << sizeInBytes << " more bytes");
+        return {nullptr, 0, 0};
+    }
+    m_head = start + sizeInBytes;
+    return {m_mapped + offset, offset, sizeInBytes};
+}
+
+void RingBuffer::bind_range(unsigned int target, unsigned int binding, const Allocation &allocation) const
+{
+    if (allocation.size == 0)
+        return;
+    GL_CHECK(glBindBufferRange(target, binding, m_id, GLintptr(allocation.offset), GLsizeiptr(allocation.size)));
+}
+
 GLSP_NAMESPACE_END
@@ -0,0 +1,681 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <cstdio>
+#include <limits>
+#include <filesystem>
+#include <random>
+#include <atomic>
+#include <unordered_map>
+#include <GLSP/cache.h>
+
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    const uint32_t SOURCE_RECORD_MAGIC = 0x53505347; // "GSPS"
+    const uint32_t SOURCE_RECORD_VERSION = 1;
+    const char *const CACHE_EXTENSIONS[] = {cache::MESH_CACHE_EXTENSION, cache::TEXTURE_CACHE_EXTENSION, cache::CUBEMAP_CACHE_EXTENSION,
+                                            cache::BAKED_CACHE_EXTENSION, cache::SOURCE_RECORD_EXTENSION};
+
+    std::string get_default_directory()
+    {
+        std::error_code error;
+        if (const char *directory = std::getenv("GLSP_CACHE_DIR"); directory && *directory)
+            return directory;
+#ifdef _WIN32
+        if (const char *local = std::getenv("LOCALAPPDATA"); local && *local)
+            return (std::filesystem::path(local) / "GLSP" / "cache").string();
+#else
+        if (const char *XDG = std::getenv("XDG_CACHE_HOME"); XDG && *XDG)
+            return (std::filesystem::path(XDG) / "GLSP").string();
+        if (const char *home = std::getenv("HOME"); home && *home)
+            return (std::filesystem::path(home) / ".cache" / "GLSP").string();
+#endif
+        return (std::filesystem::temp_directory_path(error) / "GLSP-cache").string();
+    }
+
+    bool g_cacheEnabled = true;
+    std::string g_cacheDirectory = get_default_directory();
+    uint64_t g_sizeLimit = cache::DEFAULT_SIZE_LIMIT;
+
+    struct SourceStamp
+    {
+        uint64_t size{0};
+        int64_t time{0};
+    };
+
+    /*
+    On disk memo of the content hash of a source, valid while its size and modification time do not change.
+    */
+    struct SourceRecord
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t size;
+        int64_t time;
+        uint64_t hash;
+    };
+
+    // In process state, shared by the loader threads
+    std::mutex g_mutex;
+    std::unordered_map<std::string, SourceRecord> g_sources;
+    std::unordered_map<std::string, std::weak_ptr<utils::MappedFile>> g_mappings;
+
+    bool stamp_source(const char *sourceFile, SourceStamp &stamp)
+    {
+        std::error_code error;
+        const uint64_t size = std::filesystem::file_size(sourceFile, error);
+        if (error)
+            return false;
+        const auto time = std::filesystem::last_write_time(sourceFile, error);
+        if (error)
+            return false;
+        stamp.size = size;
+        stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    bool hash_source(const char *sourceFile, uint64_t &hash)
+    {
+        try
+        {
+            utils::MappedFile file(sourceFile, utils::FILE_ACCESS_SEQUENTIAL);
+            hash = utils::hash_bytes(file.get_data(), file.get_size());
+            return true;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
+    inline uint64_t align_offset(uint64_t offset)
+    {
+        return (offset + cache::MESH_CACHE_ALIGNMENT - 1) & ~uint64_t(cache::MESH_CACHE_ALIGNMENT - 1);
+    }
+
+    std::string get_hex_name(uint64_t hash, const char *extension)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+        return std::string(name) + extension;
+    }
+
+    /*
+    Entries are named after everything that determines their content, so equal imports share one file no matter
+    where their source lives, and stale entries are never looked up again (they just age out).
+    */
+    std::string get_entry_path(uint64_t sourceHash, uint64_t optionsHash, uint32_t magic, uint32_t version, const char *extension)
+    {
+        const uint64_t key[] = {sourceHash, optionsHash, magic, version};
+        return (std::filesystem::path(g_cacheDirectory) / get_hex_name(utils::hash_bytes(key, sizeof(key)), extension)).string();
+    }
+
+    /*
+    Writes to a temporary file and renames it over the final one, so readers never see a half written cache. Temporary
+    names are unique per process and thread, several processes can store the same entry at once.
+    */
+    bool write_atomically(const std::string &path, const std::function<void(std::ofstream &)> &write)
+    {
+        static const uint64_t processSalt = (uint64_t(std::random_device{}()) << 32) ^ std::random_device{}();
+        static std::atomic<uint64_t> counter{0};
+
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".%016llx-%zx-%llu.tmp", static_cast<unsigned long long>(processSalt),
+                 std::hash<std::thread::id>{}(std::this_thread::get_id()), static_cast<unsigned long long>(counter++));
+        const std::string temporaryPath = path + suffix;
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+            write(file);
+            if (!file.good())
+            {
+                file.close();
+                std::filesystem::remove(temporaryPath, error);
+                return false;
+            }
+        }
+        std::filesystem::rename(temporaryPath, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+    Content hash of a source. Hashing is skipped while its size and modification time match the ones of the last hash,
+    remembered in memory and in a small record in the cache directory, so warm starts never read the sources.
+    */
+    bool get_source_hash(const char *sourceFile, SourceStamp &stamp, uint64_t &hash)
+    {
+        if (!stamp_source(sourceFile, stamp))
+            return false;
+        std::error_code error;
+        const std::string absolute = std::filesystem::absolute(sourceFile, error).string();
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            auto it = g_sources.find(absolute);
+            if (it != g_sources.end() && it->second.size == stamp.size && it->second.time == stamp.time)
+            {
+                hash = it->second.hash;
+                return true;
+            }
+        }
+
+        const std::string recordPath = (std::filesystem::path(g_cacheDirectory) /
+                                        get_hex_name(utils::hash_bytes(absolute.data(), absolute.size()), cache::SOURCE_RECORD_EXTENSION))
+                                           .string();
+        SourceRecord record{};
+        bool known = false;
+        if (std::ifstream file(recordPath, std::ios::binary); file.read(reinterpret_cast<char *>(&record), sizeof(record)))
+            known = record.magic == SOURCE_RECORD_MAGIC && record.version == SOURCE_RECORD_VERSION && record.size == stamp.size && record.time == stamp.time;
+        if (!known)
+        {
+            if (!hash_source(sourceFile, record.hash))
+                return false;
+            record = {SOURCE_RECORD_MAGIC, SOURCE_RECORD_VERSION, stamp.size, stamp.time, record.hash};
+            write_atomically(recordPath, [&](std::ofstream &file)
+                             { file.write(reinterpret_cast<const char *>(&record), sizeof(record)); });
+        }
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_sources[absolute] = record;
+        hash = record.hash;
+        return true;
+    }
+
+    /*
+    Maps a cache entry and checks it is the one asked for. Entries already mapped by this process are shared. Validation
+    of the format specific fields is left to the caller.
+    */
+    template <typename Header>
+    std::shared_ptr<utils::MappedFile> map_cache(const std::string &path, uint32_t magic, uint32_t version, uint64_t sourceHash, uint64_t optionsHash, Header &header)
+    {
+        std::shared_ptr<utils::MappedFile> file;
+        {
+            std::lock_guard<std::mutex> lock(g_mutex);
+            auto it = g_mappings.find(path);
+            if (it != g_mappings.end())
+                file = it->second.lock();
+        }
+        if (!file)
+        {
+            try
+            {
+                file = std::make_shared<utils::MappedFile>(path, utils::FILE_ACCESS_SEQUENTIAL);
+            }
+            catch (const std::exception &)
+            {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(g_mutex);
+            for (auto it = g_mappings.begin(); it != g_mappings.end();)
+                it = it->second.expired() ? g_mappings.erase(it) : std::next(it);
+            g_mappings[path] = file;
+        }
+        if (file->get_size() < sizeof(Header))
+            return nullptr;
+
+        memcpy(&header, file->get_data(), sizeof(header));
+        if (header.magic != magic || header.version != version || header.sourceHash != sourceHash || header.optionsHash != optionsHash)
+            return nullptr;
+
+        // Least recently used entries are the first evicted, and use is tracked through the modification time
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        return file;
+    }
+
+    template <typename Header>
+    bool stamp_header(const char *sourceFile, uint32_t magic, uint32_t version, uint64_t optionsHash, Header &header)
+    {
+        SourceStamp stamp;
+        uint64_t sourceHash;
+        if (!get_source_hash(sourceFile, stamp, sourceHash))
+            return false;
+        header.magic = magic;
+        header.version = version;
+        header.sourceSize = stamp.size;
+        header.sourceTime = stamp.time;
+        header.sourceHash = sourceHash;
+        header.optionsHash = optionsHash;
+        return true;
+    }
+
+    /*
+    Removes the least recently used entries until the directory fits in the size limit. Safe against other processes
+    doing the same or reading the entries: mapped files stay readable after being unlinked, and failures are skipped.
+    Temporary files left by crashed writers are removed once they are an hour old.
+    */
+    void enforce_size_limit()
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+        std::error_code error;
+        const auto now = std::filesystem::file_time_type::clock::now();
+        for (std::filesystem::directory_iterator it(g_cacheDirectory, error), end; !error && it != end; it.increment(error))
+        {
+            if (!it->is_regular_file(error))
+                continue;
+            const std::filesystem::path &path = it->path();
+            const std::string extension = path.extension().string();
+            const auto time = std::filesystem::last_write_time(path, error);
+            if (error)
+                continue;
+            if (extension == ".tmp")
+            {
+                if (now - time > std::chrono::hours(1))
+                    std::filesystem::remove(path, error);
+                continue;
+            }
+            if (std::find_if(std::begin(CACHE_EXTENSIONS), std::end(CACHE_EXTENSIONS), [&](const char *cacheExtension)
+                             { return extension == cacheExtension; }) == std::end(CACHE_EXTENSIONS))
+                continue;
+            const uint64_t size = it->file_size(error);
+            if (error)
+                continue;
+            entries.push_back({path, time, size});
+            total += size;
+        }
+        error.clear();
+        if (total <= g_sizeLimit)
+            return;
+
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                  { return a.time < b.time; });
+        for (const Entry &entry : entries)
+        {
+            if (total <= g_sizeLimit)
+                break;
+            if (std::filesystem::remove(entry.path, error))
+                total -= entry.size;
+        }
+    }
+
+    /*
+    Draw range inside the index buffer whose vertices, offset by its base vertex, exist. Indices are already known to be
+    under the vertex count.
+    */
+    bool is_valid_range(const Submesh &range, const unsigned int *indices, uint64_t indexCount, uint64_t vertexCount)
+    {
+        if (uint64_t(range.indexOffset) + range.indexCount > indexCount || range.baseVertex < 0)
+            return false;
+        if (range.baseVertex == 0 || range.indexCount == 0)
+            return true;
+        const unsigned int *begin = indices + range.indexOffset;
+        return uint64_t(*std::max_element(begin, begin + range.indexCount)) + uint64_t(range.baseVertex) < vertexCount;
+    }
+}
+
+void cache::set_enabled(bool op)
+{
+    g_cacheEnabled = op;
+}
+
+bool cache::is_enabled()
+{
+    return g_cacheEnabled;
+}
+
+void cache::set_directory(const std::string &directory)
+{
+    g_cacheDirectory = directory.empty() ? get_default_directory() : directory;
+}
+
+std::string cache::get_directory()
+{
+    return g_cacheDirectory;
+}
+
+void cache::set_size_limit(uint64_t bytes)
+{
+    g_sizeLimit = bytes;
+}
+
+uint64_t cache::get_size_limit()
+{
+    return g_sizeLimit;
+}
+
+void cache::trim()
+{
+    enforce_size_limit();
+}
+
+std::string cache::get_mesh_cache_path(const char *sourceFile, uint64_t optionsHash)
+{
+    SourceStamp stamp;
+    uint64_t sourceHash;
+    if (!get_source_hash(sourceFile, stamp, sourceHash))
+        return "";
+    return get_entry_path(sourceHash, optionsHash, MESH_CACHE_MAGIC, MESH_CACHE_VERSION, MESH_CACHE_EXTENSION);
+}
+
+std::string cache::get_texture_cache_path(const char *sourceFile, uint64_t optionsHash)
+{
+    SourceStamp stamp;
+    uint64_t sourceHash;
+    if (!get_source_hash(sourceFile, stamp, sourceHash))
+        return "";
+    return get_entry_path(sourceHash, optionsHash, TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, TEXTURE_CACHE_EXTENSION);
+}
+
+std::string cache::get_cubemap_cache_path(const char *sourceFile, uint64_t optionsHash)
+{
+    SourceStamp stamp;
+    uint64_t sourceHash;
+    if (!get_source_hash(sourceFile, stamp, sourceHash))
+        return "";
+    return get_entry_path(sourceHash, optionsHash, TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, CUBEMAP_CACHE_EXTENSION);
+}
+
+bool cache::store_mesh(const char *sourceFile, uint64_t optionsHash, const MeshData &data)
+{
+    if (!g_cacheEnabled)
+        return false;
+
+    MeshCacheHeader header{};
+    if (!stamp_header(sourceFile, MESH_CACHE_MAGIC, MESH_CACHE_VERSION, optionsHash, header))
+        return false;
+
+    // Canonical vertex layout. Same one Geometry sets up
+    header.vertexStride = sizeof(Vertex);
+    const uint32_t counts[] = {3, 3, 3, 2, 3};
+    header.attributeCount = 5;
+    for (uint32_t i = 0; i < header.attributeCount; i++)
+        header.attributes[i] = {GL_FLOAT, counts[i], GL_FALSE};
+    header.primitive = GL_TRIANGLES;
+
+    header.vertexCount = data.vertices.size();
+    header.vertexOffset = align_offset(sizeof(MeshCacheHeader));
+    header.indexCount = data.indices.size();
+    header.indexOffset = align_offset(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+    header.submeshCount = data.submeshes.size();
+    header.submeshOffset = align_offset(header.indexOffset + header.indexCount * sizeof(unsigned int));
+    header.LODCount = data.LODs.size();
+    header.LODOffset = align_offset(header.submeshOffset + header.submeshCount * sizeof(Submesh));
+
+    glm::vec3 boundsMin(data.vertices.empty() ? 0.0f : std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(data.vertices.empty() ? 0.0f : std::numeric_limits<float>::lowest());
+    for (const Vertex &vertex : data.vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    memcpy(header.boundsMin, &boundsMin, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, &boundsMax, sizeof(header.boundsMax));
+
+    const std::string path = get_entry_path(header.sourceHash, optionsHash, MESH_CACHE_MAGIC, MESH_CACHE_VERSION, MESH_CACHE_EXTENSION);
+    const bool stored = write_atomically(path, [&](std::ofstream &file)
+                                         {
+        const char padding[MESH_CACHE_ALIGNMENT] = {};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(padding, header.vertexOffset - sizeof(header));
+        file.write(reinterpret_cast<const char *>(data.vertices.data()), header.vertexCount * sizeof(Vertex));
+        file.write(padding, header.indexOffset - (header.vertexOffset + header.vertexCount * sizeof(Vertex)));
+        file.write(reinterpret_cast<const char *>(data.indices.data()), header.indexCount * sizeof(unsigned int));
+        file.write(padding, header.submeshOffset - (header.indexOffset + header.indexCount * sizeof(unsigned int)));
+        file.write(reinterpret_cast<const char *>(data.submeshes.data()), header.submeshCount * sizeof(Submesh));
+        file.write(padding, header.LODOffset - (header.submeshOffset + header.submeshCount * sizeof(Submesh)));
+        for (const LODLevel &level : data.LODs)
+        {
+            const MeshCacheLOD entry{static_cast<uint32_t>(level.submeshes.size()), level.error};
+            file.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+        }
+        for (const LODLevel &level : data.LODs)
+            file.write(reinterpret_cast<const char *>(level.submeshes.data()), level.submeshes.size() * sizeof(Submesh)); });
+    if (stored)
+        enforce_size_limit();
+    return stored;
+}
+
+Geometry *cache::load_mesh(const char *sourceFile, uint64_t optionsHash)
+{
+    if (!g_cacheEnabled)
+        return nullptr;
+
+    SourceStamp stamp;
+    uint64_t sourceHash;
+    if (!get_source_hash(sourceFile, stamp, sourceHash))
+        return nullptr;
+    MeshCacheHeader header;
+    std::shared_ptr<utils::MappedFile> file = map_cache(get_entry_path(sourceHash, optionsHash, MESH_CACHE_MAGIC, MESH_CACHE_VERSION, MESH_CACHE_EXTENSION),
+                                                        MESH_CACHE_MAGIC, MESH_CACHE_VERSION, sourceHash, optionsHash, header);
+    if (!file || header.attributeCount == 0 || header.attributeCount > MESH_CACHE_MAX_ATTRIBUTES)
+        return nullptr;
+
+    const uint64_t vertexBytes = header.vertexCount * header.vertexStride;
+    const uint64_t indexBytes = header.indexCount * sizeof(unsigned int);
+    const uint64_t submeshBytes = header.submeshCount * sizeof(Submesh);
+    if (header.vertexOffset + vertexBytes > file->get_size() || header.indexOffset + indexBytes > file->get_size() ||
+        header.submeshOffset + submeshBytes > file->get_size() || header.LODOffset + header.LODCount * sizeof(MeshCacheLOD) > file->get_size())
+        return nullptr;
+
+    std::vector<LODLevel> LODs(header.LODCount);
+    uint64_t LODSubmeshOffset = header.LODOffset + header.LODCount * sizeof(MeshCacheLOD);
+    for (uint64_t level = 0; level < header.LODCount; level++)
+    {
+        MeshCacheLOD entry;
+        memcpy(&entry, file->get_data() + header.LODOffset + level * sizeof(MeshCacheLOD), sizeof(entry));
+        if (LODSubmeshOffset + entry.submeshCount * sizeof(Submesh) > file->get_size())
+            return nullptr;
+        LODs[level].error = entry.error;
+        LODs[level].submeshes.resize(entry.submeshCount);
+        if (entry.submeshCount > 0)
+            memcpy(LODs[level].submeshes.data(), file->get_data() + LODSubmeshOffset, entry.submeshCount * sizeof(Submesh));
+        LODSubmeshOffset += entry.submeshCount * sizeof(Submesh);
+    }
+
+    // Stale or corrupt entries are a miss, so that they never drive out of bounds vertex fetches
+    const unsigned int *indices = reinterpret_cast<const unsigned int *>(file->get_data() + header.indexOffset);
+    if (header.indexCount > 0 && *std::max_element(indices, indices + header.indexCount) >= header.vertexCount)
+        return nullptr;
+    std::vector<Submesh> submeshes(header.submeshCount);
+    if (header.submeshCount > 0)
+        memcpy(submeshes.data(), file->get_data() + header.submeshOffset, submeshBytes);
+    for (const Submesh &range : submeshes)
+        if (!is_valid_range(range, indices, header.indexCount, header.vertexCount))
+            return nullptr;
+    for (const LODLevel &level : LODs)
+        for (const Submesh &range : level.submeshes)
+            if (!is_valid_range(range, indices, header.indexCount, header.vertexCount))
+                return nullptr;
+
+    // Aliasing shared pointer: buffers keep the whole mapping alive while pointing inside it
+    std::shared_ptr<const void> storage(file, file->get_data());
+
+    VertexBuffer VBO(file->get_data() + header.vertexOffset, vertexBytes, storage);
+    for (uint32_t i = 0; i < header.attributeCount; i++)
+        VBO.push_attribute_layout(AttributeLayout{header.attributes[i].type, header.attributes[i].count, static_cast<unsigned char>(header.attributes[i].normalized)});
+    if (VBO.get_stride_size() != header.vertexStride)
+        return nullptr;
+
+    VertexArray VAO;
+    VAO.push_vertex_buffer(std::move(VBO));
+    IndexBuffer IBO(indices, header.indexCount, storage);
+
+    Geometry *geometry = new Geometry(std::move(VAO), header.vertexCount, std::move(IBO), header.primitive);
+    geometry->set_submeshes(submeshes);
+    geometry->set_LODs(LODs);
+    return geometry;
+}
+
+namespace
+{
+    /*
+    Shared by textures, cubemaps and bakes. The header comes stamped with its source. Every face must have the same layout.
+    */
+    bool store_faces(const std::string &path, cache::TextureCacheHeader header, const processing::MipChain *faces, uint32_t faceCount)
+    {
+        const processing::MipChain &first = faces[0];
+        if (first.get_level_count() == 0 || first.get_level_count() > cache::TEXTURE_CACHE_MAX_LEVELS)
+            return false;
+
+        header.width = first.extent.width;
+        header.height = first.extent.height;
+        header.channels = first.channels;
+        header.dataType = first.HDR ? GL_FLOAT : GL_UNSIGNED_BYTE;
+        header.sRGB = first.sRGB;
+        header.compressedFormat = first.compressedFormat;
+        header.faceCount = faceCount;
+        header.levelCount = static_cast<uint32_t>(first.get_level_count());
+        uint64_t offset = sizeof(cache::TextureCacheHeader);
+        for (uint32_t face = 0; face < faceCount; face++)
+        {
+            if (faces[face].levelOffsets != first.levelOffsets)
+                return false;
+            for (uint32_t level = 0; level < header.levelCount; level++)
+            {
+                header.levels[face][level].offset = align_offset(offset);
+                header.levels[face][level].size = first.get_level_size(level);
+                offset = header.levels[face][level].offset + header.levels[face][level].size;
+            }
+        }
+
+        const bool stored = write_atomically(path, [&](std::ofstream &file)
+                                             {
+            const char padding[cache::MESH_CACHE_ALIGNMENT] = {};
+            uint64_t written = sizeof(header);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (uint32_t face = 0; face < faceCount; face++)
+                for (uint32_t level = 0; level < header.levelCount; level++)
+                {
+                    file.write(padding, header.levels[face][level].offset - written);
+                    file.write(reinterpret_cast<const char *>(faces[face].get_level_data(level)), header.levels[face][level].size);
+                    written = header.levels[face][level].offset + header.levels[face][level].size;
+                } });
+        if (stored)
+            enforce_size_limit();
+        return stored;
+    }
+
+    bool store_faces(const char *sourceFile, uint64_t optionsHash, const char *extension, const processing::MipChain *faces, uint32_t faceCount)
+    {
+        cache::TextureCacheHeader header{};
+        if (!g_cacheEnabled || !stamp_header(sourceFile, cache::TEXTURE_CACHE_MAGIC, cache::TEXTURE_CACHE_VERSION, optionsHash, header))
+            return false;
+        return store_faces(get_entry_path(header.sourceHash, optionsHash, cache::TEXTURE_CACHE_MAGIC, cache::TEXTURE_CACHE_VERSION, extension), header, faces, faceCount);
+    }
+
+    /*
+    Fills the levels from an already validated mapping.
+    */
+    bool load_faces(const std::shared_ptr<utils::MappedFile> &file, const cache::TextureCacheHeader &header, uint32_t faceCount, TextureLevels &levels)
+    {
+        if (!file || header.faceCount != faceCount || header.levelCount == 0 || header.levelCount > cache::TEXTURE_CACHE_MAX_LEVELS ||
+            header.channels == 0 || header.channels > 4 || (header.dataType != GL_UNSIGNED_BYTE && header.dataType != GL_FLOAT))
+            return false;
+
+        const unsigned int formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+        const uint64_t texelSize = header.channels * (header.dataType == GL_FLOAT ? sizeof(float) : sizeof(unsigned char));
+        const uint64_t blockSize = header.compressedFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || header.compressedFormat == GL_COMPRESSED_RED_RGTC1 ? 8 : 16;
+
+        TextureLevels result;
+        result.format = formats[header.channels - 1];
+        result.dataType = header.dataType;
+        result.compressedFormat = header.compressedFormat;
+        result.faceCount = faceCount;
+        for (uint32_t level = 0; level < header.levelCount; level++)
+        {
+            const Extent2D extent{std::max(int(header.width >> level), 1), std::max(int(header.height >> level), 1)};
+            result.extents.push_back(extent);
+            result.sizes.push_back(header.compressedFormat ? uint64_t((extent.width + 3) / 4) * ((extent.height + 3) / 4) * blockSize
+                                                           : uint64_t(extent.width) * extent.height * texelSize);
+        }
+        for (uint32_t face = 0; face < faceCount; face++)
+            for (uint32_t level = 0; level < header.levelCount; level++)
+            {
+                if (header.levels[face][level].size != result.sizes[level] || header.levels[face][level].offset + header.levels[face][level].size > file->get_size())
+                    return false;
+                result.data.push_back(file->get_data() + header.levels[face][level].offset);
+            }
+        result.storage = std::shared_ptr<const void>(file, file->get_data());
+
+        levels = std::move(result);
+        return true;
+    }
+
+    bool load_faces(const char *sourceFile, uint64_t optionsHash, const char *extension, uint32_t faceCount, TextureLevels &levels)
+    {
+        SourceStamp stamp;
+        uint64_t sourceHash;
+        if (!g_cacheEnabled || !get_source_hash(sourceFile, stamp, sourceHash))
+            return false;
+
+        cache::TextureCacheHeader header;
+        std::shared_ptr<utils::MappedFile> file = map_cache(get_entry_path(sourceHash, optionsHash, cache::TEXTURE_CACHE_MAGIC, cache::TEXTURE_CACHE_VERSION, extension),
+                                                            cache::TEXTURE_CACHE_MAGIC, cache::TEXTURE_CACHE_VERSION, sourceHash, optionsHash, header);
+        return load_faces(file, header, faceCount, levels);
+    }
+}
+
+bool cache::store_texture(const char *sourceFile, uint64_t optionsHash, const processing::MipChain &chain)
+{
+    return store_faces(sourceFile, optionsHash, TEXTURE_CACHE_EXTENSION, &chain, 1);
+}
+
+bool cache::load_texture(const char *sourceFile, uint64_t optionsHash, TextureLevels &levels)
+{
+    return load_faces(sourceFile, optionsHash, TEXTURE_CACHE_EXTENSION, 1, levels);
+}
+
+bool cache::store_cubemap(const char *sourceFile, uint64_t optionsHash, const processing::CubemapData &cubemap)
+{
+    return store_faces(sourceFile, optionsHash, CUBEMAP_CACHE_EXTENSION, cubemap.faces, 6);
+}
+
+bool cache::load_cubemap(const char *sourceFile, uint64_t optionsHash, TextureLevels &levels)
+{
+    return load_faces(sourceFile, optionsHash, CUBEMAP_CACHE_EXTENSION, 6, levels);
+}
+
+std::string cache::get_baked_cache_path(uint64_t contentHash, uint64_t optionsHash)
+{
+    return get_entry_path(contentHash, optionsHash, TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, BAKED_CACHE_EXTENSION);
+}
+
+bool cache::store_baked(uint64_t contentHash, uint64_t optionsHash, const processing::MipChain *faces, uint32_t faceCount)
+{
+    if (!g_cacheEnabled || faceCount == 0 || faceCount > TEXTURE_CACHE_MAX_FACES)
+        return false;
+
+    // No source file to stamp, the content hash is the whole identity
+    TextureCacheHeader header{};
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = contentHash;
+    header.optionsHash = optionsHash;
+    return store_faces(get_baked_cache_path(contentHash, optionsHash), header, faces, faceCount);
+}
+
+bool cache::load_baked(uint64_t contentHash, uint64_t optionsHash, uint32_t faceCount, TextureLevels &levels)
+{
+    if (!g_cacheEnabled)
+        return false;
+
+    TextureCacheHeader header;
+    std::shared_ptr<utils::MappedFile> file = map_cache(get_baked_cache_path(contentHash, optionsHash), TEXTURE_CACHE_MAGIC, TEXTURE_CACHE_VERSION, contentHash, optionsHash, header);
+    return load_faces(file, header, faceCount, levels);
+}
+
+GLSP_NAMESPACE_END
@@ -31,4 +31,22 @@ bool GLlogCall(const char *function, const char *file, int line)
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    bool DIRECT_STATE_ACCESS = false;
+}
+
+void set_direct_state_access(bool enabled)
+{
+    DIRECT_STATE_ACCESS = enabled;
+}
+
+bool uses_direct_state_access()
+{
+    return DIRECT_STATE_ACCESS;
+}
+
+GLSP_NAMESPACE_END
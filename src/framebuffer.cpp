@@ -14,9 +14,16 @@ GLSP_NAMESPACE_BEGIN
 
 void Framebuffer::generate()
 {
-
-    GL_CHECK(glGenFramebuffers(1, &m_id));
-    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
+    const bool direct = uses_direct_state_access();
+    if (direct)
+    {
+        GL_CHECK(glCreateFramebuffers(1, &m_id));
+    }
+    else
+    {
+        GL_CHECK(glGenFramebuffers(1, &m_id));
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
+    }
 
     for (Attachment &attachment : m_attachments)
     {
@@ -47,6 +54,12 @@ void Framebuffer::generate()
                     ERR_LOG("ERROR::FRAMEBUFFER::Texture sample count does not match framebuffer sample count!");
             }
 
+            if (direct)
+            {
+                attach_direct(attachment);
+                continue;
+            }
+
             TextureType type = texture->get_config().type;
             switch (type)
             {
@@ -82,6 +95,13 @@ void Framebuffer::generate()
             if (!renderbuffer->is_generated())
                 renderbuffer->generate();
 
+            if (direct)
+            {
+                allocate_direct(*renderbuffer);
+                attach_direct(attachment);
+                continue;
+            }
+
             renderbuffer->bind();
 
             if (m_samples == 1)
@@ -97,13 +117,40 @@ void Framebuffer::generate()
         }
     }
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    const GLenum status = direct ? glCheckNamedFramebufferStatus(m_id, GL_FRAMEBUFFER) : glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
         ERR_LOG("ERROR::FRAMEBUFFER::" << m_id << ":: Framebuffer is not complete!");
 
-    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    if (!direct)
+    {
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    }
 
     m_generated = true;
 }
+void Framebuffer::attach_direct(const Attachment &attachment) const
+{
+    if (attachment.isRenderbuffer)
+    {
+        GL_CHECK(glNamedFramebufferRenderbuffer(m_id, attachment.attachmentType, GL_RENDERBUFFER, attachment.renderbuffer->get_id()));
+        return;
+    }
+    // Layered for cubemaps, arrays and 3D textures
+    GL_CHECK(glNamedFramebufferTexture(m_id, attachment.attachmentType, attachment.texture->get_id(), attachment.texture->get_config().level));
+}
+
+void Framebuffer::allocate_direct(const Renderbuffer &renderbuffer) const
+{
+    if (m_samples == 1)
+    {
+        GL_CHECK(glNamedRenderbufferStorage(renderbuffer.get_id(), renderbuffer.get_internal_format(), m_extent.width, m_extent.height));
+    }
+    else
+    {
+        GL_CHECK(glNamedRenderbufferStorageMultisample(renderbuffer.get_id(), m_samples, renderbuffer.get_internal_format(), m_extent.width, m_extent.height));
+    }
+}
+
 void Framebuffer::bind() const
 {
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
@@ -119,7 +166,14 @@ void Framebuffer::bind_default()
 }
 void Renderbuffer::generate()
 {
-    GL_CHECK(glGenRenderbuffers(1, &m_id));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateRenderbuffers(1, &m_id));
+    }
+    else
+    {
+        GL_CHECK(glGenRenderbuffers(1, &m_id));
+    }
 }
 
 void Renderbuffer::bind() const
@@ -148,6 +202,13 @@ void Framebuffer::resize(Extent2D extent)
             if (!attachment.isRenderbuffer && attachment.texture)
             {
                 attachment.texture->resize(extent);
+                // Immutable storage is respecified under a new name
+                if (uses_direct_state_access())
+                    attach_direct(attachment);
+            }
+            else if (attachment.renderbuffer && uses_direct_state_access())
+            {
+                allocate_direct(*attachment.renderbuffer);
             }
             else if (attachment.renderbuffer && attachment.renderbuffer)
             {
@@ -169,6 +230,14 @@ void Framebuffer::blit(const Framebuffer *const src, const Framebuffer *const ds
                        Extent2D srcExtent, Extent2D dstExtent,
                        Position2D srcOrigin, Position2D dstOrigin)
 {
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glBlitNamedFramebuffer(src ? src->get_id() : 0, dst ? dst->get_id() : 0,
+                                        srcOrigin.x, srcOrigin.y, srcExtent.width, srcExtent.height,
+                                        dstOrigin.x, dstOrigin.y, dstExtent.width, dstExtent.height,
+                                        mask, filter));
+        return;
+    }
     GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, src ? src->get_id() : 0));
     GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst ? dst->get_id() : 0));
 
@@ -0,0 +1,926 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <filesystem>
+#include <GLSP/loaders.h>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/matrix_decompose.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    /*
+    Minimal JSON document, enough for glTF. Object members keep their file order.
+    */
+    struct JSONValue
+    {
+        enum Type
+        {
+            NUL,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        } type{NUL};
+        bool boolean{false};
+        double number{0.0};
+        std::string string;
+        std::vector<JSONValue> elements;
+        std::vector<std::pair<std::string, JSONValue>> members;
+
+        // Missing members and elements read as null, so lookups can be chained
+        const JSONValue &operator[](const char *key) const
+        {
+            static const JSONValue null;
+            for (const auto &member : members)
+                if (member.first == key)
+                    return member.second;
+            return null;
+        }
+
+        const JSONValue &operator[](size_t index) const
+        {
+            static const JSONValue null;
+            return index < elements.size() ? elements[index] : null;
+        }
+
+        inline bool is_null() const { return type == NUL; }
+        inline size_t size() const { return elements.size(); }
+        inline double as_number(double fallback) const { return type == NUMBER ? number : fallback; }
+        inline int64_t as_int(int64_t fallback) const { return type == NUMBER ? int64_t(number) : fallback; }
+    };
+
+    class JSONParser
+    {
+        const char *m_p;
+        const char *m_end;
+
+        static const int MAX_DEPTH = 128;
+
+        void skip_blanks()
+        {
+            while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r'))
+                m_p++;
+        }
+
+        bool expect(const char *literal)
+        {
+            const size_t length = strlen(literal);
+            if (size_t(m_end - m_p) < length || memcmp(m_p, literal, length) != 0)
+                return false;
+            m_p += length;
+            return true;
+        }
+
+        static void append_UTF8(std::string &out, uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+                out += char(codepoint);
+            else if (codepoint < 0x800)
+            {
+                out += char(0xC0 | (codepoint >> 6));
+                out += char(0x80 | (codepoint & 0x3F));
+            }
+            else if (codepoint < 0x10000)
+            {
+                out += char(0xE0 | (codepoint >> 12));
+                out += char(0x80 | ((codepoint >> 6) & 0x3F));
+                out += char(0x80 | (codepoint & 0x3F));
+            }
+            else
+            {
+                out += char(0xF0 | (codepoint >> 18));
+                out += char(0x80 | ((codepoint >> 12) & 0x3F));
+                out += char(0x80 | ((codepoint >> 6) & 0x3F));
+                out += char(0x80 | (codepoint & 0x3F));
+            }
+        }
+
+        bool parse_hex4(uint32_t &value)
+        {
+            if (m_end - m_p < 4)
+                return false;
+            value = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                const char c = *m_p++;
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                    value |= uint32_t(c - '0');
+                else if (c >= 'a' && c <= 'f')
+                    value |= uint32_t(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F')
+                    value |= uint32_t(c - 'A' + 10);
+                else
+                    return false;
+            }
+            return true;
+        }
+
+        bool parse_string(std::string &out)
+        {
+            if (m_p >= m_end || *m_p != '"')
+                return false;
+            m_p++;
+            while (m_p < m_end)
+            {
+                // Copy plain runs at once
+                const char *run = m_p;
+                while (m_p < m_end && *m_p != '"' && *m_p != '\\')
+                    m_p++;
+                out.append(run, m_p - run);
+                if (m_p >= m_end)
+                    return false;
+                if (*m_p++ == '"')
+                    return true;
+                if (m_p >= m_end)
+                    return false;
+                switch (*m_p++)
+                {
+                case '"':
+                    out += '"';
+                    break;
+                case '\\':
+                    out += '\\';
+                    break;
+                case '/':
+                    out += '/';
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t codepoint;
+                    if (!parse_hex4(codepoint))
+                        return false;
+                    // Surrogate pair
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && expect("\\u"))
+                    {
+                        uint32_t low;
+                        if (!parse_hex4(low) || low < 0xDC00 || low >= 0xE000)
+                            return false;
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    append_UTF8(out, codepoint);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool parse_number(double &value)
+        {
+            // The input is not null terminated, strtod reads from a bounded copy
+            char buffer[64];
+            size_t length = 0;
+            while (m_p + length < m_end && length < sizeof(buffer) - 1 && m_p[length] != '\0' && strchr("+-0123456789.eE", m_p[length]))
+            {
+                buffer[length] = m_p[length];
+                length++;
+            }
+            buffer[length] = '\0';
+            char *end = nullptr;
+            value = std::strtod(buffer, &end);
+            if (end == buffer)
+                return false;
+            m_p += end - buffer;
+            return true;
+        }
+
+        bool parse_value(JSONValue &value, int depth)
+        {
+            skip_blanks();
+            if (m_p >= m_end || depth > MAX_DEPTH)
+                return false;
+            switch (*m_p)
+            {
+            case '{':
+                value.type = JSONValue::OBJECT;
+                m_p++;
+                skip_blanks();
+                if (m_p < m_end && *m_p == '}')
+                {
+                    m_p++;
+                    return true;
+                }
+                while (true)
+                {
+                    skip_blanks();
+                    value.members.emplace_back();
+                    if (!parse_string(value.members.back().first))
+                        return false;
+                    skip_blanks();
+                    if (!expect(":") || !parse_value(value.members.back().second, depth + 1))
+                        return false;
+                    skip_blanks();
+                    if (expect(","))
+                        continue;
+                    return expect("}");
+                }
+            case '[':
+                value.type = JSONValue::ARRAY;
+                m_p++;
+                skip_blanks();
+                if (m_p < m_end && *m_p == ']')
+                {
+                    m_p++;
+                    return true;
+                }
+                while (true)
+                {
+                    value.elements.emplace_back();
+                    if (!parse_value(value.elements.back(), depth + 1))
+                        return false;
+                    skip_blanks();
+                    if (expect(","))
+                        continue;
+                    return expect("]");
+                }
+            case '"':
+                value.type = JSONValue::STRING;
+                return parse_string(value.string);
+            case 't':
+                value.type = JSONValue::BOOLEAN;
+                value.boolean = true;
+                return expect("true");
+            case 'f':
+                value.type = JSONValue::BOOLEAN;
+                return expect("false");
+            case 'n':
+                return expect("null");
+            default:
+                value.type = JSONValue::NUMBER;
+                return parse_number(value.number);
+            }
+        }
+
+    public:
+        bool parse(const char *begin, const char *end, JSONValue &value)
+        {
+            m_p = begin;
+            m_end = end;
+            if (!parse_value(value, 0))
+                return false;
+            skip_blanks();
+            return m_p == m_end;
+        }
+    };
+
+    const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    struct GLTFBuffer
+    {
+        const uint8_t *data{nullptr};
+        size_t size{0};
+        std::shared_ptr<const void> storage; // Mapped file or decoded data URI
+    };
+
+    struct GLTFDocument
+    {
+        JSONValue json;
+        std::vector<GLTFBuffer> buffers;
+    };
+
+    /*
+    Accessor located in its buffer. If data is null the accessor has no buffer view and reads as zeros, before sparse
+    substitutions if any.
+    */
+    struct GLTFAccessor
+    {
+        const uint8_t *data{nullptr};
+        std::shared_ptr<const void> storage;
+        size_t count{0};
+        size_t stride{0};      // Bytes between elements
+        size_t elementSize{0}; // Bytes of an element
+        size_t componentCount{0};
+        unsigned int componentType{0};
+        bool normalized{false};
+        int view{-1};
+        bool interleavable{false}; // Its buffer view declares a stride, so other accessors may share it
+        const JSONValue *sparse{nullptr};
+
+        inline size_t get_span() const { return count == 0 ? 0 : (count - 1) * stride + elementSize; }
+    };
+
+    size_t get_component_count(const std::string &type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4" || type == "MAT2")
+            return 4;
+        if (type == "MAT3")
+            return 9;
+        if (type == "MAT4")
+            return 16;
+        return 0;
+    }
+
+    size_t get_component_size(unsigned int componentType)
+    {
+        switch (componentType)
+        {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+            return 2;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            return 4;
+        }
+        return 0;
+    }
+
+    uint32_t read_index(const uint8_t *p, unsigned int componentType)
+    {
+        switch (componentType)
+        {
+        case GL_UNSIGNED_BYTE:
+            return *p;
+        case GL_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        default:
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        }
+    }
+
+    /*
+    Range of a buffer view, checked against its buffer.
+    */
+    bool get_view(const GLTFDocument &document, int64_t index, const uint8_t *&data, size_t &length, size_t &stride, std::shared_ptr<const void> &storage)
+    {
+        const JSONValue &view = document.json["bufferViews"][size_t(index)];
+        const int64_t buffer = view["buffer"].as_int(-1);
+        if (view.is_null() || index < 0 || buffer < 0 || size_t(buffer) >= document.buffers.size())
+            return false;
+        const size_t offset = size_t(view["byteOffset"].as_int(0));
+        length = size_t(view["byteLength"].as_int(0));
+        stride = size_t(view["byteStride"].as_int(0));
+        const GLTFBuffer &source = document.buffers[size_t(buffer)];
+        if (offset > source.size || length > source.size - offset)
+            return false;
+        data = source.data + offset;
+        storage = source.storage;
+        return true;
+    }
+
+    bool resolve_accessor(const GLTFDocument &document, int64_t index, GLTFAccessor &accessor)
+    {
+        const JSONValue &json = document.json["accessors"][size_t(index)];
+        if (json.is_null() || index < 0)
+            return false;
+        accessor.count = size_t(json["count"].as_int(0));
+        accessor.componentType = unsigned(json["componentType"].as_int(0));
+        accessor.componentCount = get_component_count(json["type"].string);
+        accessor.normalized = json["normalized"].boolean;
+        accessor.elementSize = accessor.componentCount * get_component_size(accessor.componentType);
+        accessor.stride = accessor.elementSize;
+        if (accessor.elementSize == 0)
+            return false;
+        if (!json["sparse"].is_null())
+            accessor.sparse = &json["sparse"];
+
+        accessor.view = int(json["bufferView"].as_int(-1));
+        if (accessor.view < 0)
+            return true;
+        const uint8_t *data;
+        size_t length, stride;
+        if (!get_view(document, accessor.view, data, length, stride, accessor.storage))
+            return false;
+        const size_t offset = size_t(json["byteOffset"].as_int(0));
+        accessor.interleavable = stride != 0;
+        accessor.stride = stride != 0 ? stride : accessor.elementSize;
+        if (accessor.stride < accessor.elementSize || offset > length || accessor.get_span() > length - offset)
+            return false;
+        accessor.data = data + offset;
+        return true;
+    }
+
+    /*
+    Tightly packed copy of an accessor with its sparse substitutions applied.
+    */
+    std::shared_ptr<std::vector<uint8_t>> materialize(const GLTFDocument &document, const GLTFAccessor &accessor)
+    {
+        auto packed = std::make_shared<std::vector<uint8_t>>(accessor.count * accessor.elementSize, 0);
+        if (accessor.data)
+            for (size_t i = 0; i < accessor.count; i++)
+                memcpy(packed->data() + i * accessor.elementSize, accessor.data + i * accessor.stride, accessor.elementSize);
+        if (!accessor.sparse)
+            return packed;
+
+        const JSONValue &sparse = *accessor.sparse;
+        const size_t count = size_t(sparse["count"].as_int(0));
+        const JSONValue &indices = sparse["indices"];
+        const JSONValue &values = sparse["values"];
+        const unsigned int indexType = unsigned(indices["componentType"].as_int(0));
+        const size_t indexSize = get_component_size(indexType);
+        const uint8_t *indexData, *valueData;
+        size_t indexLength, valueLength, stride;
+        std::shared_ptr<const void> storage;
+        if (indexSize == 0 || !get_view(document, indices["bufferView"].as_int(-1), indexData, indexLength, stride, storage) ||
+            !get_view(document, values["bufferView"].as_int(-1), valueData, valueLength, stride, storage))
+            return nullptr;
+        const size_t indexOffset = size_t(indices["byteOffset"].as_int(0));
+        const size_t valueOffset = size_t(values["byteOffset"].as_int(0));
+        if (indexOffset > indexLength || count * indexSize > indexLength - indexOffset ||
+            valueOffset > valueLength || count * accessor.elementSize > valueLength - valueOffset)
+            return nullptr;
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t target = read_index(indexData + indexOffset + i * indexSize, indexType);
+            if (target >= accessor.count)
+                return nullptr;
+            memcpy(packed->data() + size_t(target) * accessor.elementSize, valueData + valueOffset + i * accessor.elementSize, accessor.elementSize);
+        }
+        return packed;
+    }
+
+    /*
+    Attributes of a primitive mapped to the locations of the canonical vertex.
+    */
+    const std::pair<const char *, int> GLTF_ATTRIBUTES[] = {{"POSITION", 0}, {"NORMAL", 1}, {"TANGENT", 2}, {"TEXCOORD_0", 3}, {"COLOR_0", 4}};
+
+    Geometry *import_primitive(const GLTFDocument &document, const JSONValue &primitive)
+    {
+        const JSONValue &attributes = primitive["attributes"];
+
+        // Accessors sharing an interleaved buffer view go into a single vertex buffer spanning all of them
+        struct Group
+        {
+            int view;
+            const uint8_t *begin;
+            const uint8_t *end;
+            size_t stride;
+            std::shared_ptr<const void> storage;
+            std::vector<std::pair<GLTFAccessor, int>> accessors;
+        };
+        std::vector<Group> groups;
+        VertexArray VAO;
+        size_t vertexCount = 0, minCount = SIZE_MAX;
+        bool hasPosition = false;
+        for (const auto &attribute : GLTF_ATTRIBUTES)
+        {
+            const JSONValue &index = attributes[attribute.first];
+            if (index.is_null())
+                continue;
+            GLTFAccessor accessor;
+            if (!resolve_accessor(document, index.as_int(-1), accessor))
+            {
+                ERR_LOG("Invalid glTF accessor for " << attribute.first);
+                return nullptr;
+            }
+            if (attribute.second == 0)
+            {
+                vertexCount = accessor.count;
+                hasPosition = true;
+            }
+            minCount = std::min(minCount, accessor.count);
+            const AttributeLayout layout{accessor.componentType, accessor.componentCount, static_cast<unsigned char>(accessor.normalized), attribute.second, 0};
+
+            if (!accessor.data || accessor.sparse)
+            {
+                std::shared_ptr<std::vector<uint8_t>> packed = materialize(document, accessor);
+                if (!packed)
+                {
+                    ERR_LOG("Invalid glTF sparse accessor for " << attribute.first);
+                    return nullptr;
+                }
+                VertexBuffer VBO(packed->data(), packed->size(), packed);
+                VBO.push_attribute_layout(layout);
+                VAO.push_vertex_buffer(std::move(VBO));
+                continue;
+            }
+
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const Group &g)
+                                      { return accessor.interleavable && g.view == accessor.view; });
+            if (group == groups.end())
+            {
+                groups.push_back({accessor.interleavable ? accessor.view : -1, accessor.data, accessor.data, accessor.stride, accessor.storage, {}});
+                group = groups.end() - 1;
+            }
+            group->begin = std::min(group->begin, accessor.data);
+            group->end = std::max(group->end, accessor.data + accessor.get_span());
+            group->accessors.push_back({accessor, attribute.second});
+        }
+        if (!hasPosition)
+        {
+            ERR_LOG("glTF primitive without POSITION attribute");
+            return nullptr;
+        }
+        if (minCount < vertexCount)
+        {
+            ERR_LOG("glTF primitive with an attribute shorter than POSITION");
+            return nullptr;
+        }
+
+        for (const Group &group : groups)
+        {
+            // References the mapped file, nothing is copied until the upload
+            VertexBuffer VBO(group.begin, size_t(group.end - group.begin), group.storage);
+            for (const auto &entry : group.accessors)
+            {
+                const GLTFAccessor &accessor = entry.first;
+                VBO.push_attribute_layout(AttributeLayout{accessor.componentType, accessor.componentCount, static_cast<unsigned char>(accessor.normalized),
+                                                          entry.second, int(accessor.data - group.begin)});
+            }
+            VBO.set_stride_size(group.stride);
+            VAO.push_vertex_buffer(std::move(VBO));
+        }
+
+        const unsigned int mode = unsigned(primitive["mode"].as_int(GL_TRIANGLES));
+        const JSONValue &indices = primitive["indices"];
+        if (indices.is_null())
+            return new Geometry(std::move(VAO), vertexCount, mode);
+
+        GLTFAccessor accessor;
+        if (!resolve_accessor(document, indices.as_int(-1), accessor) || accessor.componentCount != 1 ||
+            (accessor.componentType != GL_UNSIGNED_BYTE && accessor.componentType != GL_UNSIGNED_SHORT && accessor.componentType != GL_UNSIGNED_INT))
+        {
+            ERR_LOG("Invalid glTF index accessor");
+            return nullptr;
+        }
+        if (accessor.data && !accessor.sparse && accessor.componentType == GL_UNSIGNED_INT && accessor.stride == sizeof(unsigned int))
+        {
+            const unsigned int *data = reinterpret_cast<const unsigned int *>(accessor.data);
+            if (std::any_of(data, data + accessor.count, [&](unsigned int index)
+                            { return index >= vertexCount; }))
+            {
+                ERR_LOG("glTF primitive references a vertex out of range");
+                return nullptr;
+            }
+            return new Geometry(std::move(VAO), vertexCount, IndexBuffer(data, accessor.count, accessor.storage), mode);
+        }
+
+        // Index buffers are 32 bit, narrower indices are widened
+        std::shared_ptr<std::vector<uint8_t>> packed = materialize(document, accessor);
+        if (!packed)
+        {
+            ERR_LOG("Invalid glTF sparse index accessor");
+            return nullptr;
+        }
+        std::vector<unsigned int> widened(accessor.count);
+        for (size_t i = 0; i < accessor.count; i++)
+            widened[i] = read_index(packed->data() + i * accessor.elementSize, accessor.componentType);
+        if (std::any_of(widened.begin(), widened.end(), [&](unsigned int index)
+                        { return index >= vertexCount; }))
+        {
+            ERR_LOG("glTF primitive references a vertex out of range");
+            return nullptr;
+        }
+        return new Geometry(std::move(VAO), vertexCount, IndexBuffer(std::move(widened)), mode);
+    }
+
+    glm::vec3 read_vec3(const JSONValue &value, glm::vec3 fallback)
+    {
+        if (value.size() != 3)
+            return fallback;
+        glm::vec3 vector;
+        for (size_t i = 0; i < 3; i++)
+            vector[int(i)] = float(value[i].as_number(0.0));
+        return vector;
+    }
+
+    void set_node_transform(Object3D *const object, const JSONValue &node)
+    {
+        glm::vec3 translation = read_vec3(node["translation"], glm::vec3(0.0f));
+        glm::vec3 scale = read_vec3(node["scale"], glm::vec3(1.0f));
+        glm::quat rotation(1.0f, 0.0f, 0.0f, 0.0f);
+        const JSONValue &quaternion = node["rotation"];
+        if (quaternion.size() == 4)
+            for (size_t i = 0; i < 4; i++)
+                rotation[int(i)] = float(quaternion[i].as_number(0.0)); // x, y, z, w like glm
+
+        const JSONValue &matrix = node["matrix"];
+        if (matrix.size() == 16)
+        {
+            glm::mat4 m;
+            for (int i = 0; i < 16; i++)
+                m[i / 4][i % 4] = float(matrix[size_t(i)].as_number(0.0)); // Column major, like glm
+            glm::vec3 skew;
+            glm::vec4 perspective;
+            glm::decompose(m, scale, rotation, translation, skew, perspective);
+        }
+
+        // Object3D rotates around X, then Y, then Z in matrix order
+        float x, y, z;
+        glm::extractEulerAngleXYZ(glm::mat4_cast(rotation), x, y, z);
+        object->set_position(translation);
+        object->set_rotation(glm::degrees(glm::vec3(x, y, z)));
+        object->set_scale(scale);
+    }
+
+    bool import_node(const GLTFDocument &document, size_t index, Object3D *const parent, std::vector<bool> &visited, std::vector<Mesh *> &meshes)
+    {
+        const JSONValue &node = document.json["nodes"][index];
+        if (node.is_null() || visited[index])
+        {
+            ERR_LOG("Invalid glTF node hierarchy");
+            return false;
+        }
+        visited[index] = true;
+
+        Mesh *object = new Mesh();
+        meshes.push_back(object);
+        set_node_transform(object, node);
+        if (parent)
+            parent->add_child(object);
+
+        const JSONValue &mesh = node["mesh"];
+        if (!mesh.is_null())
+        {
+            const JSONValue &primitives = document.json["meshes"][size_t(mesh.as_int(-1))]["primitives"];
+            for (size_t i = 0; i < primitives.size(); i++)
+            {
+                Geometry *geometry = import_primitive(document, primitives[i]);
+                if (!geometry)
+                    return false;
+                if (i == 0)
+                {
+                    object->set_geometry(geometry);
+                    continue;
+                }
+                // Extra primitives have their own attributes, each one is drawn by a child
+                Mesh *part = new Mesh(geometry, nullptr);
+                meshes.push_back(part);
+                object->add_child(part);
+            }
+        }
+
+        const JSONValue &children = node["children"];
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            const int64_t child = children[i].as_int(-1);
+            if (child < 0 || size_t(child) >= visited.size() || !import_node(document, size_t(child), object, visited, meshes))
+                return false;
+        }
+        return true;
+    }
+
+    inline int get_hex_digit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    /*
+    Resolves percent escapes. Returns false if one is not followed by two hex digits.
+    */
+    bool decode_URI(const std::string &uri, std::string &decoded)
+    {
+        decoded.clear();
+        decoded.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            if (uri[i] != '%')
+            {
+                decoded += uri[i];
+                continue;
+            }
+            const int high = i + 2 < uri.size() ? get_hex_digit(uri[i + 1]) : -1;
+            const int low = high >= 0 ? get_hex_digit(uri[i + 2]) : -1;
+            if (low < 0)
+                return false;
+            decoded += char(high * 16 + low);
+            i += 2;
+        }
+        return true;
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> decode_base64(const char *p, const char *end)
+    {
+        auto decoded = std::make_shared<std::vector<uint8_t>>();
+        decoded->reserve((end - p) / 4 * 3);
+        uint32_t bits = 0;
+        int count = 0;
+        for (; p < end && *p != '='; p++)
+        {
+            const char c = *p;
+            uint32_t value;
+            if (c >= 'A' && c <= 'Z')
+                value = c - 'A';
+            else if (c >= 'a' && c <= 'z')
+                value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9')
+                value = c - '0' + 52;
+            else if (c == '+')
+                value = 62;
+            else if (c == '/')
+                value = 63;
+            else
+                return nullptr;
+            bits = (bits << 6) | value;
+            if (++count == 4)
+            {
+                decoded->push_back(uint8_t(bits >> 16));
+                decoded->push_back(uint8_t(bits >> 8));
+                decoded->push_back(uint8_t(bits));
+                bits = 0;
+                count = 0;
+            }
+        }
+        if (count == 3)
+        {
+            decoded->push_back(uint8_t(bits >> 10));
+            decoded->push_back(uint8_t(bits >> 2));
+        }
+        else if (count == 2)
+            decoded->push_back(uint8_t(bits >> 4));
+        return decoded;
+    }
+
+    bool load_buffers(GLTFDocument &document, const std::filesystem::path &directory, const GLTFBuffer &binaryChunk)
+    {
+        const JSONValue &buffers = document.json["buffers"];
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            const JSONValue &uri = buffers[i]["uri"];
+            const size_t byteLength = size_t(buffers[i]["byteLength"].as_int(0));
+            GLTFBuffer buffer;
+            if (uri.is_null())
+            {
+                if (i != 0 || !binaryChunk.data)
+                {
+                    ERR_LOG("glTF buffer " << i << " has no uri");
+                    return false;
+                }
+                buffer = binaryChunk;
+            }
+            else if (uri.string.compare(0, 5, "data:") == 0)
+            {
+                const size_t comma = uri.string.find(";base64,");
+                std::shared_ptr<std::vector<uint8_t>> decoded;
+                if (comma != std::string::npos)
+                    decoded = decode_base64(uri.string.data() + comma + 8, uri.string.data() + uri.string.size());
+                if (!decoded)
+                {
+                    ERR_LOG("glTF buffer " << i << " has an unsupported data uri");
+                    return false;
+                }
+                buffer = {decoded->data(), decoded->size(), decoded};
+            }
+            else
+            {
+                std::string fileName;
+                if (!decode_URI(uri.string, fileName))
+                {
+                    ERR_LOG("glTF buffer " << i << " has an invalid uri " << uri.string);
+                    return false;
+                }
+                const std::string path = (directory / fileName).string();
+                try
+                {
+                    auto file = std::make_shared<utils::MappedFile>(path);
+                    buffer = {file->get_data(), file->get_size(), file};
+                }
+                catch (const std::exception &)
+                {
+                    ERR_LOG("Error opening glTF buffer " << path);
+                    return false;
+                }
+            }
+            if (buffer.size < byteLength)
+            {
+                ERR_LOG("glTF buffer " << i << " is shorter than its byteLength");
+                return false;
+            }
+            buffer.size = byteLength;
+            document.buffers.push_back(buffer);
+        }
+        return true;
+    }
+}
+
+bool loaders::load_GLTF(Object3D *const root, const char *fileName, std::vector<Mesh *> &meshes)
+{
+    std::shared_ptr<utils::MappedFile> file;
+    try
+    {
+        file = std::make_shared<utils::MappedFile>(fileName);
+    }
+    catch (const std::exception &)
+    {
+        ERR_LOG("Error opening file " << fileName);
+        return false;
+    }
+
+    // Binary glTF: 12 byte header followed by a JSON chunk and an optional BIN chunk, both mapped in place
+    const uint8_t *json = file->get_data();
+    size_t jsonSize = file->get_size();
+    GLTFBuffer binaryChunk;
+    uint32_t header[5];
+    if (file->get_size() >= sizeof(header) && (memcpy(header, file->get_data(), sizeof(header)), header[0] == GLB_MAGIC))
+    {
+        const size_t length = std::min<size_t>(header[2], file->get_size());
+        if (length < sizeof(header) || header[1] != 2 || header[4] != GLB_CHUNK_JSON || header[3] > length - sizeof(header))
+        {
+            ERR_LOG("Unsupported or corrupt GLB file " << fileName);
+            return false;
+        }
+        json = file->get_data() + sizeof(header);
+        jsonSize = header[3];
+        const size_t binOffset = sizeof(header) + ((jsonSize + 3) & ~size_t(3));
+        uint32_t chunk[2];
+        if (binOffset + sizeof(chunk) <= length && (memcpy(chunk, file->get_data() + binOffset, sizeof(chunk)), chunk[1] == GLB_CHUNK_BIN) &&
+            chunk[0] <= length - binOffset - sizeof(chunk))
+            binaryChunk = {file->get_data() + binOffset + sizeof(chunk), chunk[0], file};
+    }
+
+    GLTFDocument document;
+    if (!JSONParser().parse(reinterpret_cast<const char *>(json), reinterpret_cast<const char *>(json) + jsonSize, document.json))
+    {
+        ERR_LOG("Error parsing glTF JSON in " << fileName);
+        return false;
+    }
+    if (document.json["asset"]["version"].string.compare(0, 2, "2.") != 0)
+    {
+        ERR_LOG("Only glTF 2.0 is supported: " << fileName);
+        return false;
+    }
+    if (!load_buffers(document, std::filesystem::path(fileName).parent_path(), binaryChunk))
+        return false;
+
+    // Default scene, or every node that is nobody's child if there are no scenes
+    const JSONValue &nodes = document.json["nodes"];
+    std::vector<size_t> roots;
+    const JSONValue &scene = document.json["scenes"][size_t(document.json["scene"].as_int(0))];
+    if (!scene.is_null())
+    {
+        for (size_t i = 0; i < scene["nodes"].size(); i++)
+            roots.push_back(size_t(scene["nodes"][i].as_int(-1)));
+    }
+    else
+    {
+        std::vector<bool> isChild(nodes.size(), false);
+        for (size_t i = 0; i < nodes.size(); i++)
+            for (size_t j = 0; j < nodes[i]["children"].size(); j++)
+                if (size_t(nodes[i]["children"][j].as_int(-1)) < nodes.size())
+                    isChild[size_t(nodes[i]["children"][j].as_int(-1))] = true;
+        for (size_t i = 0; i < nodes.size(); i++)
+            if (!isChild[i])
+                roots.push_back(i);
+    }
+
+    std::vector<bool> visited(nodes.size(), false);
+    const size_t firstMesh = meshes.size();
+    for (size_t node : roots)
+        if (node >= nodes.size() || !import_node(document, node, root, visited, meshes))
+        {
+            // Nothing of a failed import is handed to the caller. Objects delete their parent, detach them first
+            for (size_t i = firstMesh; i < meshes.size(); i++)
+                if (meshes[i]->get_parent())
+                    meshes[i]->get_parent()->remove_child(meshes[i]);
+            for (size_t i = firstMesh; i < meshes.size(); i++)
+                delete meshes[i];
+            meshes.resize(firstMesh);
+            return false;
+        }
+    return true;
+}
+
+GLSP_NAMESPACE_END
@@ -0,0 +1,1766 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <limits>
+#include <GLSP/processing.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLSP_SSE2
+#include <emmintrin.h>
+#endif
+
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    const float KAISER_ALPHA = 4.0f;
+    const float KAISER_RADIUS = 3.0f; // In target texels
+
+    inline float srgb_to_linear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    const int SRGB_ENCODE_BUCKETS = 4096;
+
+    /*
+    Decoding tables for 8 bit sources and the thresholds for encoding back. Thresholds are the linear values halfway
+    between two consecutive codes in encoded space, so encoding rounds exactly like the reference formula would. The
+    buckets give the code at the start of uniform linear intervals, narrow enough to never span more than one threshold.
+    */
+    struct ColorTables
+    {
+        float sRGBToLinear[256];
+        float unormToFloat[256];
+        float sRGBThresholds[257]; // [code] = lowest linear value that encodes to code
+        unsigned char sRGBBuckets[SRGB_ENCODE_BUCKETS];
+    };
+
+    const ColorTables &get_color_tables()
+    {
+        static const ColorTables tables = []()
+        {
+            ColorTables t;
+            for (int i = 0; i < 256; i++)
+            {
+                t.sRGBToLinear[i] = srgb_to_linear(i / 255.0f);
+                t.unormToFloat[i] = i / 255.0f;
+                t.sRGBThresholds[i] = i == 0 ? -std::numeric_limits<float>::max() : srgb_to_linear((i - 0.5f) / 255.0f);
+            }
+            t.sRGBThresholds[256] = std::numeric_limits<float>::max();
+            int code = 0;
+            for (int bucket = 0; bucket < SRGB_ENCODE_BUCKETS; bucket++)
+            {
+                while (float(bucket) / SRGB_ENCODE_BUCKETS >= t.sRGBThresholds[code + 1])
+                    code++;
+                t.sRGBBuckets[bucket] = static_cast<unsigned char>(code);
+            }
+            return t;
+        }();
+        return tables;
+    }
+
+    inline unsigned char encode_srgb(float value, const ColorTables &tables)
+    {
+        const int bucket = std::min(static_cast<int>(std::max(value, 0.0f) * SRGB_ENCODE_BUCKETS), SRGB_ENCODE_BUCKETS - 1);
+        const int code = tables.sRGBBuckets[bucket];
+        return static_cast<unsigned char>(code + (value >= tables.sRGBThresholds[code + 1] ? 1 : 0));
+    }
+
+    inline unsigned char encode_unorm(float value)
+    {
+        return static_cast<unsigned char>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    inline bool is_alpha_channel(unsigned int channel, unsigned int channels)
+    {
+        return (channels == 4 && channel == 3) || (channels == 2 && channel == 1);
+    }
+
+    float bessel_i0(float x)
+    {
+        // Power series, converges quickly for the arguments the window uses
+        float sum = 1.0f, term = 1.0f;
+        const float halfSquared = x * x * 0.25f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; k++)
+        {
+            term *= halfSquared / float(k * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    float kaiser_sinc(float x)
+    {
+        const float t = x / KAISER_RADIUS;
+        if (t <= -1.0f || t >= 1.0f)
+            return 0.0f;
+        const float sinc = std::abs(x) < 1e-5f ? 1.0f : std::sin(glm::pi<float>() * x) / (glm::pi<float>() * x);
+        return sinc * bessel_i0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / bessel_i0(KAISER_ALPHA);
+    }
+
+    /*
+    Source texels and weights contributing to each target texel of one axis. Every target uses the same amount of taps,
+    padded with zero weights, so the inner loops have no branches.
+    */
+    struct FilterTaps
+    {
+        size_t tapCount{0};
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    FilterTaps build_filter_taps(int sourceSize, int targetSize, processing::MipFilter filter, bool wrap)
+    {
+        const float scale = float(sourceSize) / float(targetSize);
+        const float radius = filter == processing::MIP_FILTER_BOX ? 0.5f * scale : KAISER_RADIUS * scale;
+
+        std::vector<std::vector<std::pair<int, float>>> targets(targetSize);
+        size_t tapCount = 1;
+        for (int x = 0; x < targetSize; x++)
+        {
+            const float center = (x + 0.5f) * scale;
+            const int first = static_cast<int>(std::floor(center - radius));
+            const int last = static_cast<int>(std::ceil(center + radius));
+            float total = 0.0f;
+            for (int i = first; i < last; i++)
+            {
+                float weight;
+                if (filter == processing::MIP_FILTER_BOX) // Coverage of the source texel by the target footprint
+                    weight = std::max(0.0f, std::min(i + 1.0f, center + radius) - std::max(float(i), center - radius));
+                else
+                    weight = kaiser_sinc((i + 0.5f - center) / scale);
+                if (weight == 0.0f)
+                    continue;
+
+                int index = i;
+                if (wrap)
+                    index = ((index % sourceSize) + sourceSize) % sourceSize;
+                else
+                    index = std::min(std::max(index, 0), sourceSize - 1);
+                targets[x].push_back({index, weight});
+                total += weight;
+            }
+            for (auto &tap : targets[x])
+                tap.second /= total;
+            tapCount = std::max(tapCount, targets[x].size());
+        }
+
+        FilterTaps taps;
+        taps.tapCount = tapCount;
+        taps.indices.assign(targetSize * tapCount, 0);
+        taps.weights.assign(targetSize * tapCount, 0.0f);
+        for (int x = 0; x < targetSize; x++)
+            for (size_t t = 0; t < targets[x].size(); t++)
+            {
+                taps.indices[x * tapCount + t] = targets[x][t].first;
+                taps.weights[x * tapCount + t] = targets[x][t].second;
+            }
+        return taps;
+    }
+
+    /*
+    Horizontal pass of one row. A four channel texel fits a single SSE register.
+    */
+    void filter_row(const float *source, float *target, int targetWidth, unsigned int channels, const FilterTaps &taps)
+    {
+        const int *indices = taps.indices.data();
+        const float *weights = taps.weights.data();
+#ifdef GLSP_SSE2
+        if (channels == 4)
+        {
+            for (int x = 0; x < targetWidth; x++, indices += taps.tapCount, weights += taps.tapCount)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (size_t t = 0; t < taps.tapCount; t++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + indices[t] * 4), _mm_set1_ps(weights[t])));
+                _mm_storeu_ps(target + x * 4, sum);
+            }
+            return;
+        }
+#endif
+        for (int x = 0; x < targetWidth; x++, indices += taps.tapCount, weights += taps.tapCount)
+            for (unsigned int c = 0; c < channels; c++)
+            {
+                float sum = 0.0f;
+                for (size_t t = 0; t < taps.tapCount; t++)
+                    sum += source[indices[t] * channels + c] * weights[t];
+                target[x * channels + c] = sum;
+            }
+    }
+
+    /*
+    Vertical pass accumulation. Rows are contiguous, so it is vectorized regardless of the channel count.
+    */
+    inline void accumulate_row(float *target, const float *source, float weight, size_t count)
+    {
+        size_t i = 0;
+#ifdef GLSP_SSE2
+        const __m128 w = _mm_set1_ps(weight);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(target + i, _mm_add_ps(_mm_loadu_ps(target + i), _mm_mul_ps(_mm_loadu_ps(source + i), w)));
+#endif
+        for (; i < count; i++)
+            target[i] += source[i] * weight;
+    }
+
+    void encode_row(const float *source, unsigned char *target, size_t width, unsigned int channels, bool HDR, bool sRGB)
+    {
+        const size_t count = width * channels;
+        if (HDR)
+        {
+            float *out = reinterpret_cast<float *>(target);
+            for (size_t i = 0; i < count; i++)
+                out[i] = std::max(source[i], 0.0f); // Kaiser lobes can ring below zero
+            return;
+        }
+        const ColorTables &tables = get_color_tables();
+        for (unsigned int c = 0; c < channels; c++)
+        {
+            if (sRGB && !is_alpha_channel(c, channels))
+                for (size_t i = c; i < count; i += channels)
+                    target[i] = encode_srgb(source[i], tables);
+            else
+                for (size_t i = c; i < count; i += channels)
+                    target[i] = encode_unorm(source[i]);
+        }
+    }
+
+    void setup_mip_chain(Extent2D extent, unsigned int channels, bool HDR, bool sRGB, processing::MipChain &chain)
+    {
+        chain.extent = extent;
+        chain.channels = channels;
+        chain.HDR = HDR;
+        chain.sRGB = sRGB && !HDR;
+
+        const size_t texelSize = channels * (HDR ? sizeof(float) : sizeof(unsigned char));
+        size_t levelCount = 1;
+        while ((extent.width >> levelCount) > 0 || (extent.height >> levelCount) > 0)
+            levelCount++;
+
+        chain.levelOffsets.assign(1, 0);
+        for (size_t level = 0; level < levelCount; level++)
+        {
+            const Extent2D levelExtent = chain.get_level_extent(level);
+            chain.levelOffsets.push_back(chain.levelOffsets.back() + size_t(levelExtent.width) * levelExtent.height * texelSize);
+        }
+        chain.data.resize(chain.levelOffsets.back());
+    }
+
+    /*
+    Shared by both source types. Level 0 is decoded row by row during the first horizontal pass, later levels read the
+    linear float result of the previous one.
+    */
+    template <typename T>
+    void build_mip_chain(const T *pixels, Extent2D extent, unsigned int channels, processing::MipChain &chain, processing::MipSettings settings)
+    {
+        const bool HDR = std::is_same<T, float>::value;
+        chain = processing::MipChain();
+        if (!pixels || extent.width <= 0 || extent.height <= 0 || channels == 0 || channels > 4)
+        {
+            ERR_LOG("Invalid image for mip chain generation");
+            return;
+        }
+        setup_mip_chain(extent, channels, HDR, settings.sRGB, chain);
+        memcpy(chain.data.data(), pixels, chain.get_level_size(0));
+
+        std::vector<float> decodeTable(256 * channels);
+        if (!HDR)
+        {
+            const ColorTables &tables = get_color_tables();
+            for (unsigned int c = 0; c < channels; c++)
+                memcpy(decodeTable.data() + c * 256, chain.sRGB && !is_alpha_channel(c, channels) ? tables.sRGBToLinear : tables.unormToFloat, 256 * sizeof(float));
+        }
+
+        std::vector<float> source, intermediate, target;
+        for (size_t level = 1; level < chain.get_level_count(); level++)
+        {
+            const Extent2D sourceExtent = chain.get_level_extent(level - 1);
+            const Extent2D targetExtent = chain.get_level_extent(level);
+            const size_t sourceRow = size_t(sourceExtent.width) * channels;
+            const size_t targetRow = size_t(targetExtent.width) * channels;
+
+            const FilterTaps rowTaps = build_filter_taps(sourceExtent.width, targetExtent.width, settings.filter, settings.wrap);
+            const FilterTaps columnTaps = build_filter_taps(sourceExtent.height, targetExtent.height, settings.filter, settings.wrap);
+
+            intermediate.resize(targetRow * sourceExtent.height);
+            utils::parallel_for(sourceExtent.height, [&](size_t begin, size_t end, size_t)
+                                {
+                std::vector<float> decoded(level == 1 ? sourceRow : 0);
+                for (size_t y = begin; y < end; y++)
+                {
+                    const float *row;
+                    if (level > 1)
+                        row = source.data() + y * sourceRow;
+                    else if (HDR)
+                        row = reinterpret_cast<const float *>(pixels) + y * sourceRow;
+                    else
+                    {
+                        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(pixels) + y * sourceRow;
+                        for (unsigned int c = 0; c < channels; c++)
+                        {
+                            const float *table = decodeTable.data() + c * 256;
+                            for (size_t i = c; i < sourceRow; i += channels)
+                                decoded[i] = table[bytes[i]];
+                        }
+                        row = decoded.data();
+                    }
+                    filter_row(row, intermediate.data() + y * targetRow, targetExtent.width, channels, rowTaps);
+                } }, settings.threadCount);
+
+            target.assign(targetRow * targetExtent.height, 0.0f);
+            unsigned char *levelData = chain.data.data() + chain.levelOffsets[level];
+            const size_t levelRowBytes = chain.get_level_size(level) / targetExtent.height;
+            utils::parallel_for(targetExtent.height, [&](size_t begin, size_t end, size_t)
+                                {
+                for (size_t y = begin; y < end; y++)
+                {
+                    float *row = target.data() + y * targetRow;
+                    for (size_t t = 0; t < columnTaps.tapCount; t++)
+                    {
+                        const float weight = columnTaps.weights[y * columnTaps.tapCount + t];
+                        if (weight != 0.0f)
+                            accumulate_row(row, intermediate.data() + columnTaps.indices[y * columnTaps.tapCount + t] * targetRow, weight, targetRow);
+                    }
+                    encode_row(row, levelData + y * levelRowBytes, targetExtent.width, channels, HDR, chain.sRGB);
+                } }, settings.threadCount);
+
+            source.swap(target);
+        }
+    }
+}
+
+void processing::generate_mip_chain(const unsigned char *pixels, Extent2D extent, unsigned int channels, MipChain &chain, MipSettings settings)
+{
+    build_mip_chain(pixels, extent, channels, chain, settings);
+}
+
+void processing::generate_mip_chain(const float *pixels, Extent2D extent, unsigned int channels, MipChain &chain, MipSettings settings)
+{
+    build_mip_chain(pixels, extent, channels, chain, settings);
+}
+
+TextureLevels processing::get_texture_levels(const MipChain *faces, unsigned int faceCount, std::shared_ptr<const void> storage)
+{
+    const unsigned int formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    TextureLevels levels;
+    levels.format = formats[faces[0].channels - 1];
+    levels.dataType = faces[0].HDR ? GL_FLOAT : GL_UNSIGNED_BYTE;
+    levels.compressedFormat = faces[0].compressedFormat;
+    levels.faceCount = faceCount;
+    for (size_t level = 0; level < faces[0].get_level_count(); level++)
+    {
+        levels.extents.push_back(faces[0].get_level_extent(level));
+        levels.sizes.push_back(faces[0].get_level_size(level));
+    }
+    for (unsigned int face = 0; face < faceCount; face++)
+        for (size_t level = 0; level < faces[face].get_level_count(); level++)
+            levels.data.push_back(faces[face].get_level_data(level));
+    levels.storage = std::move(storage);
+    return levels;
+}
+
+namespace
+{
+    /*
+    Texels of a 4x4 block as channel planes in 0..255, so four texels go in each SSE register.
+    */
+    struct BlockTexels
+    {
+        alignas(16) float channels[4][16];
+    };
+
+    const glm::vec4 RGB_WEIGHTS(1.0f, 1.0f, 1.0f, 0.0f);
+    const glm::vec4 RGBA_WEIGHTS(1.0f);
+    const float BC1_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f}; // Position of each index between the endpoints
+    const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    void fetch_block(const unsigned char *pixels, Extent2D extent, unsigned int channels, int blockX, int blockY, BlockTexels &block)
+    {
+        const float defaults[4] = {0.0f, 0.0f, 0.0f, 255.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            const int x = std::min(blockX * 4 + (i & 3), extent.width - 1);
+            const int y = std::min(blockY * 4 + (i >> 2), extent.height - 1);
+            const unsigned char *texel = pixels + (size_t(y) * extent.width + x) * channels;
+            for (unsigned int c = 0; c < 4; c++)
+                block.channels[c][i] = c < channels ? float(texel[c]) : defaults[c];
+        }
+    }
+
+    /*
+    Closest palette entry of every texel under weighted squared distance. Returns the total error.
+    */
+    float select_indices(const BlockTexels &block, const glm::vec4 *palette, int paletteSize, const glm::vec4 &weights, unsigned char *indices)
+    {
+#ifdef GLSP_SSE2
+        __m128 total = _mm_setzero_ps();
+        for (int i = 0; i < 16; i += 4)
+        {
+            const __m128 r = _mm_load_ps(block.channels[0] + i);
+            const __m128 g = _mm_load_ps(block.channels[1] + i);
+            const __m128 b = _mm_load_ps(block.channels[2] + i);
+            const __m128 a = _mm_load_ps(block.channels[3] + i);
+            __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128i bestIndex = _mm_setzero_si128();
+            for (int p = 0; p < paletteSize; p++)
+            {
+                const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p].r));
+                const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p].g));
+                const __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p].b));
+                const __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[p].a));
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(dr, dr), _mm_set1_ps(weights.r)), _mm_mul_ps(_mm_mul_ps(dg, dg), _mm_set1_ps(weights.g))),
+                                                   _mm_add_ps(_mm_mul_ps(_mm_mul_ps(db, db), _mm_set1_ps(weights.b)), _mm_mul_ps(_mm_mul_ps(da, da), _mm_set1_ps(weights.a))));
+                const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+                best = _mm_min_ps(best, distance);
+            }
+            alignas(16) int lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), bestIndex);
+            for (int lane = 0; lane < 4; lane++)
+                indices[i + lane] = static_cast<unsigned char>(lanes[lane]);
+            total = _mm_add_ps(total, best);
+        }
+        alignas(16) float sums[4];
+        _mm_store_ps(sums, total);
+        return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            const glm::vec4 texel(block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i]);
+            float best = std::numeric_limits<float>::max();
+            for (int p = 0; p < paletteSize; p++)
+            {
+                const glm::vec4 difference = texel - palette[p];
+                const float distance = glm::dot(difference * difference, weights);
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[i] = static_cast<unsigned char>(p);
+                }
+            }
+            total += best;
+        }
+        return total;
+#endif
+    }
+
+    /*
+    Endpoints at the extremes of the block projected onto its principal axis, found by power iteration.
+    */
+    void fit_principal_axis(const BlockTexels &block, const glm::vec4 &weights, int iterations, glm::vec4 &e0, glm::vec4 &e1)
+    {
+        glm::vec4 mean(0.0f), minimum(255.0f), maximum(0.0f);
+        for (int i = 0; i < 16; i++)
+        {
+            const glm::vec4 texel(block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i]);
+            mean += texel;
+            minimum = glm::min(minimum, texel);
+            maximum = glm::max(maximum, texel);
+        }
+        mean /= 16.0f;
+
+        glm::mat4 covariance(0.0f);
+        for (int i = 0; i < 16; i++)
+        {
+            const glm::vec4 d = (glm::vec4(block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i]) - mean) * weights;
+            covariance += glm::outerProduct(d, d);
+        }
+
+        glm::vec4 axis = (maximum - minimum) * weights;
+        // Start from the bounding box diagonal, flipping the channels that correlate negatively with the largest one
+        const int largest = axis.r >= axis.g && axis.r >= axis.b && axis.r >= axis.a ? 0 : (axis.g >= axis.b && axis.g >= axis.a ? 1 : (axis.b >= axis.a ? 2 : 3));
+        for (int c = 0; c < 4; c++)
+            if (covariance[largest][c] < 0.0f)
+                axis[c] = -axis[c];
+        for (int i = 0; i < iterations; i++)
+        {
+            const glm::vec4 next = covariance * axis;
+            const float length = glm::length(next);
+            if (length < 1e-6f)
+                break;
+            axis = next / length;
+        }
+        const float length = glm::length(axis);
+        if (length < 1e-6f)
+        {
+            e0 = e1 = mean;
+            return;
+        }
+        axis /= length;
+
+        float low = 0.0f, high = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            const float t = glm::dot(glm::vec4(block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i]) - mean, axis);
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+        e0 = glm::clamp(mean + axis * low, 0.0f, 255.0f);
+        e1 = glm::clamp(mean + axis * high, 0.0f, 255.0f);
+        // Channels left out of the fit keep their average
+        for (int c = 0; c < 4; c++)
+            if (weights[c] == 0.0f)
+                e0[c] = e1[c] = mean[c];
+    }
+
+    /*
+    Least squares endpoints for fixed indices, t being the position of each index between e0 and e1.
+    */
+    bool refine_endpoints(const BlockTexels &block, const unsigned char *indices, const float *t, glm::vec4 &e0, glm::vec4 &e1)
+    {
+        float a = 0.0f, b = 0.0f, c = 0.0f;
+        glm::vec4 x0(0.0f), x1(0.0f);
+        for (int i = 0; i < 16; i++)
+        {
+            const float w1 = t[indices[i]], w0 = 1.0f - w1;
+            const glm::vec4 texel(block.channels[0][i], block.channels[1][i], block.channels[2][i], block.channels[3][i]);
+            a += w0 * w0;
+            b += w0 * w1;
+            c += w1 * w1;
+            x0 += texel * w0;
+            x1 += texel * w1;
+        }
+        const float determinant = a * c - b * b;
+        if (std::abs(determinant) < 1e-6f)
+            return false;
+        e0 = glm::clamp((x0 * c - x1 * b) / determinant, 0.0f, 255.0f);
+        e1 = glm::clamp((x1 * a - x0 * b) / determinant, 0.0f, 255.0f);
+        return true;
+    }
+
+    int get_refinement_count(processing::BlockQuality quality)
+    {
+        return quality == processing::BLOCK_QUALITY_FAST ? 0 : (quality == processing::BLOCK_QUALITY_NORMAL ? 2 : 6);
+    }
+
+    // BC1 ------------------------------------------------------------------------------------------------------
+
+    inline uint16_t pack_565(const glm::vec4 &color)
+    {
+        const int r = static_cast<int>(color.r * 31.0f / 255.0f + 0.5f);
+        const int g = static_cast<int>(color.g * 63.0f / 255.0f + 0.5f);
+        const int b = static_cast<int>(color.b * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((std::min(r, 31) << 11) | (std::min(g, 63) << 5) | std::min(b, 31));
+    }
+
+    inline glm::vec4 unpack_565(uint16_t color)
+    {
+        const int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        return glm::vec4((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255.0f);
+    }
+
+    inline void get_BC1_palette(uint16_t c0, uint16_t c1, bool fourColors, glm::vec4 *palette)
+    {
+        palette[0] = unpack_565(c0);
+        palette[1] = unpack_565(c1);
+        if (fourColors)
+        {
+            palette[2] = glm::floor((palette[0] * 2.0f + palette[1]) / 3.0f);
+            palette[3] = glm::floor((palette[0] + palette[1] * 2.0f) / 3.0f);
+        }
+        else
+        {
+            palette[2] = glm::floor((palette[0] + palette[1]) / 2.0f);
+            palette[3] = glm::vec4(0.0f, 0.0f, 0.0f, 255.0f); // Opaque black, as the rgb formats decode it
+        }
+    }
+
+    float evaluate_BC1(const BlockTexels &block, uint16_t c0, uint16_t c1, unsigned char *indices)
+    {
+        glm::vec4 palette[4];
+        get_BC1_palette(c0, c1, true, palette);
+        return select_indices(block, palette, 4, RGB_WEIGHTS, indices);
+    }
+
+    /*
+    Four color mode only, so it is also valid as the color half of BC3, which never uses the three color mode.
+    */
+    void encode_BC1_block(const BlockTexels &block, processing::BlockQuality quality, unsigned char *output)
+    {
+        glm::vec4 e0, e1;
+        fit_principal_axis(block, RGB_WEIGHTS, quality == processing::BLOCK_QUALITY_FAST ? 2 : 8, e0, e1);
+
+        uint16_t c0 = pack_565(e0), c1 = pack_565(e1);
+        unsigned char indices[16], candidate[16];
+        float error = evaluate_BC1(block, c0, c1, indices);
+
+        for (int i = 0; i < get_refinement_count(quality) && error > 0.0f; i++)
+        {
+            if (!refine_endpoints(block, indices, BC1_WEIGHTS, e0, e1))
+                break;
+            const uint16_t r0 = pack_565(e0), r1 = pack_565(e1);
+            const float refined = evaluate_BC1(block, r0, r1, candidate);
+            if (refined >= error)
+                break;
+            c0 = r0, c1 = r1, error = refined;
+            memcpy(indices, candidate, 16);
+        }
+
+        if (quality == processing::BLOCK_QUALITY_HIGH)
+        {
+            // Greedy steps of one unit on every endpoint channel while they keep lowering the error
+            const uint16_t steps[3] = {1 << 11, 1 << 5, 1};
+            const uint16_t masks[3] = {31 << 11, 63 << 5, 31};
+            for (bool improved = true; improved && error > 0.0f;)
+            {
+                improved = false;
+                for (int endpoint = 0; endpoint < 2; endpoint++)
+                    for (int channel = 0; channel < 3; channel++)
+                        for (int sign = -1; sign <= 1; sign += 2)
+                        {
+                            uint16_t &color = endpoint == 0 ? c0 : c1;
+                            const int field = color & masks[channel];
+                            const int moved = field + sign * steps[channel];
+                            if (moved < 0 || moved > masks[channel])
+                                continue;
+                            const uint16_t original = color;
+                            color = static_cast<uint16_t>((color & ~masks[channel]) | moved);
+                            const float moveError = evaluate_BC1(block, c0, c1, candidate);
+                            if (moveError < error)
+                            {
+                                error = moveError;
+                                memcpy(indices, candidate, 16);
+                                improved = true;
+                            }
+                            else
+                                color = original;
+                        }
+            }
+        }
+
+        // Four color mode needs c0 > c1
+        if (c0 < c1)
+        {
+            std::swap(c0, c1);
+            for (unsigned char &index : indices)
+                index ^= 1; // 0 <-> 1, 2 <-> 3
+        }
+        else if (c0 == c1)
+            memset(indices, 0, 16);
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= uint32_t(indices[i]) << (i * 2);
+        memcpy(output, &c0, 2);
+        memcpy(output + 2, &c1, 2);
+        memcpy(output + 4, &bits, 4);
+    }
+
+    void decode_BC1_block(const unsigned char *input, bool forceFourColors, unsigned char *texels)
+    {
+        uint16_t c0, c1;
+        uint32_t bits;
+        memcpy(&c0, input, 2);
+        memcpy(&c1, input + 2, 2);
+        memcpy(&bits, input + 4, 4);
+        glm::vec4 palette[4];
+        get_BC1_palette(c0, c1, forceFourColors || c0 > c1, palette);
+        for (int i = 0; i < 16; i++)
+        {
+            const glm::vec4 &color = palette[(bits >> (i * 2)) & 3];
+            for (int c = 0; c < 4; c++)
+                texels[i * 4 + c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+
+    // BC4 ------------------------------------------------------------------------------------------------------
+
+    inline void get_BC4_palette(int a0, int a1, int *palette)
+    {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+            for (int i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        else
+        {
+            for (int i = 2; i < 6; i++)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    int evaluate_BC4(const int *values, int a0, int a1, unsigned char *indices)
+    {
+        int palette[8];
+        get_BC4_palette(a0, a1, palette);
+        int total = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            int best = std::numeric_limits<int>::max();
+            for (int p = 0; p < 8; p++)
+            {
+                const int distance = (values[i] - palette[p]) * (values[i] - palette[p]);
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[i] = static_cast<unsigned char>(p);
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    /*
+    Tries the eight value mode over the whole range and, above fast quality, the six value mode over the texels that
+    are not 0 or 255, which that mode stores exactly.
+    */
+    void encode_BC4_block(const BlockTexels &block, int channel, processing::BlockQuality quality, unsigned char *output)
+    {
+        int values[16], low = 255, high = 0, innerLow = 255, innerHigh = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            values[i] = static_cast<int>(block.channels[channel][i]);
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+            if (values[i] > 0 && values[i] < 255)
+            {
+                innerLow = std::min(innerLow, values[i]);
+                innerHigh = std::max(innerHigh, values[i]);
+            }
+        }
+
+        unsigned char indices[16], candidate[16];
+        int a0 = high, a1 = low;
+        int error = evaluate_BC4(values, a0, a1, indices);
+        if (quality != processing::BLOCK_QUALITY_FAST && error > 0 && innerLow <= innerHigh)
+        {
+            const int sixError = evaluate_BC4(values, innerLow, innerHigh, candidate);
+            if (sixError < error)
+            {
+                a0 = innerLow, a1 = innerHigh, error = sixError;
+                memcpy(indices, candidate, 16);
+            }
+        }
+
+        if (quality == processing::BLOCK_QUALITY_HIGH)
+        {
+            // Greedy steps of one unit on both endpoints, staying in the same mode
+            for (bool improved = true; improved && error > 0;)
+            {
+                improved = false;
+                for (int endpoint = 0; endpoint < 2; endpoint++)
+                    for (int sign = -1; sign <= 1; sign += 2)
+                    {
+                        int m0 = a0 + (endpoint == 0 ? sign : 0), m1 = a1 + (endpoint == 1 ? sign : 0);
+                        if (m0 < 0 || m0 > 255 || m1 < 0 || m1 > 255 || (m0 > m1) != (a0 > a1))
+                            continue;
+                        const int moveError = evaluate_BC4(values, m0, m1, candidate);
+                        if (moveError < error)
+                        {
+                            a0 = m0, a1 = m1, error = moveError;
+                            memcpy(indices, candidate, 16);
+                            improved = true;
+                        }
+                    }
+            }
+        }
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= uint64_t(indices[i]) << (i * 3);
+        output[0] = static_cast<unsigned char>(a0);
+        output[1] = static_cast<unsigned char>(a1);
+        for (int i = 0; i < 6; i++)
+            output[2 + i] = static_cast<unsigned char>(bits >> (i * 8));
+    }
+
+    void decode_BC4_block(const unsigned char *input, int channel, unsigned char *texels)
+    {
+        int palette[8];
+        get_BC4_palette(input[0], input[1], palette);
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; i++)
+            bits |= uint64_t(input[2 + i]) << (i * 8);
+        for (int i = 0; i < 16; i++)
+            texels[i * 4 + channel] = static_cast<unsigned char>(palette[(bits >> (i * 3)) & 7]);
+    }
+
+    // BC7 ------------------------------------------------------------------------------------------------------
+
+    /*
+    Mode 6 endpoint: 7 bits per channel plus a p-bit shared by the four channels.
+    */
+    struct Mode6Endpoint
+    {
+        int color[4];
+        int pBit;
+
+        inline glm::vec4 get_value() const { return glm::vec4(color[0] * 2 + pBit, color[1] * 2 + pBit, color[2] * 2 + pBit, color[3] * 2 + pBit); }
+    };
+
+    inline Mode6Endpoint quantize_mode6(const glm::vec4 &value, int pBit)
+    {
+        Mode6Endpoint endpoint;
+        endpoint.pBit = pBit;
+        for (int c = 0; c < 4; c++)
+            endpoint.color[c] = std::min(std::max(static_cast<int>((value[c] - pBit) * 0.5f + 0.5f), 0), 127);
+        return endpoint;
+    }
+
+    float evaluate_mode6(const BlockTexels &block, const Mode6Endpoint &e0, const Mode6Endpoint &e1, unsigned char *indices)
+    {
+        const glm::vec4 v0 = e0.get_value(), v1 = e1.get_value();
+        glm::vec4 palette[16];
+        for (int i = 0; i < 16; i++)
+            palette[i] = glm::floor((v0 * float(64 - BC7_WEIGHTS[i]) + v1 * float(BC7_WEIGHTS[i]) + 32.0f) / 64.0f);
+        return select_indices(block, palette, 16, RGBA_WEIGHTS, indices);
+    }
+
+    /*
+    Best quantization of a pair of endpoints. Fast quality picks each p-bit on its own, otherwise the four combinations
+    are evaluated over the block.
+    */
+    float quantize_mode6_pair(const BlockTexels &block, const glm::vec4 &e0, const glm::vec4 &e1, processing::BlockQuality quality,
+                              Mode6Endpoint &q0, Mode6Endpoint &q1, unsigned char *indices)
+    {
+        if (quality == processing::BLOCK_QUALITY_FAST)
+        {
+            auto closest = [](const glm::vec4 &value)
+            {
+                const Mode6Endpoint even = quantize_mode6(value, 0), odd = quantize_mode6(value, 1);
+                const glm::vec4 de = even.get_value() - value, dodd = odd.get_value() - value;
+                return glm::dot(de, de) <= glm::dot(dodd, dodd) ? even : odd;
+            };
+            q0 = closest(e0);
+            q1 = closest(e1);
+            return evaluate_mode6(block, q0, q1, indices);
+        }
+
+        float best = std::numeric_limits<float>::max();
+        unsigned char candidate[16];
+        for (int p = 0; p < 4; p++)
+        {
+            const Mode6Endpoint c0 = quantize_mode6(e0, p & 1), c1 = quantize_mode6(e1, p >> 1);
+            const float error = evaluate_mode6(block, c0, c1, candidate);
+            if (error < best)
+            {
+                best = error, q0 = c0, q1 = c1;
+                memcpy(indices, candidate, 16);
+            }
+        }
+        return best;
+    }
+
+    /*
+    Little endian bit stream over a 16 byte block.
+    */
+    struct BlockBits
+    {
+        unsigned char *data;
+        int position{0};
+
+        void write(uint32_t value, int count)
+        {
+            for (int i = 0; i < count; i++, position++)
+                if (value & (1u << i))
+                    data[position >> 3] |= static_cast<unsigned char>(1u << (position & 7));
+        }
+
+        uint32_t read(int count)
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < count; i++, position++)
+                value |= uint32_t((data[position >> 3] >> (position & 7)) & 1) << i;
+            return value;
+        }
+    };
+
+    void encode_BC7_block(const BlockTexels &block, processing::BlockQuality quality, unsigned char *output)
+    {
+        glm::vec4 e0, e1;
+        fit_principal_axis(block, RGBA_WEIGHTS, quality == processing::BLOCK_QUALITY_FAST ? 2 : 8, e0, e1);
+
+        Mode6Endpoint q0, q1;
+        unsigned char indices[16], candidate[16];
+        float error = quantize_mode6_pair(block, e0, e1, quality, q0, q1, indices);
+
+        float weights[16];
+        for (int i = 0; i < 16; i++)
+            weights[i] = BC7_WEIGHTS[i] / 64.0f;
+        for (int i = 0; i < get_refinement_count(quality) && error > 0.0f; i++)
+        {
+            if (!refine_endpoints(block, indices, weights, e0, e1))
+                break;
+            Mode6Endpoint r0, r1;
+            const float refined = quantize_mode6_pair(block, e0, e1, quality, r0, r1, candidate);
+            if (refined >= error)
+                break;
+            q0 = r0, q1 = r1, error = refined;
+            memcpy(indices, candidate, 16);
+        }
+
+        if (quality == processing::BLOCK_QUALITY_HIGH)
+        {
+            // Greedy steps of one unit on every endpoint channel while they keep lowering the error
+            for (bool improved = true; improved && error > 0.0f;)
+            {
+                improved = false;
+                for (int endpoint = 0; endpoint < 2; endpoint++)
+                    for (int channel = 0; channel < 4; channel++)
+                        for (int sign = -1; sign <= 1; sign += 2)
+                        {
+                            Mode6Endpoint &moved = endpoint == 0 ? q0 : q1;
+                            const int original = moved.color[channel];
+                            if (original + sign < 0 || original + sign > 127)
+                                continue;
+                            moved.color[channel] += sign;
+                            const float moveError = evaluate_mode6(block, q0, q1, candidate);
+                            if (moveError < error)
+                            {
+                                error = moveError;
+                                memcpy(indices, candidate, 16);
+                                improved = true;
+                            }
+                            else
+                                moved.color[channel] = original;
+                        }
+            }
+        }
+
+        // The anchor texel stores its index without the top bit, so it must be in the lower half
+        if (indices[0] >= 8)
+        {
+            std::swap(q0, q1);
+            for (unsigned char &index : indices)
+                index = static_cast<unsigned char>(15 - index);
+        }
+
+        memset(output, 0, 16);
+        BlockBits bits{output};
+        bits.write(1 << 6, 7); // Mode 6
+        for (int c = 0; c < 4; c++)
+        {
+            bits.write(q0.color[c], 7);
+            bits.write(q1.color[c], 7);
+        }
+        bits.write(q0.pBit, 1);
+        bits.write(q1.pBit, 1);
+        bits.write(indices[0], 3);
+        for (int i = 1; i < 16; i++)
+            bits.write(indices[i], 4);
+    }
+
+    void decode_BC7_block(const unsigned char *input, unsigned char *texels)
+    {
+        BlockBits bits{const_cast<unsigned char *>(input)};
+        if (bits.read(7) != (1 << 6))
+        {
+            memset(texels, 0, 64);
+            return;
+        }
+        Mode6Endpoint e0, e1;
+        for (int c = 0; c < 4; c++)
+        {
+            e0.color[c] = bits.read(7);
+            e1.color[c] = bits.read(7);
+        }
+        e0.pBit = bits.read(1);
+        e1.pBit = bits.read(1);
+        const glm::vec4 v0 = e0.get_value(), v1 = e1.get_value();
+        for (int i = 0; i < 16; i++)
+        {
+            const int w = BC7_WEIGHTS[bits.read(i == 0 ? 3 : 4)];
+            for (int c = 0; c < 4; c++)
+                texels[i * 4 + c] = static_cast<unsigned char>((int(v0[c]) * (64 - w) + int(v1[c]) * w + 32) >> 6);
+        }
+    }
+
+    void encode_block(const BlockTexels &block, const processing::BlockCompressionSettings &settings, unsigned char *output)
+    {
+        switch (settings.format)
+        {
+        case processing::BLOCK_FORMAT_BC1:
+            encode_BC1_block(block, settings.quality, output);
+            break;
+        case processing::BLOCK_FORMAT_BC3:
+            encode_BC4_block(block, 3, settings.quality, output);
+            encode_BC1_block(block, settings.quality, output + 8);
+            break;
+        case processing::BLOCK_FORMAT_BC4:
+            encode_BC4_block(block, 0, settings.quality, output);
+            break;
+        case processing::BLOCK_FORMAT_BC5:
+            encode_BC4_block(block, 0, settings.quality, output);
+            encode_BC4_block(block, 1, settings.quality, output + 8);
+            break;
+        case processing::BLOCK_FORMAT_BC7:
+            encode_BC7_block(block, settings.quality, output);
+            break;
+        }
+    }
+}
+
+unsigned int processing::get_block_format_GL(BlockFormat format)
+{
+    switch (format)
+    {
+    case BLOCK_FORMAT_BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BLOCK_FORMAT_BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BLOCK_FORMAT_BC4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case BLOCK_FORMAT_BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case BLOCK_FORMAT_BC7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+size_t processing::get_block_size(BlockFormat format)
+{
+    return format == BLOCK_FORMAT_BC1 || format == BLOCK_FORMAT_BC4 ? 8 : 16;
+}
+
+void processing::compress_blocks(const unsigned char *pixels, Extent2D extent, unsigned int channels, std::vector<unsigned char> &blocks, BlockCompressionSettings settings)
+{
+    const int blocksX = (extent.width + 3) / 4, blocksY = (extent.height + 3) / 4;
+    const size_t blockSize = get_block_size(settings.format);
+    blocks.assign(size_t(blocksX) * blocksY * blockSize, 0);
+    if (!pixels || blocksX == 0 || blocksY == 0 || channels == 0 || channels > 4)
+        return;
+
+    utils::parallel_for(blocksY, [&](size_t begin, size_t end, size_t)
+                        {
+        BlockTexels block;
+        for (size_t y = begin; y < end; y++)
+            for (int x = 0; x < blocksX; x++)
+            {
+                fetch_block(pixels, extent, channels, x, static_cast<int>(y), block);
+                encode_block(block, settings, blocks.data() + (y * blocksX + x) * blockSize);
+            } }, settings.threadCount);
+}
+
+bool processing::compress_mip_chain(const MipChain &chain, MipChain &compressed, BlockCompressionSettings settings)
+{
+    if (chain.HDR || chain.compressedFormat != 0)
+    {
+        ERR_LOG("Only uncompressed 8 bit mip chains can be block compressed");
+        return false;
+    }
+
+    MipChain result;
+    result.extent = chain.extent;
+    result.channels = chain.channels;
+    result.sRGB = chain.sRGB;
+    result.compressedFormat = get_block_format_GL(settings.format);
+    result.levelOffsets.assign(1, 0);
+
+    std::vector<unsigned char> blocks;
+    for (size_t level = 0; level < chain.get_level_count(); level++)
+    {
+        compress_blocks(chain.get_level_data(level), chain.get_level_extent(level), chain.channels, blocks, settings);
+        result.data.insert(result.data.end(), blocks.begin(), blocks.end());
+        result.levelOffsets.push_back(result.data.size());
+    }
+    compressed = std::move(result);
+    return true;
+}
+
+void processing::decompress_blocks(const unsigned char *blocks, Extent2D extent, BlockFormat format, unsigned char *pixels)
+{
+    const int blocksX = (extent.width + 3) / 4, blocksY = (extent.height + 3) / 4;
+    const size_t blockSize = get_block_size(format);
+    unsigned char texels[64];
+    for (int by = 0; by < blocksY; by++)
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            const unsigned char *block = blocks + (size_t(by) * blocksX + bx) * blockSize;
+            for (int i = 0; i < 16; i++)
+                texels[i * 4 + 0] = texels[i * 4 + 1] = texels[i * 4 + 2] = 0, texels[i * 4 + 3] = 255;
+            switch (format)
+            {
+            case BLOCK_FORMAT_BC1:
+                decode_BC1_block(block, false, texels);
+                break;
+            case BLOCK_FORMAT_BC3:
+                decode_BC1_block(block + 8, true, texels);
+                decode_BC4_block(block, 3, texels);
+                break;
+            case BLOCK_FORMAT_BC4:
+                decode_BC4_block(block, 0, texels);
+                break;
+            case BLOCK_FORMAT_BC5:
+                decode_BC4_block(block, 0, texels);
+                decode_BC4_block(block + 8, 1, texels);
+                break;
+            case BLOCK_FORMAT_BC7:
+                decode_BC7_block(block, texels);
+                break;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                const int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x < extent.width && y < extent.height)
+                    memcpy(pixels + (size_t(y) * extent.width + x) * 4, texels + i * 4, 4);
+            }
+        }
+}
+
+namespace
+{
+    /*
+    Unnormalized direction through a face texel, u and v in [-1, 1]. Same mapping as the GPU converter shader.
+    */
+    inline glm::vec3 get_face_direction(int face, float u, float v)
+    {
+        switch (face)
+        {
+        case 0:
+            return glm::vec3(1.0f, v, -u);
+        case 1:
+            return glm::vec3(-1.0f, v, u);
+        case 2:
+            return glm::vec3(u, -1.0f, v);
+        case 3:
+            return glm::vec3(u, 1.0f, -v);
+        case 4:
+            return glm::vec3(u, v, 1.0f);
+        default:
+            return glm::vec3(-u, v, -1.0f);
+        }
+    }
+
+#ifdef GLSP_SSE2
+    /*
+    Four atan2 at once. Octant reduction plus a minimax polynomial, maximum error around 1e-5 radians.
+    */
+    inline __m128 atan2_ps(__m128 y, __m128 x)
+    {
+        const __m128 SIGN = _mm_set1_ps(-0.0f);
+        const __m128 ax = _mm_andnot_ps(SIGN, x), ay = _mm_andnot_ps(SIGN, y);
+        const __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+        const __m128 s = _mm_mul_ps(a, a);
+        __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0464964749f), s), _mm_set1_ps(0.15931422f));
+        r = _mm_sub_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.327622764f));
+        r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+
+        const __m128 steep = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(_mm_set1_ps(glm::half_pi<float>()), r)), _mm_andnot_ps(steep, r));
+        const __m128 negativeX = _mm_cmplt_ps(x, _mm_setzero_ps());
+        r = _mm_or_ps(_mm_and_ps(negativeX, _mm_sub_ps(_mm_set1_ps(glm::pi<float>()), r)), _mm_andnot_ps(negativeX, r));
+        return _mm_xor_ps(r, _mm_and_ps(SIGN, y));
+    }
+#endif
+
+    /*
+    Bilinear footprint of a panorama lookup: wrapping horizontally, clamped at the poles.
+    */
+    struct PanoramaSample
+    {
+        int x0, x1, y0, y1;
+        float wx, wy;
+    };
+
+    inline PanoramaSample get_panorama_sample(float fx, float fy, Extent2D extent)
+    {
+        PanoramaSample sample;
+        const float x = std::floor(fx), y = std::floor(fy);
+        sample.wx = fx - x;
+        sample.wy = fy - y;
+        // Lookups stay within one texel of the [0, width) range
+        sample.x0 = static_cast<int>(x);
+        sample.x0 = sample.x0 < 0 ? sample.x0 + extent.width : (sample.x0 >= extent.width ? sample.x0 - extent.width : sample.x0);
+        sample.x1 = sample.x0 + 1 == extent.width ? 0 : sample.x0 + 1;
+        sample.y0 = std::min(std::max(static_cast<int>(y), 0), extent.height - 1);
+        sample.y1 = std::min(std::max(static_cast<int>(y) + 1, 0), extent.height - 1);
+        return sample;
+    }
+
+    inline void sample_panorama(const float *pixels, Extent2D extent, unsigned int channels, const PanoramaSample &sample, bool tonemap, float *output)
+    {
+        const float *p00 = pixels + (size_t(sample.y0) * extent.width + sample.x0) * channels;
+        const float *p01 = pixels + (size_t(sample.y0) * extent.width + sample.x1) * channels;
+        const float *p10 = pixels + (size_t(sample.y1) * extent.width + sample.x0) * channels;
+        const float *p11 = pixels + (size_t(sample.y1) * extent.width + sample.x1) * channels;
+        for (unsigned int c = 0; c < channels; c++)
+        {
+            const float top = p00[c] + (p01[c] - p00[c]) * sample.wx;
+            const float bottom = p10[c] + (p11[c] - p10[c]) * sample.wx;
+            float value = top + (bottom - top) * sample.wy;
+            if (tonemap)
+                value = c == 3 ? 1.0f : std::pow(value / (value + 1.0f), 1.0f / 2.2f);
+            output[c] = value;
+        }
+    }
+
+    void project_face_row(const float *pixels, Extent2D extent, unsigned int channels, int face, int row, int resolution, bool tonemap, float *output)
+    {
+        const float invResolution = 1.0f / resolution;
+        const float v = (row + 0.5f) * invResolution * 2.0f - 1.0f;
+        int x = 0;
+#ifdef GLSP_SSE2
+        const __m128 WIDTH = _mm_set1_ps(float(extent.width)), HEIGHT = _mm_set1_ps(float(extent.height));
+        const __m128 HALF = _mm_set1_ps(0.5f), ONE = _mm_set1_ps(1.0f);
+        const __m128 INV_PI = _mm_set1_ps(glm::one_over_pi<float>());
+        for (; x + 4 <= resolution; x += 4)
+        {
+            alignas(16) float dx[4], dy[4], dz[4];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                const glm::vec3 direction = get_face_direction(face, (x + lane + 0.5f) * invResolution * 2.0f - 1.0f, v);
+                dx[lane] = direction.x, dy[lane] = direction.y, dz[lane] = direction.z;
+            }
+            __m128 px = _mm_load_ps(dx), py = _mm_load_ps(dy), pz = _mm_load_ps(dz);
+            const __m128 invLength = _mm_div_ps(ONE, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz))));
+            px = _mm_mul_ps(px, invLength), py = _mm_mul_ps(py, invLength), pz = _mm_mul_ps(pz, invLength);
+
+            // u = 0.5 + 0.5 * atan2(z, x) / pi, v = 1 - acos(y) / pi, with acos(y) = atan2(sqrt(1 - y^2), y)
+            const __m128 u = _mm_add_ps(HALF, _mm_mul_ps(_mm_mul_ps(HALF, atan2_ps(pz, px)), INV_PI));
+            const __m128 sine = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(ONE, _mm_mul_ps(py, py)), _mm_setzero_ps()));
+            const __m128 t = _mm_sub_ps(ONE, _mm_mul_ps(atan2_ps(sine, py), INV_PI));
+
+            alignas(16) float fx[4], fy[4];
+            _mm_store_ps(fx, _mm_sub_ps(_mm_mul_ps(u, WIDTH), HALF));
+            _mm_store_ps(fy, _mm_sub_ps(_mm_mul_ps(t, HEIGHT), HALF));
+            for (int lane = 0; lane < 4; lane++)
+                sample_panorama(pixels, extent, channels, get_panorama_sample(fx[lane], fy[lane], extent), tonemap, output + (x + lane) * channels);
+        }
+#endif
+        for (; x < resolution; x++)
+        {
+            const glm::vec3 direction = glm::normalize(get_face_direction(face, (x + 0.5f) * invResolution * 2.0f - 1.0f, v));
+            const float u = 0.5f + 0.5f * std::atan2(direction.z, direction.x) * glm::one_over_pi<float>();
+            const float t = 1.0f - std::acos(std::min(std::max(direction.y, -1.0f), 1.0f)) * glm::one_over_pi<float>();
+            sample_panorama(pixels, extent, channels, get_panorama_sample(u * extent.width - 0.5f, t * extent.height - 0.5f, extent), tonemap, output + x * channels);
+        }
+    }
+}
+
+void processing::panorama_to_cubemap(const float *pixels, Extent2D extent, unsigned int channels, CubemapData &cubemap, CubemapSettings settings)
+{
+    cubemap = CubemapData();
+    if (!pixels || extent.width <= 0 || extent.height <= 0 || channels == 0 || channels > 4)
+    {
+        ERR_LOG("Invalid panorama for cubemap conversion");
+        return;
+    }
+    const int resolution = settings.resolution > 0 ? settings.resolution : std::max(extent.width / 4, 1);
+    const size_t faceRow = size_t(resolution) * channels;
+
+    std::vector<float> faces(faceRow * resolution * 6);
+    utils::parallel_for(size_t(resolution) * 6, [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t i = begin; i < end; i++)
+            project_face_row(pixels, extent, channels, static_cast<int>(i / resolution), static_cast<int>(i % resolution), resolution,
+                             settings.tonemap, faces.data() + i * faceRow); }, settings.threadCount);
+
+    MipSettings mipSettings;
+    mipSettings.filter = MIP_FILTER_BOX;
+    mipSettings.wrap = false;
+    mipSettings.threadCount = settings.threadCount;
+    for (int face = 0; face < 6; face++)
+    {
+        const float *faceData = faces.data() + face * faceRow * resolution;
+        MipChain &chain = cubemap.faces[face];
+        if (settings.mipmaps)
+        {
+            generate_mip_chain(faceData, {resolution, resolution}, channels, chain, mipSettings);
+            continue;
+        }
+        chain.extent = {resolution, resolution};
+        chain.channels = channels;
+        chain.HDR = true;
+        chain.data.assign(reinterpret_cast<const unsigned char *>(faceData), reinterpret_cast<const unsigned char *>(faceData + faceRow * resolution));
+        chain.levelOffsets = {0, chain.data.size()};
+    }
+}
+
+namespace
+{
+    /*
+    Direction sampled at a face texel, following the GL cubemap face selection table. s grows with the column and t with
+    the row, both in [-1, 1].
+    */
+    inline glm::vec3 get_texel_direction(int face, float s, float t)
+    {
+        switch (face)
+        {
+        case 0:
+            return glm::vec3(1.0f, -t, -s);
+        case 1:
+            return glm::vec3(-1.0f, -t, s);
+        case 2:
+            return glm::vec3(s, 1.0f, t);
+        case 3:
+            return glm::vec3(s, -1.0f, -t);
+        case 4:
+            return glm::vec3(s, -t, 1.0f);
+        default:
+            return glm::vec3(-s, -t, -1.0f);
+        }
+    }
+
+    // Real L2 basis constants, in the order SphericalHarmonics::evaluate uses them
+    const float SH_C0 = 0.282095f, SH_C1 = 0.488603f, SH_C2 = 1.092548f, SH_C3 = 0.315392f, SH_C4 = 0.546274f;
+
+    /*
+    Clamped cosine convolution per band divided by pi, so evaluating gives E / pi as the convolution shader stores.
+    */
+    const float SH_BAND_FACTORS[9] = {1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f};
+
+    inline void get_SH_basis(const glm::vec3 &n, float *basis)
+    {
+        basis[0] = SH_C0;
+        basis[1] = SH_C1 * n.y;
+        basis[2] = SH_C1 * n.z;
+        basis[3] = SH_C1 * n.x;
+        basis[4] = SH_C2 * n.x * n.y;
+        basis[5] = SH_C2 * n.y * n.z;
+        basis[6] = SH_C3 * (3.0f * n.z * n.z - 1.0f);
+        basis[7] = SH_C2 * n.x * n.z;
+        basis[8] = SH_C4 * (n.x * n.x - n.y * n.y);
+    }
+
+    /*
+    Solid angle of every texel of a face, from the area element atan2(xy, sqrt(x^2 + y^2 + 1)) at its corners. Every face
+    shares them.
+    */
+    std::vector<float> get_texel_solid_angles(int resolution)
+    {
+        const int corners = resolution + 1;
+        std::vector<double> area(size_t(corners) * corners);
+        for (int y = 0; y < corners; y++)
+            for (int x = 0; x < corners; x++)
+            {
+                const double u = 2.0 * x / resolution - 1.0, v = 2.0 * y / resolution - 1.0;
+                area[size_t(y) * corners + x] = std::atan2(u * v, std::sqrt(u * u + v * v + 1.0));
+            }
+
+        std::vector<float> solidAngles(size_t(resolution) * resolution);
+        for (int y = 0; y < resolution; y++)
+            for (int x = 0; x < resolution; x++)
+            {
+                const double *top = &area[size_t(y) * corners + x], *bottom = top + corners;
+                solidAngles[size_t(y) * resolution + x] = static_cast<float>(top[0] - top[1] - bottom[0] + bottom[1]);
+            }
+        return solidAngles;
+    }
+
+    /*
+    Adds the weighted radiance of a face row to the 9x3 sums. Missing channels read as 0, as GL samples them.
+    */
+    void project_SH_row(const float *texels, unsigned int channels, int face, int row, int resolution, const float *solidAngles, double *sums)
+    {
+        const float invResolution = 1.0f / resolution;
+        const float t = (row + 0.5f) * invResolution * 2.0f - 1.0f;
+        float rowSums[27] = {};
+
+        int x = 0;
+#ifdef GLSP_SSE2
+        __m128 accumulation[27];
+        for (int i = 0; i < 27; i++)
+            accumulation[i] = _mm_setzero_ps();
+        for (; x + 4 <= resolution; x += 4)
+        {
+            alignas(16) float dx[4], dy[4], dz[4], color[3][4];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                const glm::vec3 direction = get_texel_direction(face, (x + lane + 0.5f) * invResolution * 2.0f - 1.0f, t);
+                dx[lane] = direction.x, dy[lane] = direction.y, dz[lane] = direction.z;
+                const float *texel = texels + size_t(x + lane) * channels;
+                for (unsigned int c = 0; c < 3; c++)
+                    color[c][lane] = c < channels ? texel[c] : 0.0f;
+            }
+            __m128 px = _mm_load_ps(dx), py = _mm_load_ps(dy), pz = _mm_load_ps(dz);
+            const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz))));
+            px = _mm_mul_ps(px, invLength), py = _mm_mul_ps(py, invLength), pz = _mm_mul_ps(pz, invLength);
+
+            const __m128 weight = _mm_loadu_ps(solidAngles + x);
+            const __m128 w1 = _mm_mul_ps(weight, _mm_set1_ps(SH_C1)), w2 = _mm_mul_ps(weight, _mm_set1_ps(SH_C2));
+            __m128 basis[9];
+            basis[0] = _mm_mul_ps(weight, _mm_set1_ps(SH_C0));
+            basis[1] = _mm_mul_ps(w1, py);
+            basis[2] = _mm_mul_ps(w1, pz);
+            basis[3] = _mm_mul_ps(w1, px);
+            basis[4] = _mm_mul_ps(w2, _mm_mul_ps(px, py));
+            basis[5] = _mm_mul_ps(w2, _mm_mul_ps(py, pz));
+            basis[6] = _mm_mul_ps(_mm_mul_ps(weight, _mm_set1_ps(SH_C3)), _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(3.0f), _mm_mul_ps(pz, pz)), _mm_set1_ps(1.0f)));
+            basis[7] = _mm_mul_ps(w2, _mm_mul_ps(px, pz));
+            basis[8] = _mm_mul_ps(_mm_mul_ps(weight, _mm_set1_ps(SH_C4)), _mm_sub_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)));
+
+            const __m128 r = _mm_load_ps(color[0]), g = _mm_load_ps(color[1]), b = _mm_load_ps(color[2]);
+            for (int i = 0; i < 9; i++)
+            {
+                accumulation[i * 3 + 0] = _mm_add_ps(accumulation[i * 3 + 0], _mm_mul_ps(basis[i], r));
+                accumulation[i * 3 + 1] = _mm_add_ps(accumulation[i * 3 + 1], _mm_mul_ps(basis[i], g));
+                accumulation[i * 3 + 2] = _mm_add_ps(accumulation[i * 3 + 2], _mm_mul_ps(basis[i], b));
+            }
+        }
+        for (int i = 0; i < 27; i++)
+        {
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, accumulation[i]);
+            rowSums[i] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+#endif
+        for (; x < resolution; x++)
+        {
+            float basis[9];
+            get_SH_basis(glm::normalize(get_texel_direction(face, (x + 0.5f) * invResolution * 2.0f - 1.0f, t)), basis);
+            const float *texel = texels + size_t(x) * channels;
+            for (int i = 0; i < 9; i++)
+                for (unsigned int c = 0; c < 3; c++)
+                    rowSums[i * 3 + c] += c < channels ? basis[i] * solidAngles[x] * texel[c] : 0.0f;
+        }
+        for (int i = 0; i < 27; i++)
+            sums[i] += rowSums[i];
+    }
+}
+
+bool processing::project_irradiance_SH(const CubemapData &cubemap, SphericalHarmonics &sh, int maxResolution, unsigned int threadCount)
+{
+    const MipChain &first = cubemap.faces[0];
+    if (!first.HDR || first.channels == 0 || first.get_level_count() == 0)
+    {
+        ERR_LOG("Spherical harmonics projection needs an HDR cubemap");
+        return false;
+    }
+    size_t level = 0;
+    while (level + 1 < first.get_level_count() && first.get_level_extent(level).width > maxResolution)
+        level++;
+    for (int face = 1; face < 6; face++)
+    {
+        if (cubemap.faces[face].get_level_count() <= level || cubemap.faces[face].channels != first.channels || !cubemap.faces[face].HDR)
+        {
+            ERR_LOG("Cubemap faces do not match");
+            return false;
+        }
+    }
+    const int resolution = first.get_level_extent(level).width;
+    const std::vector<float> solidAngles = get_texel_solid_angles(resolution);
+    if (threadCount == 0)
+        threadCount = utils::get_thread_count();
+
+    // Every block reduces into its own sums, merged afterwards in double precision
+    std::vector<double> blockSums(size_t(threadCount) * 27, 0.0);
+    utils::parallel_for(size_t(resolution) * 6, [&](size_t begin, size_t end, size_t block)
+                        {
+        double *sums = &blockSums[block * 27];
+        for (size_t i = begin; i < end; i++)
+        {
+            const int face = static_cast<int>(i / resolution), row = static_cast<int>(i % resolution);
+            const float *texels = reinterpret_cast<const float *>(cubemap.faces[face].get_level_data(level)) + size_t(row) * resolution * first.channels;
+            project_SH_row(texels, first.channels, face, row, resolution, solidAngles.data() + size_t(row) * resolution, sums);
+        } }, threadCount);
+
+    // Solid angles add up to 4 pi up to float rounding, renormalizing keeps a constant environment exact
+    double totalSolidAngle = 0.0;
+    for (float solidAngle : solidAngles)
+        totalSolidAngle += solidAngle;
+    const double normalization = 4.0 * glm::pi<double>() / (totalSolidAngle * 6.0);
+    for (int i = 0; i < 9; i++)
+    {
+        glm::dvec3 coefficient(0.0);
+        for (unsigned int block = 0; block < threadCount; block++)
+            coefficient += glm::dvec3(blockSums[block * 27 + i * 3], blockSums[block * 27 + i * 3 + 1], blockSums[block * 27 + i * 3 + 2]);
+        sh.coefficients[i] = glm::vec3(coefficient * normalization * double(SH_BAND_FACTORS[i]));
+    }
+    return true;
+}
+
+void processing::bake_irradiance_SH(const SphericalHarmonics &sh, int resolution, CubemapData &cubemap)
+{
+    resolution = std::max(resolution, 1);
+    const float invResolution = 1.0f / resolution;
+    const size_t faceSize = size_t(resolution) * resolution * 3 * sizeof(float);
+    for (int face = 0; face < 6; face++)
+    {
+        MipChain &chain = cubemap.faces[face];
+        chain.extent = {resolution, resolution};
+        chain.channels = 3;
+        chain.HDR = true;
+        chain.sRGB = false;
+        chain.compressedFormat = 0;
+        chain.data.resize(faceSize);
+        chain.levelOffsets = {0, faceSize};
+
+        float *texels = reinterpret_cast<float *>(chain.data.data());
+        for (int y = 0; y < resolution; y++)
+            for (int x = 0; x < resolution; x++)
+            {
+                const glm::vec3 direction = get_texel_direction(face, (x + 0.5f) * invResolution * 2.0f - 1.0f, (y + 0.5f) * invResolution * 2.0f - 1.0f);
+                const glm::vec3 irradiance = sh.evaluate(glm::normalize(direction));
+                float *texel = texels + (size_t(y) * resolution + x) * 3;
+                texel[0] = irradiance.r, texel[1] = irradiance.g, texel[2] = irradiance.b;
+            }
+    }
+}
+
+namespace
+{
+    inline glm::vec2 hammersley(unsigned int i, unsigned int count)
+    {
+        unsigned int bits = i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return glm::vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10f);
+    }
+
+    /*
+    GGX distributed half vector around +z, for a = roughness^2.
+    */
+    inline glm::vec3 sample_GGX(const glm::vec2 &xi, float a)
+    {
+        const float phi = 2.0f * glm::pi<float>() * xi.x;
+        const float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+        const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+        return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+    }
+
+    struct SpecularSample
+    {
+        glm::vec3 direction; // Light direction around +z
+        float weight;        // n dot l
+        float lod;
+    };
+
+    /*
+    Texel of the face a direction hits, following the GL cubemap face selection table.
+    */
+    inline int get_cubemap_coordinates(const glm::vec3 &direction, float &s, float &t)
+    {
+        const glm::vec3 a = glm::abs(direction);
+        int face;
+        float sc, tc, ma;
+        if (a.x >= a.y && a.x >= a.z)
+        {
+            face = direction.x > 0.0f ? 0 : 1;
+            sc = direction.x > 0.0f ? -direction.z : direction.z;
+            tc = -direction.y;
+            ma = a.x;
+        }
+        else if (a.y >= a.z)
+        {
+            face = direction.y > 0.0f ? 2 : 3;
+            sc = direction.x;
+            tc = direction.y > 0.0f ? direction.z : -direction.z;
+            ma = a.y;
+        }
+        else
+        {
+            face = direction.z > 0.0f ? 4 : 5;
+            sc = direction.z > 0.0f ? direction.x : -direction.x;
+            tc = -direction.y;
+            ma = a.z;
+        }
+        s = 0.5f * (sc / ma + 1.0f);
+        t = 0.5f * (tc / ma + 1.0f);
+        return face;
+    }
+
+    /*
+    Bilinear lookup clamped to the face edges, like GL without seamless filtering.
+    */
+    inline glm::vec3 sample_face(const processing::MipChain &chain, size_t level, float s, float t)
+    {
+        const Extent2D extent = chain.get_level_extent(level);
+        const float *texels = reinterpret_cast<const float *>(chain.get_level_data(level));
+        const float fx = s * extent.width - 0.5f, fy = t * extent.height - 0.5f;
+        const float x = std::floor(fx), y = std::floor(fy);
+        const float wx = fx - x, wy = fy - y;
+        const int x0 = std::min(std::max(int(x), 0), extent.width - 1), x1 = std::min(std::max(int(x) + 1, 0), extent.width - 1);
+        const int y0 = std::min(std::max(int(y), 0), extent.height - 1), y1 = std::min(std::max(int(y) + 1, 0), extent.height - 1);
+        const unsigned int channels = chain.channels;
+        const float *p00 = texels + (size_t(y0) * extent.width + x0) * channels, *p01 = texels + (size_t(y0) * extent.width + x1) * channels;
+        const float *p10 = texels + (size_t(y1) * extent.width + x0) * channels, *p11 = texels + (size_t(y1) * extent.width + x1) * channels;
+        glm::vec3 color(0.0f);
+        for (unsigned int c = 0; c < std::min(channels, 3u); c++)
+        {
+            const float top = p00[c] + (p01[c] - p00[c]) * wx;
+            const float bottom = p10[c] + (p11[c] - p10[c]) * wx;
+            color[c] = top + (bottom - top) * wy;
+        }
+        return color;
+    }
+
+    inline glm::vec3 sample_cubemap(const processing::MipChain *faces, const glm::vec3 &direction, float lod)
+    {
+        float s, t;
+        const processing::MipChain &chain = faces[get_cubemap_coordinates(direction, s, t)];
+        const size_t lastLevel = chain.get_level_count() - 1;
+        lod = std::min(std::max(lod, 0.0f), float(lastLevel));
+        const size_t level = static_cast<size_t>(lod);
+        const float blend = lod - float(level);
+        const glm::vec3 color = sample_face(chain, level, s, t);
+        if (blend <= 0.0f || level == lastLevel)
+            return color;
+        return color + (sample_face(chain, level + 1, s, t) - color) * blend;
+    }
+
+    /*
+    Samples of the GGX lobe of a roughness with v = n = +z, and the mip each one is fetched from: the one whose texels
+    subtend the solid angle of the sample, 1 / (pdf * sampleCount).
+    */
+    std::vector<SpecularSample> get_specular_samples(float roughness, unsigned int sampleCount, int resolution)
+    {
+        const float a = roughness * roughness;
+        const float texelSolidAngle = 4.0f * glm::pi<float>() / (6.0f * resolution * resolution);
+        std::vector<SpecularSample> samples;
+        samples.reserve(sampleCount);
+        for (unsigned int i = 0; i < sampleCount; i++)
+        {
+            const glm::vec3 h = sample_GGX(hammersley(i, sampleCount), a);
+            const glm::vec3 l = 2.0f * h.z * h - glm::vec3(0.0f, 0.0f, 1.0f);
+            if (l.z <= 0.0f)
+                continue;
+            // pdf = D * (n dot h) / (4 * (v dot h)), with n = v
+            const float denominator = h.z * h.z * (a * a - 1.0f) + 1.0f;
+            const float D = a * a / (glm::pi<float>() * denominator * denominator);
+            const float sampleSolidAngle = 1.0f / (float(sampleCount) * D * 0.25f + 1e-4f);
+            samples.push_back({l, l.z, 0.5f * std::log2(sampleSolidAngle / texelSolidAngle)});
+        }
+        return samples;
+    }
+
+    float geometry_Schlick_GGX(float cosine, float k)
+    {
+        return cosine / (cosine * (1.0f - k) + k);
+    }
+}
+
+void processing::prefilter_specular(const CubemapData &environment, CubemapData &prefiltered, SpecularSettings settings)
+{
+    const MipChain &first = environment.faces[0];
+    if (!first.HDR || first.channels == 0 || first.get_level_count() == 0)
+    {
+        ERR_LOG("Specular prefiltering needs an HDR cubemap");
+        return;
+    }
+    size_t sourceLevel = 0;
+    while (sourceLevel + 1 < first.get_level_count() && first.get_level_extent(sourceLevel).width > settings.resolution)
+        sourceLevel++;
+    const int resolution = first.get_level_extent(sourceLevel).width;
+
+    // Box filtered chain below the sharpest level, the mips samples are fetched from
+    CubemapData source;
+    MipSettings mipSettings;
+    mipSettings.filter = MIP_FILTER_BOX;
+    mipSettings.wrap = false;
+    mipSettings.threadCount = settings.threadCount;
+    for (int face = 0; face < 6; face++)
+        generate_mip_chain(reinterpret_cast<const float *>(environment.faces[face].get_level_data(sourceLevel)), {resolution, resolution},
+                           environment.faces[face].channels, source.faces[face], mipSettings);
+
+    const int levelCount = std::min(std::max(settings.levelCount, 1), static_cast<int>(source.faces[0].get_level_count()));
+    for (int face = 0; face < 6; face++)
+    {
+        MipChain &chain = prefiltered.faces[face];
+        chain.extent = {resolution, resolution};
+        chain.channels = 3;
+        chain.HDR = true;
+        chain.sRGB = false;
+        chain.compressedFormat = 0;
+        chain.levelOffsets = {0};
+        for (int level = 0; level < levelCount; level++)
+        {
+            const Extent2D extent = chain.get_level_extent(level);
+            chain.levelOffsets.push_back(chain.levelOffsets.back() + size_t(extent.width) * extent.height * 3 * sizeof(float));
+        }
+        chain.data.resize(chain.levelOffsets.back());
+    }
+
+    for (int level = 0; level < levelCount; level++)
+    {
+        const int levelResolution = std::max(resolution >> level, 1);
+        const float invResolution = 1.0f / levelResolution;
+        const float roughness = levelCount > 1 ? float(level) / float(levelCount - 1) : 0.0f;
+        const std::vector<SpecularSample> samples = get_specular_samples(roughness, std::max(settings.sampleCount, 1u), resolution);
+
+        utils::parallel_for(size_t(levelResolution) * 6, [&](size_t begin, size_t end, size_t)
+                            {
+            for (size_t i = begin; i < end; i++)
+            {
+                const int face = static_cast<int>(i / levelResolution), row = static_cast<int>(i % levelResolution);
+                float *output = reinterpret_cast<float *>(prefiltered.faces[face].data.data() + prefiltered.faces[face].levelOffsets[level]) + size_t(row) * levelResolution * 3;
+                const float t = (row + 0.5f) * invResolution * 2.0f - 1.0f;
+                for (int x = 0; x < levelResolution; x++)
+                {
+                    const glm::vec3 n = glm::normalize(get_texel_direction(face, (x + 0.5f) * invResolution * 2.0f - 1.0f, t));
+                    glm::vec3 color(0.0f);
+                    if (level == 0)
+                        color = sample_cubemap(source.faces, n, 0.0f);
+                    else
+                    {
+                        const glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                        const glm::vec3 tangent = glm::normalize(glm::cross(up, n));
+                        const glm::vec3 bitangent = glm::cross(n, tangent);
+                        float weight = 0.0f;
+                        for (const SpecularSample &sample : samples)
+                        {
+                            const glm::vec3 l = tangent * sample.direction.x + bitangent * sample.direction.y + n * sample.direction.z;
+                            color += sample_cubemap(source.faces, l, sample.lod) * sample.weight;
+                            weight += sample.weight;
+                        }
+                        color = weight > 0.0f ? color / weight : sample_cubemap(source.faces, n, 0.0f);
+                    }
+                    output[x * 3 + 0] = color.r, output[x * 3 + 1] = color.g, output[x * 3 + 2] = color.b;
+                }
+            } }, settings.threadCount);
+    }
+}
+
+void processing::integrate_BRDF(int resolution, unsigned int sampleCount, MipChain &lut, unsigned int threadCount)
+{
+    resolution = std::max(resolution, 1);
+    sampleCount = std::max(sampleCount, 1u);
+    lut.extent = {resolution, resolution};
+    lut.channels = 2;
+    lut.HDR = true;
+    lut.sRGB = false;
+    lut.compressedFormat = 0;
+    lut.data.resize(size_t(resolution) * resolution * 2 * sizeof(float));
+    lut.levelOffsets = {0, lut.data.size()};
+
+    float *texels = reinterpret_cast<float *>(lut.data.data());
+    utils::parallel_for(size_t(resolution), [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t row = begin; row < end; row++)
+        {
+            const float roughness = (row + 0.5f) / resolution;
+            const float a = roughness * roughness;
+            const float k = a * 0.5f;
+            // Half vectors only depend on the roughness, the whole row shares them
+            std::vector<glm::vec3> halfVectors(sampleCount);
+            for (unsigned int i = 0; i < sampleCount; i++)
+                halfVectors[i] = sample_GGX(hammersley(i, sampleCount), a);
+            for (int x = 0; x < resolution; x++)
+            {
+                const float NdotV = (x + 0.5f) / resolution;
+                const glm::vec3 v(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+                float scale = 0.0f, bias = 0.0f;
+                for (const glm::vec3 &h : halfVectors)
+                {
+                    const float VdotH = glm::dot(v, h);
+                    const glm::vec3 l = 2.0f * VdotH * h - v;
+                    if (l.z <= 0.0f)
+                        continue;
+                    const float G = geometry_Schlick_GGX(NdotV, k) * geometry_Schlick_GGX(l.z, k);
+                    const float visibility = G * std::max(VdotH, 0.0f) / (h.z * NdotV);
+                    const float f = 1.0f - std::max(VdotH, 0.0f), f2 = f * f;
+                    const float fresnel = f2 * f2 * f;
+                    scale += (1.0f - fresnel) * visibility;
+                    bias += fresnel * visibility;
+                }
+                texels[(row * resolution + x) * 2 + 0] = scale / sampleCount;
+                texels[(row * resolution + x) * 2 + 1] = bias / sampleCount;
+            }
+        } }, threadCount);
+}
+
+GLSP_NAMESPACE_END
@@ -8,11 +8,452 @@
     Copyright (c) 2024 Antonio Espinosa Garcia
 
 */
+#include <sstream>
+#include <cstddef>
+#include <atomic>
+#include <filesystem>
+#include <limits>
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
 #include <GLSP/loaders.h>
+#include <GLSP/cache.h>
+#include <GLSP/processing.h>
 
 GLSP_NAMESPACE_BEGIN
 
-void loaders::load_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials, bool calculateTangents)
+namespace
+{
+    /*
+    OBJ face corner. Indices are zero based, -1 if the attribute is not present.
+    */
+    struct OBJCorner
+    {
+        int v;
+        int t;
+        int n;
+        unsigned char relative; // Bitmask of indices that are still relative to the chunk they were read from
+    };
+
+    /*
+    Shape (o/g) or material (usemtl) statement, located by the face it precedes.
+    */
+    struct OBJGroup
+    {
+        size_t face;
+        size_t corner; // Filled once the chunk is triangulated
+        bool material;
+        std::string name;
+    };
+
+    struct OBJChunk
+    {
+        const char *begin;
+        const char *end;
+
+        std::vector<float> positions;
+        std::vector<float> colors;
+        std::vector<float> normals;
+        std::vector<float> uvs;
+
+        std::vector<OBJCorner> corners;
+        std::vector<unsigned int> faceSizes;
+        std::vector<OBJCorner> triangles;
+        std::vector<OBJGroup> groups;
+
+        size_t positionOffset{0};
+        size_t normalOffset{0};
+        size_t uvOffset{0};
+    };
+
+    inline const char *parse_index(const char *p, const char *end, int &value)
+    {
+        bool negative = false;
+        if (p < end && *p == '-')
+        {
+            negative = true;
+            p++;
+        }
+        int result = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            result = result * 10 + (*p++ - '0');
+        value = negative ? -result : result;
+        return p;
+    }
+
+    /*
+    Turns a one based (or negative, relative) OBJ index into a zero based one. Negative indices are resolved against
+    the current chunk and fixed up once the offsets of every chunk are known.
+    */
+    inline int resolve_index(int raw, size_t localCount, unsigned char bit, unsigned char &relative)
+    {
+        if (raw > 0)
+            return raw - 1;
+        if (raw < 0)
+        {
+            relative |= bit;
+            return static_cast<int>(localCount) + raw;
+        }
+        return -1;
+    }
+
+    void parse_OBJ_chunk(OBJChunk &chunk)
+    {
+        const char *p = chunk.begin;
+        const char *const end = chunk.end;
+
+        while (p < end)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+            if (!lineEnd)
+                lineEnd = end;
+
+            while (p < lineEnd && (*p == ' ' || *p == '\t'))
+                p++;
+
+            if (lineEnd - p > 2 && p[0] == 'v')
+            {
+                if (p[1] == ' ' || p[1] == '\t')
+                {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    p = utils::parse_float(p + 2, lineEnd, x);
+                    p = utils::parse_float(p, lineEnd, y);
+                    p = utils::parse_float(p, lineEnd, z);
+                    chunk.positions.insert(chunk.positions.end(), {x, y, z});
+
+                    float r = 1.0f, g = 1.0f, b = 1.0f;
+                    const char *q = utils::parse_float(p, lineEnd, r);
+                    if (q != p)
+                    {
+                        const char *qg = utils::parse_float(q, lineEnd, g);
+                        const char *qb = utils::parse_float(qg, lineEnd, b);
+                        if (qg == q || qb == qg)
+                            r = g = b = 1.0f;
+                    }
+                    chunk.colors.insert(chunk.colors.end(), {r, g, b});
+                }
+                else if (p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+                {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    p = utils::parse_float(p + 3, lineEnd, x);
+                    p = utils::parse_float(p, lineEnd, y);
+                    p = utils::parse_float(p, lineEnd, z);
+                    chunk.normals.insert(chunk.normals.end(), {x, y, z});
+                }
+                else if (p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+                {
+                    float u = 0.0f, v = 0.0f;
+                    p = utils::parse_float(p + 3, lineEnd, u);
+                    p = utils::parse_float(p, lineEnd, v);
+                    chunk.uvs.insert(chunk.uvs.end(), {u, v});
+                }
+            }
+            else if (lineEnd - p > 1 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+            {
+                p += 2;
+                unsigned int faceSize = 0;
+                const size_t positionCount = chunk.positions.size() / 3;
+                const size_t normalCount = chunk.normals.size() / 3;
+                const size_t uvCount = chunk.uvs.size() / 2;
+                while (true)
+                {
+                    while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r'))
+                        p++;
+                    if (p >= lineEnd || !((*p >= '0' && *p <= '9') || *p == '-'))
+                        break;
+
+                    int v = 0, t = 0, n = 0;
+                    p = parse_index(p, lineEnd, v);
+                    if (p < lineEnd && *p == '/')
+                    {
+                        p = parse_index(p + 1, lineEnd, t);
+                        if (p < lineEnd && *p == '/')
+                            p = parse_index(p + 1, lineEnd, n);
+                    }
+                    // Skip anything unexpected until the next blank
+                    while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r')
+                        p++;
+
+                    OBJCorner corner{};
+                    corner.v = resolve_index(v, positionCount, 1, corner.relative);
+                    corner.t = resolve_index(t, uvCount, 2, corner.relative);
+                    corner.n = resolve_index(n, normalCount, 4, corner.relative);
+                    chunk.corners.push_back(corner);
+                    faceSize++;
+                }
+                if (faceSize > 0)
+                    chunk.faceSizes.push_back(faceSize);
+            }
+            else if ((lineEnd - p > 1 && (p[0] == 'o' || p[0] == 'g') && (p[1] == ' ' || p[1] == '\t')) ||
+                     (lineEnd - p > 6 && memcmp(p, "usemtl", 6) == 0 && (p[6] == ' ' || p[6] == '\t')))
+            {
+                const bool material = p[0] == 'u';
+                const char *name = p + (material ? 7 : 2);
+                const char *nameEnd = lineEnd;
+                while (name < nameEnd && (*name == ' ' || *name == '\t'))
+                    name++;
+                while (nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+                    nameEnd--;
+                chunk.groups.push_back({chunk.faceSizes.size(), 0, material, std::string(name, nameEnd)});
+            }
+            p = lineEnd + 1;
+        }
+    }
+
+    /*
+    Resolves the chunk indices against the whole file and triangulates its faces the same way tinyobj does:
+    quads are split along their shortest diagonal and bigger polygons are fanned.
+    */
+    void triangulate_OBJ_chunk(OBJChunk &chunk, const std::vector<float> &positions, size_t normalCount, size_t uvCount)
+    {
+        const size_t positionCount = positions.size() / 3;
+
+        for (OBJCorner &corner : chunk.corners)
+        {
+            if (corner.relative & 1)
+                corner.v += static_cast<int>(chunk.positionOffset);
+            if (corner.relative & 2)
+                corner.t += static_cast<int>(chunk.uvOffset);
+            if (corner.relative & 4)
+                corner.n += static_cast<int>(chunk.normalOffset);
+            if (corner.t >= static_cast<int>(uvCount))
+                corner.t = -1;
+            if (corner.n >= static_cast<int>(normalCount))
+                corner.n = -1;
+            corner.relative = 0;
+        }
+
+        chunk.triangles.reserve(chunk.corners.size() * 3 / 2);
+        size_t first = 0;
+        size_t group = 0;
+        for (size_t f = 0; f < chunk.faceSizes.size(); f++)
+        {
+            for (; group < chunk.groups.size() && chunk.groups[group].face <= f; group++)
+                chunk.groups[group].corner = chunk.triangles.size();
+
+            const unsigned int faceSize = chunk.faceSizes[f];
+            const OBJCorner *face = &chunk.corners[first];
+            first += faceSize;
+
+            bool valid = faceSize >= 3;
+            for (unsigned int i = 0; i < faceSize && valid; i++)
+                valid = face[i].v >= 0 && face[i].v < static_cast<int>(positionCount);
+            if (!valid)
+                continue;
+
+            if (faceSize == 4)
+            {
+                const glm::vec3 p0 = glm::make_vec3(&positions[3 * face[0].v]);
+                const glm::vec3 p1 = glm::make_vec3(&positions[3 * face[1].v]);
+                const glm::vec3 p2 = glm::make_vec3(&positions[3 * face[2].v]);
+                const glm::vec3 p3 = glm::make_vec3(&positions[3 * face[3].v]);
+                const glm::vec3 e02 = p2 - p0;
+                const glm::vec3 e13 = p3 - p1;
+                if (glm::dot(e02, e02) < glm::dot(e13, e13))
+                    chunk.triangles.insert(chunk.triangles.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+                else
+                    chunk.triangles.insert(chunk.triangles.end(), {face[0], face[1], face[3], face[1], face[2], face[3]});
+                continue;
+            }
+            for (unsigned int i = 1; i + 1 < faceSize; i++)
+                chunk.triangles.insert(chunk.triangles.end(), {face[0], face[i], face[i + 1]});
+        }
+        for (; group < chunk.groups.size(); group++)
+            chunk.groups[group].corner = chunk.triangles.size();
+        std::vector<OBJCorner>().swap(chunk.corners);
+        std::vector<unsigned int>().swap(chunk.faceSizes);
+    }
+
+    /*
+    Identifies the loader and the options an import was made with, so that cached results are only reused for identical imports.
+    */
+    inline uint64_t hash_import_options(const char *loader, std::initializer_list<uint64_t> options)
+    {
+        uint64_t hash = utils::hash_bytes(loader, strlen(loader));
+        for (uint64_t option : options)
+            hash = utils::hash_bytes(&option, sizeof(uint64_t), hash);
+        return hash;
+    }
+
+    inline size_t hash_corner(const OBJCorner &c)
+    {
+        uint64_t h = uint64_t(uint32_t(c.v)) * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t(uint32_t(c.t)) + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+        h ^= (uint64_t(uint32_t(c.n)) + 0x165667B19E3779F9ull) * 0x27D4EB2F165667C5ull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+}
+
+bool loaders::parse_OBJ(const char *fileName, MeshData &data, unsigned int threadCount, bool materialGroups)
+{
+    std::unique_ptr<utils::MappedFile> file;
+    try
+    {
+        file.reset(new utils::MappedFile(fileName, utils::FILE_ACCESS_SEQUENTIAL));
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
+    const std::string_view fileBuffer = file->get_text();
+    if (threadCount == 0)
+        threadCount = utils::get_thread_count();
+
+    const char *const fileBegin = fileBuffer.data();
+    const char *const fileEnd = fileBegin + fileBuffer.size();
+
+    // Split in line-aligned chunks. Small files are not worth the thread spawn
+    const size_t MIN_CHUNK_BYTES = 1 << 18;
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, fileBuffer.size() / MIN_CHUNK_BYTES));
+    std::vector<OBJChunk> chunks(chunkCount);
+    const char *chunkBegin = fileBegin;
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const char *chunkEnd = i + 1 == chunkCount ? fileEnd : fileBegin + (fileBuffer.size() * (i + 1)) / chunkCount;
+        if (chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        const char *newline = static_cast<const char *>(memchr(chunkEnd, '\n', fileEnd - chunkEnd));
+        chunkEnd = newline ? newline + 1 : fileEnd;
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    // Tokenize
+    utils::parallel_for(chunkCount, [&](size_t begin, size_t end, size_t)
+                        { for (size_t i = begin; i < end; i++) parse_OBJ_chunk(chunks[i]); }, threadCount);
+
+    // Merge attribute arrays
+    size_t positionCount = 0, normalCount = 0, uvCount = 0;
+    for (OBJChunk &chunk : chunks)
+    {
+        chunk.positionOffset = positionCount;
+        chunk.normalOffset = normalCount;
+        chunk.uvOffset = uvCount;
+        positionCount += chunk.positions.size() / 3;
+        normalCount += chunk.normals.size() / 3;
+        uvCount += chunk.uvs.size() / 2;
+    }
+    std::vector<float> positions(positionCount * 3), colors(positionCount * 3), normals(normalCount * 3), uvs(uvCount * 2);
+    utils::parallel_for(chunkCount, [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t i = begin; i < end; i++)
+        {
+            OBJChunk &chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + 3 * chunk.positionOffset);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + 3 * chunk.positionOffset);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + 3 * chunk.normalOffset);
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + 2 * chunk.uvOffset);
+            std::vector<float>().swap(chunk.positions);
+            std::vector<float>().swap(chunk.colors);
+            std::vector<float>().swap(chunk.normals);
+            std::vector<float>().swap(chunk.uvs);
+        } }, threadCount);
+
+    utils::parallel_for(chunkCount, [&](size_t begin, size_t end, size_t)
+                        { for (size_t i = begin; i < end; i++) triangulate_OBJ_chunk(chunks[i], positions, normalCount, uvCount); }, threadCount);
+
+    // Deduplicate corners with an open addressing table keyed by the index triplet
+    size_t cornerCount = 0;
+    for (const OBJChunk &chunk : chunks)
+        cornerCount += chunk.triangles.size();
+
+    size_t capacity = 16;
+    while (capacity < cornerCount * 2)
+        capacity <<= 1;
+    std::vector<unsigned int> table(capacity, 0); // Stores unique corner + 1. Zero means empty slot
+    std::vector<OBJCorner> uniqueCorners;
+    uniqueCorners.reserve(std::min(cornerCount, positionCount * 2 + 16));
+
+    data.indices.clear();
+    data.indices.reserve(cornerCount);
+    for (const OBJChunk &chunk : chunks)
+    {
+        for (const OBJCorner &corner : chunk.triangles)
+        {
+            size_t slot = hash_corner(corner) & (capacity - 1);
+            while (true)
+            {
+                const unsigned int entry = table[slot];
+                if (entry == 0)
+                {
+                    uniqueCorners.push_back(corner);
+                    table[slot] = static_cast<unsigned int>(uniqueCorners.size());
+                    data.indices.push_back(table[slot] - 1);
+                    break;
+                }
+                const OBJCorner &other = uniqueCorners[entry - 1];
+                if (other.v == corner.v && other.t == corner.t && other.n == corner.n)
+                {
+                    data.indices.push_back(entry - 1);
+                    break;
+                }
+                slot = (slot + 1) & (capacity - 1);
+            }
+        }
+    }
+    std::vector<unsigned int>().swap(table);
+
+    // Shapes and material groups become ranges of the shared index buffer
+    data.submeshes.clear();
+    data.materials.clear();
+    {
+        std::unordered_map<std::string, int> materialIds;
+        int material = -1;
+        size_t rangeBegin = 0, chunkOffset = 0;
+        auto close_range = [&](size_t rangeEnd)
+        {
+            if (rangeEnd > rangeBegin)
+                data.submeshes.push_back({static_cast<unsigned int>(rangeBegin), static_cast<unsigned int>(rangeEnd - rangeBegin), 0, material});
+            rangeBegin = rangeEnd;
+        };
+        for (const OBJChunk &chunk : chunks)
+        {
+            for (const OBJGroup &group : chunk.groups)
+            {
+                if (group.material)
+                {
+                    if (!materialGroups)
+                        continue;
+                    auto it = materialIds.find(group.name);
+                    if (it == materialIds.end())
+                    {
+                        it = materialIds.emplace(group.name, static_cast<int>(data.materials.size())).first;
+                        data.materials.push_back(group.name);
+                    }
+                    if (it->second == material)
+                        continue;
+                    close_range(chunkOffset + group.corner);
+                    material = it->second;
+                }
+                else
+                    close_range(chunkOffset + group.corner);
+            }
+            chunkOffset += chunk.triangles.size();
+        }
+        close_range(chunkOffset);
+    }
+    chunks.clear();
+
+    // Build final vertices
+    data.vertices.resize(uniqueCorners.size());
+    utils::parallel_for(uniqueCorners.size(), [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t i = begin; i < end; i++)
+        {
+            const OBJCorner &corner = uniqueCorners[i];
+            Vertex &vertex = data.vertices[i];
+            vertex.position = glm::make_vec3(&positions[3 * corner.v]);
+            vertex.color = glm::make_vec3(&colors[3 * corner.v]);
+            vertex.normal = corner.n >= 0 ? glm::make_vec3(&normals[3 * corner.n]) : glm::vec3(0.0f);
+            vertex.tangent = glm::vec3(0.0f);
+            vertex.uv = corner.t >= 0 ? glm::make_vec2(&uvs[2 * corner.t]) : glm::vec2(0.0f);
+        } }, threadCount);
+
+    return true;
+}
+
+bool loaders::parse_OBJ_tinyobj(const char *fileName, MeshData &data)
 {
     // Preparing output
     tinyobj::attrib_t attrib;
@@ -21,7 +462,19 @@ void loaders::load_OBJ(Mesh *const mesh, const char *fileName, bool importMateri
     std::string warn;
     std::string err;
 
-    tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, fileName, importMaterials ? nullptr : nullptr);
+    // Same as loading by file name, but parsing from the mapped file
+    try
+    {
+        const utils::MappedFile file(fileName, utils::FILE_ACCESS_SEQUENTIAL);
+        utils::memory_stream stream(reinterpret_cast<const char *>(file.get_data()), file.get_size());
+        tinyobj::MaterialFileReader materialReader("");
+        tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream, &materialReader);
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
 
     // Check for errors
     if (!warn.empty())
@@ -31,125 +484,143 @@ void loaders::load_OBJ(Mesh *const mesh, const char *fileName, bool importMateri
     if (!err.empty())
     {
         ERR_LOG(err);
-        DEBUG_LOG("ERROR: Couldn't load mesh");
-        return;
+        return false;
     }
 
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::vector<Vertex> &vertices = data.vertices;
+    std::vector<unsigned int> &indices = data.indices;
     std::unordered_map<Vertex, unsigned int> uniqueVertices;
 
-    size_t shape_id = 0;
-    // attrib.
     for (const tinyobj::shape_t &shape : shapes)
     {
         if (!shape.mesh.indices.empty())
-            // IS INDEXED
-            for (const tinyobj::index_t &index : shape.mesh.indices)
-            {
-                Vertex vertex = {};
-
-                // positionition and color
-                if (index.vertex_index >= 0)
-                {
-                    vertex.position.x = attrib.vertices[3 * index.vertex_index + 0];
-                    vertex.position.y = attrib.vertices[3 * index.vertex_index + 1];
-                    vertex.position.z = attrib.vertices[3 * index.vertex_index + 2];
-
-                    vertex.color.r = attrib.colors[3 + index.vertex_index + 0];
-                    vertex.color.g = attrib.colors[3 + index.vertex_index + 1];
-                    vertex.color.b = attrib.colors[3 + index.vertex_index + 2];
-                }
-                // Normal
-                if (index.normal_index >= 0)
-                {
-                    vertex.normal.x = attrib.normals[3 * index.normal_index + 0];
-                    vertex.normal.y = attrib.normals[3 * index.normal_index + 1];
-                    vertex.normal.z = attrib.normals[3 * index.normal_index + 2];
-                }
+            data.submeshes.push_back({static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(shape.mesh.indices.size()), 0, -1});
+        for (const tinyobj::index_t &index : shape.mesh.indices)
+        {
+            Vertex vertex = {};
 
-                vertex.tangent = {0.0, 0.0, 0.0};
+            // Position and color
+            if (index.vertex_index >= 0)
+            {
+                vertex.position.x = attrib.vertices[3 * index.vertex_index + 0];
+                vertex.position.y = attrib.vertices[3 * index.vertex_index + 1];
+                vertex.position.z = attrib.vertices[3 * index.vertex_index + 2];
 
-                // UV
-                if (index.texcoord_index >= 0)
-                {
-                    vertex.uv.x = attrib.texcoords[2 * index.texcoord_index + 0];
-                    vertex.uv.y = attrib.texcoords[2 * index.texcoord_index + 1];
-                }
+                vertex.color.r = attrib.colors[3 * index.vertex_index + 0];
+                vertex.color.g = attrib.colors[3 * index.vertex_index + 1];
+                vertex.color.b = attrib.colors[3 * index.vertex_index + 2];
+            }
+            // Normal
+            if (index.normal_index >= 0)
+            {
+                vertex.normal.x = attrib.normals[3 * index.normal_index + 0];
+                vertex.normal.y = attrib.normals[3 * index.normal_index + 1];
+                vertex.normal.z = attrib.normals[3 * index.normal_index + 2];
+            }
 
-                // Check if the vertex is already in the map
-                if (uniqueVertices.count(vertex) == 0)
-                {
-                    uniqueVertices[vertex] = static_cast<unsigned int>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+            vertex.tangent = {0.0, 0.0, 0.0};
 
-                indices.push_back(uniqueVertices[vertex]);
+            // UV
+            if (index.texcoord_index >= 0)
+            {
+                vertex.uv.x = attrib.texcoords[2 * index.texcoord_index + 0];
+                vertex.uv.y = attrib.texcoords[2 * index.texcoord_index + 1];
             }
-        else
-            // NOT INDEXED
-            for (size_t i = 0; i < shape.mesh.num_face_vertices.size(); i++)
+
+            // Check if the vertex is already in the map
+            if (uniqueVertices.count(vertex) == 0)
             {
-                for (size_t j = 0; j < shape.mesh.num_face_vertices[i]; j++)
-                {
-                    Vertex vertex{};
-                    size_t vertex_index = shape.mesh.indices[i * shape.mesh.num_face_vertices[i] + j].vertex_index;
-                    // position
-                    if (!attrib.vertices.empty())
-                    {
-                        vertex.position.x = attrib.vertices[3 * vertex_index + 0];
-                        vertex.position.y = attrib.vertices[3 * vertex_index + 1];
-                        vertex.position.z = attrib.vertices[3 * vertex_index + 2];
-                    }
-                    // Normals
-                    if (!attrib.normals.empty())
-                    {
-                        vertex.normal.x = attrib.normals[3 * vertex_index + 0];
-                        vertex.normal.y = attrib.normals[3 * vertex_index + 1];
-                        vertex.normal.z = attrib.normals[3 * vertex_index + 2];
-                    }
-                    // Tangents
+                uniqueVertices[vertex] = static_cast<unsigned int>(vertices.size());
+                vertices.push_back(vertex);
+            }
 
-                    vertex.tangent = {0.0, 0.0, 0.0};
+            indices.push_back(uniqueVertices[vertex]);
+        }
+    }
+    return true;
+}
 
-                    // UV
-                    if (!attrib.texcoords.empty())
-                    {
-                        vertex.uv.x = attrib.texcoords[2 * vertex_index + 0];
-                        vertex.uv.y = attrib.texcoords[2 * vertex_index + 1];
-                    }
-                    // COLORS
-                    if (!attrib.colors.empty())
-                    {
-                        vertex.color.r = attrib.colors[3 * vertex_index + 0];
-                        vertex.color.g = attrib.colors[3 * vertex_index + 1];
-                        vertex.color.b = attrib.colors[3 * vertex_index + 2];
-                    }
+namespace
+{
+    // LODCount levels, each one with half the triangles of the previous
+    void generate_import_LODs(MeshData &data, unsigned int LODCount)
+    {
+        if (LODCount == 0)
+            return;
+        processing::LODSettings settings;
+        settings.ratios.resize(LODCount);
+        for (unsigned int level = 0; level < LODCount; level++)
+            settings.ratios[level] = 1.0f / float(2u << level);
+        processing::generate_LODs(data, settings);
+    }
 
-                    vertices.push_back(vertex);
-                }
-            }
+    /*
+    Cache lookup or full import. Builds the geometry CPU side only, so it is safe to run outside the GL thread.
+    */
+    Geometry *import_OBJ(const char *fileName, bool importMaterials, bool calculateTangents, unsigned int LODCount)
+    {
+        const uint64_t options = hash_import_options("OBJ", {importMaterials, calculateTangents, LODCount});
+        if (Geometry *cached = cache::load_mesh(fileName, options))
+            return cached;
+
+        MeshData data;
+        if (!loaders::parse_OBJ(fileName, data, 0, importMaterials))
+        {
+            DEBUG_LOG("ERROR: Couldn't load mesh");
+            return nullptr;
+        }
+        if (calculateTangents)
+            processing::compute_tangents(data);
+        generate_import_LODs(data, LODCount);
+        cache::store_mesh(fileName, options, data);
 
-        mesh->set_geometry(new Geometry(vertices, indices));
+        return new Geometry(std::move(data));
+    }
 
-        shape_id++;
+    Geometry *import_PLY(const char *fileName, bool preload, bool verbose, bool calculateTangents, unsigned int LODCount)
+    {
+        const uint64_t options = hash_import_options("PLY", {calculateTangents, LODCount});
+        if (Geometry *cached = cache::load_mesh(fileName, options))
+            return cached;
+
+        MeshData data;
+        if (!loaders::parse_PLY(fileName, data, preload, verbose))
+            return nullptr;
+        if (calculateTangents)
+            processing::compute_tangents(data);
+        generate_import_LODs(data, LODCount);
+        cache::store_mesh(fileName, options, data);
+
+        return new Geometry(std::move(data));
     }
 }
 
-void loaders::load_PLY(Mesh *const mesh, const char *fileName, bool preload, bool verbose, bool calculateTangents)
+void loaders::load_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials, bool calculateTangents, unsigned int LODCount)
+{
+    if (Geometry *geometry = import_OBJ(fileName, importMaterials, calculateTangents, LODCount))
+        mesh->set_geometry(geometry);
+}
+
+void loaders::load_PLY(Mesh *const mesh, const char *fileName, bool preload, bool verbose, bool calculateTangents, unsigned int LODCount)
+{
+    if (Geometry *geometry = import_PLY(fileName, preload, verbose, calculateTangents, LODCount))
+        mesh->set_geometry(geometry);
+}
+
+bool loaders::parse_PLY_tinyply(const char *fileName, MeshData &data, bool preload, bool verbose)
 {
 
     std::unique_ptr<std::istream> file_stream;
-    std::vector<uint8_t> byte_buffer;
+    std::unique_ptr<utils::MappedFile> mapped_file;
     std::string filePath = fileName;
     try
     {
         // For most files < 1gb, pre-loading the entire file upfront and wrapping it into a
-        // stream is a net win for parsing speed, about 40% faster.
+        // stream is a net win for parsing speed, about 40% faster. Mapping it avoids the copy.
         if (preload)
         {
-            byte_buffer = utils::read_file_binary(filePath);
-            file_stream.reset(new utils::memory_stream((char *)byte_buffer.data(), byte_buffer.size()));
+            mapped_file.reset(new utils::MappedFile(filePath, utils::FILE_ACCESS_SEQUENTIAL));
+            file_stream.reset(new utils::memory_stream((const char *)mapped_file->get_data(), mapped_file->get_size()));
         }
         else
         {
@@ -273,14 +744,13 @@ void loaders::load_PLY(Mesh *const mesh, const char *fileName, bool preload, boo
                 std::cerr << "tinyply exception: " << e.what() << std::endl;
         }
 
+        utils::ManualTimer readTimer;
+        readTimer.start();
+        file.read(*file_stream);
+        readTimer.stop();
+
         if (verbose)
         {
-            utils::ManualTimer readTimer;
-
-            readTimer.start();
-            file.read(*file_stream);
-            readTimer.stop();
-
             const float parsingTime = static_cast<float>(readTimer.get()) / 1000.f;
             std::cout << "\tparsing " << size_mb << "mb in " << parsingTime << " seconds [" << (size_mb / parsingTime) << " MBps]" << std::endl;
 
@@ -298,17 +768,20 @@ void loaders::load_PLY(Mesh *const mesh, const char *fileName, bool preload, boo
                 std::cout << "\tRead " << (tripstrip->buffer.size_bytes() / tinyply::PropertyTable[tripstrip->t].stride) << " total indices (tristrip) " << std::endl;
         }
 
-        std::vector<Vertex> vertices;
+        if (!positions)
+            return false;
+
+        std::vector<Vertex> &vertices = data.vertices;
         vertices.reserve(positions->count);
-        std::vector<unsigned int> indices;
-        indices.reserve(faces->count * 3);
+        std::vector<unsigned int> &indices = data.indices;
+        if (faces)
+            indices.reserve(faces->count * 3);
 
-        if (positions)
         {
             const float *posData = reinterpret_cast<const float *>(positions->buffer.get());
-            const float *normalData;
-            unsigned char *colorData;
-            const float *uvData;
+            const float *normalData = nullptr;
+            unsigned char *colorData = nullptr;
+            const float *uvData = nullptr;
 
             if (normals)
                 normalData = reinterpret_cast<const float *>(normals->buffer.get());
@@ -343,96 +816,1364 @@ void loaders::load_PLY(Mesh *const mesh, const char *fileName, bool preload, boo
                 vertices.push_back({{x, y, z}, {nx, ny, nz}, {0.0f, 0.0f, 0.0f}, {u, v}, {r, g, b}}); // You can set color and other attributes as needed
             }
         }
-        unsigned *facesData = reinterpret_cast<unsigned *>(faces->buffer.get());
-        for (size_t i = 0; i < faces->count; ++i)
+        // Point clouds have no faces
+        const unsigned *facesData = faces ? reinterpret_cast<const unsigned *>(faces->buffer.get()) : nullptr;
+        for (size_t i = 0; facesData && i < faces->count; ++i)
         {
-
-            // Assuming faces are triangles, so we extract the vertex indices
-            unsigned int vertexIndex1 = static_cast<unsigned int>(facesData[i]);
-            unsigned int vertexIndex2 = static_cast<unsigned int>(facesData[i + 1]);
-            unsigned int vertexIndex3 = static_cast<unsigned int>(facesData[i + 2]);
-
+            // Assuming faces are triangles
             indices.push_back(facesData[3 * i]);
             indices.push_back(facesData[3 * i + 1]);
             indices.push_back(facesData[3 * i + 2]);
         }
+        if (std::any_of(indices.begin(), indices.end(), [&](unsigned int index)
+                        { return index >= vertices.size(); }))
+        {
+            ERR_LOG("PLY face references a vertex out of range in " << fileName);
+            return false;
+        }
 
-        mesh->set_geometry(new Geometry(vertices, indices));
-
-        return;
+        return true;
     }
     catch (const std::exception &e)
     {
         std::cerr << "Caught tinyply exception: " << e.what() << std::endl;
     }
+    return false;
 }
 
-void loaders::load_image(Texture *const texture, const char *fileName, bool isPanorama)
+namespace
 {
-    Image img = texture->get_image();
-    img.path = fileName;
-    img.panorama = isPanorama;
+    enum class PLYType
+    {
+        INVALID,
+        INT8,
+        UINT8,
+        INT16,
+        UINT16,
+        INT32,
+        UINT32,
+        FLOAT32,
+        FLOAT64
+    };
+
+    PLYType get_PLY_type(const std::string &name)
+    {
+        if (name == "char" || name == "int8")
+            return PLYType::INT8;
+        if (name == "uchar" || name == "uint8")
+            return PLYType::UINT8;
+        if (name == "short" || name == "int16")
+            return PLYType::INT16;
+        if (name == "ushort" || name == "uint16")
+            return PLYType::UINT16;
+        if (name == "int" || name == "int32")
+            return PLYType::INT32;
+        if (name == "uint" || name == "uint32")
+            return PLYType::UINT32;
+        if (name == "float" || name == "float32")
+            return PLYType::FLOAT32;
+        if (name == "double" || name == "float64")
+            return PLYType::FLOAT64;
+        return PLYType::INVALID;
+    }
 
-    if (img.data || img.HDRdata)
-        DEBUG_LOG("Image data already in texture");
+    inline size_t get_PLY_type_size(PLYType type)
+    {
+        switch (type)
+        {
+        case PLYType::INT8:
+        case PLYType::UINT8:
+            return 1;
+        case PLYType::INT16:
+        case PLYType::UINT16:
+            return 2;
+        case PLYType::INT32:
+        case PLYType::UINT32:
+        case PLYType::FLOAT32:
+            return 4;
+        case PLYType::FLOAT64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
 
-    // Check extension
-    const std::string PNG = "png";
-    const std::string JPG = "jpg";
-    const std::string HDR = "hdr";
-    const std::string EXR = "exr";
+    /*
+    Reads a binary scalar and converts it to double. Swaps bytes if the file endianness differs from the host one.
+    */
+    inline double read_PLY_scalar(const char *p, PLYType type, bool swap)
+    {
+        uint8_t bytes[8];
+        const size_t size = get_PLY_type_size(type);
+        memcpy(bytes, p, size);
+        if (swap)
+            std::reverse(bytes, bytes + size);
+        switch (type)
+        {
+        case PLYType::INT8:
+            return static_cast<int8_t>(bytes[0]);
+        case PLYType::UINT8:
+            return bytes[0];
+        case PLYType::INT16:
+        {
+            int16_t v;
+            memcpy(&v, bytes, 2);
+            return v;
+        }
+        case PLYType::UINT16:
+        {
+            uint16_t v;
+            memcpy(&v, bytes, 2);
+            return v;
+        }
+        case PLYType::INT32:
+        {
+            int32_t v;
+            memcpy(&v, bytes, 4);
+            return v;
+        }
+        case PLYType::UINT32:
+        {
+            uint32_t v;
+            memcpy(&v, bytes, 4);
+            return v;
+        }
+        case PLYType::FLOAT32:
+        {
+            float v;
+            memcpy(&v, bytes, 4);
+            return v;
+        }
+        case PLYType::FLOAT64:
+        {
+            double v;
+            memcpy(&v, bytes, 8);
+            return v;
+        }
+        default:
+            return 0.0;
+        }
+    }
 
-    int desiredChannels = 4;
+    // Float slots inside the canonical Vertex
+    const int PLY_SLOT_NONE = -1;
+    const int PLY_SLOT_POSITION = offsetof(Vertex, position) / sizeof(float);
+    const int PLY_SLOT_NORMAL = offsetof(Vertex, normal) / sizeof(float);
+    const int PLY_SLOT_UV = offsetof(Vertex, uv) / sizeof(float);
+    const int PLY_SLOT_COLOR = offsetof(Vertex, color) / sizeof(float);
 
-    std::string fileNameStr(fileName);
-    size_t dotPosition = fileNameStr.find_last_of(".");
-    std::string fileExtension = "";
+    int get_PLY_vertex_slot(const std::string &name)
+    {
+        static const std::unordered_map<std::string, int> SLOTS = {
+            {"x", PLY_SLOT_POSITION}, {"y", PLY_SLOT_POSITION + 1}, {"z", PLY_SLOT_POSITION + 2},
+            {"nx", PLY_SLOT_NORMAL}, {"ny", PLY_SLOT_NORMAL + 1}, {"nz", PLY_SLOT_NORMAL + 2},
+            {"u", PLY_SLOT_UV}, {"v", PLY_SLOT_UV + 1}, {"s", PLY_SLOT_UV}, {"t", PLY_SLOT_UV + 1},
+            {"texture_u", PLY_SLOT_UV}, {"texture_v", PLY_SLOT_UV + 1}, {"texture_s", PLY_SLOT_UV}, {"texture_t", PLY_SLOT_UV + 1},
+            {"red", PLY_SLOT_COLOR}, {"green", PLY_SLOT_COLOR + 1}, {"blue", PLY_SLOT_COLOR + 2},
+            {"r", PLY_SLOT_COLOR}, {"g", PLY_SLOT_COLOR + 1}, {"b", PLY_SLOT_COLOR + 2},
+            {"diffuse_red", PLY_SLOT_COLOR}, {"diffuse_green", PLY_SLOT_COLOR + 1}, {"diffuse_blue", PLY_SLOT_COLOR + 2}};
+        auto it = SLOTS.find(name);
+        return it != SLOTS.end() ? it->second : PLY_SLOT_NONE;
+    }
 
-    // Set file extension for further checks
-    if (dotPosition != std::string::npos) {
-        fileExtension = fileNameStr.substr(dotPosition + 1);
+    struct PLYProperty
+    {
+        std::string name;
+        PLYType type{PLYType::INVALID};
+        bool isList{false};
+        PLYType countType{PLYType::INVALID};
 
-        if (fileExtension == PNG)
-            desiredChannels = 4;
-        if (fileExtension == JPG)
-            desiredChannels = 3;
-    }
+        size_t offset{0}; // Inside the record, only meaningful in fixed size elements
+        int slot{PLY_SLOT_NONE};
+        float scale{1.0f}; // Integer colors get normalized
+    };
 
-    int w, h;
-    if (fileExtension != HDR && fileExtension != EXR) // If not HDR Image
+    struct PLYElement
     {
-      
+        std::string name;
+        size_t count{0};
+        std::vector<PLYProperty> properties;
 
-        unsigned char *cache = stbi_load(fileName, &w, &h, &img.channels, desiredChannels);
-        if (cache == nullptr)
+        bool fixedSize{true};
+        size_t stride{0};
+    };
+
+    struct PLYHeader
+    {
+        bool ascii{false};
+        bool swap{false};
+        std::vector<PLYElement> elements;
+        std::vector<std::string> comments;
+        size_t bytes{0};
+    };
+
+    /*
+    Byte source for the decoder. Either a memory mapped file, or a file streamed through a fixed size window
+    so that it is never fully held in memory.
+    */
+    class PLYStream
+    {
+        std::unique_ptr<utils::MappedFile> m_map;
+        std::ifstream m_file;
+        std::vector<char> m_buffer;
+        const char *m_cur{nullptr};
+        const char *m_end{nullptr};
+        bool m_eof{false};
+        size_t m_consumed{0};
+
+    public:
+        PLYStream(const char *fileName, bool map, size_t chunkBytes)
         {
-            ERR_LOG(stbi_failure_reason());
-            return;
+            if (map)
+            {
+                m_map.reset(new utils::MappedFile(fileName, utils::FILE_ACCESS_SEQUENTIAL));
+                m_cur = reinterpret_cast<const char *>(m_map->get_data());
+                m_end = m_cur + m_map->get_size();
+                m_eof = true;
+            }
+            else
+            {
+                m_file.open(fileName, std::ios::binary);
+                if (!m_file.is_open())
+                    throw std::runtime_error(std::string("could not open file ") + fileName);
+                m_buffer.resize(chunkBytes);
+                m_cur = m_end = m_buffer.data();
+            }
         }
 
-        img.linear = true;
-        img.data = cache;
-    }
-    else
-    { // If HDR Image
+        inline const char *data() const { return m_cur; }
+        inline size_t available() const { return m_end - m_cur; }
+        inline size_t consumed() const { return m_consumed; }
 
-        float *HDRcache = stbi_loadf(fileName, &w, &h, &img.channels, 0);
+        inline void advance(size_t bytes)
+        {
+            m_cur += bytes;
+            m_consumed += bytes;
+        }
 
-        if (HDRcache == nullptr)
+        /*
+        Makes at least the requested amount of bytes contiguously available. Returns false on end of file.
+        */
+        bool ensure(size_t bytes)
         {
-            ERR_LOG(stbi_failure_reason());
-            return;
+            if (available() >= bytes)
+                return true;
+            if (m_eof)
+                return false;
+
+            const size_t remaining = available();
+            if (bytes > m_buffer.size())
+                m_buffer.resize(std::max(bytes, m_buffer.size() * 2));
+            memmove(m_buffer.data(), m_cur, remaining);
+            m_file.read(m_buffer.data() + remaining, m_buffer.size() - remaining);
+            const size_t read = static_cast<size_t>(m_file.gcount());
+            if (read < m_buffer.size() - remaining)
+                m_eof = true;
+            m_cur = m_buffer.data();
+            m_end = m_cur + remaining + read;
+            return available() >= bytes;
         }
 
-        img.linear = false;
-        img.HDRdata = HDRcache; // Fill float pointer, for having higher color precission
-    }
+        /*
+        Returns the next text line without its line break.
+        */
+        bool next_line(const char *&begin, const char *&end)
+        {
+            size_t searched = 0;
+            while (true)
+            {
+                const char *newline = static_cast<const char *>(memchr(m_cur + searched, '\n', available() - searched));
+                if (newline)
+                {
+                    begin = m_cur;
+                    end = newline > m_cur && newline[-1] == '\r' ? newline - 1 : newline;
+                    advance(newline + 1 - m_cur);
+                    return true;
+                }
+                searched = available();
+                if (m_eof)
+                {
+                    if (searched == 0)
+                        return false;
+                    begin = m_cur;
+                    end = m_end;
+                    advance(searched);
+                    return true;
+                }
+                ensure(searched + 1);
+            }
+        }
+    };
 
-    img.extent = {w, h};
-    if (!isPanorama)
-        texture->set_extent(img.extent);
+    bool parse_PLY_header(PLYStream &stream, PLYHeader &header)
+    {
+        const char *begin, *end;
+        if (!stream.next_line(begin, end) || std::string(begin, end) != "ply")
+            return false;
+
+        while (stream.next_line(begin, end))
+        {
+            std::istringstream line(std::string(begin, end));
+            std::string keyword;
+            line >> keyword;
+
+            if (keyword == "format")
+            {
+                std::string format;
+                line >> format;
+                header.ascii = format == "ascii";
+                const bool bigEndian = format == "binary_big_endian";
+                const uint16_t probe = 1;
+                const bool hostBigEndian = *reinterpret_cast<const uint8_t *>(&probe) == 0;
+                header.swap = !header.ascii && bigEndian != hostBigEndian;
+            }
+            else if (keyword == "comment" || keyword == "obj_info")
+                header.comments.push_back(std::string(begin, end));
+            else if (keyword == "element")
+            {
+                PLYElement element;
+                line >> element.name >> element.count;
+                header.elements.push_back(element);
+            }
+            else if (keyword == "property")
+            {
+                if (header.elements.empty())
+                    return false;
+                PLYElement &element = header.elements.back();
+                PLYProperty property;
+                std::string type;
+                line >> type;
+                if (type == "list")
+                {
+                    std::string countType, itemType;
+                    line >> countType >> itemType;
+                    property.isList = true;
+                    property.countType = get_PLY_type(countType);
+                    property.type = get_PLY_type(itemType);
+                    if (property.countType == PLYType::INVALID)
+                        return false;
+                    element.fixedSize = false;
+                }
+                else
+                {
+                    property.type = get_PLY_type(type);
+                    property.offset = element.stride;
+                    element.stride += get_PLY_type_size(property.type);
+                }
+                if (property.type == PLYType::INVALID)
+                    return false;
+                line >> property.name;
+
+                if (element.name == "vertex" && !property.isList)
+                {
+                    property.slot = get_PLY_vertex_slot(property.name);
+                    if (property.slot >= PLY_SLOT_COLOR && property.slot < PLY_SLOT_COLOR + 3)
+                    {
+                        if (property.type == PLYType::UINT8)
+                            property.scale = 1.0f / 255.0f;
+                        else if (property.type == PLYType::UINT16)
+                            property.scale = 1.0f / 65535.0f;
+                    }
+                }
+                element.properties.push_back(property);
+            }
+            else if (keyword == "end_header")
+            {
+                // Records without properties would take no bytes, and never advance the stream
+                for (const PLYElement &element : header.elements)
+                    if (element.count > 0 && element.fixedSize && element.stride == 0)
+                        return false;
+                header.bytes = stream.consumed();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+    List counts and vertex indices must be non negative integers, anything else is a corrupt file.
+    */
+    inline bool read_PLY_integer(double value, size_t &integer)
+    {
+        if (!(value >= 0.0) || value != std::floor(value) || value > double(std::numeric_limits<unsigned int>::max()))
+            return false;
+        integer = static_cast<size_t>(value);
+        return true;
+    }
+
+    inline const PLYProperty *find_PLY_face_list(const PLYElement &element)
+    {
+        for (const PLYProperty &property : element.properties)
+            if (property.isList && (property.name == "vertex_indices" || property.name == "vertex_index"))
+                return &property;
+        return nullptr;
+    }
+
+    inline void push_PLY_polygon(std::vector<unsigned int> &indices, const unsigned int *polygon, size_t size)
+    {
+        // Fan triangulation
+        for (size_t i = 1; i + 1 < size; i++)
+        {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[i]);
+            indices.push_back(polygon[i + 1]);
+        }
+    }
+
+    bool decode_PLY_binary_element(PLYStream &stream, const PLYHeader &header, const PLYElement &element,
+                                   Vertex *vertices, std::vector<unsigned int> *indices)
+    {
+        const bool isVertex = element.name == "vertex" && vertices;
+        const bool isFace = element.name == "face" && indices;
+        const PLYProperty *faceList = isFace ? find_PLY_face_list(element) : nullptr;
+
+        if (element.fixedSize)
+        {
+            // Whole records are decoded in batches straight from the stream window
+            size_t remaining = element.count;
+            Vertex *destination = vertices;
+            while (remaining > 0)
+            {
+                if (!stream.ensure(element.stride))
+                    return false;
+                const size_t batch = std::min(remaining, stream.available() / element.stride);
+                if (isVertex)
+                {
+                    const char *record = stream.data();
+                    for (size_t i = 0; i < batch; i++, record += element.stride, destination++)
+                    {
+                        float *slots = reinterpret_cast<float *>(destination);
+                        for (const PLYProperty &property : element.properties)
+                            if (property.slot != PLY_SLOT_NONE)
+                                slots[property.slot] = static_cast<float>(read_PLY_scalar(record + property.offset, property.type, header.swap)) * property.scale;
+                    }
+                }
+                stream.advance(batch * element.stride);
+                remaining -= batch;
+            }
+            return true;
+        }
+
+        std::vector<unsigned int> polygon;
+        for (size_t i = 0; i < element.count; i++)
+        {
+            for (const PLYProperty &property : element.properties)
+            {
+                if (!property.isList)
+                {
+                    if (!stream.ensure(get_PLY_type_size(property.type)))
+                        return false;
+                    stream.advance(get_PLY_type_size(property.type));
+                    continue;
+                }
+                const size_t countSize = get_PLY_type_size(property.countType);
+                if (!stream.ensure(countSize))
+                    return false;
+                size_t count;
+                if (!read_PLY_integer(read_PLY_scalar(stream.data(), property.countType, header.swap), count))
+                    return false;
+                stream.advance(countSize);
+
+                const size_t itemSize = get_PLY_type_size(property.type);
+                if (!stream.ensure(count * itemSize))
+                    return false;
+                if (&property == faceList)
+                {
+                    polygon.resize(count);
+                    for (size_t j = 0; j < count; j++)
+                    {
+                        size_t index;
+                        if (!read_PLY_integer(read_PLY_scalar(stream.data() + j * itemSize, property.type, header.swap), index))
+                            return false;
+                        polygon[j] = static_cast<unsigned int>(index);
+                    }
+                    push_PLY_polygon(*indices, polygon.data(), count);
+                }
+                stream.advance(count * itemSize);
+            }
+        }
+        return true;
+    }
+
+    bool decode_PLY_ascii_element(PLYStream &stream, const PLYElement &element, Vertex *vertices, std::vector<unsigned int> *indices)
+    {
+        const bool isVertex = element.name == "vertex" && vertices;
+        const bool isFace = element.name == "face" && indices;
+        const PLYProperty *faceList = isFace ? find_PLY_face_list(element) : nullptr;
+
+        std::vector<unsigned int> polygon;
+        for (size_t i = 0; i < element.count; i++)
+        {
+            const char *p, *end;
+            if (!stream.next_line(p, end))
+                return false;
+            float *slots = isVertex ? reinterpret_cast<float *>(vertices + i) : nullptr;
+
+            for (const PLYProperty &property : element.properties)
+            {
+                float value = 0.0f;
+                if (!property.isList)
+                {
+                    p = utils::parse_float(p, end, value);
+                    if (slots && property.slot != PLY_SLOT_NONE)
+                        slots[property.slot] = value * property.scale;
+                    continue;
+                }
+                p = utils::parse_float(p, end, value);
+                size_t count;
+                if (!read_PLY_integer(value, count))
+                    return false;
+                polygon.resize(count);
+                for (size_t j = 0; j < count; j++)
+                {
+                    // Indices might not fit a float mantissa, read them as integers
+                    while (p < end && (*p == ' ' || *p == '\t'))
+                        p++;
+                    if (p == end || *p < '0' || *p > '9')
+                        return false;
+                    unsigned int index = 0;
+                    while (p < end && *p >= '0' && *p <= '9')
+                        index = index * 10 + unsigned(*p++ - '0');
+                    polygon[j] = index;
+                }
+                if (&property == faceList)
+                    push_PLY_polygon(*indices, polygon.data(), count);
+            }
+        }
+        return true;
+    }
+}
+
+bool loaders::read_PLY_info(const char *fileName, PLYInfo &info)
+{
+    try
+    {
+        PLYStream stream(fileName, false, 1 << 16);
+        PLYHeader header;
+        if (!parse_PLY_header(stream, header))
+            return false;
+
+        info = {};
+        info.binary = !header.ascii;
+        for (const PLYElement &element : header.elements)
+        {
+            if (element.name == "vertex")
+            {
+                info.vertexCount = element.count;
+                for (const PLYProperty &property : element.properties)
+                {
+                    info.hasNormals |= property.slot == PLY_SLOT_NORMAL;
+                    info.hasUVs |= property.slot == PLY_SLOT_UV;
+                    info.hasColors |= property.slot == PLY_SLOT_COLOR;
+                }
+            }
+            else if (element.name == "face")
+                info.faceCount = element.count;
+        }
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
+}
+
+bool loaders::decode_PLY(const char *fileName, Vertex *vertices, size_t vertexCapacity, std::vector<unsigned int> *indices, bool preload, bool verbose)
+{
+    try
+    {
+        PLYStream stream(fileName, preload, PLY_STREAM_CHUNK_BYTES);
+        PLYHeader header;
+        if (!parse_PLY_header(stream, header))
+        {
+            ERR_LOG("Invalid PLY header in " << fileName);
+            return false;
+        }
+
+        if (verbose)
+        {
+            std::cout << "\t[ply_header] Type: " << (header.ascii ? "ascii" : "binary") << std::endl;
+            for (const auto &c : header.comments)
+                std::cout << "\t[ply_header] " << c << std::endl;
+            for (const auto &e : header.elements)
+            {
+                std::cout << "\t[ply_header] element: " << e.name << " (" << e.count << ")" << std::endl;
+                for (const auto &p : e.properties)
+                    std::cout << "\t[ply_header] \tproperty: " << p.name << (p.isList ? " (list)" : "") << std::endl;
+            }
+        }
+
+        utils::ManualTimer readTimer;
+        readTimer.start();
+
+        size_t vertexCount = 0;
+        for (const PLYElement &element : header.elements)
+            if (element.name == "vertex")
+                vertexCount = element.count;
+        const size_t firstIndex = indices ? indices->size() : 0;
+
+        for (const PLYElement &element : header.elements)
+        {
+            Vertex *destination = nullptr;
+            if (element.name == "vertex" && vertices)
+            {
+                if (element.count > vertexCapacity)
+                {
+                    ERR_LOG("PLY destination too small for " << element.count << " vertices");
+                    return false;
+                }
+                // Attributes absent from the file keep the canonical defaults
+                const Vertex defaults{glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(1.0f)};
+                std::fill(vertices, vertices + element.count, defaults);
+                destination = vertices;
+            }
+            const bool decoded = header.ascii ? decode_PLY_ascii_element(stream, element, destination, indices)
+                                              : decode_PLY_binary_element(stream, header, element, destination, indices);
+            if (!decoded)
+            {
+                ERR_LOG("Truncated or corrupt PLY element " << element.name << " in " << fileName);
+                return false;
+            }
+        }
+
+        // Faces referencing missing vertices would read past the vertex buffer
+        if (indices && std::any_of(indices->begin() + firstIndex, indices->end(), [vertexCount](unsigned int index)
+                                   { return index >= vertexCount; }))
+        {
+            ERR_LOG("PLY face references a vertex out of range in " << fileName);
+            return false;
+        }
+
+        if (verbose)
+        {
+            readTimer.stop();
+            const float sizeMB = stream.consumed() * float(1e-6);
+            const float parsingTime = static_cast<float>(readTimer.get()) / 1000.f;
+            std::cout << "\tparsing " << sizeMB << "mb in " << parsingTime << " seconds [" << (sizeMB / parsingTime) << " MBps]" << std::endl;
+        }
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
+}
+
+bool loaders::stream_PLY(const char *fileName, const std::function<bool(const Vertex *, size_t)> &sink, size_t batchSize)
+{
+    try
+    {
+        PLYStream stream(fileName, false, PLY_STREAM_CHUNK_BYTES);
+        PLYHeader header;
+        if (!parse_PLY_header(stream, header))
+        {
+            ERR_LOG("Invalid PLY header in " << fileName);
+            return false;
+        }
+
+        const Vertex defaults{glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f), glm::vec3(1.0f)};
+        std::vector<Vertex> batch(std::max<size_t>(batchSize, 1));
+        for (const PLYElement &element : header.elements)
+        {
+            if (element.name != "vertex")
+            {
+                const bool skipped = header.ascii ? decode_PLY_ascii_element(stream, element, nullptr, nullptr)
+                                                  : decode_PLY_binary_element(stream, header, element, nullptr, nullptr);
+                if (!skipped)
+                    break;
+                continue;
+            }
+            // The decoders read as many records as the element has, so the vertex element is fed to them in slices
+            PLYElement slice = element;
+            for (size_t first = 0; first < element.count; first += slice.count)
+            {
+                slice.count = std::min(batch.size(), element.count - first);
+                std::fill(batch.begin(), batch.begin() + slice.count, defaults);
+                const bool decoded = header.ascii ? decode_PLY_ascii_element(stream, slice, batch.data(), nullptr)
+                                                  : decode_PLY_binary_element(stream, header, slice, batch.data(), nullptr);
+                if (!decoded)
+                {
+                    ERR_LOG("Truncated or corrupt PLY element " << element.name << " in " << fileName);
+                    return false;
+                }
+                if (!sink(batch.data(), slice.count))
+                    return true;
+            }
+            return true;
+        }
+        ERR_LOG("PLY file without vertices " << fileName);
+        return false;
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
+}
+
+bool loaders::parse_PLY(const char *fileName, MeshData &data, bool preload, bool verbose)
+{
+    PLYInfo info;
+    if (!read_PLY_info(fileName, info))
+        return false;
+
+    // Sized once from the header, vertices are decoded in place
+    data.vertices.resize(info.vertexCount);
+    data.indices.clear();
+    data.indices.reserve(info.faceCount * 3);
+    return decode_PLY(fileName, data.vertices.data(), data.vertices.size(), &data.indices, preload, verbose);
+}
+
+bool loaders::decode_image(const char *fileName, Image &image)
+{
+    image.path = fileName;
+
+    // Check extension
+    const std::string PNG = "png";
+    const std::string JPG = "jpg";
+    const std::string HDR = "hdr";
+    const std::string EXR = "exr";
+
+    int desiredChannels = 4;
+
+    std::string fileNameStr(fileName);
+    size_t dotPosition = fileNameStr.find_last_of(".");
+    std::string fileExtension = "";
+
+    // Set file extension for further checks
+    if (dotPosition != std::string::npos) {
+        fileExtension = fileNameStr.substr(dotPosition + 1);
+
+        if (fileExtension == PNG)
+            desiredChannels = 4;
+        if (fileExtension == JPG)
+            desiredChannels = 3;
+    }
+
+    // Decoded straight from the mapped file instead of through stdio reads
+    std::unique_ptr<utils::MappedFile> file;
+    try
+    {
+        file.reset(new utils::MappedFile(fileName, utils::FILE_ACCESS_SEQUENTIAL));
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG(e.what());
+        return false;
+    }
+    if (file->get_size() > size_t(std::numeric_limits<int>::max()))
+    {
+        ERR_LOG("Image file too large " + image.path);
+        return false;
+    }
+    const int fileSize = static_cast<int>(file->get_size());
+
+    int w, h;
+    if (fileExtension != HDR && fileExtension != EXR) // If not HDR Image
+    {
+        unsigned char *cache = stbi_load_from_memory(file->get_data(), fileSize, &w, &h, &image.channels, desiredChannels);
+        if (cache == nullptr)
+        {
+            ERR_LOG(stbi_failure_reason());
+            return false;
+        }
+
+        image.linear = true;
+        image.data = cache;
+        image.channels = desiredChannels; // stb reports the channels in the file, not the ones returned
+    }
+    else
+    { // If HDR Image
+
+        float *HDRcache = stbi_loadf_from_memory(file->get_data(), fileSize, &w, &h, &image.channels, 0);
+
+        if (HDRcache == nullptr)
+        {
+            ERR_LOG(stbi_failure_reason());
+            return false;
+        }
+
+        image.linear = false;
+        image.HDRdata = HDRcache; // Fill float pointer, for having higher color precission
+    }
+
+    image.extent = {w, h};
+    return true;
+}
+
+void loaders::load_image(Texture *const texture, const char *fileName, bool isPanorama)
+{
+    Image img = texture->get_image();
+    img.panorama = isPanorama;
+
+    if (img.data || img.HDRdata)
+        DEBUG_LOG("Image data already in texture");
+
+    if (!decode_image(fileName, img))
+        return;
+
+    if (!isPanorama)
+        texture->set_extent(img.extent);
 
     // Update texture
     texture->set_image(img);
 }
-GLSP_NAMESPACE_END
\ No newline at end of file
+
+namespace
+{
+    /*
+    Maps the mip chain of an image from the texture cache, or decodes the image and builds it, storing it for next time.
+    */
+    bool import_texture_levels(const char *fileName, const processing::MipSettings &settings, const processing::BlockCompressionSettings *compression, TextureLevels &levels)
+    {
+        const uint64_t options = hash_import_options("texture", {settings.filter, settings.sRGB, settings.wrap, compression != nullptr,
+                                                                 compression ? uint64_t(compression->format) : 0, compression ? uint64_t(compression->quality) : 0});
+        if (cache::load_texture(fileName, options, levels))
+            return true;
+
+        Image img;
+        if (!loaders::decode_image(fileName, img))
+            return false;
+
+        auto chain = std::make_shared<processing::MipChain>();
+        if (img.HDRdata)
+        {
+            processing::generate_mip_chain(img.HDRdata, img.extent, img.channels, *chain, settings);
+            stbi_image_free(img.HDRdata);
+        }
+        else
+        {
+            processing::generate_mip_chain(img.data, img.extent, img.channels, *chain, settings);
+            stbi_image_free(img.data);
+        }
+        if (chain->get_level_count() == 0)
+            return false;
+        if (compression && !processing::compress_mip_chain(*chain, *chain, *compression))
+            return false;
+
+        cache::store_texture(fileName, options, *chain);
+        levels = processing::get_texture_levels(chain.get(), 1, chain);
+        return true;
+    }
+
+    /*
+    Maps the faces of a panorama from the cubemap cache, or decodes and projects it, storing the faces for next time.
+    */
+    bool import_cubemap_levels(const char *fileName, const processing::CubemapSettings &settings, TextureLevels &levels)
+    {
+        const uint64_t options = hash_import_options("cubemap", {uint64_t(settings.resolution), settings.tonemap, settings.mipmaps});
+        if (cache::load_cubemap(fileName, options, levels))
+            return true;
+
+        Image img;
+        if (!loaders::decode_image(fileName, img))
+            return false;
+        if (!img.HDRdata)
+        {
+            ERR_LOG("Panoramas must be HDR images");
+            stbi_image_free(img.data);
+            return false;
+        }
+
+        auto cubemap = std::make_shared<processing::CubemapData>();
+        processing::panorama_to_cubemap(img.HDRdata, img.extent, img.channels, *cubemap, settings);
+        stbi_image_free(img.HDRdata);
+        if (cubemap->faces[0].get_level_count() == 0)
+            return false;
+
+        cache::store_cubemap(fileName, options, *cubemap);
+        levels = processing::get_texture_levels(cubemap->faces, 6, cubemap);
+        return true;
+    }
+}
+
+bool loaders::load_texture(Texture *const texture, const char *fileName, processing::MipSettings settings, const processing::BlockCompressionSettings *compression)
+{
+    TextureLevels levels;
+    if (!import_texture_levels(fileName, settings, compression, levels))
+        return false;
+
+    texture->set_levels(levels);
+    texture->set_extent(levels.extents[0]);
+    return true;
+}
+
+bool loaders::load_panorama(Texture *const texture, const char *fileName, processing::CubemapSettings settings)
+{
+    if (texture->get_config().type != TEXTURE_CUBEMAP)
+    {
+        ERR_LOG("Texture must be a CUBEMAP in order to load a panorama into it");
+        return false;
+    }
+    TextureLevels levels;
+    if (!import_cubemap_levels(fileName, settings, levels))
+        return false;
+
+    texture->set_levels(levels);
+    texture->set_extent(levels.extents[0]);
+    return true;
+}
+
+namespace
+{
+    /*
+    Background import state. Workers parse and decode, while GPU uploads are queued until the GL thread processes them.
+    */
+    struct AsyncLoader
+    {
+        std::unique_ptr<utils::ThreadPool> pool;
+        std::mutex poolMutex;
+
+        std::deque<std::function<void()>> uploads;
+        std::mutex uploadMutex;
+
+        utils::ThreadPool &get_pool()
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!pool)
+                pool.reset(new utils::ThreadPool());
+            return *pool;
+        }
+
+        void push_upload(std::function<void()> &&upload)
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex);
+            uploads.push_back(std::move(upload));
+        }
+    };
+
+    AsyncLoader &get_async_loader()
+    {
+        static AsyncLoader loader;
+        return loader;
+    }
+
+    /*
+    GL thread side of an asynchronous image load.
+    */
+    void upload_image(Texture *const texture, const Image &img, bool isPanorama, bool generate)
+    {
+        if (!isPanorama)
+            texture->set_extent(img.extent);
+        texture->set_image(img);
+        if (generate)
+            texture->generate();
+    }
+
+    void upload_levels(Texture *const texture, const TextureLevels &levels, bool generate)
+    {
+        texture->set_levels(levels);
+        texture->set_extent(levels.extents[0]);
+        if (generate)
+            texture->generate();
+    }
+
+    std::shared_future<bool> load_geometry_async(Mesh *const mesh, std::function<Geometry *()> &&import)
+    {
+        auto promise = std::make_shared<std::promise<bool>>();
+        std::shared_future<bool> result = promise->get_future().share();
+
+        AsyncLoader &loader = get_async_loader();
+        loader.get_pool().enqueue([&loader, mesh, promise, import]()
+                                  {
+            Geometry *geometry = import();
+            if (!geometry)
+            {
+                promise->set_value(false);
+                return;
+            }
+            loader.push_upload([mesh, geometry, promise]()
+                               {
+                mesh->set_geometry(geometry);
+                geometry->generate_buffers();
+                promise->set_value(true); }); });
+        return result;
+    }
+}
+
+void loaders::set_async_thread_count(unsigned int threadCount)
+{
+    AsyncLoader &loader = get_async_loader();
+    std::lock_guard<std::mutex> lock(loader.poolMutex);
+    // Previous pool finishes its queued imports before being replaced
+    loader.pool.reset(new utils::ThreadPool(threadCount));
+}
+
+std::shared_future<bool> loaders::load_OBJ_async(Mesh *const mesh, const char *fileName, bool importMaterials, bool calculateTangents, unsigned int LODCount)
+{
+    const std::string path = fileName;
+    return load_geometry_async(mesh, [path, importMaterials, calculateTangents, LODCount]()
+                               { return import_OBJ(path.c_str(), importMaterials, calculateTangents, LODCount); });
+}
+
+std::shared_future<bool> loaders::load_PLY_async(Mesh *const mesh, const char *fileName, bool preload, bool verbose, bool calculateTangents, unsigned int LODCount)
+{
+    const std::string path = fileName;
+    return load_geometry_async(mesh, [path, preload, verbose, calculateTangents, LODCount]()
+                               { return import_PLY(path.c_str(), preload, verbose, calculateTangents, LODCount); });
+}
+
+std::shared_future<bool> loaders::load_image_async(Texture *const texture, const char *fileName, bool isPanorama, bool generate)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::shared_future<bool> result = promise->get_future().share();
+
+    // The texture is only touched from the GL thread
+    Image img = texture->get_image();
+    img.panorama = isPanorama;
+
+    const std::string path = fileName;
+    AsyncLoader &loader = get_async_loader();
+    loader.get_pool().enqueue([&loader, texture, img, path, isPanorama, generate, promise]() mutable
+                              {
+        if (!decode_image(path.c_str(), img))
+        {
+            promise->set_value(false);
+            return;
+        }
+        loader.push_upload([texture, img, isPanorama, generate, promise]()
+                           {
+            upload_image(texture, img, isPanorama, generate);
+            promise->set_value(true); }); });
+    return result;
+}
+
+std::shared_future<bool> loaders::load_texture_async(Texture *const texture, const char *fileName, processing::MipSettings settings,
+                                                     const processing::BlockCompressionSettings *compression, bool generate)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::shared_future<bool> result = promise->get_future().share();
+
+    const std::string path = fileName;
+    const bool compress = compression != nullptr;
+    const processing::BlockCompressionSettings compressionSettings = compress ? *compression : processing::BlockCompressionSettings{};
+    AsyncLoader &loader = get_async_loader();
+    loader.get_pool().enqueue([&loader, texture, path, settings, compress, compressionSettings, generate, promise]()
+                              {
+        TextureLevels levels;
+        if (!import_texture_levels(path.c_str(), settings, compress ? &compressionSettings : nullptr, levels))
+        {
+            promise->set_value(false);
+            return;
+        }
+        loader.push_upload([texture, levels, generate, promise]()
+                           {
+            upload_levels(texture, levels, generate);
+            promise->set_value(true); }); });
+    return result;
+}
+
+std::shared_future<bool> loaders::load_panorama_async(Texture *const texture, const char *fileName, processing::CubemapSettings settings, bool generate)
+{
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::shared_future<bool> result = promise->get_future().share();
+    if (texture->get_config().type != TEXTURE_CUBEMAP)
+    {
+        ERR_LOG("Texture must be a CUBEMAP in order to load a panorama into it");
+        promise->set_value(false);
+        return result;
+    }
+
+    const std::string path = fileName;
+    AsyncLoader &loader = get_async_loader();
+    loader.get_pool().enqueue([&loader, texture, path, settings, generate, promise]()
+                              {
+        TextureLevels levels;
+        if (!import_cubemap_levels(path.c_str(), settings, levels))
+        {
+            promise->set_value(false);
+            return;
+        }
+        loader.push_upload([texture, levels, generate, promise]()
+                           {
+            upload_levels(texture, levels, generate);
+            promise->set_value(true); }); });
+    return result;
+}
+
+std::shared_future<loaders::ImageBatchReport> loaders::load_images(const std::vector<ImageLoadRequest> &requests, bool generate)
+{
+    struct Batch
+    {
+        std::promise<ImageBatchReport> promise;
+        ImageBatchReport report;
+        std::mutex mutex;
+        std::atomic<size_t> remaining;
+        utils::ManualTimer timer;
+    };
+    auto batch = std::make_shared<Batch>();
+    std::shared_future<ImageBatchReport> result = batch->promise.get_future().share();
+    batch->remaining = requests.size();
+    batch->report.files.reserve(requests.size());
+    if (requests.empty())
+    {
+        batch->promise.set_value(batch->report);
+        return result;
+    }
+
+    // Whoever finishes the last file, a failed decode or an upload, completes the batch
+    auto finish = [batch]()
+    {
+        if (--batch->remaining == 0)
+            batch->promise.set_value(batch->report);
+    };
+
+    batch->timer.start();
+    AsyncLoader &loader = get_async_loader();
+    for (const ImageLoadRequest &request : requests)
+    {
+        // The texture is only touched from the GL thread
+        Image img = request.texture->get_image();
+        img.panorama = request.isPanorama;
+        loader.get_pool().enqueue([&loader, batch, finish, request, img, generate]() mutable
+                                  {
+            ImageBatchReport::File file;
+            file.fileName = request.fileName;
+            std::error_code error;
+            const uintmax_t fileBytes = std::filesystem::file_size(request.fileName, error);
+            file.fileBytes = error ? 0 : size_t(fileBytes);
+            utils::ManualTimer timer;
+            timer.start();
+            file.decoded = decode_image(request.fileName.c_str(), img);
+            timer.stop();
+            file.decodeMs = timer.get();
+            file.extent = img.extent;
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->timer.stop();
+                batch->report.elapsedMs = batch->timer.get();
+                batch->report.fileBytes += file.decoded ? file.fileBytes : 0;
+                batch->report.pixels += file.decoded ? size_t(img.extent.width) * img.extent.height : 0;
+                batch->report.files.push_back(file);
+            }
+            if (!file.decoded)
+            {
+                finish();
+                return;
+            }
+            loader.push_upload([request, img, generate, finish]()
+                               {
+                upload_image(request.texture, img, request.isPanorama, generate);
+                finish(); }); });
+    }
+    return result;
+}
+
+size_t loaders::process_uploads(double budgetMs)
+{
+    AsyncLoader &loader = get_async_loader();
+    utils::ManualTimer timer;
+    timer.start();
+
+    size_t processed = 0;
+    while (true)
+    {
+        std::function<void()> upload;
+        {
+            std::lock_guard<std::mutex> lock(loader.uploadMutex);
+            if (loader.uploads.empty())
+                break;
+            upload = std::move(loader.uploads.front());
+            loader.uploads.pop_front();
+        }
+        upload();
+        processed++;
+
+        timer.stop();
+        if (budgetMs > 0.0 && timer.get() >= budgetMs)
+            break;
+    }
+    return processed;
+}
+
+namespace
+{
+    /*
+    Hot reload state, only touched from the GL thread. Every watched object knows how to re-import itself. Reloads are
+    tagged with a generation so that the ones superseded by a newer change, or whose object stopped being watched, are
+    dropped before swapping.
+    */
+    struct HotReloader
+    {
+        struct Watch
+        {
+            std::string path;                                // Absolute
+            std::function<std::function<void()>()> reimport; // Runs on a worker. Returns the GL thread side swap, empty if the import failed
+            uint64_t generation{0};
+        };
+
+        std::unique_ptr<utils::FileWatcher> watcher; // Created with the first watch
+        std::unordered_map<const void *, Watch> watches;
+        uint64_t generation{0};
+
+        bool is_current(const void *object, uint64_t reloadGeneration) const
+        {
+            auto it = watches.find(object);
+            return it != watches.end() && it->second.generation == reloadGeneration;
+        }
+
+        // Stops watching a file once no object is created from it
+        void release(const std::string &path)
+        {
+            for (const auto &watch : watches)
+                if (watch.second.path == path)
+                    return;
+            watcher->remove(path);
+        }
+    };
+
+    HotReloader &get_hot_reloader()
+    {
+        static HotReloader reloader;
+        return reloader;
+    }
+
+    bool watch(const void *object, const char *fileName, std::function<std::function<void()>()> &&reimport)
+    {
+        HotReloader &reloader = get_hot_reloader();
+        if (!reloader.watcher)
+            reloader.watcher.reset(new utils::FileWatcher());
+        if (!reloader.watcher->add(fileName))
+        {
+            ERR_LOG("Can not watch " << fileName << " for changes");
+            return false;
+        }
+        HotReloader::Watch &watch = reloader.watches[object];
+        const std::string previous = watch.path;
+        watch.path = utils::FileWatcher::get_absolute_path(fileName);
+        watch.reimport = std::move(reimport);
+        watch.generation = ++reloader.generation;
+        if (!previous.empty() && previous != watch.path)
+            reloader.release(previous);
+        return true;
+    }
+
+    /*
+    Buffers of the current geometry are reused if the new one has the same layout, otherwise it is replaced.
+    */
+    std::function<void()> swap_geometry(Mesh *const mesh, Geometry *imported)
+    {
+        if (!imported)
+            return {};
+        std::shared_ptr<Geometry> geometry(imported);
+        return [mesh, geometry]()
+        {
+            Geometry *current = mesh->get_geometry();
+            if (current && current->update_buffers(*geometry))
+                return;
+            Geometry *replacement = new Geometry(std::move(*geometry));
+            mesh->set_geometry(replacement);
+            replacement->generate_buffers();
+        };
+    }
+
+    std::function<void()> swap_levels(Texture *const texture, bool imported, TextureLevels &&levels)
+    {
+        if (!imported)
+            return {};
+        auto shared = std::make_shared<TextureLevels>(std::move(levels));
+        return [texture, shared]()
+        { texture->update_levels(std::move(*shared)); };
+    }
+}
+
+bool loaders::watch_OBJ(Mesh *const mesh, const char *fileName, bool importMaterials, bool calculateTangents, unsigned int LODCount)
+{
+    const std::string path = fileName;
+    return watch(mesh, fileName, [mesh, path, importMaterials, calculateTangents, LODCount]()
+                 { return swap_geometry(mesh, import_OBJ(path.c_str(), importMaterials, calculateTangents, LODCount)); });
+}
+
+bool loaders::watch_PLY(Mesh *const mesh, const char *fileName, bool preload, bool calculateTangents, unsigned int LODCount)
+{
+    const std::string path = fileName;
+    return watch(mesh, fileName, [mesh, path, preload, calculateTangents, LODCount]()
+                 { return swap_geometry(mesh, import_PLY(path.c_str(), preload, false, calculateTangents, LODCount)); });
+}
+
+bool loaders::watch_texture(Texture *const texture, const char *fileName, processing::MipSettings settings, const processing::BlockCompressionSettings *compression)
+{
+    const std::string path = fileName;
+    const bool compress = compression != nullptr;
+    const processing::BlockCompressionSettings compressionSettings = compress ? *compression : processing::BlockCompressionSettings{};
+    return watch(texture, fileName, [texture, path, settings, compress, compressionSettings]()
+                 {
+        TextureLevels levels;
+        const bool imported = import_texture_levels(path.c_str(), settings, compress ? &compressionSettings : nullptr, levels);
+        return swap_levels(texture, imported, std::move(levels)); });
+}
+
+bool loaders::watch_panorama(Texture *const texture, const char *fileName, processing::CubemapSettings settings)
+{
+    if (texture->get_config().type != TEXTURE_CUBEMAP)
+    {
+        ERR_LOG("Texture must be a CUBEMAP in order to load a panorama into it");
+        return false;
+    }
+    const std::string path = fileName;
+    return watch(texture, fileName, [texture, path, settings]()
+                 {
+        TextureLevels levels;
+        const bool imported = import_cubemap_levels(path.c_str(), settings, levels);
+        return swap_levels(texture, imported, std::move(levels)); });
+}
+
+bool loaders::watch_shader(Shader *const shader, const char *fileName)
+{
+    const std::string path = fileName;
+    return watch(shader, fileName, [shader, path]() -> std::function<void()>
+                 {
+        const ShaderStageSource source = Shader::parse_shader(path.c_str());
+        if (source.vertexBit.empty() && source.fragmentBit.empty())
+            return {};
+        return [shader, source, path]()
+        {
+            if (!shader->reload(source))
+                ERR_LOG("Keeping the previous program of " << path);
+        }; });
+}
+
+void loaders::unwatch(const void *object)
+{
+    HotReloader &reloader = get_hot_reloader();
+    auto it = reloader.watches.find(object);
+    if (it == reloader.watches.end())
+        return;
+    const std::string path = it->second.path;
+    reloader.watches.erase(it);
+    reloader.release(path);
+}
+
+size_t loaders::poll_hot_reload()
+{
+    HotReloader &reloader = get_hot_reloader();
+    if (!reloader.watcher)
+        return 0;
+    std::vector<std::string> changed;
+    if (reloader.watcher->poll(changed) == 0)
+        return 0;
+
+    AsyncLoader &loader = get_async_loader();
+    size_t started = 0;
+    for (auto &watch : reloader.watches)
+    {
+        if (std::find(changed.begin(), changed.end(), watch.second.path) == changed.end())
+            continue;
+        const void *const object = watch.first;
+        const uint64_t generation = watch.second.generation = ++reloader.generation;
+        loader.get_pool().enqueue([&loader, &reloader, object, generation, reimport = watch.second.reimport]()
+                                  {
+            std::function<void()> swap = reimport();
+            if (!swap)
+                return;
+            loader.push_upload([&reloader, object, generation, swap]()
+                               {
+                if (reloader.is_current(object, generation))
+                    swap(); }); });
+        started++;
+    }
+    return started;
+}
+GLSP_NAMESPACE_END
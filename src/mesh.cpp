@@ -12,18 +12,34 @@
 
 GLSP_NAMESPACE_BEGIN
 
-Geometry::Geometry(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int primitive) : m_VAO(), m_IBO(indices), m_vertexCount(vertices.size()), m_primitiveType{primitive}, m_vertexPerPatch(4)
+Geometry::Geometry(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int primitive) : m_VAO(), m_IBO(std::move(indices)), m_vertexCount(vertices.size()), m_primitiveType{primitive}, m_vertexPerPatch(4)
 {
     // ATTRIBUTE LAYOUT SETUP
     // Interleaved
     //    GL_CHECK(glBufferData(GL_ARRAY_BUFFER, vertexSize * m_geometry.vertices.size(), m_geometry.vertices.data(), GL_STATIC_DRAW));
-    VertexBuffer VBO(vertices.data(), vertices.size() * sizeof(Vertex));
+    VertexBuffer VBO(std::move(vertices));
     VBO.push_attribute_layout<float>(3);
     VBO.push_attribute_layout<float>(3);
     VBO.push_attribute_layout<float>(3);
     VBO.push_attribute_layout<float>(2);
     VBO.push_attribute_layout<float>(3);
-    m_VAO.push_vertex_buffer(VBO);
+    m_VAO.push_vertex_buffer(std::move(VBO));
+}
+
+Geometry::Geometry(MeshData &&data, unsigned int primitive) : m_VAO(), m_IBO({}), m_vertexCount(data.vertices.size()), m_primitiveType{primitive}, m_vertexPerPatch(4)
+{
+    std::shared_ptr<const MeshData> storage = std::make_shared<MeshData>(std::move(data));
+
+    VertexBuffer VBO(storage->vertices.data(), storage->vertices.size() * sizeof(Vertex), storage);
+    VBO.push_attribute_layout<float>(3);
+    VBO.push_attribute_layout<float>(3);
+    VBO.push_attribute_layout<float>(3);
+    VBO.push_attribute_layout<float>(2);
+    VBO.push_attribute_layout<float>(3);
+    m_VAO.push_vertex_buffer(std::move(VBO));
+    m_IBO = IndexBuffer(storage->indices.data(), storage->indices.size(), storage);
+    m_submeshes = storage->submeshes;
+    m_LODs = storage->LODs;
 }
 
 void Geometry::generate_buffers()
@@ -32,10 +48,19 @@ void Geometry::generate_buffers()
     // Manage indices
     if (!m_IBO.empty())
     {
-        m_VAO.bind();
         m_IBO.generate();
-        m_IBO.upload_data();
-        m_VAO.unbind();
+        if (uses_direct_state_access())
+        {
+            m_IBO.upload_data();
+            m_VAO.set_index_buffer(m_IBO);
+        }
+        else
+        {
+            // Uploaded inside the VAO, which keeps the element array binding
+            m_VAO.bind();
+            m_IBO.upload_data();
+            m_VAO.unbind();
+        }
 
         m_indexed = true;
     }
@@ -50,15 +75,77 @@ void Geometry::generate_buffers()
     m_buffer_loaded = true;
 }
 
+bool Geometry::update_buffers(const Geometry &source)
+{
+    if (!m_buffer_loaded || m_primitiveType != source.m_primitiveType || m_IBO.empty() != source.m_IBO.empty())
+        return false;
+    if (!m_VAO.update_vertex_buffers(source.m_VAO))
+        return false;
+    if (!m_IBO.empty() && uses_direct_state_access())
+        m_IBO.update_data(source.m_IBO);
+    else if (!m_IBO.empty())
+    {
+        m_VAO.bind();
+        m_IBO.update_data(source.m_IBO);
+        m_VAO.unbind();
+    }
+    m_vertexCount = source.m_vertexCount;
+    m_submeshes = source.m_submeshes;
+    m_LODs = source.m_LODs;
+    m_LOD = std::min(m_LOD, m_LODs.size());
+    return true;
+}
+
+void Geometry::release_data()
+{
+    if (!m_buffer_loaded)
+        return;
+    m_VAO.release_data();
+    m_IBO.release_data();
+}
+
 int Mesh::INSTANCED_MESHES = 0;
 
 void Mesh::set_geometry(Geometry *const g)
 {
+    if (m_geometry != g)
+        delete m_geometry;
     m_geometry = g;
 }
 
+void Mesh::set_submesh_material(unsigned int materialId, Material *const material)
+{
+    if (materialId >= m_submeshMaterials.size())
+        m_submeshMaterials.resize(materialId + 1, nullptr);
+    m_submeshMaterials[materialId] = material;
+}
+
+size_t Geometry::select_LOD(float maxError)
+{
+    m_LOD = 0;
+    while (m_LOD < m_LODs.size() && m_LODs[m_LOD].error <= maxError)
+        m_LOD++;
+    return m_LOD;
+}
+
+size_t Mesh::select_LOD(const glm::vec3 &cameraPosition, float fieldOfView, float viewportHeight, float pixelError)
+{
+    if (!m_geometry)
+        return 0;
+    // Object space error allowed at this distance, undoing the largest scale of the model matrix
+    const glm::mat4 model = get_model_matrix();
+    const float scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+    const float distance = glm::length(glm::vec3(model[3]) - cameraPosition);
+    const float worldError = pixelError * distance * 2.0f * std::tan(glm::radians(fieldOfView) * 0.5f) / std::max(viewportHeight, 1.0f);
+    return m_geometry->select_LOD(scale > 0.0f ? worldError / scale : 0.0f);
+}
+
 void Mesh::draw(bool useMaterial)
 {
+    // Geometry might still be loading asynchronously
+    if (!m_geometry)
+        return;
+
     if (m_enabled && m_geometry->is_buffer_loaded())
     {
         if (m_material && useMaterial)
@@ -66,9 +153,36 @@ void Mesh::draw(bool useMaterial)
 
         m_geometry->get_VAO().bind();
 
-        if (m_geometry->is_indexed() && m_geometry->get_primitive_type() != GL_PATCHES)
+        const std::vector<Submesh> &submeshes = m_geometry->get_draw_submeshes();
+        if (m_geometry->is_indexed() && m_geometry->get_primitive_type() != GL_PATCHES && !submeshes.empty())
+        {
+            // Every range is drawn from the same bound VAO, switching material only when needed
+            Material *bound = m_material && useMaterial ? m_material : nullptr;
+            for (const Submesh &submesh : submeshes)
+            {
+                if (useMaterial)
+                {
+                    // Ranges without a material of their own use the one of the mesh
+                    Material *material = submesh.materialId >= 0 ? get_submesh_material(submesh.materialId) : nullptr;
+                    material = material ? material : m_material;
+                    if (material != bound)
+                    {
+                        if (bound)
+                            bound->unbind();
+                        if (material)
+                            material->bind();
+                        bound = material;
+                    }
+                }
+                GL_CHECK(glDrawElementsBaseVertex(m_geometry->get_primitive_type(), submesh.indexCount, GL_UNSIGNED_INT,
+                                                  (void *)(submesh.indexOffset * sizeof(unsigned int)), submesh.baseVertex));
+            }
+            if (bound && bound != m_material)
+                bound->unbind();
+        }
+        else if (m_geometry->is_indexed() && m_geometry->get_primitive_type() != GL_PATCHES)
         {
-            GL_CHECK(glDrawElements(m_geometry->get_primitive_type(), m_geometry->get_IBO().get_indices().size(), GL_UNSIGNED_INT, (void *)0));
+            GL_CHECK(glDrawElements(m_geometry->get_primitive_type(), m_geometry->get_IBO().get_index_count(), GL_UNSIGNED_INT, (void *)0));
         }
         else
         {
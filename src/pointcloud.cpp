@@ -0,0 +1,782 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <queue>
+#include <bitset>
+#include <limits>
+#include <cstddef>
+#include <glm/gtc/matrix_access.hpp>
+#include <GLSP/pointcloud.h>
+#include <GLSP/loaders.h>
+
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    constexpr uint32_t OCTREE_MAGIC = 0x434F5047; // "GPOC"
+    constexpr uint32_t OCTREE_VERSION = 1;
+    constexpr unsigned int COUNTING_LEVEL = 6; // Grid of 64^3 cells used to split the cloud in chunks
+    constexpr unsigned int MAX_LEVEL = 18;     // Coincident points can not be split further. Keeps node keys in 64 bits
+    constexpr const char *HIERARCHY_FILE = "hierarchy.bin";
+    constexpr const char *POINTS_FILE = "points.bin";
+
+    struct OctreeHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        float origin[3];
+        float size;
+        float spacing;
+        uint32_t nodeCount;
+        uint64_t pointCount;
+    };
+
+    inline uint32_t pack_color(const glm::vec3 &color)
+    {
+        const glm::uvec3 c = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+        return c.r | (c.g << 8) | (c.b << 16) | (255u << 24);
+    }
+
+    inline uint64_t spread_bits(uint32_t v)
+    {
+        uint64_t x = v & 0x1FFFFF;
+        x = (x | x << 32) & 0x1F00000000FFFFull;
+        x = (x | x << 16) & 0x1F0000FF0000FFull;
+        x = (x | x << 8) & 0x100F00F00F00F00Full;
+        x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+        x = (x | x << 2) & 0x1249249249249249ull;
+        return x;
+    }
+
+    inline uint64_t morton_code(uint32_t x, uint32_t y, uint32_t z)
+    {
+        return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+    }
+
+    /*
+    Cell of a point in the regular grid of a level. Scaling by powers of two is exact, so the cell of a level is
+    always the parent of the cell in the next one.
+    */
+    inline glm::uvec3 cell_of(const glm::vec3 &position, float size, unsigned int level)
+    {
+        const float cells = float(1u << level);
+        const glm::vec3 cell = glm::clamp(position / size * cells, 0.0f, cells - 1.0f);
+        return glm::uvec3(cell);
+    }
+
+    /*
+    Node while building, its points live in a file of the build directory.
+    */
+    struct BuildNode
+    {
+        uint8_t level;
+        uint32_t x, y, z;
+        uint32_t pointCount;
+        int file;
+        uint64_t fileOffset; // In points
+    };
+
+    /*
+    Sorts by level and then by Morton code
+    */
+    inline uint64_t node_key(const BuildNode &node)
+    {
+        return uint64_t(node.level) << 58 | morton_code(node.x, node.y, node.z);
+    }
+
+    /*
+    Keeps the first point falling in every cell of a regular grid over the node, which spaces the kept points
+    by the size of a cell. Cells are tagged with a stamp per node so the grid is never cleared.
+    */
+    class GridSampler
+    {
+        std::vector<uint32_t> m_stamps;
+        uint32_t m_stamp{0};
+        unsigned int m_resolution;
+
+    public:
+        GridSampler(unsigned int resolution) : m_stamps(size_t(resolution) * resolution * resolution, 0), m_resolution(resolution) {}
+
+        void sample(const std::vector<PointRecord> &points, const glm::vec3 &nodeMin, float nodeSize,
+                    std::vector<PointRecord> &accepted, std::vector<PointRecord> &rejected)
+        {
+            if (++m_stamp == 0)
+            {
+                std::fill(m_stamps.begin(), m_stamps.end(), 0);
+                m_stamp = 1;
+            }
+            const float cells = float(m_resolution);
+            for (const PointRecord &point : points)
+            {
+                const glm::uvec3 c = glm::uvec3(glm::clamp((point.position - nodeMin) / nodeSize * cells, 0.0f, cells - 1.0f));
+                uint32_t &stamp = m_stamps[(size_t(c.z) * m_resolution + c.y) * m_resolution + c.x];
+                if (stamp != m_stamp)
+                {
+                    stamp = m_stamp;
+                    accepted.push_back(point);
+                }
+                else
+                    rejected.push_back(point);
+            }
+        }
+    };
+
+    bool read_records(const std::string &path, uint64_t offset, size_t count, std::vector<PointRecord> &records)
+    {
+        records.resize(count);
+        if (count == 0)
+            return true;
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(offset * sizeof(PointRecord));
+        file.read(reinterpret_cast<char *>(records.data()), count * sizeof(PointRecord));
+        return bool(file);
+    }
+
+    bool write_records(const std::string &path, const std::vector<PointRecord> &records, bool append)
+    {
+        std::ofstream file(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(PointRecord));
+        return bool(file);
+    }
+
+    struct OctreeBuilder
+    {
+        PointOctreeSettings settings;
+        std::filesystem::path directory;
+        float size;
+        float spacing;
+
+        std::vector<std::string> files;
+        std::mutex filesMutex;
+
+        int add_file(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(filesMutex);
+            files.push_back((directory / name).string());
+            return int(files.size() - 1);
+        }
+
+        std::string get_file(int file)
+        {
+            std::lock_guard<std::mutex> lock(filesMutex);
+            return files[file];
+        }
+
+        inline glm::vec3 node_min(unsigned int level, uint32_t x, uint32_t y, uint32_t z) const
+        {
+            return glm::vec3(x, y, z) * (size / float(1u << level));
+        }
+
+        /*
+        Splits the points of a chunk into a local octree, appending every node but its root to the nodes file.
+        */
+        bool build_subtree(std::vector<PointRecord> &&points, uint8_t level, uint32_t x, uint32_t y, uint32_t z,
+                           GridSampler &sampler, int nodesFile, uint64_t &fileSize, std::vector<BuildNode> &nodes,
+                           std::vector<PointRecord> &rootPoints)
+        {
+            std::vector<PointRecord> kept;
+            std::vector<PointRecord> rejected;
+            if (points.size() <= settings.maxNodePoints || level >= MAX_LEVEL)
+                kept = std::move(points);
+            else
+                sampler.sample(points, node_min(level, x, y, z), size / float(1u << level), kept, rejected);
+            std::vector<PointRecord>().swap(points);
+
+            const bool isRoot = nodes.empty();
+            nodes.push_back({level, x, y, z, uint32_t(kept.size()), isRoot ? -1 : nodesFile, isRoot ? 0 : fileSize});
+            if (isRoot)
+                rootPoints = std::move(kept);
+            else
+            {
+                if (!write_records(get_file(nodesFile), kept, true))
+                    return false;
+                fileSize += kept.size();
+            }
+
+            std::vector<PointRecord> children[8];
+            for (const PointRecord &point : rejected)
+            {
+                const glm::uvec3 c = cell_of(point.position, size, level + 1);
+                children[(c.x & 1) | (c.y & 1) << 1 | (c.z & 1) << 2].push_back(point);
+            }
+            std::vector<PointRecord>().swap(rejected);
+            for (uint32_t i = 0; i < 8; i++)
+                if (!children[i].empty() &&
+                    !build_subtree(std::move(children[i]), level + 1, x * 2 + (i & 1), y * 2 + (i >> 1 & 1), z * 2 + (i >> 2), sampler,
+                                   nodesFile, fileSize, nodes, rootPoints))
+                    return false;
+            return true;
+        }
+    };
+}
+
+bool PointCloud::build_octree(const char *fileName, const char *directory, PointOctreeSettings settings)
+{
+    utils::ManualTimer timer;
+    timer.start();
+
+    settings.gridResolution = std::max(settings.gridResolution, 2u) & ~1u; // Even, so grid cells never straddle two children
+    settings.maxNodePoints = std::max<size_t>(settings.maxNodePoints, 1);
+    const unsigned int threadCount = settings.threadCount ? settings.threadCount : utils::get_thread_count();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (!std::filesystem::is_directory(directory))
+    {
+        ERR_LOG("Could not create octree directory " << directory);
+        return false;
+    }
+
+    // Bounds
+    glm::vec3 minBound(std::numeric_limits<float>::max());
+    glm::vec3 maxBound(std::numeric_limits<float>::lowest());
+    uint64_t pointCount = 0;
+    if (!loaders::stream_PLY(fileName, [&](const Vertex *vertices, size_t count)
+                             {
+                                 for (size_t i = 0; i < count; i++)
+                                 {
+                                     minBound = glm::min(minBound, vertices[i].position);
+                                     maxBound = glm::max(maxBound, vertices[i].position);
+                                 }
+                                 pointCount += count;
+                                 return true; }))
+        return false;
+    if (pointCount == 0)
+    {
+        ERR_LOG("Empty point cloud " << fileName);
+        return false;
+    }
+
+    OctreeBuilder builder;
+    builder.settings = settings;
+    builder.directory = directory;
+    const glm::vec3 extent = maxBound - minBound;
+    builder.size = std::max(std::max(extent.x, extent.y), std::max(extent.z, std::numeric_limits<float>::min())) * 1.0001f;
+    builder.spacing = builder.size / float(settings.gridResolution);
+
+    // Counting grid, then chunks as the largest cells under the chunk size
+    const uint32_t gridCells = 1u << COUNTING_LEVEL;
+    std::vector<uint32_t> counts(size_t(gridCells) * gridCells * gridCells, 0);
+    auto grid_index = [gridCells](uint32_t x, uint32_t y, uint32_t z)
+    { return (size_t(z) * gridCells + y) * gridCells + x; };
+    if (!loaders::stream_PLY(fileName, [&](const Vertex *vertices, size_t count)
+                             {
+                                 for (size_t i = 0; i < count; i++)
+                                 {
+                                     const glm::uvec3 c = cell_of(vertices[i].position - minBound, builder.size, COUNTING_LEVEL);
+                                     counts[grid_index(c.x, c.y, c.z)]++;
+                                 }
+                                 return true; }))
+        return false;
+
+    struct Chunk
+    {
+        uint8_t level;
+        uint32_t x, y, z;
+        uint64_t pointCount;
+    };
+    std::vector<Chunk> chunks;
+    std::vector<int> cellChunks(counts.size(), -1);
+    std::function<void(uint8_t, uint32_t, uint32_t, uint32_t)> split = [&](uint8_t level, uint32_t x, uint32_t y, uint32_t z)
+    {
+        const uint32_t span = 1u << (COUNTING_LEVEL - level);
+        uint64_t count = 0;
+        for (uint32_t k = z * span; k < (z + 1) * span; k++)
+            for (uint32_t j = y * span; j < (y + 1) * span; j++)
+                for (uint32_t i = x * span; i < (x + 1) * span; i++)
+                    count += counts[grid_index(i, j, k)];
+        if (count == 0)
+            return;
+        if (count > settings.chunkPoints && level < COUNTING_LEVEL)
+        {
+            for (uint32_t i = 0; i < 8; i++)
+                split(level + 1, x * 2 + (i & 1), y * 2 + (i >> 1 & 1), z * 2 + (i >> 2));
+            return;
+        }
+        for (uint32_t k = z * span; k < (z + 1) * span; k++)
+            for (uint32_t j = y * span; j < (y + 1) * span; j++)
+                for (uint32_t i = x * span; i < (x + 1) * span; i++)
+                    cellChunks[grid_index(i, j, k)] = int(chunks.size());
+        chunks.push_back({level, x, y, z, count});
+    };
+    split(0, 0, 0, 0);
+    std::vector<uint32_t>().swap(counts);
+
+    // Distribution of the points to a file per chunk, through buffers bounded by the memory budget
+    std::vector<int> chunkFiles(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+        chunkFiles[i] = builder.add_file("chunk_" + std::to_string(i) + ".points");
+    {
+        std::vector<std::vector<PointRecord>> buffers(chunks.size());
+        const size_t bufferedCapacity = std::max<size_t>(settings.memoryBudget / sizeof(PointRecord), 1);
+        size_t buffered = 0;
+        bool written = true;
+        auto flush = [&]()
+        {
+            for (size_t i = 0; i < buffers.size(); i++)
+                if (!buffers[i].empty())
+                {
+                    written = written && write_records(builder.files[chunkFiles[i]], buffers[i], true);
+                    std::vector<PointRecord>().swap(buffers[i]);
+                }
+            buffered = 0;
+        };
+        for (const int file : chunkFiles)
+            std::ofstream(builder.files[file], std::ios::binary | std::ios::trunc);
+        if (!loaders::stream_PLY(fileName, [&](const Vertex *vertices, size_t count)
+                                 {
+                                     for (size_t i = 0; i < count; i++)
+                                     {
+                                         const glm::vec3 position = vertices[i].position - minBound;
+                                         const glm::uvec3 c = cell_of(position, builder.size, COUNTING_LEVEL);
+                                         buffers[cellChunks[grid_index(c.x, c.y, c.z)]].push_back({position, pack_color(vertices[i].color)});
+                                     }
+                                     buffered += count;
+                                     if (buffered >= bufferedCapacity)
+                                         flush();
+                                     return written; }))
+            return false;
+        flush();
+        if (!written)
+        {
+            ERR_LOG("Could not write the chunks of the octree in " << directory);
+            return false;
+        }
+    }
+
+    // Local octrees of the chunks, in parallel. Their roots go to a file of their own since upper levels take points from them
+    std::vector<std::vector<BuildNode>> chunkNodes(chunks.size());
+    std::vector<int> nodesFiles(chunks.size());
+    std::vector<int> rootFiles(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        nodesFiles[i] = builder.add_file("chunk_" + std::to_string(i) + ".nodes");
+        rootFiles[i] = builder.add_file("chunk_" + std::to_string(i) + ".root");
+    }
+    {
+        utils::ThreadPool pool(threadCount);
+        std::vector<std::future<bool>> results;
+        for (size_t i = 0; i < chunks.size(); i++)
+            results.push_back(pool.submit([&, i]()
+                                          {
+                                              GridSampler sampler(settings.gridResolution);
+                                              std::vector<PointRecord> points;
+                                              const std::string pointsFile = builder.get_file(chunkFiles[i]);
+                                              if (!read_records(pointsFile, 0, size_t(chunks[i].pointCount), points))
+                                                  return false;
+                                              std::filesystem::remove(pointsFile);
+                                              std::ofstream(builder.get_file(nodesFiles[i]), std::ios::binary | std::ios::trunc);
+
+                                              uint64_t fileSize = 0;
+                                              std::vector<PointRecord> rootPoints;
+                                              const Chunk &chunk = chunks[i];
+                                              if (!builder.build_subtree(std::move(points), chunk.level, chunk.x, chunk.y, chunk.z, sampler,
+                                                                         nodesFiles[i], fileSize, chunkNodes[i], rootPoints))
+                                                  return false;
+                                              chunkNodes[i][0].file = rootFiles[i];
+                                              return write_records(builder.get_file(rootFiles[i]), rootPoints, false); }));
+        bool built = true;
+        for (auto &result : results)
+            built = result.get() && built;
+        if (!built)
+        {
+            ERR_LOG("Could not build the chunks of the octree in " << directory);
+            return false;
+        }
+    }
+
+    // Upper levels, bottom up. Every parent samples the points of its children, which keep the rest
+    std::vector<BuildNode> nodes;
+    std::unordered_map<uint64_t, size_t> topNodes; // Nodes whose points can still be taken by a parent
+    uint8_t deepestChunk = 0;
+    for (auto &local : chunkNodes)
+    {
+        topNodes[node_key(local[0])] = nodes.size();
+        deepestChunk = std::max(deepestChunk, local[0].level);
+        nodes.insert(nodes.end(), local.begin(), local.end());
+        std::vector<BuildNode>().swap(local);
+    }
+    for (int level = int(deepestChunk); level > 0; level--)
+    {
+        std::unordered_map<uint64_t, std::vector<size_t>> parents;
+        for (const auto &top : topNodes)
+        {
+            const BuildNode &node = nodes[top.second];
+            if (node.level == level)
+                parents[uint64_t(level - 1) << 58 | morton_code(node.x >> 1, node.y >> 1, node.z >> 1)].push_back(top.second);
+        }
+        std::vector<std::pair<uint64_t, std::vector<size_t>>> groups(parents.begin(), parents.end());
+        std::vector<BuildNode> created(groups.size());
+
+        utils::ThreadPool pool(threadCount);
+        std::vector<std::future<bool>> results;
+        for (size_t g = 0; g < groups.size(); g++)
+            results.push_back(pool.submit([&, g]()
+                                          {
+                                              GridSampler sampler(settings.gridResolution);
+                                              const std::vector<size_t> &children = groups[g].second;
+                                              const BuildNode &first = nodes[children[0]];
+                                              BuildNode parent{uint8_t(level - 1), first.x >> 1, first.y >> 1, first.z >> 1, 0, -1, 0};
+
+                                              std::vector<PointRecord> kept;
+                                              for (const size_t child : children)
+                                              {
+                                                  BuildNode &node = nodes[child];
+                                                  std::vector<PointRecord> points, rejected;
+                                                  const std::string path = builder.get_file(node.file);
+                                                  if (!read_records(path, node.fileOffset, node.pointCount, points))
+                                                      return false;
+                                                  // Grid cells of the parent never straddle two children, so children can be sampled one by one
+                                                  sampler.sample(points, builder.node_min(parent.level, parent.x, parent.y, parent.z),
+                                                                 builder.size / float(1u << parent.level), kept, rejected);
+                                                  node.pointCount = uint32_t(rejected.size());
+                                                  if (!write_records(path, rejected, false))
+                                                      return false;
+                                              }
+                                              parent.pointCount = uint32_t(kept.size());
+                                              parent.file = builder.add_file("upper_" + std::to_string(level - 1) + "_" + std::to_string(g) + ".root");
+                                              created[g] = parent;
+                                              return write_records(builder.get_file(parent.file), kept, false); }));
+        bool built = true;
+        for (auto &result : results)
+            built = result.get() && built;
+        if (!built)
+        {
+            ERR_LOG("Could not build the hierarchy of the octree in " << directory);
+            return false;
+        }
+        for (const BuildNode &parent : created)
+        {
+            topNodes[node_key(parent)] = nodes.size();
+            nodes.push_back(parent);
+        }
+    }
+
+    // Breadth first order, where siblings are contiguous since they share the prefix of their Morton codes
+    std::sort(nodes.begin(), nodes.end(), [](const BuildNode &a, const BuildNode &b)
+              { return node_key(a) < node_key(b); });
+    {
+        std::unordered_map<uint64_t, size_t> indices;
+        std::vector<uint8_t> hasChildren(nodes.size(), 0);
+        for (size_t i = 0; i < nodes.size(); i++)
+            indices[node_key(nodes[i])] = i;
+        for (const BuildNode &node : nodes)
+            if (node.level > 0)
+                hasChildren[indices[uint64_t(node.level - 1) << 58 | morton_code(node.x >> 1, node.y >> 1, node.z >> 1)]] = 1;
+        // Roots of chunks emptied by their parents are dropped if they have nothing under them
+        size_t kept = 0;
+        for (size_t i = 0; i < nodes.size(); i++)
+            if (nodes[i].pointCount > 0 || hasChildren[i])
+                nodes[kept++] = nodes[i];
+        nodes.resize(kept);
+    }
+
+    std::vector<PointCloudNode> hierarchy(nodes.size());
+    std::unordered_map<uint64_t, size_t> indices;
+    for (size_t i = 0; i < nodes.size(); i++)
+        indices[node_key(nodes[i])] = i;
+    const std::filesystem::path pointsPath = builder.directory / POINTS_FILE;
+    {
+        std::ofstream points(pointsPath, std::ios::binary | std::ios::trunc);
+        std::vector<PointRecord> records;
+        uint64_t offset = 0;
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const BuildNode &node = nodes[i];
+            hierarchy[i] = {offset, node.pointCount, 0, 0, node.level, 0, node.x, node.y, node.z};
+            if (node.level > 0)
+            {
+                PointCloudNode &parent = hierarchy[indices[uint64_t(node.level - 1) << 58 | morton_code(node.x >> 1, node.y >> 1, node.z >> 1)]];
+                if (parent.childMask == 0)
+                    parent.firstChild = uint32_t(i);
+                parent.childMask |= 1 << ((node.x & 1) | (node.y & 1) << 1 | (node.z & 1) << 2);
+            }
+            if (!read_records(builder.files[node.file], node.fileOffset, node.pointCount, records))
+            {
+                ERR_LOG("Could not read the nodes of the octree in " << directory);
+                return false;
+            }
+            points.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(PointRecord));
+            offset += node.pointCount;
+        }
+        if (!points || offset != pointCount)
+        {
+            ERR_LOG("Could not write the points of the octree in " << directory);
+            return false;
+        }
+    }
+    for (const std::string &file : builder.files)
+        std::filesystem::remove(file, error);
+
+    OctreeHeader header{OCTREE_MAGIC, OCTREE_VERSION, {minBound.x, minBound.y, minBound.z}, builder.size, builder.spacing, uint32_t(hierarchy.size()), pointCount};
+    std::ofstream file(builder.directory / HIERARCHY_FILE, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(hierarchy.data()), hierarchy.size() * sizeof(PointCloudNode));
+    if (!file)
+    {
+        ERR_LOG("Could not write the hierarchy of the octree in " << directory);
+        return false;
+    }
+
+    timer.stop();
+    DEBUG_LOG("Point octree of " << pointCount << " points in " << hierarchy.size() << " nodes, " << chunks.size() << " chunks, built in " << timer.get() / 1000.0 << " seconds");
+    return true;
+}
+
+PointCloud::PointCloud(const char *directory, PointCloudSettings settings) : Mesh(), m_settings(settings)
+{
+    set_name("PointCloud");
+    try
+    {
+        const std::filesystem::path path(directory);
+        const utils::MappedFile hierarchy((path / HIERARCHY_FILE).string(), utils::FILE_ACCESS_SEQUENTIAL);
+        OctreeHeader header;
+        if (hierarchy.get_size() < sizeof(header))
+            throw std::runtime_error("truncated octree hierarchy");
+        memcpy(&header, hierarchy.get_data(), sizeof(header));
+        if (header.magic != OCTREE_MAGIC || header.version != OCTREE_VERSION || header.nodeCount == 0 ||
+            hierarchy.get_size() != sizeof(header) + size_t(header.nodeCount) * sizeof(PointCloudNode))
+            throw std::runtime_error("invalid octree hierarchy");
+
+        std::vector<PointCloudNode> nodes(header.nodeCount);
+        memcpy(nodes.data(), hierarchy.get_data() + sizeof(header), nodes.size() * sizeof(PointCloudNode));
+        m_points.reset(new utils::MappedFile((path / POINTS_FILE).string(), utils::FILE_ACCESS_RANDOM));
+        const uint64_t filePoints = m_points->get_size() / sizeof(PointRecord);
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const PointCloudNode &node = nodes[i];
+            if (node.offset > filePoints || node.pointCount > filePoints - node.offset ||
+                (node.childMask && (node.firstChild <= i || size_t(node.firstChild) + std::bitset<8>(node.childMask).count() > nodes.size())))
+                throw std::runtime_error("corrupted octree hierarchy");
+            m_slotPoints = std::max<size_t>(m_slotPoints, node.pointCount);
+        }
+
+        m_origin = glm::vec3(header.origin[0], header.origin[1], header.origin[2]);
+        m_size = header.size;
+        m_spacing = header.spacing;
+        m_pointCount = header.pointCount;
+        m_nodes = std::move(nodes);
+        m_nodeSlots.assign(m_nodes.size(), -1);
+        m_pending.assign(m_nodes.size(), 0);
+        m_loader.reset(new utils::ThreadPool(1));
+        set_position(m_origin);
+    }
+    catch (const std::exception &e)
+    {
+        ERR_LOG("Could not open point octree " << directory << ": " << e.what());
+    }
+}
+
+const std::vector<uint32_t> &PointCloud::select_nodes(const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight)
+{
+    m_visibleNodes.clear();
+    if (m_nodes.empty())
+        return m_visibleNodes;
+
+    // Frustum planes in the space of the octree
+    const glm::mat4 modelView = view * get_model_matrix();
+    const glm::mat4 viewProjection = projection * modelView;
+    glm::vec4 planes[6];
+    for (int i = 0; i < 3; i++)
+    {
+        planes[i * 2] = glm::row(viewProjection, 3) + glm::row(viewProjection, i);
+        planes[i * 2 + 1] = glm::row(viewProjection, 3) - glm::row(viewProjection, i);
+    }
+    const glm::vec3 cameraPosition = glm::vec3(glm::inverse(modelView)[3]);
+    const bool perspective = projection[3][3] == 0.0f;
+    // Pixels covered by a unit of length at unit distance, or at any distance in orthographic projections
+    const float pixelScale = projection[1][1] * viewportHeight * 0.5f;
+
+    auto inside = [&](const PointCloudNode &node)
+    {
+        const float nodeSize = m_size / float(1u << node.level);
+        const glm::vec3 nodeMin = glm::vec3(node.x, node.y, node.z) * nodeSize;
+        for (const glm::vec4 &plane : planes)
+        {
+            // Corner furthest along the plane normal
+            const glm::vec3 corner = nodeMin + glm::vec3(plane.x >= 0.0f, plane.y >= 0.0f, plane.z >= 0.0f) * nodeSize;
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    };
+    auto projected_spacing = [&](const PointCloudNode &node)
+    {
+        const float nodeSize = m_size / float(1u << node.level);
+        const float spacing = m_spacing / float(1u << node.level) * pixelScale;
+        if (!perspective)
+            return spacing;
+        const glm::vec3 center = (glm::vec3(node.x, node.y, node.z) + 0.5f) * nodeSize;
+        const float distance = glm::length(center - cameraPosition) - nodeSize * 0.8660254f;
+        return distance > 0.0f ? spacing / distance : std::numeric_limits<float>::max();
+    };
+
+    std::priority_queue<std::pair<float, uint32_t>> queue;
+    if (inside(m_nodes[0]))
+        queue.push({projected_spacing(m_nodes[0]), 0});
+    size_t points = 0;
+    while (!queue.empty())
+    {
+        const auto [spacing, index] = queue.top();
+        queue.pop();
+        const PointCloudNode &node = m_nodes[index];
+        if (points + node.pointCount > m_settings.pointBudget)
+            break;
+        points += node.pointCount;
+        m_visibleNodes.push_back(index);
+        if (spacing <= m_settings.pointSpacing)
+            continue;
+
+        uint32_t child = node.firstChild;
+        for (int i = 0; i < 8; i++)
+            if (node.childMask & (1 << i))
+            {
+                if (inside(m_nodes[child]))
+                    queue.push({projected_spacing(m_nodes[child]), child});
+                child++;
+            }
+    }
+    return m_visibleNodes;
+}
+
+void PointCloud::create_pool()
+{
+    const size_t slotBytes = std::max<size_t>(m_slotPoints, 1) * sizeof(PointRecord);
+    size_t slotCount = std::max<size_t>(m_settings.memoryBudget / slotBytes, 1);
+    slotCount = std::min(slotCount, m_nodes.size());
+    // Draw offsets are ints
+    slotCount = std::min(slotCount, size_t(std::numeric_limits<int>::max()) / std::max<size_t>(m_slotPoints, 1));
+
+    m_slotNodes.assign(slotCount, std::numeric_limits<uint32_t>::max());
+    m_slotFrames.assign(slotCount, 0);
+    m_freeSlots.resize(slotCount);
+    for (size_t i = 0; i < slotCount; i++)
+        m_freeSlots[i] = int(slotCount - 1 - i);
+
+    VertexBuffer VBO(nullptr, slotCount * slotBytes, nullptr);
+    VBO.push_attribute_layout(AttributeLayout{GL_FLOAT, 3, GL_FALSE, 0, int(offsetof(PointRecord, position))});
+    VBO.push_attribute_layout(AttributeLayout{GL_UNSIGNED_BYTE, 4, GL_TRUE, 4, int(offsetof(PointRecord, color))});
+    VertexArray VAO;
+    VAO.push_vertex_buffer(std::move(VBO));
+    Geometry *geometry = new Geometry(std::move(VAO), slotCount * m_slotPoints, GL_POINTS);
+    geometry->generate_buffers();
+    set_geometry(geometry);
+}
+
+void PointCloud::request_node(uint32_t node)
+{
+    m_pending[node] = 1;
+    m_pendingLoads++;
+    m_loader->enqueue([this, node]()
+                      {
+                          // Reading the mapped range pages it in here instead of in the GL thread
+                          const PointCloudNode &info = m_nodes[node];
+                          const PointRecord *points = reinterpret_cast<const PointRecord *>(m_points->get_data()) + info.offset;
+                          LoadedNode loaded{node, std::vector<PointRecord>(points, points + info.pointCount)};
+                          std::lock_guard<std::mutex> lock(m_loadedMutex);
+                          m_loaded.push_back(std::move(loaded)); });
+}
+
+int PointCloud::acquire_slot()
+{
+    if (!m_freeSlots.empty())
+    {
+        const int slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        return slot;
+    }
+    // Least recently used, as long as it is not needed in this frame
+    int slot = -1;
+    for (size_t i = 0; i < m_slotFrames.size(); i++)
+        if (m_slotFrames[i] < m_frame && (slot < 0 || m_slotFrames[i] < m_slotFrames[slot]))
+            slot = int(i);
+    if (slot >= 0)
+        m_nodeSlots[m_slotNodes[slot]] = -1;
+    return slot;
+}
+
+void PointCloud::update(Camera *const camera, float viewportHeight)
+{
+    if (m_nodes.empty())
+        return;
+    if (!m_geometry)
+        create_pool();
+    m_frame++;
+
+    select_nodes(camera->get_view(), camera->get_projection(), viewportHeight);
+    for (const uint32_t node : m_visibleNodes)
+    {
+        const int slot = m_nodeSlots[node];
+        if (slot >= 0)
+            m_slotFrames[slot] = m_frame;
+        else if (!m_pending[node] && m_pendingLoads < m_settings.maxPendingLoads)
+            request_node(node);
+    }
+
+    const VertexBuffer &VBO = m_geometry->get_VAO().get_vertex_buffers()[0];
+    utils::ManualTimer timer;
+    timer.start();
+    for (;;)
+    {
+        LoadedNode loaded;
+        {
+            std::lock_guard<std::mutex> lock(m_loadedMutex);
+            if (m_loaded.empty())
+                break;
+            loaded = std::move(m_loaded.front());
+            m_loaded.pop_front();
+        }
+        m_pending[loaded.node] = 0;
+        m_pendingLoads--;
+        // Without a slot the node is dropped and requested again in a later frame
+        const int slot = acquire_slot();
+        if (slot >= 0)
+        {
+            VBO.upload_data(loaded.points.size() * sizeof(PointRecord), loaded.points.data(), size_t(slot) * m_slotPoints * sizeof(PointRecord));
+            m_nodeSlots[loaded.node] = slot;
+            m_slotNodes[slot] = loaded.node;
+            m_slotFrames[slot] = m_frame;
+        }
+        timer.stop();
+        if (timer.get() > m_settings.uploadBudget)
+            break;
+    }
+
+    m_drawFirsts.clear();
+    m_drawCounts.clear();
+    m_drawnPoints = 0;
+    for (const uint32_t node : m_visibleNodes)
+    {
+        const int slot = m_nodeSlots[node];
+        if (slot < 0 || m_nodes[node].pointCount == 0)
+            continue;
+        m_drawFirsts.push_back(int(size_t(slot) * m_slotPoints));
+        m_drawCounts.push_back(int(m_nodes[node].pointCount));
+        m_drawnPoints += m_nodes[node].pointCount;
+    }
+}
+
+void PointCloud::draw(bool useMaterial)
+{
+    if (!m_enabled || !m_geometry || !m_geometry->is_buffer_loaded() || m_drawCounts.empty())
+        return;
+
+    if (m_material && useMaterial)
+        m_material->bind();
+
+    m_geometry->get_VAO().bind();
+    GL_CHECK(glMultiDrawArrays(GL_POINTS, m_drawFirsts.data(), m_drawCounts.data(), GLsizei(m_drawCounts.size())));
+    m_geometry->get_VAO().unbind();
+
+    if (m_material && useMaterial)
+        m_material->unbind();
+}
+
+GLSP_NAMESPACE_END
@@ -0,0 +1,1625 @@
+/*
+    This file is part of OpenGL-StarterPack (GLSP), an open source OpenGL based framework
+    that facilitates and speeds up demo and project creation by offering an abstraction to
+    the basic objects of OpenGL as well as incluing the necessary libraries.
+
+    MIT License
+
+    Copyright (c) 2024 Antonio Espinosa Garcia
+
+*/
+#include <GLSP/processing.h>
+#include <glm/gtc/packing.hpp>
+#include <unordered_map>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLSP_SSE2
+#include <emmintrin.h>
+#endif
+
+GLSP_NAMESPACE_BEGIN
+
+namespace
+{
+    const float TANGENT_EPSILON = 1e-6f;
+
+    /*
+    Any unit vector perpendicular to the normal. Used when the uv mapping gives no usable direction.
+    */
+    inline glm::vec3 get_perpendicular(const glm::vec3 &normal)
+    {
+        if (glm::dot(normal, normal) < TANGENT_EPSILON * TANGENT_EPSILON)
+            return glm::vec3(1.0f, 0.0f, 0.0f);
+        const glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(glm::cross(normal, axis), normal));
+    }
+
+    inline glm::vec3 orthonormalize_tangent(glm::vec3 normal, glm::vec3 tangent)
+    {
+        const float normalLength = glm::length(normal);
+        if (normalLength > TANGENT_EPSILON)
+        {
+            normal /= normalLength;
+            tangent -= normal * glm::dot(normal, tangent);
+        }
+        const float tangentLength = glm::length(tangent);
+        return tangentLength > TANGENT_EPSILON ? tangent / tangentLength : get_perpendicular(normal);
+    }
+
+    /*
+    Gram-Schmidt of the accumulated tangents against the vertex normals. Four vertices per iteration when SSE2 is available.
+    */
+    void orthonormalize_tangents(Vertex *vertices, const glm::vec3 *tangents, size_t count)
+    {
+        size_t i = 0;
+#ifdef GLSP_SSE2
+        const __m128 EPSILON = _mm_set1_ps(TANGENT_EPSILON * TANGENT_EPSILON);
+        const __m128 ONE = _mm_set1_ps(1.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            const Vertex *v = vertices + i;
+            const glm::vec3 *t = tangents + i;
+
+            // Transpose to SoA
+            __m128 nx = _mm_setr_ps(v[0].normal.x, v[1].normal.x, v[2].normal.x, v[3].normal.x);
+            __m128 ny = _mm_setr_ps(v[0].normal.y, v[1].normal.y, v[2].normal.y, v[3].normal.y);
+            __m128 nz = _mm_setr_ps(v[0].normal.z, v[1].normal.z, v[2].normal.z, v[3].normal.z);
+            __m128 tx = _mm_setr_ps(t[0].x, t[1].x, t[2].x, t[3].x);
+            __m128 ty = _mm_setr_ps(t[0].y, t[1].y, t[2].y, t[3].y);
+            __m128 tz = _mm_setr_ps(t[0].z, t[1].z, t[2].z, t[3].z);
+
+            // Normalize normals, zero normals stay zero and leave the tangent untouched
+            const __m128 nn = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+            const __m128 nInverse = _mm_and_ps(_mm_cmpgt_ps(nn, EPSILON), _mm_div_ps(ONE, _mm_sqrt_ps(_mm_max_ps(nn, EPSILON))));
+            nx = _mm_mul_ps(nx, nInverse);
+            ny = _mm_mul_ps(ny, nInverse);
+            nz = _mm_mul_ps(nz, nInverse);
+
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+            tx = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+            ty = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+            tz = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+
+            const __m128 tt = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+            const __m128 valid = _mm_cmpgt_ps(tt, EPSILON);
+            const __m128 tInverse = _mm_div_ps(ONE, _mm_sqrt_ps(_mm_max_ps(tt, EPSILON)));
+            tx = _mm_mul_ps(tx, tInverse);
+            ty = _mm_mul_ps(ty, tInverse);
+            tz = _mm_mul_ps(tz, tInverse);
+
+            alignas(16) float x[4], y[4], z[4];
+            _mm_store_ps(x, tx);
+            _mm_store_ps(y, ty);
+            _mm_store_ps(z, tz);
+            const int mask = _mm_movemask_ps(valid);
+            for (int k = 0; k < 4; k++)
+                vertices[i + k].tangent = (mask >> k) & 1 ? glm::vec3(x[k], y[k], z[k]) : get_perpendicular(vertices[i + k].normal);
+        }
+#endif
+        for (; i < count; i++)
+            vertices[i].tangent = orthonormalize_tangent(vertices[i].normal, tangents[i]);
+    }
+}
+
+void processing::compute_tangents(MeshData &data, unsigned int threadCount)
+{
+    std::vector<Vertex> &vertices = data.vertices;
+    const std::vector<unsigned int> &indices = data.indices;
+    const size_t vertexCount = vertices.size();
+    const size_t triangleCount = indices.size() / 3;
+    if (vertexCount == 0 || triangleCount == 0)
+        return;
+    if (threadCount == 0)
+        threadCount = utils::get_thread_count();
+
+    // Each block accumulates into its own copy so no synchronization is needed. Small meshes are not worth the extra memory
+    const size_t MIN_TRIANGLES_PER_BLOCK = 1 << 14;
+    const size_t blocks = std::max<size_t>(1, std::min<size_t>(threadCount, triangleCount / MIN_TRIANGLES_PER_BLOCK));
+    std::vector<glm::vec3> accumulation(blocks * vertexCount, glm::vec3(0.0f));
+
+    utils::parallel_for(triangleCount, [&](size_t begin, size_t end, size_t block)
+                        {
+        glm::vec3 *tangents = &accumulation[block * vertexCount];
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            const unsigned int *corner = &indices[3 * triangle];
+            if (corner[0] >= vertexCount || corner[1] >= vertexCount || corner[2] >= vertexCount)
+                continue;
+            const Vertex &v0 = vertices[corner[0]];
+            const Vertex &v1 = vertices[corner[1]];
+            const Vertex &v2 = vertices[corner[2]];
+
+            // Face tangent, direction already accounts for mirrored uvs
+            const glm::vec3 edge1 = v1.position - v0.position;
+            const glm::vec3 edge2 = v2.position - v0.position;
+            const glm::vec2 deltaUV1 = v1.uv - v0.uv;
+            const glm::vec2 deltaUV2 = v2.uv - v0.uv;
+            const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+            if (std::abs(determinant) < 1e-20f)
+                continue;
+            const glm::vec3 faceTangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) / determinant;
+
+            const Vertex *face[3] = {&v0, &v1, &v2};
+            for (int c = 0; c < 3; c++)
+            {
+                const Vertex &vertex = *face[c];
+                const glm::vec3 &p1 = face[(c + 1) % 3]->position;
+                const glm::vec3 &p2 = face[(c + 2) % 3]->position;
+
+                glm::vec3 normal = vertex.normal;
+                const float normalLength = glm::length(normal);
+                normal = normalLength > TANGENT_EPSILON ? normal / normalLength : glm::vec3(0.0f);
+
+                // Tangent and corner edges projected onto the vertex normal plane
+                glm::vec3 tangent = faceTangent - normal * glm::dot(normal, faceTangent);
+                const float tangentLength = glm::length(tangent);
+                if (tangentLength < TANGENT_EPSILON)
+                    continue;
+                glm::vec3 e1 = p1 - vertex.position;
+                glm::vec3 e2 = p2 - vertex.position;
+                e1 -= normal * glm::dot(normal, e1);
+                e2 -= normal * glm::dot(normal, e2);
+                const float e1Length = glm::length(e1), e2Length = glm::length(e2);
+                if (e1Length < TANGENT_EPSILON || e2Length < TANGENT_EPSILON)
+                    continue;
+                const float angle = std::acos(glm::clamp(glm::dot(e1, e2) / (e1Length * e2Length), -1.0f, 1.0f));
+
+                tangents[corner[c]] += tangent * (angle / tangentLength);
+            }
+        } }, static_cast<unsigned int>(blocks));
+
+    utils::parallel_for(vertexCount, [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t block = 1; block < blocks; block++)
+        {
+            const glm::vec3 *tangents = &accumulation[block * vertexCount];
+            for (size_t i = begin; i < end; i++)
+                accumulation[i] += tangents[i];
+        }
+        orthonormalize_tangents(&vertices[begin], &accumulation[begin], end - begin); }, threadCount);
+}
+
+namespace
+{
+    /*
+    Index ranges that can be reordered independently: the submeshes, or the whole full resolution part of the buffer
+    if there are none, followed by the ranges of every level of detail.
+    */
+    std::vector<Submesh> get_index_ranges(const MeshData &data)
+    {
+        std::vector<Submesh> ranges = data.submeshes;
+        if (ranges.empty())
+        {
+            // Levels of detail are appended after the full resolution indices
+            size_t baseCount = data.indices.size();
+            for (const LODLevel &level : data.LODs)
+                for (const Submesh &range : level.submeshes)
+                    baseCount = std::min(baseCount, size_t(range.indexOffset));
+            ranges.push_back(Submesh{0, static_cast<unsigned int>(baseCount), 0, -1});
+        }
+        for (const LODLevel &level : data.LODs)
+            ranges.insert(ranges.end(), level.submeshes.begin(), level.submeshes.end());
+        return ranges;
+    }
+
+    const unsigned int FORSYTH_CACHE_SIZE = 32;
+    const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+    const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    inline float get_forsyth_score(int cachePosition, unsigned int valence)
+    {
+        // No triangles left to draw with this vertex
+        if (valence == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = FORSYTH_LAST_TRIANGLE_SCORE;
+            else
+            {
+                const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+            }
+        }
+        return score + FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -FORSYTH_VALENCE_BOOST_POWER);
+    }
+
+    /*
+    Forsyth reordering of a triangle list whose indices are compact local ids in [0, vertexCount).
+    */
+    void forsyth_reorder(unsigned int *indices, size_t indexCount, size_t vertexCount)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount < 2)
+            return;
+
+        // Vertex to triangle adjacency
+        std::vector<unsigned int> valence(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            valence[indices[i]]++;
+        std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+        std::vector<unsigned int> adjacency(triangleCount * 3);
+        {
+            std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+                for (int c = 0; c < 3; c++)
+                    adjacency[fill[indices[3 * t + c]]++] = static_cast<unsigned int>(t);
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            vertexScore[v] = get_forsyth_score(-1, valence[v]);
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        size_t bestTriangle = 0;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+            if (triangleScore[t] > triangleScore[bestTriangle])
+                bestTriangle = t;
+        }
+
+        std::vector<unsigned int> output;
+        output.reserve(triangleCount * 3);
+        std::vector<unsigned int> cache, nextCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+        size_t cursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            if (bestTriangle == SIZE_MAX)
+            {
+                // Nothing adjacent to the cache left, continue with the next triangle in input order
+                while (emitted[cursor])
+                    cursor++;
+                bestTriangle = cursor;
+            }
+
+            const unsigned int *triangle = &indices[3 * bestTriangle];
+            output.insert(output.end(), triangle, triangle + 3);
+            emitted[bestTriangle] = true;
+
+            // Remove it from the live adjacency of its vertices
+            for (int c = 0; c < 3; c++)
+            {
+                const unsigned int v = triangle[c];
+                unsigned int *begin = &adjacency[adjacencyOffset[v]];
+                unsigned int *end = begin + valence[v];
+                unsigned int *found = std::find(begin, end, static_cast<unsigned int>(bestTriangle));
+                std::swap(*found, *(end - 1));
+                valence[v]--;
+            }
+
+            // Push its vertices to the front of the LRU cache
+            nextCache.assign(triangle, triangle + 3);
+            for (unsigned int v : cache)
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    nextCache.push_back(v);
+            std::swap(cache, nextCache);
+
+            for (size_t i = 0; i < cache.size(); i++)
+            {
+                const unsigned int v = cache[i];
+                cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+                vertexScore[v] = get_forsyth_score(cachePosition[v], valence[v]);
+            }
+
+            // Rescore triangles touching the cache and pick the best one
+            bestTriangle = SIZE_MAX;
+            float bestScore = -1e30f;
+            for (unsigned int v : cache)
+            {
+                const unsigned int *begin = &adjacency[adjacencyOffset[v]];
+                for (const unsigned int *t = begin; t != begin + valence[v]; t++)
+                {
+                    const unsigned int *corners = &indices[3 * *t];
+                    const float score = vertexScore[corners[0]] + vertexScore[corners[1]] + vertexScore[corners[2]];
+                    triangleScore[*t] = score;
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = *t;
+                    }
+                }
+            }
+            if (cache.size() > FORSYTH_CACHE_SIZE)
+                cache.resize(FORSYTH_CACHE_SIZE);
+        }
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    /*
+    FIFO cache simulation. Writes the amount of misses of every triangle in the range.
+    */
+    void simulate_vertex_cache(const unsigned int *indices, size_t indexCount, std::vector<unsigned int> &timestamps,
+                               unsigned int &time, unsigned int cacheSize, unsigned char *triangleMisses)
+    {
+        for (size_t t = 0; t < indexCount / 3; t++)
+        {
+            unsigned char misses = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                const unsigned int v = indices[3 * t + c];
+                if (time - timestamps[v] > cacheSize)
+                {
+                    timestamps[v] = ++time;
+                    misses++;
+                }
+            }
+            triangleMisses[t] = misses;
+        }
+    }
+}
+
+processing::VertexCacheStatistics processing::analyze_vertex_cache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStatistics statistics{};
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return statistics;
+
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<unsigned char> referenced(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    for (unsigned int index : indices)
+    {
+        if (index >= vertexCount)
+            continue;
+        referenced[index] = 1;
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = ++time;
+            statistics.vertexTransforms++;
+        }
+    }
+    size_t referencedCount = 0;
+    for (unsigned char r : referenced)
+        referencedCount += r;
+
+    statistics.ACMR = static_cast<float>(statistics.vertexTransforms) / triangleCount;
+    statistics.ATVR = referencedCount ? static_cast<float>(statistics.vertexTransforms) / referencedCount : 0.0f;
+    return statistics;
+}
+
+void processing::optimize_vertex_cache(MeshData &data)
+{
+    const std::vector<Submesh> ranges = get_index_ranges(data);
+
+    // Compact local vertex ids per range, so each range only pays for the vertices it uses
+    std::vector<unsigned int> localId(data.vertices.size(), UINT32_MAX);
+    std::vector<unsigned int> globalId;
+    for (const Submesh &range : ranges)
+    {
+        unsigned int *indices = &data.indices[range.indexOffset];
+        const size_t indexCount = range.indexCount - range.indexCount % 3;
+        globalId.clear();
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            unsigned int &id = localId[indices[i]];
+            if (id == UINT32_MAX)
+            {
+                id = static_cast<unsigned int>(globalId.size());
+                globalId.push_back(indices[i]);
+            }
+            indices[i] = id;
+        }
+        forsyth_reorder(indices, indexCount, globalId.size());
+        for (size_t i = 0; i < indexCount; i++)
+            indices[i] = globalId[indices[i]];
+        for (unsigned int v : globalId)
+            localId[v] = UINT32_MAX;
+    }
+}
+
+void processing::optimize_overdraw(MeshData &data, float threshold)
+{
+    const unsigned int CACHE_SIZE = 16;
+    const std::vector<Submesh> ranges = get_index_ranges(data);
+
+    std::vector<unsigned int> timestamps(data.vertices.size(), 0);
+    unsigned int time = CACHE_SIZE + 1;
+    std::vector<unsigned char> misses;
+    std::vector<unsigned int> clusters, reordered;
+    for (const Submesh &range : ranges)
+    {
+        unsigned int *indices = &data.indices[range.indexOffset];
+        const size_t triangleCount = range.indexCount / 3;
+        if (triangleCount < 2)
+            continue;
+
+        // Hard boundaries where the cache had to start over (every vertex missed)
+        misses.resize(triangleCount);
+        time += CACHE_SIZE + 1;
+        simulate_vertex_cache(indices, triangleCount * 3, timestamps, time, CACHE_SIZE, misses.data());
+
+        std::vector<unsigned int> hard;
+        for (size_t t = 0; t < triangleCount; t++)
+            if (t == 0 || misses[t] == 3)
+                hard.push_back(static_cast<unsigned int>(t));
+        hard.push_back(static_cast<unsigned int>(triangleCount));
+
+        // Soft boundaries inside them, wherever the running ACMR is already close enough to the whole cluster one
+        clusters.clear();
+        for (size_t h = 0; h + 1 < hard.size(); h++)
+        {
+            const unsigned int begin = hard[h], end = hard[h + 1];
+            size_t clusterMisses = 0;
+            for (unsigned int t = begin; t < end; t++)
+                clusterMisses += misses[t];
+            const float clusterACMR = static_cast<float>(clusterMisses) / (end - begin);
+
+            // Each soft cluster starts with a cold cache, as it may end up drawn after any other one
+            clusters.push_back(begin);
+            time += CACHE_SIZE + 1;
+            size_t runningMisses = 0;
+            unsigned int runningBegin = begin;
+            for (unsigned int t = begin; t < end; t++)
+            {
+                unsigned char triangleMisses;
+                simulate_vertex_cache(indices + 3 * t, 3, timestamps, time, CACHE_SIZE, &triangleMisses);
+                runningMisses += triangleMisses;
+                const float runningACMR = static_cast<float>(runningMisses) / (t - runningBegin + 1);
+                if (t + 1 < end && runningACMR <= clusterACMR * threshold)
+                {
+                    clusters.push_back(t + 1);
+                    time += CACHE_SIZE + 1;
+                    runningBegin = t + 1;
+                    runningMisses = 0;
+                }
+            }
+        }
+        clusters.push_back(static_cast<unsigned int>(triangleCount));
+
+        // Sort clusters so the ones facing away from the mesh center are drawn first
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        const size_t clusterCount = clusters.size() - 1;
+        std::vector<float> sortKeys(clusterCount);
+        std::vector<glm::vec3> clusterCentroid(clusterCount);
+        std::vector<glm::vec3> clusterNormal(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const glm::vec3 &p0 = data.vertices[indices[3 * t] + range.baseVertex].position;
+                const glm::vec3 &p1 = data.vertices[indices[3 * t + 1] + range.baseVertex].position;
+                const glm::vec3 &p2 = data.vertices[indices[3 * t + 2] + range.baseVertex].position;
+                const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+                const float triangleArea = glm::length(cross);
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += cross;
+                area += triangleArea;
+            }
+            meshCentroid += centroid;
+            meshArea += area;
+            clusterCentroid[c] = area > 0.0f ? centroid / area : centroid;
+            clusterNormal[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+        }
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+        for (size_t c = 0; c < clusterCount; c++)
+            sortKeys[c] = glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+
+        std::vector<unsigned int> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+            order[c] = static_cast<unsigned int>(c);
+        std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+                         { return sortKeys[a] > sortKeys[b]; });
+
+        reordered.clear();
+        reordered.reserve(triangleCount * 3);
+        for (unsigned int c : order)
+            reordered.insert(reordered.end(), indices + 3 * clusters[c], indices + 3 * clusters[c + 1]);
+        std::copy(reordered.begin(), reordered.end(), indices);
+    }
+}
+
+size_t processing::weld_vertices(MeshData &data)
+{
+    const size_t count = data.vertices.size();
+    if (data.indices.empty())
+    {
+        data.indices.resize(count);
+        for (size_t i = 0; i < count; i++)
+            data.indices[i] = static_cast<unsigned int>(i);
+    }
+
+    // Open addressing table of the first occurrences, at most half full
+    size_t capacity = 16;
+    while (capacity < count * 2)
+        capacity <<= 1;
+    std::vector<unsigned int> table(capacity, UINT32_MAX);
+    std::vector<unsigned int> remap(count);
+    std::vector<Vertex> vertices;
+    vertices.reserve(count);
+    for (size_t v = 0; v < count; v++)
+    {
+        const Vertex &vertex = data.vertices[v];
+        size_t slot = utils::hash_bytes(&vertex, sizeof(Vertex)) & (capacity - 1);
+        while (table[slot] != UINT32_MAX && memcmp(&vertices[table[slot]], &vertex, sizeof(Vertex)) != 0)
+            slot = (slot + 1) & (capacity - 1);
+        if (table[slot] == UINT32_MAX)
+        {
+            table[slot] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(vertex);
+        }
+        remap[v] = table[slot];
+    }
+
+    auto remap_range = [&](Submesh &range)
+    {
+        for (size_t i = range.indexOffset; i < size_t(range.indexOffset) + range.indexCount; i++)
+            data.indices[i] = remap[data.indices[i] + range.baseVertex];
+        range.baseVertex = 0;
+    };
+    if (data.submeshes.empty())
+        for (unsigned int &index : data.indices)
+            index = remap[index];
+    else
+    {
+        for (Submesh &range : data.submeshes)
+            remap_range(range);
+        for (LODLevel &level : data.LODs)
+            for (Submesh &range : level.submeshes)
+                remap_range(range);
+    }
+
+    data.vertices.swap(vertices);
+    return count - data.vertices.size();
+}
+
+void processing::optimize_vertex_fetch(MeshData &data)
+{
+    std::vector<unsigned int> remap(data.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(data.vertices.size());
+
+    for (const Submesh &range : get_index_ranges(data))
+        for (size_t i = range.indexOffset; i < size_t(range.indexOffset) + range.indexCount; i++)
+        {
+            const unsigned int vertex = data.indices[i] + range.baseVertex;
+            if (remap[vertex] == UINT32_MAX)
+            {
+                remap[vertex] = static_cast<unsigned int>(vertices.size());
+                vertices.push_back(data.vertices[vertex]);
+            }
+        }
+    auto remap_range = [&](Submesh &range)
+    {
+        for (size_t i = range.indexOffset; i < size_t(range.indexOffset) + range.indexCount; i++)
+            data.indices[i] = remap[data.indices[i] + range.baseVertex];
+        range.baseVertex = 0;
+    };
+    if (data.submeshes.empty())
+        for (unsigned int &index : data.indices)
+            index = remap[index];
+    else
+    {
+        for (Submesh &range : data.submeshes)
+            remap_range(range);
+        for (LODLevel &level : data.LODs)
+            for (Submesh &range : level.submeshes)
+                remap_range(range);
+    }
+
+    // Unreferenced vertices are kept at the end
+    for (size_t v = 0; v < data.vertices.size(); v++)
+        if (remap[v] == UINT32_MAX)
+            vertices.push_back(data.vertices[v]);
+    data.vertices.swap(vertices);
+}
+
+processing::MeshOptimizationReport processing::optimize_mesh(MeshData &data, bool overdraw, float overdrawThreshold)
+{
+    MeshOptimizationReport report{};
+    report.before = analyze_vertex_cache(data.indices, data.vertices.size());
+
+    optimize_vertex_cache(data);
+    if (overdraw)
+        optimize_overdraw(data, overdrawThreshold);
+    optimize_vertex_fetch(data);
+
+    report.after = analyze_vertex_cache(data.indices, data.vertices.size());
+    return report;
+}
+
+bool processing::optimize_geometry(Geometry &geometry, MeshOptimizationReport *report, bool overdraw, float overdrawThreshold)
+{
+    if (geometry.is_buffer_loaded() || geometry.get_primitive_type() != GL_TRIANGLES)
+        return false;
+    const std::vector<VertexBuffer> &VBOs = geometry.get_VAO().get_vertex_buffers();
+    const IndexBuffer &IBO = geometry.get_IBO();
+    if (VBOs.size() != 1 || VBOs[0].get_stride_size() != sizeof(Vertex) || !VBOs[0].get_data() || IBO.empty())
+        return false;
+
+    MeshData data;
+    const Vertex *vertices = static_cast<const Vertex *>(VBOs[0].get_data());
+    data.vertices.assign(vertices, vertices + VBOs[0].get_element_count());
+    data.indices = IBO.get_indices();
+    data.submeshes = geometry.get_submeshes();
+    // Reordered and remapped along with the full resolution ranges
+    data.LODs = geometry.get_LODs();
+    for (unsigned int index : data.indices)
+        if (index >= data.vertices.size())
+            return false;
+
+    const MeshOptimizationReport result = optimize_mesh(data, overdraw, overdrawThreshold);
+    if (report)
+        *report = result;
+
+    geometry = Geometry(std::move(data), geometry.get_primitive_type());
+    return true;
+}
+
+namespace
+{
+    const float OCTAHEDRAL_MAX = 32767.0f;
+
+    inline float sign_not_zero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+    /*
+    Same decoding as the GLSL oct_decode in processing::QuantizedVertexDecodeSource.
+    */
+    inline glm::vec3 oct_decode(short x, short y)
+    {
+        glm::vec3 v(std::max(x / OCTAHEDRAL_MAX, -1.0f), std::max(y / OCTAHEDRAL_MAX, -1.0f), 0.0f);
+        v.z = 1.0f - std::abs(v.x) - std::abs(v.y);
+        const float t = std::max(-v.z, 0.0f);
+        v.x += v.x >= 0.0f ? -t : t;
+        v.y += v.y >= 0.0f ? -t : t;
+        return glm::normalize(v);
+    }
+
+    /*
+    Octahedral encoding of a unit vector into two snorm16. Rounding each component independently is not optimal, so the
+    four floor/ceil combinations are decoded and the closest one kept. Returns the angular error in radians.
+    */
+    float oct_encode(glm::vec3 v, short *encoded)
+    {
+        const float length = glm::length(v);
+        if (length < TANGENT_EPSILON)
+        {
+            encoded[0] = encoded[1] = 0;
+            return 0.0f;
+        }
+        v /= length;
+        glm::vec2 e = glm::vec2(v.x, v.y) / (std::abs(v.x) + std::abs(v.y) + std::abs(v.z));
+        if (v.z < 0.0f)
+            e = glm::vec2((1.0f - std::abs(e.y)) * sign_not_zero(e.x), (1.0f - std::abs(e.x)) * sign_not_zero(e.y));
+
+        const float fx = std::floor(e.x * OCTAHEDRAL_MAX), fy = std::floor(e.y * OCTAHEDRAL_MAX);
+        float bestError = 4.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            const short x = (short)glm::clamp(fx + (i & 1), -OCTAHEDRAL_MAX, OCTAHEDRAL_MAX);
+            const short y = (short)glm::clamp(fy + (i >> 1), -OCTAHEDRAL_MAX, OCTAHEDRAL_MAX);
+            const glm::vec3 decoded = oct_decode(x, y);
+            // Precise for small angles, unlike acos of the dot product
+            const float error = std::atan2(glm::length(glm::cross(decoded, v)), glm::dot(decoded, v));
+            if (error < bestError)
+            {
+                bestError = error;
+                encoded[0] = x;
+                encoded[1] = y;
+            }
+        }
+        return bestError;
+    }
+
+    inline unsigned short quantize_unorm16(float v, float offset, float extent)
+    {
+        return extent > 0.0f ? (unsigned short)std::lround(glm::clamp((v - offset) / extent, 0.0f, 1.0f) * 65535.0f) : 0;
+    }
+}
+
+glm::mat4 processing::QuantizationTransform::get_position_matrix() const
+{
+    glm::mat4 matrix(1.0f);
+    matrix[0][0] = positionScale.x;
+    matrix[1][1] = positionScale.y;
+    matrix[2][2] = positionScale.z;
+    matrix[3] = glm::vec4(positionOffset, 1.0f);
+    return matrix;
+}
+
+processing::QuantizationReport processing::quantize_mesh(const MeshData &data, QuantizedMeshData &quantized, QuantizationSettings settings)
+{
+    static_assert(sizeof(QuantizedVertex) == 24, "Quantized vertex must be tightly packed");
+
+    const std::vector<Vertex> &vertices = data.vertices;
+    const size_t vertexCount = vertices.size();
+
+    QuantizationReport report;
+    report.originalBytes = vertexCount * sizeof(Vertex);
+    report.quantizedBytes = vertexCount * sizeof(QuantizedVertex);
+
+    quantized.vertices.resize(vertexCount);
+    quantized.indices = data.indices;
+    quantized.submeshes = data.submeshes;
+    quantized.materials = data.materials;
+    quantized.halfFloatPositions = settings.halfFloatPositions;
+    quantized.transform = QuantizationTransform();
+    if (vertexCount == 0)
+        return report;
+
+    glm::vec3 minPosition(vertices[0].position), maxPosition(vertices[0].position);
+    glm::vec2 minUV(vertices[0].uv), maxUV(vertices[0].uv);
+    for (const Vertex &v : vertices)
+    {
+        minPosition = glm::min(minPosition, v.position);
+        maxPosition = glm::max(maxPosition, v.position);
+        minUV = glm::min(minUV, v.uv);
+        maxUV = glm::max(maxUV, v.uv);
+    }
+    const glm::vec3 positionExtent = maxPosition - minPosition;
+    const glm::vec2 uvExtent = maxUV - minUV;
+
+    // Flat axes keep a unit scale so the position matrix stays invertible
+    QuantizationTransform &transform = quantized.transform;
+    if (!settings.halfFloatPositions)
+    {
+        transform.positionOffset = minPosition;
+        for (int axis = 0; axis < 3; axis++)
+            transform.positionScale[axis] = positionExtent[axis] > 0.0f ? positionExtent[axis] : 1.0f;
+    }
+    transform.uvOffset = minUV;
+    for (int axis = 0; axis < 2; axis++)
+        transform.uvScale[axis] = uvExtent[axis] > 0.0f ? uvExtent[axis] : 1.0f;
+
+    const unsigned int threadCount = settings.threadCount ? settings.threadCount : utils::get_thread_count();
+    const size_t blocks = std::max<size_t>(1, std::min<size_t>(threadCount, vertexCount / (1 << 14)));
+    std::vector<QuantizationReport> blockReports(blocks);
+
+    utils::parallel_for(vertexCount, [&](size_t begin, size_t end, size_t block)
+                        {
+        QuantizationReport &blockReport = blockReports[block];
+        for (size_t i = begin; i < end; i++)
+        {
+            const Vertex &v = vertices[i];
+            QuantizedVertex &q = quantized.vertices[i];
+
+            glm::vec3 position;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (settings.halfFloatPositions)
+                {
+                    q.position[axis] = glm::packHalf1x16(v.position[axis]);
+                    position[axis] = glm::unpackHalf1x16(q.position[axis]);
+                }
+                else
+                {
+                    q.position[axis] = quantize_unorm16(v.position[axis], minPosition[axis], positionExtent[axis]);
+                    position[axis] = transform.positionOffset[axis] + q.position[axis] / 65535.0f * transform.positionScale[axis];
+                }
+            }
+            q.position[3] = settings.halfFloatPositions ? glm::packHalf1x16(1.0f) : 65535;
+            blockReport.maxPositionError = std::max(blockReport.maxPositionError, glm::length(position - v.position));
+
+            blockReport.maxNormalError = std::max(blockReport.maxNormalError, oct_encode(v.normal, q.normal));
+            blockReport.maxTangentError = std::max(blockReport.maxTangentError, oct_encode(v.tangent, q.tangent));
+
+            glm::vec2 uv;
+            for (int axis = 0; axis < 2; axis++)
+            {
+                q.uv[axis] = quantize_unorm16(v.uv[axis], minUV[axis], uvExtent[axis]);
+                uv[axis] = transform.uvOffset[axis] + q.uv[axis] / 65535.0f * transform.uvScale[axis];
+            }
+            blockReport.maxUVError = std::max(blockReport.maxUVError, glm::length(uv - v.uv));
+
+            for (int channel = 0; channel < 3; channel++)
+                q.color[channel] = (unsigned char)std::lround(glm::clamp(v.color[channel], 0.0f, 1.0f) * 255.0f);
+            q.color[3] = 255;
+        } }, blocks);
+
+    for (const QuantizationReport &blockReport : blockReports)
+    {
+        report.maxPositionError = std::max(report.maxPositionError, blockReport.maxPositionError);
+        report.maxNormalError = std::max(report.maxNormalError, blockReport.maxNormalError);
+        report.maxTangentError = std::max(report.maxTangentError, blockReport.maxTangentError);
+        report.maxUVError = std::max(report.maxUVError, blockReport.maxUVError);
+    }
+    return report;
+}
+
+Geometry *processing::create_quantized_geometry(QuantizedMeshData &&data, unsigned int primitive)
+{
+    std::shared_ptr<const QuantizedMeshData> storage = std::make_shared<QuantizedMeshData>(std::move(data));
+
+    VertexBuffer VBO(storage->vertices.data(), storage->vertices.size() * sizeof(QuantizedVertex), storage);
+    if (storage->halfFloatPositions)
+        VBO.push_attribute_layout({GL_HALF_FLOAT, 4, GL_FALSE});
+    else
+        VBO.push_attribute_layout<unsigned short>(4);
+    VBO.push_attribute_layout<short>(2);
+    VBO.push_attribute_layout<short>(2);
+    VBO.push_attribute_layout<unsigned short>(2);
+    VBO.push_attribute_layout<unsigned char>(4);
+
+    VertexArray VAO;
+    VAO.push_vertex_buffer(std::move(VBO));
+    Geometry *geometry = storage->indices.empty() ? new Geometry(std::move(VAO), storage->vertices.size(), primitive)
+                                                  : new Geometry(std::move(VAO), storage->vertices.size(), IndexBuffer(storage->indices.data(), storage->indices.size(), storage), primitive);
+    geometry->set_submeshes(storage->submeshes);
+    return geometry;
+}
+
+namespace
+{
+    /*
+    Strided read only view of float3 positions
+    */
+    struct PositionStream
+    {
+        const unsigned char *data;
+        size_t stride;
+        size_t count;
+
+        inline glm::vec3 operator[](size_t i) const
+        {
+            glm::vec3 position;
+            std::memcpy(&position, data + i * stride, sizeof(glm::vec3));
+            return position;
+        }
+    };
+
+    struct MeshletPiece
+    {
+        const unsigned int *indices;
+        size_t triangleCount;
+        int baseVertex;
+    };
+
+    struct MeshletPieceResult
+    {
+        std::vector<glm::uvec4> ranges;
+        std::vector<unsigned int> vertices;
+        std::vector<unsigned int> triangles;
+    };
+
+    void build_meshlet_piece(const MeshletPiece &piece, const processing::MeshletSettings &settings,
+                             std::vector<unsigned int> &stamps, std::vector<unsigned char> &localIndices, unsigned int &stamp, MeshletPieceResult &result)
+    {
+        glm::uvec4 meshlet(0);
+        auto flush = [&]()
+        {
+            if (meshlet.w == 0)
+                return;
+            result.ranges.push_back(meshlet);
+            meshlet = glm::uvec4(result.vertices.size(), 0, result.triangles.size(), 0);
+            stamp++;
+        };
+
+        for (size_t triangle = 0; triangle < piece.triangleCount; triangle++)
+        {
+            unsigned int corners[3];
+            unsigned int newVertices = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                corners[k] = piece.baseVertex + piece.indices[triangle * 3 + k];
+                newVertices += stamps[corners[k]] != stamp;
+            }
+            if (meshlet.y + newVertices > settings.maxVertices || meshlet.w + 1 > settings.maxTriangles)
+                flush();
+
+            unsigned int packed = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned int vertex = corners[k];
+                if (stamps[vertex] != stamp)
+                {
+                    stamps[vertex] = stamp;
+                    localIndices[vertex] = (unsigned char)meshlet.y++;
+                    result.vertices.push_back(vertex);
+                }
+                packed |= (unsigned int)localIndices[vertex] << (8 * k);
+            }
+            result.triangles.push_back(packed);
+            meshlet.w++;
+        }
+        flush();
+    }
+
+    /*
+    Ritter's bounding sphere, AABB and the backface cone of the meshlet triangles.
+    */
+    void compute_meshlet_bounds(const PositionStream &positions, processing::MeshletData &meshlets, size_t meshlet)
+    {
+        const glm::uvec4 range = meshlets.ranges[meshlet];
+        const unsigned int *vertices = &meshlets.vertices[range.x];
+
+        glm::vec3 minPosition(positions[vertices[0]]), maxPosition(minPosition);
+        for (unsigned int i = 1; i < range.y; i++)
+        {
+            minPosition = glm::min(minPosition, positions[vertices[i]]);
+            maxPosition = glm::max(maxPosition, positions[vertices[i]]);
+        }
+        meshlets.boundsMin[meshlet] = glm::vec4(minPosition, 0.0f);
+        meshlets.boundsMax[meshlet] = glm::vec4(maxPosition, 0.0f);
+
+        auto farthest = [&](const glm::vec3 &from)
+        {
+            glm::vec3 result = from;
+            float best = -1.0f;
+            for (unsigned int i = 0; i < range.y; i++)
+            {
+                const glm::vec3 position = positions[vertices[i]];
+                const float distance = glm::dot(position - from, position - from);
+                if (distance > best)
+                {
+                    best = distance;
+                    result = position;
+                }
+            }
+            return result;
+        };
+        const glm::vec3 a = farthest(positions[vertices[0]]);
+        const glm::vec3 b = farthest(a);
+        glm::vec3 center = (a + b) * 0.5f;
+        float radius = glm::length(b - a) * 0.5f;
+        for (unsigned int i = 0; i < range.y; i++)
+        {
+            const glm::vec3 position = positions[vertices[i]];
+            const float distance = glm::length(position - center);
+            if (distance > radius)
+            {
+                const float grownRadius = (radius + distance) * 0.5f;
+                center += (position - center) * ((grownRadius - radius) / distance);
+                radius = grownRadius;
+            }
+        }
+        meshlets.spheres[meshlet] = glm::vec4(center, radius);
+
+        // Cone around the average face normal. Wider than about 84 degrees it would rarely cull and the apex gets unstable
+        const unsigned int *triangles = &meshlets.triangles[range.z];
+        glm::vec3 normalSum(0.0f);
+        for (unsigned int t = 0; t < range.w; t++)
+        {
+            const glm::vec3 p0 = positions[vertices[triangles[t] & 0xff]];
+            const glm::vec3 normal = glm::cross(positions[vertices[(triangles[t] >> 8) & 0xff]] - p0, positions[vertices[(triangles[t] >> 16) & 0xff]] - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f)
+                normalSum += normal / length;
+        }
+        meshlets.coneApexes[meshlet] = glm::vec4(center, 0.0f);
+        meshlets.coneAxes[meshlet] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        const float sumLength = glm::length(normalSum);
+        if (sumLength < TANGENT_EPSILON)
+            return;
+        const glm::vec3 axis = normalSum / sumLength;
+
+        float minDot = 1.0f;
+        float maxT = 0.0f;
+        for (unsigned int t = 0; t < range.w; t++)
+        {
+            const glm::vec3 p0 = positions[vertices[triangles[t] & 0xff]];
+            const glm::vec3 normal = glm::cross(positions[vertices[(triangles[t] >> 8) & 0xff]] - p0, positions[vertices[(triangles[t] >> 16) & 0xff]] - p0);
+            const float length = glm::length(normal);
+            if (length == 0.0f)
+                continue;
+            const float d = glm::dot(axis, normal / length);
+            minDot = std::min(minDot, d);
+            if (d > 0.0f)
+                maxT = std::max(maxT, glm::dot(center - p0, normal / length) / d);
+        }
+        if (minDot <= 0.1f)
+            return;
+        meshlets.coneApexes[meshlet] = glm::vec4(center - axis * maxT, 0.0f);
+        meshlets.coneAxes[meshlet] = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+    }
+
+    void build_meshlet_clusters(const PositionStream &positions, const unsigned int *indices, size_t indexCount, std::vector<Submesh> submeshes,
+                                processing::MeshletData &meshlets, processing::MeshletSettings settings)
+    {
+        meshlets = processing::MeshletData();
+        settings.maxVertices = glm::clamp(settings.maxVertices, 3u, 256u);
+        settings.maxTriangles = std::max(settings.maxTriangles, 1u);
+        const unsigned int threadCount = settings.threadCount ? settings.threadCount : utils::get_thread_count();
+        if (submeshes.empty())
+            submeshes.push_back({0, (unsigned int)indexCount, 0});
+
+        // Submeshes longer than a thread share are split in pieces. Each piece boundary may leave one partial meshlet
+        const size_t MIN_TRIANGLES_PER_PIECE = 1 << 15;
+        const size_t pieceTriangles = std::max(MIN_TRIANGLES_PER_PIECE, (indexCount / 3 + threadCount - 1) / threadCount);
+        std::vector<MeshletPiece> pieces;
+        std::vector<size_t> submeshPieces;
+        for (const Submesh &submesh : submeshes)
+        {
+            submeshPieces.push_back(pieces.size());
+            const size_t triangleCount = submesh.indexCount / 3;
+            for (size_t first = 0; first < triangleCount; first += pieceTriangles)
+                pieces.push_back({indices + submesh.indexOffset + first * 3, std::min(pieceTriangles, triangleCount - first), submesh.baseVertex});
+        }
+        submeshPieces.push_back(pieces.size());
+
+        std::vector<MeshletPieceResult> results(pieces.size());
+        utils::parallel_for(pieces.size(), [&](size_t begin, size_t end, size_t)
+                            {
+            std::vector<unsigned int> stamps(positions.count, ~0u);
+            std::vector<unsigned char> localIndices(positions.count);
+            unsigned int stamp = 0;
+            for (size_t piece = begin; piece < end; piece++)
+                build_meshlet_piece(pieces[piece], settings, stamps, localIndices, stamp, results[piece]); }, threadCount);
+
+        for (size_t submesh = 0; submesh < submeshes.size(); submesh++)
+        {
+            meshlets.submeshOffsets.push_back((unsigned int)meshlets.ranges.size());
+            for (size_t piece = submeshPieces[submesh]; piece < submeshPieces[submesh + 1]; piece++)
+            {
+                const glm::uvec4 offset(meshlets.vertices.size(), 0, meshlets.triangles.size(), 0);
+                for (const glm::uvec4 &range : results[piece].ranges)
+                    meshlets.ranges.push_back(range + offset);
+                meshlets.vertices.insert(meshlets.vertices.end(), results[piece].vertices.begin(), results[piece].vertices.end());
+                meshlets.triangles.insert(meshlets.triangles.end(), results[piece].triangles.begin(), results[piece].triangles.end());
+            }
+        }
+        meshlets.submeshOffsets.push_back((unsigned int)meshlets.ranges.size());
+
+        const size_t meshletCount = meshlets.size();
+        meshlets.spheres.resize(meshletCount);
+        meshlets.boundsMin.resize(meshletCount);
+        meshlets.boundsMax.resize(meshletCount);
+        meshlets.coneApexes.resize(meshletCount);
+        meshlets.coneAxes.resize(meshletCount);
+        utils::parallel_for(meshletCount, [&](size_t begin, size_t end, size_t)
+                            {
+            for (size_t meshlet = begin; meshlet < end; meshlet++)
+                compute_meshlet_bounds(positions, meshlets, meshlet); }, threadCount);
+    }
+}
+
+void processing::build_meshlets(const MeshData &data, MeshletData &meshlets, MeshletSettings settings)
+{
+    const PositionStream positions{reinterpret_cast<const unsigned char *>(data.vertices.data()), sizeof(Vertex), data.vertices.size()};
+    build_meshlet_clusters(positions, data.indices.data(), data.indices.size(), data.submeshes, meshlets, settings);
+}
+
+bool processing::build_meshlets(const Geometry &geometry, MeshletData &meshlets, MeshletSettings settings)
+{
+    if (geometry.get_primitive_type() != GL_TRIANGLES)
+        return false;
+    const std::vector<VertexBuffer> &VBOs = geometry.get_VAO().get_vertex_buffers();
+    const IndexBuffer &IBO = geometry.get_IBO();
+    if (VBOs.empty() || IBO.empty())
+        return false;
+    const VertexBuffer &VBO = VBOs.front();
+    const std::vector<AttributeLayout> layouts = VBO.get_layouts();
+    if (!VBO.get_data() || layouts.empty() || layouts[0].type != GL_FLOAT || layouts[0].count < 3)
+        return false;
+
+    const PositionStream positions{static_cast<const unsigned char *>(VBO.get_data()), VBO.get_stride_size(), VBO.get_element_count()};
+    std::vector<Submesh> submeshes = geometry.get_submeshes();
+    if (submeshes.empty())
+        submeshes.push_back({0, (unsigned int)IBO.get_index_count(), 0});
+    for (const Submesh &submesh : submeshes)
+    {
+        if (submesh.indexOffset + (size_t)submesh.indexCount > IBO.get_index_count())
+            return false;
+        for (size_t i = submesh.indexOffset; i < submesh.indexOffset + (size_t)submesh.indexCount; i++)
+            if (submesh.baseVertex + (size_t)IBO.get_data()[i] >= positions.count)
+                return false;
+    }
+    build_meshlet_clusters(positions, IBO.get_data(), IBO.get_index_count(), submeshes, meshlets, settings);
+    return true;
+}
+
+namespace
+{
+    /*
+    Symmetric 4x4 error quadric, area weighted. Evaluates to the weighted squared distance to the accumulated planes.
+    */
+    struct Quadric
+    {
+        double a00{0}, a11{0}, a22{0}, a01{0}, a02{0}, a12{0};
+        double b0{0}, b1{0}, b2{0};
+        double c{0};
+        double weight{0};
+
+        static Quadric from_plane(const glm::vec3 &n, float d, float weight)
+        {
+            Quadric q;
+            q.a00 = weight * n.x * n.x;
+            q.a11 = weight * n.y * n.y;
+            q.a22 = weight * n.z * n.z;
+            q.a01 = weight * n.x * n.y;
+            q.a02 = weight * n.x * n.z;
+            q.a12 = weight * n.y * n.z;
+            q.b0 = weight * n.x * d;
+            q.b1 = weight * n.y * d;
+            q.b2 = weight * n.z * d;
+            q.c = weight * d * d;
+            q.weight = weight;
+            return q;
+        }
+
+        Quadric &operator+=(const Quadric &o)
+        {
+            a00 += o.a00, a11 += o.a11, a22 += o.a22, a01 += o.a01, a02 += o.a02, a12 += o.a12;
+            b0 += o.b0, b1 += o.b1, b2 += o.b2;
+            c += o.c;
+            weight += o.weight;
+            return *this;
+        }
+
+        float error(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double r = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                             2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return weight > 0.0 ? float(std::abs(r) / weight) : 0.0f;
+        }
+    };
+
+    enum SimplificationVertexKind : unsigned char
+    {
+        VERTEX_MANIFOLD, // Moves freely
+        VERTEX_BORDER,   // Moves along open edges only
+        VERTEX_SEAM,     // Moves along its attribute seam, both wedges at once
+        VERTEX_LOCKED
+    };
+
+    const float BORDER_QUADRIC_WEIGHT = 10.0f;
+
+    /*
+    Read only topology of a submesh, shared by the tasks simplifying its levels. Vertices are compacted to the ones the
+    submesh uses and positions are normalized by the mesh extent. Wedges are the vertices that share a position.
+    */
+    struct SimplificationMesh
+    {
+        std::vector<unsigned int> sourceVertices; // Submesh relative index of each local vertex
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<unsigned int> positionIds; // First wedge with the same position
+        std::vector<unsigned int> wedges;      // Next wedge with the same position, circular
+        std::vector<unsigned char> kinds;      // Indexed by position id
+        std::vector<Quadric> quadrics;         // Indexed by position id
+        std::vector<unsigned int> indices;
+    };
+
+    inline uint64_t pack_edge(unsigned int a, unsigned int b) { return (uint64_t(a) << 32) | b; }
+
+    inline bool has_edge(const std::vector<uint64_t> &sortedEdges, unsigned int a, unsigned int b)
+    {
+        return std::binary_search(sortedEdges.begin(), sortedEdges.end(), pack_edge(a, b));
+    }
+
+    void setup_simplification_mesh(const MeshData &data, const Submesh &submesh, const glm::vec3 &origin, float extent, bool lockBorders, SimplificationMesh &mesh)
+    {
+        const unsigned int *indices = data.indices.data() + submesh.indexOffset;
+        const size_t indexCount = submesh.indexCount / 3 * 3;
+
+        std::unordered_map<unsigned int, unsigned int> localIds;
+        std::unordered_map<glm::vec3, unsigned int> positionIds;
+        mesh.indices.resize(indexCount);
+        for (size_t i = 0; i < indexCount; i++)
+        {
+            auto inserted = localIds.emplace(indices[i], (unsigned int)mesh.sourceVertices.size());
+            if (inserted.second)
+            {
+                const unsigned int local = inserted.first->second;
+                const Vertex &vertex = data.vertices[submesh.baseVertex + indices[i]];
+                mesh.sourceVertices.push_back(indices[i]);
+                mesh.positions.push_back((vertex.position - origin) / extent);
+                mesh.normals.push_back(vertex.normal);
+                mesh.uvs.push_back(vertex.uv);
+
+                auto position = positionIds.emplace(vertex.position, local);
+                const unsigned int first = position.first->second;
+                mesh.positionIds.push_back(first);
+                mesh.wedges.push_back(local);
+                if (!position.second)
+                {
+                    // Link into the circular wedge list of the first one
+                    mesh.wedges[local] = mesh.wedges[first];
+                    mesh.wedges[first] = local;
+                }
+            }
+            mesh.indices[i] = localIds[indices[i]];
+        }
+
+        const size_t vertexCount = mesh.sourceVertices.size();
+        std::vector<uint64_t> vertexEdges, positionEdges;
+        vertexEdges.reserve(indexCount);
+        positionEdges.reserve(indexCount);
+        for (size_t i = 0; i < indexCount; i += 3)
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned int a = mesh.indices[i + k], b = mesh.indices[i + (k + 1) % 3];
+                vertexEdges.push_back(pack_edge(a, b));
+                positionEdges.push_back(pack_edge(mesh.positionIds[a], mesh.positionIds[b]));
+            }
+        std::sort(vertexEdges.begin(), vertexEdges.end());
+        std::sort(positionEdges.begin(), positionEdges.end());
+
+        std::vector<unsigned char> border(vertexCount, 0), seam(vertexCount, 0), locked(vertexCount, 0);
+        for (size_t i = 0; i < positionEdges.size(); i++)
+        {
+            const unsigned int a = unsigned(positionEdges[i] >> 32), b = unsigned(positionEdges[i]);
+            if (a == b)
+                continue;
+            if (i + 1 < positionEdges.size() && positionEdges[i + 1] == positionEdges[i])
+                locked[a] = locked[b] = 1; // Non manifold
+            if (!has_edge(positionEdges, b, a))
+                border[a] = border[b] = 1;
+        }
+        for (uint64_t edge : vertexEdges)
+        {
+            const unsigned int a = unsigned(edge >> 32), b = unsigned(edge);
+            const unsigned int pa = mesh.positionIds[a], pb = mesh.positionIds[b];
+            if (pa != pb && !has_edge(vertexEdges, b, a) && has_edge(positionEdges, pb, pa))
+                seam[pa] = seam[pb] = 1;
+        }
+
+        mesh.kinds.assign(vertexCount, VERTEX_LOCKED);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            if (mesh.positionIds[v] != v || locked[v])
+                continue;
+            const unsigned int wedgeCount = mesh.wedges[v] == v ? 1 : mesh.wedges[mesh.wedges[v]] == v ? 2 : 3;
+            if (wedgeCount == 1 && !seam[v])
+                mesh.kinds[v] = border[v] ? (lockBorders ? VERTEX_LOCKED : VERTEX_BORDER) : VERTEX_MANIFOLD;
+            else if (wedgeCount == 2 && seam[v] && !border[v])
+                mesh.kinds[v] = VERTEX_SEAM;
+        }
+
+        mesh.quadrics.assign(vertexCount, Quadric());
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            const unsigned int p[3] = {mesh.positionIds[mesh.indices[i]], mesh.positionIds[mesh.indices[i + 1]], mesh.positionIds[mesh.indices[i + 2]]};
+            const glm::vec3 &p0 = mesh.positions[p[0]], &p1 = mesh.positions[p[1]], &p2 = mesh.positions[p[2]];
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            if (area == 0.0f)
+                continue;
+            normal /= area;
+            const Quadric plane = Quadric::from_plane(normal, -glm::dot(normal, p0), area);
+            for (int k = 0; k < 3; k++)
+                mesh.quadrics[p[k]] += plane;
+
+            // Open edges get a perpendicular plane so that borders keep their shape when they are allowed to move
+            for (int k = 0; k < 3; k++)
+            {
+                const unsigned int a = p[k], b = p[(k + 1) % 3];
+                if (has_edge(positionEdges, b, a))
+                    continue;
+                const glm::vec3 edge = mesh.positions[b] - mesh.positions[a];
+                const float length = glm::length(edge);
+                if (length == 0.0f)
+                    continue;
+                const glm::vec3 perpendicular = glm::normalize(glm::cross(edge, normal));
+                const Quadric borderPlane = Quadric::from_plane(perpendicular, -glm::dot(perpendicular, mesh.positions[a]), length * length * BORDER_QUADRIC_WEIGHT);
+                mesh.quadrics[a] += borderPlane;
+                mesh.quadrics[b] += borderPlane;
+            }
+        }
+    }
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        float error; // Geometric part
+        float cost;  // Error plus attribute penalty, used for ranking
+    };
+
+    /*
+    Counting sort on the upper bits of the (positive) float costs. Order is approximate within a bucket, which is
+    precise enough for ranking and linear instead of n log n.
+    */
+    void sort_collapses(const std::vector<Collapse> &collapses, std::vector<Collapse> &sorted, std::vector<unsigned int> &buckets)
+    {
+        const int SHIFT = 17;
+        buckets.assign((1u << (32 - SHIFT)) + 1, 0);
+        auto key = [](float cost)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &cost, sizeof(bits));
+            return (bits & 0x7fffffffu) >> SHIFT;
+        };
+        for (const Collapse &collapse : collapses)
+            buckets[key(collapse.cost) + 1]++;
+        for (size_t i = 1; i < buckets.size(); i++)
+            buckets[i] += buckets[i - 1];
+        sorted.resize(collapses.size());
+        for (const Collapse &collapse : collapses)
+            sorted[buckets[key(collapse.cost)]++] = collapse;
+    }
+
+    /*
+    Simplifies a submesh towards a triangle count. Each pass ranks every edge collapse, then applies the cheapest ones
+    whose one-rings do not overlap, so that flip checks stay valid within the pass. Returns local indices.
+    */
+    std::vector<unsigned int> simplify_submesh(const SimplificationMesh &mesh, size_t targetTriangles, float maxError, float attributeWeight, float &resultError)
+    {
+        std::vector<unsigned int> indices = mesh.indices;
+        std::vector<Quadric> quadrics = mesh.quadrics;
+        const size_t vertexCount = mesh.positions.size();
+        const float maxErrorSquared = maxError * maxError;
+
+        std::vector<unsigned int> remap(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::vector<unsigned int> adjacencyOffsets(vertexCount + 1), adjacency;
+        std::vector<unsigned char> touched(vertexCount);
+        std::vector<Collapse> collapses, sortedCollapses;
+        std::vector<unsigned int> buckets;
+        resultError = 0.0f;
+
+        auto attribute_cost = [&](unsigned int a, unsigned int b)
+        {
+            const glm::vec3 dn = mesh.normals[a] - mesh.normals[b];
+            const glm::vec2 duv = mesh.uvs[a] - mesh.uvs[b];
+            return attributeWeight * (glm::dot(dn, dn) + glm::dot(duv, duv));
+        };
+
+        while (indices.size() / 3 > targetTriangles)
+        {
+            const size_t triangleCount = indices.size() / 3;
+
+            // Triangles around each position
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (unsigned int index : indices)
+                adjacencyOffsets[mesh.positionIds[index] + 1]++;
+            for (size_t v = 0; v < vertexCount; v++)
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            adjacency.resize(indices.size());
+            {
+                std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++)
+                    adjacency[fill[mesh.positionIds[indices[i]]]++] = unsigned(i / 3);
+            }
+
+            // Triangles that contain both positions. Scans around the one with fewer triangles
+            auto shared_triangles = [&](unsigned int pa, unsigned int pb, unsigned int *found, unsigned int capacity)
+            {
+                if (adjacencyOffsets[pa + 1] - adjacencyOffsets[pa] > adjacencyOffsets[pb + 1] - adjacencyOffsets[pb])
+                    std::swap(pa, pb);
+                unsigned int count = 0;
+                for (unsigned int j = adjacencyOffsets[pa]; j < adjacencyOffsets[pa + 1]; j++)
+                {
+                    const unsigned int *t = &indices[adjacency[j] * 3];
+                    if (mesh.positionIds[t[0]] == pb || mesh.positionIds[t[1]] == pb || mesh.positionIds[t[2]] == pb)
+                    {
+                        if (count < capacity)
+                            found[count] = adjacency[j];
+                        count++;
+                    }
+                }
+                return count;
+            };
+
+            // Wedge of position pv that the sibling of u connects to across the seam edge, or ~0u
+            auto seam_target = [&](unsigned int u, unsigned int v)
+            {
+                const unsigned int pu = mesh.positionIds[u], pv = mesh.positionIds[v];
+                unsigned int triangles[2];
+                if (shared_triangles(pu, pv, triangles, 2) != 2)
+                    return ~0u;
+                const unsigned int sibling = mesh.wedges[u];
+                unsigned int target = ~0u;
+                bool direct = false;
+                for (unsigned int t : triangles)
+                {
+                    unsigned int cornerU = ~0u, cornerV = ~0u;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const unsigned int w = indices[t * 3 + k];
+                        if (mesh.positionIds[w] == pu)
+                            cornerU = w;
+                        else if (mesh.positionIds[w] == pv)
+                            cornerV = w;
+                    }
+                    if (cornerU == u && cornerV == v)
+                        direct = true;
+                    else if (cornerU == sibling && cornerV != v)
+                        target = cornerV;
+                }
+                return direct ? target : ~0u;
+            };
+
+            collapses.clear();
+            for (size_t t = 0; t < triangleCount; t++)
+                for (int k = 0; k < 3; k++)
+                {
+                    const unsigned int a = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+                    const unsigned int pa = mesh.positionIds[a], pb = mesh.positionIds[b];
+                    // Interior edges are seen from both of their triangles, keep one
+                    if (pa == pb || (pa > pb && shared_triangles(pa, pb, nullptr, 0) > 1))
+                        continue;
+                    Collapse best{0, 0, 0.0f, std::numeric_limits<float>::max()};
+                    const unsigned int ends[2][2] = {{a, b}, {b, a}};
+                    for (const auto &end : ends)
+                    {
+                        const unsigned int u = end[0], v = end[1];
+                        const unsigned char kind = mesh.kinds[mesh.positionIds[u]];
+                        if (kind == VERTEX_LOCKED)
+                            continue;
+                        const float error = quadrics[mesh.positionIds[u]].error(mesh.positions[v]);
+                        const float cost = error + attribute_cost(u, v);
+                        if (cost < best.cost)
+                            best = {u, v, error, cost};
+                    }
+                    if (best.cost < std::numeric_limits<float>::max() && best.error <= maxErrorSquared)
+                        collapses.push_back(best);
+                }
+            sort_collapses(collapses, sortedCollapses, buckets);
+
+            std::fill(touched.begin(), touched.end(), 0);
+            const size_t needed = triangleCount - targetTriangles;
+            size_t removed = 0, applied = 0;
+            for (const Collapse &collapse : sortedCollapses)
+            {
+                const unsigned int u = collapse.from, v = collapse.to;
+                const unsigned int pu = mesh.positionIds[u], pv = mesh.positionIds[v];
+                if (touched[pu] || touched[pv])
+                    continue;
+
+                unsigned int shared[2];
+                const unsigned int sharedCount = shared_triangles(pu, pv, shared, 2);
+                unsigned int siblingTarget = ~0u;
+                switch (mesh.kinds[pu])
+                {
+                case VERTEX_BORDER:
+                    // Only along an open edge
+                    if (sharedCount != 1 || mesh.kinds[pv] == VERTEX_MANIFOLD)
+                        continue;
+                    break;
+                case VERTEX_SEAM:
+                    if (mesh.kinds[pv] != VERTEX_SEAM || (siblingTarget = seam_target(u, v)) == ~0u)
+                        continue;
+                    break;
+                default:
+                    break;
+                }
+
+                // Reject collapses that flip or degenerate any surviving triangle around u
+                bool flips = false;
+                for (unsigned int j = adjacencyOffsets[pu]; j < adjacencyOffsets[pu + 1] && !flips; j++)
+                {
+                    const unsigned int *t = &indices[adjacency[j] * 3];
+                    glm::vec3 p[3];
+                    bool containsV = false;
+                    int moved = 0;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const unsigned int pk = mesh.positionIds[t[k]];
+                        containsV |= pk == pv;
+                        if (pk == pu)
+                            moved = k;
+                        p[k] = mesh.positions[pk];
+                    }
+                    if (containsV)
+                        continue;
+                    const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    p[moved] = mesh.positions[pv];
+                    const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    flips = glm::dot(before, after) <= 0.0f;
+                }
+                if (flips)
+                    continue;
+
+                remap[u] = v;
+                if (siblingTarget != ~0u)
+                    remap[mesh.wedges[u]] = siblingTarget;
+                quadrics[pv] += quadrics[pu];
+                touched[pv] = 1;
+                for (unsigned int j = adjacencyOffsets[pu]; j < adjacencyOffsets[pu + 1]; j++)
+                    for (int k = 0; k < 3; k++)
+                        touched[mesh.positionIds[indices[adjacency[j] * 3 + k]]] = 1;
+                resultError = std::max(resultError, collapse.error);
+                removed += sharedCount;
+                applied++;
+                if (removed >= needed)
+                    break;
+            }
+
+            if (applied == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                const unsigned int a = remap[indices[t * 3]], b = remap[indices[t * 3 + 1]], c = remap[indices[t * 3 + 2]];
+                const unsigned int pa = mesh.positionIds[a], pb = mesh.positionIds[b], pc = mesh.positionIds[c];
+                if (pa == pb || pb == pc || pa == pc)
+                    continue;
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+            indices.resize(write);
+            for (size_t t = 0; t < indices.size(); t++)
+                remap[indices[t]] = indices[t];
+        }
+        resultError = std::sqrt(resultError);
+        return indices;
+    }
+}
+
+void processing::generate_LODs(MeshData &data, LODSettings settings)
+{
+    if (data.vertices.empty() || data.indices.size() < 3 || settings.ratios.empty())
+        return;
+    const unsigned int threadCount = settings.threadCount ? settings.threadCount : utils::get_thread_count();
+
+    // The base range has to be explicit once LOD indices are appended after it
+    if (data.submeshes.empty())
+        data.submeshes.push_back({0, (unsigned int)data.indices.size(), 0, -1});
+    const std::vector<Submesh> submeshes = data.submeshes;
+
+    glm::vec3 minPosition(data.vertices[0].position), maxPosition(minPosition);
+    for (const Vertex &vertex : data.vertices)
+    {
+        minPosition = glm::min(minPosition, vertex.position);
+        maxPosition = glm::max(maxPosition, vertex.position);
+    }
+    const glm::vec3 size = maxPosition - minPosition;
+    const float extent = std::max({size.x, size.y, size.z}) > 0.0f ? std::max({size.x, size.y, size.z}) : 1.0f;
+
+    std::vector<SimplificationMesh> meshes(submeshes.size());
+    utils::parallel_for(submeshes.size(), [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t i = begin; i < end; i++)
+            setup_simplification_mesh(data, submeshes[i], minPosition, extent, settings.lockBorders, meshes[i]); }, threadCount);
+
+    // One task per level and submesh
+    const size_t levelCount = settings.ratios.size();
+    std::vector<std::vector<unsigned int>> results(levelCount * submeshes.size());
+    std::vector<float> errors(results.size(), 0.0f);
+    utils::parallel_for(results.size(), [&](size_t begin, size_t end, size_t)
+                        {
+        for (size_t task = begin; task < end; task++)
+        {
+            const SimplificationMesh &mesh = meshes[task % submeshes.size()];
+            const float ratio = glm::clamp(settings.ratios[task / submeshes.size()], 0.0f, 1.0f);
+            const size_t target = size_t(mesh.indices.size() / 3 * ratio);
+            results[task] = simplify_submesh(mesh, target, settings.maxError, settings.attributeWeight, errors[task]);
+            for (unsigned int &index : results[task])
+                index = mesh.sourceVertices[index];
+        } }, threadCount);
+
+    data.LODs.clear();
+    size_t previous = levelCount;
+    for (size_t level = 0; level < levelCount; level++)
+    {
+        // A level the simplifier could not reduce any further would only duplicate the previous one
+        if (previous < levelCount)
+        {
+            bool same = true;
+            for (size_t i = 0; i < submeshes.size() && same; i++)
+                same = results[level * submeshes.size() + i] == results[previous * submeshes.size() + i];
+            if (same)
+                continue;
+        }
+        previous = level;
+        data.LODs.emplace_back();
+        LODLevel &lod = data.LODs.back();
+        for (size_t i = 0; i < submeshes.size(); i++)
+        {
+            const std::vector<unsigned int> &indices = results[level * submeshes.size() + i];
+            lod.error = std::max(lod.error, errors[level * submeshes.size() + i] * extent);
+            if (indices.empty())
+                continue;
+            Submesh submesh = submeshes[i];
+            submesh.indexOffset = (unsigned int)data.indices.size();
+            submesh.indexCount = (unsigned int)indices.size();
+            lod.submeshes.push_back(submesh);
+            data.indices.insert(data.indices.end(), indices.begin(), indices.end());
+        }
+    }
+    // Errors are measured against the full resolution mesh, keep them monotonic for selection
+    for (size_t level = 1; level < data.LODs.size(); level++)
+        data.LODs[level].error = std::max(data.LODs[level].error, data.LODs[level - 1].error);
+}
+
+GLSP_NAMESPACE_END
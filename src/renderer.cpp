@@ -9,6 +9,7 @@
 
 */
 #include <GLSP/renderer.h>
+#include <GLSP/loaders.h>
 
 GLSP_NAMESPACE_BEGIN
 
@@ -48,6 +49,10 @@ void Renderer::create_context()
         throw new GLSPException("Failed to initialize OpenGL context\n");
     }
 
+    if (m_context.directStateAccess && !GLAD_GL_VERSION_4_5)
+        ERR_LOG("Direct State Access needs OpenGL 4.5, falling back to bind to edit");
+    set_direct_state_access(m_context.directStateAccess && GLAD_GL_VERSION_4_5);
+
     glfwSwapInterval(m_settings.vSync);
 }
 
@@ -74,6 +79,9 @@ void Renderer::tick()
         m_time.last = m_time.current;
         m_time.framerate = int(1.0 / m_time.delta);
 
+        loaders::poll_hot_reload();
+        loaders::process_uploads(m_settings.uploadBudget);
+
         update();
 
         if (m_settings.userInterface)
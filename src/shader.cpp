@@ -9,6 +9,7 @@
 
 */
 #include <GLSP/shader.h>
+#include <GLSP/utils.h>
 
 GLSP_NAMESPACE_BEGIN
 
@@ -22,6 +23,23 @@ Shader::Shader(ShaderStageSource src, ShaderType t) : m_type(t)
     m_ID = create_program(src);
 }
 
+bool Shader::reload(const ShaderStageSource &source)
+{
+    const unsigned int program = create_program(source);
+    int linkStatus;
+    GL_CHECK(glGetProgramiv(program, GL_LINK_STATUS, &linkStatus));
+    if (linkStatus != GL_TRUE)
+    {
+        GL_CHECK(glDeleteProgram(program));
+        return false;
+    }
+    GL_CHECK(glDeleteProgram(m_ID));
+    m_ID = program;
+    m_uniformLocationCache.clear();
+    m_uniformBlockCache.clear();
+    return true;
+}
+
 void Shader::bind() const
 {
     GL_CHECK(glUseProgram(m_ID));
@@ -203,12 +221,15 @@ unsigned int Shader::create_program(ShaderStageSource source)
 
 ShaderStageSource Shader::parse_shader(const char *filename)
 {
-    const std::string file(filename);
-    std::ifstream stream(file);
-
-    if (!stream.is_open())
+    std::unique_ptr<utils::MappedFile> file;
+    try
     {
-        ERR_LOG("Error opening file " + file);
+        file.reset(new utils::MappedFile(filename, utils::FILE_ACCESS_SEQUENTIAL));
+    }
+    catch (const std::exception &)
+    {
+        ERR_LOG("Error opening file " + std::string(filename));
+        return {};
     }
 
     const size_t MAX_STAGES = 5;
@@ -223,64 +244,78 @@ ShaderStageSource Shader::parse_shader(const char *filename)
 
     };
 
-    std::string line;
-    std::stringstream ss[MAX_STAGES];
+    // Lines between two #stage markers are copied in a single span straight from the mapped file
+    const std::string_view text = file->get_text();
+    std::string sources[MAX_STAGES];
     StageType type = StageType::NONE;
+    size_t sectionBegin = 0;
+    size_t position = 0;
+    auto close_section = [&](size_t sectionEnd)
+    {
+        if (type != StageType::NONE && sectionEnd > sectionBegin)
+            sources[(int)type].append(text.data() + sectionBegin, sectionEnd - sectionBegin);
+    };
 
-    while (getline(stream, line))
+    while (position < text.size())
     {
-        if (line.find("#stage") != std::string::npos)
+        size_t lineEnd = text.find('\n', position);
+        const size_t next = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+        if (lineEnd == std::string_view::npos)
+            lineEnd = text.size();
+        const std::string_view line = text.substr(position, lineEnd - position);
+
+        if (line.find("#stage") != std::string_view::npos)
         {
-            if (line.find("vertex") != std::string::npos)
+            close_section(position);
+            if (line.find("vertex") != std::string_view::npos)
             {
                 type = StageType::VERTEX;
             }
-            else if (line.find("fragment") != std::string::npos)
+            else if (line.find("fragment") != std::string_view::npos)
             {
                 type = StageType::FRAGMENT;
             }
-            else if (line.find("geometry") != std::string::npos)
+            else if (line.find("geometry") != std::string_view::npos)
             {
                 type = StageType::GEOMETRY;
             }
-            else if (line.find("control") != std::string::npos)
+            else if (line.find("control") != std::string_view::npos)
             {
                 type = StageType::TESS_CTRL;
             }
-            else if (line.find("eval") != std::string::npos)
+            else if (line.find("eval") != std::string_view::npos)
             {
                 type = StageType::TESS_EVAL;
             }
+            sectionBegin = next;
         }
-        else
-        {
-            ss[(int)type] << line << '\n';
-        }
+        position = next;
     }
-    return {ss[0].str().size() != 0 ? ss[0].str() : "",
-            ss[1].str().size() != 0 ? ss[1].str() : "",
-            ss[2].str().size() != 0 ? ss[2].str() : "",
-            ss[3].str().size() != 0 ? ss[3].str() : "",
-            ss[4].str().size() != 0 ? ss[4].str() : ""};
+    close_section(text.size());
+
+    // Every line ends in a new line, the last one included
+    for (std::string &source : sources)
+        if (!source.empty() && source.back() != '\n')
+            source += '\n';
+    return {std::move(sources[0]), std::move(sources[1]), std::move(sources[2]), std::move(sources[3]), std::move(sources[4])};
 }
 
 std::string Shader::parse_shader_stage(const char *filename)
 {
-    const std::string file(filename);
-    std::ifstream stream(file);
-
-    if (!stream.is_open())
+    std::unique_ptr<utils::MappedFile> file;
+    try
     {
-        ERR_LOG("Error opening file " + file);
+        file.reset(new utils::MappedFile(filename, utils::FILE_ACCESS_SEQUENTIAL));
     }
-    std::string line;
-    std::stringstream ss;
-
-    while (getline(stream, line))
+    catch (const std::exception &)
     {
-        ss << line << '\n';
+        ERR_LOG("Error opening file " + std::string(filename));
+        return "";
     }
-    return ss.str();
+    std::string source(file->get_text());
+    if (!source.empty() && source.back() != '\n')
+        source += '\n';
+    return source;
 }
 #pragma region COMPUTE SHADER
 ComputeShader::ComputeShader(const char *filename) : Shader(ShaderType::COMPUTE)
@@ -9,23 +9,91 @@
 
 */
 #include <GLSP/texture.h>
+#include <GLSP/processing.h>
+#include <GLSP/cache.h>
 
 GLSP_NAMESPACE_BEGIN
 
 Shader *Texture::HDRIConverterShader = nullptr;
 Shader *Texture::IrradianceComputeShader = nullptr;
 
+namespace
+{
+    // Keep bakes of different kinds apart in the shared cache
+    const uint64_t SPECULAR_BAKE_TAG = 1;
+    const uint64_t BRDF_BAKE_TAG = 2;
+}
+
 void Texture::generate()
 {
-    GL_CHECK(glGenTextures(1, &m_id));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateTextures(m_config.type, 1, &m_id));
+    }
+    else
+    {
+        GL_CHECK(glGenTextures(1, &m_id));
+    }
 
     setup();
 
     m_generated = true;
 }
+namespace
+{
+    /*
+    Immutable storage only accepts sized internal formats.
+    */
+    int get_sized_internal_format(int internalFormat, unsigned int dataType)
+    {
+        const bool isFloat = dataType == GL_FLOAT;
+        switch (internalFormat)
+        {
+        case GL_RED:
+            return isFloat ? GL_R32F : GL_R8;
+        case GL_RG:
+            return isFloat ? GL_RG32F : GL_RG8;
+        case GL_RGB:
+            return isFloat ? GL_RGB32F : GL_RGB8;
+        case GL_RGBA:
+            return isFloat ? GL_RGBA32F : GL_RGBA8;
+        case GL_DEPTH_COMPONENT:
+            return isFloat ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24;
+        case GL_DEPTH_STENCIL:
+            return isFloat ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+        default:
+            return internalFormat;
+        }
+    }
+
+    int get_mip_level_count(Extent2D extent)
+    {
+        int count = 1;
+        for (int side = std::max(extent.width, extent.height); side > 1; side /= 2)
+            count++;
+        return count;
+    }
+}
+
 void Texture::setup()
 {
-    GL_CHECK(glBindTexture(m_config.type, m_id));
+    // Immutable storage can not be respecified, it needs a new texture object
+    if (m_immutable)
+    {
+        GL_CHECK(glDeleteTextures(1, &m_id));
+        if (uses_direct_state_access())
+        {
+            GL_CHECK(glCreateTextures(m_config.type, 1, &m_id));
+        }
+        else
+        {
+            GL_CHECK(glGenTextures(1, &m_id));
+        }
+        m_immutable = false;
+    }
+
+    const bool uploadLevels = m_levels.get_level_count() > 0 && m_levels.extents[0] == m_extent &&
+                              ((m_config.type == TEXTURE_2D && m_levels.faceCount == 1) || (m_config.type == TEXTURE_CUBEMAP && m_levels.faceCount == 6));
 
     const void *data = nullptr;
     if (m_image.linear) // Check if image is linear
@@ -39,9 +107,23 @@ void Texture::setup()
             data = static_cast<const void *>(m_image.HDRdata);
     }
 
+    if (uses_direct_state_access())
+    {
+        setup_direct(data, uploadLevels);
+        finish_setup();
+        return;
+    }
+
+    GL_CHECK(glBindTexture(m_config.type, m_id));
+
     switch (m_config.type)
     {
     case TEXTURE_2D:
+        if (uploadLevels)
+        {
+            upload_levels();
+            break;
+        }
         GL_CHECK(glTexImage2D(
             m_config.type,
             m_config.level,
@@ -87,6 +169,11 @@ void Texture::setup()
             GL_TRUE));
         break;
     case TEXTURE_CUBEMAP:
+        if (uploadLevels)
+        {
+            upload_levels();
+            break;
+        }
 
         for (int i = 0; i < 6; i++)
         {
@@ -106,7 +193,7 @@ void Texture::setup()
 
     if (m_config.type != TEXTURE_2D_MULTISAMPLE && m_config.type != TEXTURE_2D_MULRISAMPLE_ARRAY)
     {
-        if (m_config.useMipmaps || !m_image.panorama)
+        if ((m_config.useMipmaps || !m_image.panorama) && !uploadLevels)
         {
             GL_CHECK(glGenerateMipmap(m_config.type));
         }
@@ -130,6 +217,89 @@ void Texture::setup()
 
     GL_CHECK(glBindTexture(m_config.type, 0));
 
+    finish_setup();
+}
+
+void Texture::setup_direct(const void *data, bool uploadLevels)
+{
+    const bool multisampled = m_config.type == TEXTURE_2D_MULTISAMPLE || m_config.type == TEXTURE_2D_MULRISAMPLE_ARRAY;
+    const bool mipmaps = !multisampled && !uploadLevels && (m_config.useMipmaps || !m_image.panorama);
+    const int levelCount = mipmaps ? std::max(get_mip_level_count(m_extent), m_config.level + 1) : m_config.level + 1;
+    const int format = get_sized_internal_format(m_config.internalFormat, m_config.dataType);
+
+    switch (m_config.type)
+    {
+    case TEXTURE_2D:
+        if (uploadLevels)
+        {
+            upload_levels();
+            break;
+        }
+        GL_CHECK(glTextureStorage2D(m_id, levelCount, format, m_extent.width, m_extent.height));
+        if (data)
+        {
+            GL_CHECK(glTextureSubImage2D(m_id, m_config.level, 0, 0, m_extent.width, m_extent.height, m_config.format, m_config.dataType, data));
+        }
+        break;
+    case TEXTURE_3D:
+    case TEXTURE_2D_ARRAY:
+        GL_CHECK(glTextureStorage3D(m_id, levelCount, format, m_extent.width, m_extent.height, m_config.layers));
+        if (data)
+        {
+            GL_CHECK(glTextureSubImage3D(m_id, m_config.level, 0, 0, 0, m_extent.width, m_extent.height, m_config.layers,
+                                         m_config.format, m_config.dataType, data));
+        }
+        break;
+    case TEXTURE_2D_MULTISAMPLE:
+        GL_CHECK(glTextureStorage2DMultisample(m_id, m_config.samples, format, m_extent.width, m_extent.height, GL_TRUE));
+        break;
+    case TEXTURE_2D_MULRISAMPLE_ARRAY:
+        GL_CHECK(glTextureStorage3DMultisample(m_id, m_config.samples, format, m_extent.width, m_extent.height, m_config.layers, GL_TRUE));
+        break;
+    case TEXTURE_CUBEMAP:
+        if (uploadLevels)
+        {
+            upload_levels();
+            break;
+        }
+        GL_CHECK(glTextureStorage2D(m_id, levelCount, format, m_extent.width, m_extent.height));
+        // Panoramas are rendered into the faces afterwards
+        if (data && !m_image.panorama)
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                GL_CHECK(glTextureSubImage3D(m_id, m_config.level, 0, 0, i, m_extent.width, m_extent.height, 1, m_config.format, m_config.dataType, data));
+            }
+        }
+        break;
+    }
+    m_immutable = true;
+
+    if (multisampled)
+        return;
+    if (mipmaps)
+    {
+        GL_CHECK(glGenerateTextureMipmap(m_id));
+    }
+    GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_MIN_FILTER, m_config.minFilter));
+    GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_MAG_FILTER, m_config.magFilter));
+
+    GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_WRAP_T, m_config.wrapT));
+    GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_WRAP_S, m_config.wrapS));
+    GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_WRAP_R, m_config.wrapR));
+
+    GL_CHECK(glTextureParameterfv(m_id, GL_TEXTURE_BORDER_COLOR, (float *)&m_config.borderColor));
+
+    if (m_config.anisotropicFilter)
+    {
+        float fLargest;
+        GL_CHECK(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &fLargest));
+        GL_CHECK(glTextureParameterf(m_id, GL_TEXTURE_MAX_ANISOTROPY_EXT, fLargest));
+    }
+}
+
+void Texture::finish_setup()
+{
     if (m_image.panorama)
         panorama_to_cubemap();
 
@@ -139,7 +309,134 @@ void Texture::setup()
             free(m_image.data);
         if (m_image.HDRdata)
             free(m_image.HDRdata);
+        m_levels = TextureLevels();
+    }
+}
+
+int Texture::get_storage_format(const TextureLevels &levels) const
+{
+    return levels.compressedFormat != 0 ? levels.compressedFormat : get_sized_internal_format(m_config.internalFormat, levels.dataType);
+}
+
+void Texture::upload_levels()
+{
+    m_storageFormat = get_storage_format(m_levels);
+    m_storageLevelCount = m_levels.get_level_count();
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glTextureStorage2D(m_id, static_cast<int>(m_storageLevelCount), m_storageFormat, m_extent.width, m_extent.height));
+        upload_level_data();
+        m_immutable = true;
+        return;
+    }
+    GL_CHECK(glTexStorage2D(
+        m_config.type,
+        static_cast<int>(m_storageLevelCount),
+        m_storageFormat,
+        m_extent.width,
+        m_extent.height));
+    upload_level_data();
+    m_immutable = true;
+}
+
+void Texture::upload_level_data()
+{
+    const bool compressed = m_levels.compressedFormat != 0;
+    // Levels are tightly packed
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    if (uses_direct_state_access())
+    {
+        // Cubemap faces are the layers of the storage
+        const bool cubemap = m_config.type == TEXTURE_CUBEMAP;
+        for (unsigned int face = 0; face < m_levels.faceCount; face++)
+        {
+            for (size_t level = 0; level < m_levels.get_level_count(); level++)
+            {
+                const Extent2D &extent = m_levels.extents[level];
+                const int mip = static_cast<int>(level);
+                const void *levelData = m_levels.get_data(face, level);
+                if (compressed && cubemap)
+                {
+                    GL_CHECK(glCompressedTextureSubImage3D(m_id, mip, 0, 0, face, extent.width, extent.height, 1, m_levels.compressedFormat,
+                                                           static_cast<int>(m_levels.sizes[level]), levelData));
+                }
+                else if (compressed)
+                {
+                    GL_CHECK(glCompressedTextureSubImage2D(m_id, mip, 0, 0, extent.width, extent.height, m_levels.compressedFormat,
+                                                           static_cast<int>(m_levels.sizes[level]), levelData));
+                }
+                else if (cubemap)
+                {
+                    GL_CHECK(glTextureSubImage3D(m_id, mip, 0, 0, face, extent.width, extent.height, 1, m_levels.format, m_levels.dataType, levelData));
+                }
+                else
+                {
+                    GL_CHECK(glTextureSubImage2D(m_id, mip, 0, 0, extent.width, extent.height, m_levels.format, m_levels.dataType, levelData));
+                }
+            }
+        }
+        GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        return;
+    }
+    for (unsigned int face = 0; face < m_levels.faceCount; face++)
+    {
+        const unsigned int target = m_config.type == TEXTURE_CUBEMAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : static_cast<unsigned int>(m_config.type);
+        for (size_t level = 0; level < m_levels.get_level_count(); level++)
+        {
+            if (compressed)
+            {
+                GL_CHECK(glCompressedTexSubImage2D(
+                    target,
+                    static_cast<int>(level),
+                    0,
+                    0,
+                    m_levels.extents[level].width,
+                    m_levels.extents[level].height,
+                    m_levels.compressedFormat,
+                    static_cast<int>(m_levels.sizes[level]),
+                    m_levels.get_data(face, level)));
+                continue;
+            }
+            GL_CHECK(glTexSubImage2D(
+                target,
+                static_cast<int>(level),
+                0,
+                0,
+                m_levels.extents[level].width,
+                m_levels.extents[level].height,
+                m_levels.format,
+                m_levels.dataType,
+                m_levels.get_data(face, level)));
+        }
+    }
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+}
+
+bool Texture::update_levels(TextureLevels levels)
+{
+    if (levels.get_level_count() == 0)
+        return false;
+    const bool reuse = m_generated && m_immutable && levels.extents[0] == m_extent &&
+                       levels.get_level_count() == m_storageLevelCount && get_storage_format(levels) == m_storageFormat &&
+                       levels.faceCount == (m_config.type == TEXTURE_CUBEMAP ? 6u : 1u);
+    m_levels = std::move(levels);
+    if (!reuse)
+    {
+        set_extent(m_levels.extents[0]);
+        return false;
+    }
+
+    if (uses_direct_state_access())
+        upload_level_data();
+    else
+    {
+        GL_CHECK(glBindTexture(m_config.type, m_id));
+        upload_level_data();
+        GL_CHECK(glBindTexture(m_config.type, 0));
     }
+    if (m_config.freeImageCacheOnGenerate)
+        m_levels = TextureLevels();
+    return true;
 }
 
 void Texture::set_extent(Extent2D extent)
@@ -167,10 +464,15 @@ void Texture::resize(Extent2D extent)
 
 void Texture::generate_mipmaps()
 {
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glGenerateTextureMipmap(m_id));
+        return;
+    }
     bind();
     GL_CHECK(glGenerateMipmap(m_config.type));
 }
-Texture *Texture::compute_irradiance(int resolution)
+Texture *Texture::compute_irradiance(int resolution, IrradianceMethod method)
 {
     if (m_config.type != TextureType::TEXTURE_CUBEMAP)
     {
@@ -178,6 +480,20 @@ Texture *Texture::compute_irradiance(int resolution)
         return nullptr;
     }
 
+    if (method == IRRADIANCE_SPHERICAL_HARMONICS)
+    {
+        SphericalHarmonics sh;
+        if (!compute_irradiance_SH(sh))
+            return nullptr;
+        auto cubemap = std::make_shared<processing::CubemapData>();
+        processing::bake_irradiance_SH(sh, resolution, *cubemap);
+
+        Texture *irradianceMap = new Texture({resolution, resolution}, m_config);
+        irradianceMap->set_levels(processing::get_texture_levels(cubemap->faces, 6, cubemap));
+        irradianceMap->generate();
+        return irradianceMap;
+    }
+
     if (!Texture::IrradianceComputeShader) // If null, create utility irradiance compute shader
     {
         ShaderStageSource source{};
@@ -246,6 +562,137 @@ Texture *Texture::compute_irradiance(int resolution)
 
     return irradianceMap;
 }
+namespace
+{
+    /*
+    Reads back the largest level of a cubemap not bigger than maxResolution (level 0 if it has no mipmaps) as float RGB.
+    Bakes that can not hold more detail than that save most of the transfer.
+    */
+    void read_cubemap(const Texture &texture, int maxResolution, processing::CubemapData &cubemap)
+    {
+        const Extent2D extent = texture.get_extent();
+        int level = 0;
+        if (texture.get_config().useMipmaps)
+            while ((extent.width >> level) > maxResolution)
+                level++;
+        const int resolution = std::max(extent.width >> level, 1);
+        const size_t faceSize = size_t(resolution) * resolution * 3 * sizeof(float);
+
+        const bool direct = uses_direct_state_access();
+        if (!direct)
+            texture.bind();
+        for (int face = 0; face < 6; face++)
+        {
+            processing::MipChain &chain = cubemap.faces[face];
+            chain.extent = {resolution, resolution};
+            chain.channels = 3;
+            chain.HDR = true;
+            chain.data.resize(faceSize);
+            chain.levelOffsets = {0, faceSize};
+            // Faces are the layers of the texture for Direct State Access reads
+            if (direct)
+            {
+                GL_CHECK(glGetTextureSubImage(texture.get_id(), level, 0, 0, face, resolution, resolution, 1, GL_RGB, GL_FLOAT,
+                                              static_cast<int>(faceSize), chain.data.data()));
+            }
+            else
+            {
+                GL_CHECK(glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_FLOAT, chain.data.data()));
+            }
+        }
+        if (!direct)
+            texture.unbind();
+    }
+}
+
+bool Texture::compute_irradiance_SH(SphericalHarmonics &sh, unsigned int threadCount)
+{
+    if (m_config.type != TextureType::TEXTURE_CUBEMAP || !m_generated)
+    {
+        ERR_LOG("Texture must be a generated CUBEMAP in order to compute irradiance");
+        return false;
+    }
+
+    const int MAX_RESOLUTION = 128;
+    processing::CubemapData cubemap;
+    read_cubemap(*this, MAX_RESOLUTION, cubemap);
+    return processing::project_irradiance_SH(cubemap, sh, MAX_RESOLUTION, threadCount);
+}
+
+Texture *Texture::compute_specular(int resolution, int levelCount, unsigned int sampleCount)
+{
+    if (m_config.type != TextureType::TEXTURE_CUBEMAP || !m_generated)
+    {
+        ERR_LOG("Texture must be a generated CUBEMAP in order to compute specular");
+        return nullptr;
+    }
+
+    // Texels finer than the sharpest level never reach the result, the bake is keyed by the level it starts from
+    processing::CubemapData environment;
+    read_cubemap(*this, resolution, environment);
+    uint64_t faceHashes[6];
+    for (int face = 0; face < 6; face++)
+        faceHashes[face] = utils::hash_bytes(environment.faces[face].data.data(), environment.faces[face].data.size());
+    const uint64_t contentHash = utils::hash_bytes(faceHashes, sizeof(faceHashes));
+    const uint64_t options[] = {SPECULAR_BAKE_TAG, uint64_t(resolution), uint64_t(levelCount), sampleCount};
+    const uint64_t optionsHash = utils::hash_bytes(options, sizeof(options));
+
+    TextureLevels levels;
+    if (!cache::load_baked(contentHash, optionsHash, 6, levels))
+    {
+        processing::SpecularSettings settings;
+        settings.resolution = resolution;
+        settings.levelCount = levelCount;
+        settings.sampleCount = sampleCount;
+        auto prefiltered = std::make_shared<processing::CubemapData>();
+        processing::prefilter_specular(environment, *prefiltered, settings);
+        if (prefiltered->faces[0].get_level_count() == 0)
+            return nullptr;
+        cache::store_baked(contentHash, optionsHash, prefiltered->faces, 6);
+        levels = processing::get_texture_levels(prefiltered->faces, 6, prefiltered);
+    }
+
+    TextureConfig config = m_config;
+    config.useMipmaps = true;
+    config.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    config.magFilter = GL_LINEAR;
+    Texture *specularMap = new Texture(levels.extents[0], config);
+    specularMap->set_levels(std::move(levels));
+    specularMap->generate();
+    return specularMap;
+}
+
+Texture *Texture::compute_BRDF_LUT(int resolution, unsigned int sampleCount)
+{
+    // Does not depend on any content, only on its parameters
+    const uint64_t options[] = {BRDF_BAKE_TAG, uint64_t(resolution), sampleCount};
+    const uint64_t optionsHash = utils::hash_bytes(options, sizeof(options));
+
+    TextureLevels levels;
+    if (!cache::load_baked(0, optionsHash, 1, levels))
+    {
+        auto lut = std::make_shared<processing::MipChain>();
+        processing::integrate_BRDF(resolution, sampleCount, *lut);
+        cache::store_baked(0, optionsHash, lut.get(), 1);
+        levels = processing::get_texture_levels(lut.get(), 1, lut);
+    }
+
+    TextureConfig config;
+    config.format = GL_RG;
+    config.internalFormat = GL_RG16F;
+    config.dataType = GL_FLOAT;
+    config.useMipmaps = false;
+    config.anisotropicFilter = false;
+    config.minFilter = GL_LINEAR;
+    config.magFilter = GL_LINEAR;
+    config.wrapS = GL_CLAMP_TO_EDGE;
+    config.wrapT = GL_CLAMP_TO_EDGE;
+    config.wrapR = GL_CLAMP_TO_EDGE;
+    Texture *lutTexture = new Texture(levels.extents[0], config);
+    lutTexture->set_levels(std::move(levels));
+    lutTexture->generate();
+    return lutTexture;
+}
 void Texture::panorama_to_cubemap()
 {
     if (!Texture::HDRIConverterShader) // If null, create utility converter shader
@@ -258,25 +705,40 @@ void Texture::panorama_to_cubemap()
 
     // Create panorama texture
     unsigned int panoramaID;
-    GL_CHECK(glGenTextures(1, &panoramaID));
-    GL_CHECK(glBindTexture(GL_TEXTURE_2D, panoramaID));
-
-    GL_CHECK(glTexImage2D(
-        GL_TEXTURE_2D,
-        m_config.level,
-        m_config.internalFormat,
-        m_image.extent.width,
-        m_image.extent.height,
-        m_config.border,
-        m_config.format,
-        m_config.dataType,
-        m_image.HDRdata));
-
-    GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
-    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_config.minFilter));
-    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_config.magFilter));
-    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_config.wrapT));
-    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_config.wrapS));
+    if (uses_direct_state_access())
+    {
+        GL_CHECK(glCreateTextures(GL_TEXTURE_2D, 1, &panoramaID));
+        GL_CHECK(glTextureStorage2D(panoramaID, get_mip_level_count(m_image.extent), get_sized_internal_format(m_config.internalFormat, m_config.dataType),
+                                    m_image.extent.width, m_image.extent.height));
+        GL_CHECK(glTextureSubImage2D(panoramaID, 0, 0, 0, m_image.extent.width, m_image.extent.height, m_config.format, m_config.dataType, m_image.HDRdata));
+        GL_CHECK(glGenerateTextureMipmap(panoramaID));
+        GL_CHECK(glTextureParameterf(panoramaID, GL_TEXTURE_MIN_FILTER, m_config.minFilter));
+        GL_CHECK(glTextureParameterf(panoramaID, GL_TEXTURE_MAG_FILTER, m_config.magFilter));
+        GL_CHECK(glTextureParameterf(panoramaID, GL_TEXTURE_WRAP_T, m_config.wrapT));
+        GL_CHECK(glTextureParameterf(panoramaID, GL_TEXTURE_WRAP_S, m_config.wrapS));
+    }
+    else
+    {
+        GL_CHECK(glGenTextures(1, &panoramaID));
+        GL_CHECK(glBindTexture(GL_TEXTURE_2D, panoramaID));
+
+        GL_CHECK(glTexImage2D(
+            GL_TEXTURE_2D,
+            m_config.level,
+            m_config.internalFormat,
+            m_image.extent.width,
+            m_image.extent.height,
+            m_config.border,
+            m_config.format,
+            m_config.dataType,
+            m_image.HDRdata));
+
+        GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
+        GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_config.minFilter));
+        GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_config.magFilter));
+        GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_config.wrapT));
+        GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_config.wrapS));
+    }
 
     GL_CHECK(glBindVertexArray(1));
 
@@ -316,11 +778,10 @@ void Texture::panorama_to_cubemap()
     GL_CHECK(glDeleteTextures(1, &panoramaID));
     GL_CHECK(glDeleteFramebuffers(1, &converterFBO));
 
-    bind();
     if (m_config.useMipmaps)
     {
         // Regenerate mipmaps with newly computed data
-        GL_CHECK(glGenerateMipmap(m_config.type));
+        generate_mipmaps();
     }
 }
 
@@ -9,11 +9,419 @@
 
 */
 #include <GLSP/utils.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 GLSP_NAMESPACE_BEGIN
 
 glm::vec3 utils::get_tangent_gram_smidt(glm::vec3 &p1, glm::vec3 &p2, glm::vec3 &p3, glm::vec2 &uv1, glm::vec2 &uv2, glm::vec2 &uv3, glm::vec3 normal)
 {
-    return glm::vec3();
+    const glm::vec3 edge1 = p2 - p1;
+    const glm::vec3 edge2 = p3 - p1;
+    const glm::vec2 deltaUV1 = uv2 - uv1;
+    const glm::vec2 deltaUV2 = uv3 - uv1;
+
+    const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+    if (std::abs(determinant) < 1e-20f)
+        return glm::vec3(0.0f);
+    glm::vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) / determinant;
+
+    // Gram-Schmidt against the normal
+    tangent -= normal * glm::dot(normal, tangent);
+    const float length = glm::length(tangent);
+    return length > 1e-6f ? tangent / length : glm::vec3(0.0f);
+}
+
+void utils::parallel_for(size_t count, const std::function<void(size_t, size_t, size_t)> &task, unsigned int threadCount)
+{
+    if (count == 0)
+        return;
+    if (threadCount == 0)
+        threadCount = get_thread_count();
+
+    const size_t blocks = std::min<size_t>(threadCount, count);
+    if (blocks == 1)
+    {
+        task(0, count, 0);
+        return;
+    }
+
+    const size_t blockSize = (count + blocks - 1) / blocks;
+    std::vector<std::thread> workers;
+    workers.reserve(blocks - 1);
+    for (size_t block = 1; block < blocks; block++)
+    {
+        const size_t begin = block * blockSize;
+        const size_t end = std::min(count, begin + blockSize);
+        if (begin >= end)
+            break;
+        workers.emplace_back(task, begin, end, block);
+    }
+    // Calling thread takes the first block
+    task(0, std::min(count, blockSize), 0);
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+utils::ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = utils::get_thread_count();
+    m_workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+utils::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (std::thread &worker : m_workers)
+        worker.join();
+}
+
+void utils::ThreadPool::enqueue(std::function<void()> &&task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void utils::ThreadPool::work()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]()
+                             { return m_stopping || !m_tasks.empty(); });
+            // Drain the queue before leaving
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+utils::MappedFile::MappedFile(const std::string &pathToFile, FileAccess access)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(pathToFile.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              access == FILE_ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : (access == FILE_ACCESS_RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL), nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("could not open file to map " + pathToFile);
+    m_fileHandle = file;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    m_size = static_cast<size_t>(size.QuadPart);
+    if (m_size == 0)
+        return;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping)
+    {
+        m_mappingHandle = mapping;
+        m_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!m_data)
+    {
+        if (m_mappingHandle)
+            CloseHandle(m_mappingHandle);
+        m_mappingHandle = nullptr;
+        read_buffered(pathToFile);
+    }
+#else
+    m_fileDescriptor = open(pathToFile.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+        throw std::runtime_error("could not open file to map " + pathToFile);
+
+    struct stat info;
+    if (fstat(m_fileDescriptor, &info) != 0)
+    {
+        close(m_fileDescriptor);
+        throw std::runtime_error("could not stat file " + pathToFile);
+    }
+    // Sizes of pipes and virtual files (procfs reports 0) are not reliable, only reading tells
+    m_size = static_cast<size_t>(info.st_size);
+    if (!S_ISREG(info.st_mode) || m_size == 0)
+    {
+        read_buffered(pathToFile);
+        return;
+    }
+
+    void *mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if (mapped == MAP_FAILED)
+    {
+        read_buffered(pathToFile);
+        return;
+    }
+    m_data = static_cast<const uint8_t *>(mapped);
+
+    // Hints only, failures are harmless
+    if (access == FILE_ACCESS_SEQUENTIAL)
+    {
+        madvise(mapped, m_size, MADV_SEQUENTIAL);
+        madvise(mapped, m_size, MADV_WILLNEED);
+    }
+    else if (access == FILE_ACCESS_RANDOM)
+        madvise(mapped, m_size, MADV_RANDOM);
+#endif
+}
+
+void utils::MappedFile::read_buffered(const std::string &pathToFile)
+{
+    // Grows geometrically from the reported size, so files whose size is unknown are read whole as well
+    size_t capacity = std::max<size_t>(m_size, 1 << 16);
+    size_t size = 0;
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+    while (true)
+    {
+        if (size == capacity)
+        {
+            std::unique_ptr<uint8_t[]> grown(new uint8_t[capacity * 2]);
+            memcpy(grown.get(), buffer.get(), size);
+            buffer = std::move(grown);
+            capacity *= 2;
+        }
+#ifdef _WIN32
+        DWORD count = 0;
+        const DWORD request = static_cast<DWORD>(std::min<size_t>(capacity - size, 1u << 30));
+        if (!ReadFile(static_cast<HANDLE>(m_fileHandle), buffer.get() + size, request, &count, nullptr))
+        {
+            CloseHandle(m_fileHandle);
+            throw std::runtime_error("could not read file " + pathToFile);
+        }
+#else
+        const ssize_t count = read(m_fileDescriptor, buffer.get() + size, capacity - size);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            close(m_fileDescriptor);
+            throw std::runtime_error("could not read file " + pathToFile);
+        }
+#endif
+        if (count == 0)
+            break;
+        size += static_cast<size_t>(count);
+    }
+    m_buffer = std::move(buffer);
+    m_data = m_buffer.get();
+    m_size = size;
+}
+
+utils::MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (m_data && !m_buffer)
+        UnmapViewOfFile(m_data);
+    if (m_mappingHandle)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle)
+        CloseHandle(m_fileHandle);
+#else
+    if (m_data && !m_buffer)
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    if (m_fileDescriptor >= 0)
+        close(m_fileDescriptor);
+#endif
+}
+
+namespace
+{
+    void push_unique(std::vector<std::string> &changed, size_t first, const std::string &path)
+    {
+        if (std::find(changed.begin() + first, changed.end(), path) == changed.end())
+            changed.push_back(path);
+    }
+}
+
+utils::FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+utils::FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (m_inotify >= 0)
+        close(m_inotify);
+#endif
+}
+
+std::string utils::FileWatcher::get_absolute_path(const std::string &pathToFile)
+{
+    std::error_code error;
+    const std::filesystem::path absolute = std::filesystem::absolute(pathToFile, error);
+    return (error ? std::filesystem::path(pathToFile) : absolute).lexically_normal().string();
+}
+
+bool utils::FileWatcher::add(const std::string &pathToFile)
+{
+    const std::string path = get_absolute_path(pathToFile);
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        // Watching the directory instead of the file survives saves that replace the file. Adding a directory twice
+        // returns the same descriptor
+        const std::string directory = std::filesystem::path(path).parent_path().string();
+        const int watch = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0)
+            return false;
+        m_directories[watch] = directory;
+    }
+#endif
+    std::error_code error;
+    const std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    m_files[path] = error ? std::filesystem::file_time_type::min() : time;
+    return true;
+}
+
+void utils::FileWatcher::remove(const std::string &pathToFile)
+{
+    const std::string path = get_absolute_path(pathToFile);
+    if (m_files.erase(path) == 0)
+        return;
+#ifdef __linux__
+    const std::string directory = std::filesystem::path(path).parent_path().string();
+    for (const auto &file : m_files)
+        if (std::filesystem::path(file.first).parent_path() == directory)
+            return;
+    for (auto it = m_directories.begin(); it != m_directories.end(); it++)
+    {
+        if (it->second != directory)
+            continue;
+        inotify_rm_watch(m_inotify, it->first);
+        m_directories.erase(it);
+        return;
+    }
+#endif
+}
+
+size_t utils::FileWatcher::poll(std::vector<std::string> &changed)
+{
+    const size_t first = changed.size();
+#ifdef __linux__
+    if (m_inotify >= 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+        bool overflow = false;
+        ssize_t length;
+        while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (const char *p = buffer; p < buffer + length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+                p += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW)
+                    overflow = true;
+                auto directory = m_directories.find(event->wd);
+                if (directory == m_directories.end() || event->len == 0)
+                    continue;
+                const std::string path = (std::filesystem::path(directory->second) / event->name).string();
+                auto file = m_files.find(path);
+                if (file == m_files.end())
+                    continue;
+                std::error_code error;
+                const std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+                if (!error)
+                    file->second = time;
+                push_unique(changed, first, path);
+            }
+        }
+        if (!overflow)
+            return changed.size() - first;
+        // Events were dropped, compare times right away instead
+        m_lastScan = {};
+    }
+#endif
+    scan(changed, first);
+    return changed.size() - first;
+}
+
+void utils::FileWatcher::scan(std::vector<std::string> &changed, size_t first)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - m_lastScan < std::chrono::milliseconds(POLL_INTERVAL_MS))
+        return;
+    m_lastScan = now;
+    for (auto &file : m_files)
+    {
+        // A file being replaced may be missing for a moment, it is picked up on a later scan
+        std::error_code error;
+        const std::filesystem::file_time_type time = std::filesystem::last_write_time(file.first, error);
+        if (error || time == file.second)
+            continue;
+        file.second = time;
+        push_unique(changed, first, file.first);
+    }
+}
+
+uint64_t utils::hash_bytes(const void *data, size_t size, uint64_t seed)
+{
+    // Four independent multiply-rotate lanes, similar in spirit to xxHash64
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+    auto rotl = [](uint64_t x, int r)
+    { return (x << r) | (x >> (64 - r)); };
+    auto round = [&](uint64_t acc, uint64_t word)
+    { return rotl(acc + word * PRIME2, 31) * PRIME1; };
+
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const uint8_t *const end = p + size;
+    uint64_t lanes[4] = {seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1};
+
+    while (end - p >= 32)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            uint64_t word;
+            memcpy(&word, p + 8 * i, 8);
+            lanes[i] = round(lanes[i], word);
+        }
+        p += 32;
+    }
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + uint64_t(size);
+    while (end - p >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        hash = rotl(hash ^ round(0, word), 27) * PRIME1 + PRIME3;
+        p += 8;
+    }
+    while (p < end)
+        hash = rotl(hash ^ (uint64_t(*p++) * PRIME3), 11) * PRIME1;
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
 }
 GLSP_NAMESPACE_END
\ No newline at end of file